@@ -32,10 +32,14 @@
 #include "common/filesystem.hpp"
 #include "common/quantity.hpp"
 #include "common/system.hpp"
+#include "experiment/aging2_experiment.hpp"
 #include "experiment/graphalytics.hpp"
+#include "experiment/mixed_workload.hpp"
+#include "experiment/update_short_reads_experiment.hpp"
 #include "library/interface.hpp"
 #include "reader/graphlog_reader.hpp"
 #include "third-party/cxxopts/cxxopts.hpp"
+#include "utility/vertex_sampler.hpp"
 
 using namespace common;
 using namespace std;
@@ -101,16 +105,25 @@ void Configuration::initialise(int argc, char* argv[]){
         ("aging_memfp_physical", "Whether to consider the virtual or the physical memory in the memory footprint", value<bool>()->default_value("false"))
         ("aging_memfp_report", "Whether to log to stdout the memory footprint measurements observed", value<bool>()->default_value("false"))
         ("aging_memfp_threshold", "Forcedly stop the execution of the aging experiment if the memory footprint of the whole process is above this threshold", value<ComputerQuantity>())
+        ("aging_partition", "How to partition the updates among the writers in the aging experiment: hash (source + destination), source (by source vertex) or range (degree-aware ranges of the vertex space)", value<string>()->default_value(get_aging_partition()))
         ("aging_release_memory", "Whether to release the memory from the driver as the experiment proceeds", value<bool>()->default_value("true"))
+        ("aging_trace_record", "Record the updates performed by each writer in the aging experiment, in the files <prefix>.<writer_id>.trace", value<string>())
+        ("aging_trace_replay", "Replay the updates recorded by a previous aging experiment, from the files <prefix>.<writer_id>.trace. It requires the same log and number of writers", value<string>())
+        ("aging_work_stealing", "Whether the writers in the aging experiment can steal chunks of updates from the other writers once done with their own", value<bool>()->default_value("false"))
         ("aging_step_size", "The step of each recording for the measured progress in the Aging2 experiment. Valid values are 0.1, 0.25, 0.5 and 1.0", value<double>()->default_value("1"))
         ("aging_timeout", "Force terminating the aging experiment after the given amount of time (excl. cool-off time)", value<DurationQuantity>())
+        ("analytics_csr", "Copy the snapshot of the library into a CSR before running the analytics kernels, when supported by the library. The time to materialise the CSR is reported separately", value<bool>()->default_value("false"))
+        ("analytics_incremental", "In the mixed workload, after each execution of PageRank and WCC, also refresh their previous results with the updates performed since then. Both the incremental and the from-scratch times are reported", value<bool>()->default_value("false"))
         ("blacklist", "Comma separated list of graph algorithms to blacklist and do not execute", value<string>())
         ("build_frequency", "The frequency to build a new snapshot in the aging experiment (default: disabled)", value<DurationQuantity>())
+        ("client_max_in_flight", "The max number of updates (add/remove vertex/edge) a network client pipelines on each connection before waiting for their responses (1 = synchronous, the only value supported by the experiments so far)", value<uint64_t>()->default_value(to_string(get_client_max_in_flight())))
         ("d, database", "Store the current configuration value into the a sqlite3 database at the given location", value<string>())
         ("efe", "Expansion factor for the edges in the graph", value<double>()->default_value(to_string(get_ef_edges())))
         ("efv", "Expansion factor for the vertices in the graph", value<double>()->default_value(to_string(get_ef_vertices())))
         ("G, graph", "The path to the graph to load", value<string>())
         ("h, help", "Show this help menu")
+        ("hop_candidates", "How to draw the candidates of the 1-hop and 2-hop expansions: uniform, degree (proportional to the degree of the vertices) or zipf", value<string>()->default_value(get_hop_candidates()))
+        ("hop_candidates_zipf", "The exponent of the zipf distribution for the candidates of the 1-hop and 2-hop expansions", value<double>()->default_value(to_string(get_hop_candidates_zipf())))
         ("latency", "Measure the latency of inserts/updates, report the average, median, std. dev. and 90/95/97/99 percentiles")
         ("l, library", libraries_help_screen(), value<string>())
         ("load", "Load the graph into the library in one go")
@@ -119,14 +132,22 @@ void Configuration::initialise(int argc, char* argv[]){
         ("omp", "Maximum number of threads that can be used by OpenMP (0 = do not change)", value<int>()->default_value(to_string(num_threads_omp())))
         ("R, repetitions", "The number of repetitions of the same experiment (where applicable)", value<uint64_t>()->default_value(to_string(num_repetitions())))
         ("r, readers", "The number of client threads to use for the read operations", value<int>()->default_value(to_string(num_threads(THREADS_READ))))
+        ("short_reads", "The number of reader threads issuing short reads (point lookups, 1-hop and 2-hop expansions) concurrently with the aging experiment (0 = disabled)", value<uint64_t>()->default_value(to_string(get_short_reads())))
+        ("short_reads_distribution", "How the readers pick the vertices to read, among the vertices of the final graph: uniform or zipf", value<string>()->default_value(get_short_reads_distribution()))
+        ("short_reads_mix", "The weight of each operation issued by the readers, as a comma separated list of <operation>=<weight>. Valid operations are has_edge, get_weight, one_hop and two_hops", value<string>()->default_value(get_short_reads_mix()))
+        ("short_reads_zipf", "The exponent of the zipf distribution for the short reads", value<double>()->default_value(to_string(get_short_reads_zipf())))
         ("seed", "Random seed used in various places in the experiments", value<uint64_t>()->default_value(to_string(seed())))
         ("t, threads", "The number of threads to use for both the read and write operations", value<int>()->default_value(to_string(num_threads(THREADS_TOTAL))))
         ("timeout", "Set the maximum time for an operation to complete, in seconds", value<uint64_t>()->default_value(to_string(get_timeout_graphalytics())))
         ("u, undirected", "Is the graph undirected? By default, it's considered directed.")
         ("v, validate", "Whether to validate the output results of the Graphalytics algorithms", value<string>()->implicit_value("<path>"))
+        ("validate_inserts", "Validate the edges stored in the library after the insertions/updates have been performed")
+        ("validate_max_errors", "Stop the validation of the edges inserted after the given number of errors (0 = no limit)", value<uint64_t>()->default_value(to_string(get_validate_max_errors())))
         ("w, writers", "The number of client threads to use for the write operations", value<int>()->default_value(to_string(num_threads(THREADS_WRITE))))
         ("b, block_size", "The block size for Sortledton to use.", value<int>()->default_value("1024"))
         ("m, mixed_workload", "If set run updates and analytics concurrently.", value<bool>()->default_value("false"))
+        ("mixed_streams", "In the mixed workload, comma separated list of analytics streams to run concurrently, each in the form <num_threads>:<kernel>+<kernel>+... Valid kernels are bfs, pagerank, sssp, wcc, one_hop and two_hops. E.g. 4:bfs+pagerank,2:one_hop+two_hops", value<string>())
+        ("mixed_windows", "In the mixed workload, comma separated list of windows where to run the analytics, each in the form <start>:<end> in terms of progress of the updates. E.g. 0.1:0.5,0.6:0.9", value<string>())
         ("is_timestamped", "If the graph log is sorted by external timestamps and should not be shuffled.", value<bool>()->default_value("false"))
         ("track_memory", "Track the total memory used by the experiment program", value<bool>()->default_value("false"))
     ;
@@ -229,6 +250,14 @@ void Configuration::initialise(int argc, char* argv[]){
             set_load(true);
         }
 
+        if( result["validate_inserts"].count() > 0 ){
+            m_validate_inserts = true;
+        }
+
+        if( result["validate_max_errors"].count() > 0 ){
+            m_validate_max_errors = result["validate_max_errors"].as<uint64_t>();
+        }
+
         if( result["undirected"].count() > 0 ){
             m_graph_directed = false;
         }
@@ -269,6 +298,40 @@ void Configuration::initialise(int argc, char* argv[]){
           m_is_mixed_workload = result["mixed_workload"].as<bool>();
         }
 
+        if(result["hop_candidates"].count() > 0){
+            set_hop_candidates( result["hop_candidates"].as<string>() );
+        }
+
+        if(result["hop_candidates_zipf"].count() > 0){
+            m_hop_candidates_zipf = result["hop_candidates_zipf"].as<double>();
+            if(m_hop_candidates_zipf <= 0){ ERROR("Option --hop_candidates_zipf, the exponent must be positive: " << m_hop_candidates_zipf); }
+        }
+
+        if(result["short_reads"].count() > 0){
+            m_short_reads = result["short_reads"].as<uint64_t>();
+        }
+
+        if(result["short_reads_distribution"].count() > 0){
+            set_short_reads_distribution( result["short_reads_distribution"].as<string>() );
+        }
+
+        if(result["short_reads_mix"].count() > 0){
+            set_short_reads_mix( result["short_reads_mix"].as<string>() );
+        }
+
+        if(result["short_reads_zipf"].count() > 0){
+            m_short_reads_zipf = result["short_reads_zipf"].as<double>();
+            if(m_short_reads_zipf <= 0){ ERROR("Option --short_reads_zipf, the exponent must be positive: " << m_short_reads_zipf); }
+        }
+
+        if(result["mixed_streams"].count() > 0){
+            set_mixed_streams( result["mixed_streams"].as<string>() );
+        }
+
+        if(result["mixed_windows"].count() > 0){
+            set_mixed_windows( result["mixed_windows"].as<string>() );
+        }
+
         if( result["aging_memfp_physical"].count() > 0 ){
             m_aging_memfp_physical = result["aging_memfp_physical"].as<bool>();
         }
@@ -281,10 +344,42 @@ void Configuration::initialise(int argc, char* argv[]){
             m_aging_memfp_report = result["aging_memfp_report"].as<bool>();
         }
 
+        if(result["aging_partition"].count() > 0){
+            set_aging_partition( result["aging_partition"].as<string>() );
+        }
+
         if(result["aging_release_memory"].count() > 0){
             m_aging_release_memory = result["aging_release_memory"].as<bool>();
         }
 
+        if(result["aging_trace_record"].count() > 0){
+            m_aging_trace_record = result["aging_trace_record"].as<string>();
+        }
+
+        if(result["aging_trace_replay"].count() > 0){
+            m_aging_trace_replay = result["aging_trace_replay"].as<string>();
+            if(!common::filesystem::exists(m_aging_trace_replay + ".0.trace")){ ERROR("Option --aging_trace_replay \"" << m_aging_trace_replay << "\", the file " << m_aging_trace_replay << ".0.trace does not exist"); }
+        }
+
+        if(result["aging_work_stealing"].count() > 0){
+            m_aging_work_stealing = result["aging_work_stealing"].as<bool>();
+        }
+
+        if(result["client_max_in_flight"].count() > 0){
+            m_client_max_in_flight = result["client_max_in_flight"].as<uint64_t>();
+            if(m_client_max_in_flight == 0){ ERROR("Option --client_max_in_flight, the value must be positive"); }
+            // the aging workers retry the updates that return false, they cannot consume the outcomes of the pipelined updates yet
+            if(m_client_max_in_flight > 1){ ERROR("Option --client_max_in_flight, pipelining the updates is not supported by the experiments yet, the value must be 1"); }
+        }
+
+        if(result["analytics_csr"].count() > 0){
+            m_analytics_csr = result["analytics_csr"].as<bool>();
+        }
+
+        if(result["analytics_incremental"].count() > 0){
+            m_analytics_incremental = result["analytics_incremental"].as<bool>();
+        }
+
         if( result["blacklist"].count() > 0 ){
             string algorithm;
             stringstream ss(result["blacklist"].as<string>());
@@ -431,6 +526,60 @@ void Configuration::set_aging_memfp_threshold(uint64_t bytes){
     m_aging_memfp_threshold = bytes;
 }
 
+void Configuration::set_aging_partition(const std::string& value){
+    try {
+        experiment::aging2_partition_from_string(value); // validate the value
+    } catch(...){
+        ERROR("Invalid value for the option --aging_partition: `" << value << "'. Expected either `hash', `source' or `range'");
+    }
+    m_aging_partition = value;
+}
+
+void Configuration::set_mixed_streams(const std::string& value){
+    try {
+        experiment::details::analytics_streams_from_string(value); // validate the value
+    } catch(...){
+        ERROR("Invalid value for the option --mixed_streams: `" << value << "'. Expected <num_threads>:<kernel>+<kernel>,...");
+    }
+    m_mixed_streams = value;
+}
+
+void Configuration::set_mixed_windows(const std::string& value){
+    try {
+        experiment::mixed_workload_windows_from_string(value); // validate the value
+    } catch(...){
+        ERROR("Invalid value for the option --mixed_windows: `" << value << "'. Expected a sorted list of non overlapping windows <start>:<end>,... in [0, 1]");
+    }
+    m_mixed_windows = value;
+}
+
+void Configuration::set_hop_candidates(const std::string& value){
+    try {
+        utility::vertex_sampler_distribution_from_string(value); // validate the value
+    } catch(...){
+        ERROR("Invalid value for the option --hop_candidates: `" << value << "'. Expected one of `uniform', `degree' or `zipf'");
+    }
+    m_hop_candidates = value;
+}
+
+void Configuration::set_short_reads_distribution(const std::string& value){
+    try {
+        experiment::short_reads_distribution_from_string(value); // validate the value
+    } catch(...){
+        ERROR("Invalid value for the option --short_reads_distribution: `" << value << "'. Expected either `uniform' or `zipf'");
+    }
+    m_short_reads_distribution = value;
+}
+
+void Configuration::set_short_reads_mix(const std::string& value){
+    try {
+        experiment::short_reads_mix_from_string(value); // validate the value
+    } catch(...){
+        ERROR("Invalid value for the option --short_reads_mix: `" << value << "'. Expected <operation>=<weight>,... with the operations has_edge, get_weight, one_hop or two_hops");
+    }
+    m_short_reads_mix = value;
+}
+
 void Configuration::set_block_size(size_t block_size) {
   m_block_size = block_size;
 }
@@ -554,10 +703,17 @@ void Configuration::save_parameters() {
     params.push_back(P{"aging_memfp_physical", to_string(get_aging_memfp_physical())});
     params.push_back(P{"aging_memfp_report", to_string(get_aging_memfp_report())});
     params.push_back(P{"aging_memfp_threshold", to_string(get_aging_memfp_threshold())});
+    params.push_back(P{"aging_partition", get_aging_partition()});
     params.push_back(P{"aging_release_memory", to_string(get_aging_release_memory())});
     params.push_back(P{"aging_step_size", to_string(get_aging_step_size())});
     params.push_back(P{"aging_timeout", to_string(get_timeout_aging2())});
+    params.push_back(P{"aging_work_stealing", to_string(get_aging_work_stealing())});
+    if(!get_aging_trace_record().empty()){ params.push_back(P{"aging_trace_record", get_aging_trace_record()}); }
+    if(!get_aging_trace_replay().empty()){ params.push_back(P{"aging_trace_replay", get_aging_trace_replay()}); }
+    params.push_back(P{"analytics_csr", to_string(get_analytics_csr())});
+    params.push_back(P{"analytics_incremental", to_string(get_analytics_incremental())});
     params.push_back(P{"build_frequency", to_string(get_build_frequency())}); // milliseconds
+    params.push_back(P{"client_max_in_flight", to_string(get_client_max_in_flight())});
     params.push_back(P{"ef_edges", to_string(get_ef_edges())});
     params.push_back(P{"ef_vertices", to_string(get_ef_vertices())});
     if(!get_path_graph().empty()){ params.push_back(P{"graph", get_path_graph()}); }
@@ -567,6 +723,14 @@ void Configuration::save_parameters() {
     params.push_back(P{"num_threads_read", to_string(num_threads(ThreadsType::THREADS_READ))});
     params.push_back(P{"num_threads_write", to_string(num_threads(ThreadsType::THREADS_WRITE))});
     params.push_back(P{"omp_proc_bind", omp_proc_bind_to_string()});
+    params.push_back(P{"hop_candidates", get_hop_candidates()});
+    if(get_hop_candidates() == "zipf"){ params.push_back(P{"hop_candidates_zipf", to_string(get_hop_candidates_zipf())}); }
+    params.push_back(P{"short_reads", to_string(get_short_reads())});
+    if(get_short_reads() > 0){
+        params.push_back(P{"short_reads_distribution", get_short_reads_distribution()});
+        params.push_back(P{"short_reads_mix", get_short_reads_mix()});
+        params.push_back(P{"short_reads_zipf", to_string(get_short_reads_zipf())});
+    }
     params.push_back(P{"timeout", to_string(get_timeout_graphalytics())});
     params.push_back(P{"directed", to_string(is_graph_directed())});
     params.push_back(P{"library", get_library_name()});
@@ -580,10 +744,13 @@ void Configuration::save_parameters() {
     }
     params.push_back(P{"role", "standalone"});
     params.push_back(P{"validate_inserts", to_string(validate_inserts())});
+    params.push_back(P{"validate_max_errors", to_string(get_validate_max_errors())});
     params.push_back(P{"validate_output", to_string(validate_output())});
     params.push_back(P{"validate_output_graph", get_validation_graph()});
     params.push_back(P{"block_size", to_string(block_size())});
     params.push_back(P{"is_mixed_workload", to_string(m_is_mixed_workload)});
+    if(!get_mixed_streams().empty()){ params.push_back(P{"mixed_streams", get_mixed_streams()}); }
+    if(!get_mixed_windows().empty()){ params.push_back(P{"mixed_windows", get_mixed_windows()}); }
 
     if(!m_blacklist.empty()){
         stringstream ss;
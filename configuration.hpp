@@ -64,15 +64,24 @@ class Configuration {
     bool m_aging_memfp_physical = false; // whether to compute the physical memory or the virtual memory
     bool m_aging_memfp_report = false; // whether to print stdout the measurements observed for the memory footprint
     uint64_t m_aging_memfp_threshold { 0 }; // forcedly stop the execution of the aging2 experiment if the process is using more memory than this threshold, in bytes
+    std::string m_aging_partition { "hash" }; // how to partition the updates among the writers in the aging2 experiment
     bool m_aging_release_memory = true; // whether to release the memory from the driver as the experiment proceeds
+    bool m_aging_work_stealing = false; // whether the writers in the aging2 experiment can steal updates from the other writers
+    std::string m_aging_trace_record; // record the updates performed by each writer in the aging2 experiment in the traces <prefix>.<worker_id>.trace
+    std::string m_aging_trace_replay; // replay the updates of the aging2 experiment from the traces <prefix>.<worker_id>.trace
+    bool m_analytics_csr = false; // whether to materialise the snapshot of the library into a CSR before running the analytics kernels
+    bool m_analytics_incremental = false; // whether to also refresh PageRank and WCC incrementally in the mixed workload
     std::vector<std::string> m_blacklist; // list of graph algorithms that cannot be executed
     uint64_t m_build_frequency { 0 }; // in the aging experiment, the amount of time that must pass before each invocation to #build(), in milliseconds
+    uint64_t m_client_max_in_flight { 1 }; // max number of updates pipelined by a network client on each connection
     double m_coeff_aging { 0.0 }; // coefficient for the additional updates to perform
     common::Database* m_database { nullptr }; // handle to the database
     std::string m_database_path { "" }; // the path where to store the results
     double m_ef_vertices = 1; // expansion factor for the vertices in the graph
     double m_ef_edges = 1;  // expansion factor for the edges in the graph
     bool m_graph_directed = true; // whether the graph is undirected or directed
+    std::string m_hop_candidates { "uniform" }; // how to draw the candidates of the 1-hop and 2-hop expansions: "uniform", "degree" or "zipf"
+    double m_hop_candidates_zipf = 0.99; // the exponent of the zipf distribution for the candidates of the 1-hop and 2-hop expansions
     std::string m_library_name; // the library to test
     bool m_load = false; // whether to load the graph in one go
     double m_max_weight { 1.0 }; // the maximum weight that can be assigned when reading non weighted graphs
@@ -83,6 +92,10 @@ class Configuration {
     int m_num_threads_write { 1 }; // number of threads to use for the write (insert/update/delete) operations
     std::string m_path_graph_to_load; // the file must be accessible to the server
     uint64_t m_seed = 5051789ull; // random seed, used in various places in the experiments
+    uint64_t m_short_reads = 0; // number of reader threads issuing short reads concurrently with the aging experiment (0 = disabled)
+    std::string m_short_reads_distribution { "uniform" }; // how the readers pick the vertices to read: "uniform" or "zipf"
+    std::string m_short_reads_mix { "has_edge=40,get_weight=20,one_hop=30,two_hops=10" }; // the weight of each operation issued by the readers
+    double m_short_reads_zipf = 0.99; // the exponent of the zipf distribution for the short reads
     double m_step_size_recordings { 1.0 }; // in the aging2 experiment, how often to record the progress done in the db. It must be a value in (0, 1].
     uint64_t m_timeout_aging2 { 0 }; // forcedly stop the aging2 experiment after the given amount of seconds
     uint64_t m_timeout_graphalytics { 3600 }; // max time to complete a kernel from Graphalytics, in seconds (0 => indefinite)
@@ -90,14 +103,18 @@ class Configuration {
     std::unique_ptr<library::Interface> (*m_library_factory)(bool directed) {nullptr} ; // function to retrieve an instance of the library `m_library_name'
     std::string m_validate_graph; // validate the results from graphalytics against the given graph
     bool m_validate_inserts = false; // whether to validate the edges inserted
+    uint64_t m_validate_max_errors = 0; // stop the validation of the edges inserted after the given number of errors (0 = no limit)
     bool m_validate_output = false; // whether to validate the execution results of the Graphalytics algorithms
     size_t m_block_size = 1024;  // Block size for Sortledton to use
     bool m_is_mixed_workload = false;
+    std::string m_mixed_streams; // the analytics streams to run concurrently in the mixed workload, empty => a single stream with the enabled algorithms
+    std::string m_mixed_windows; // the windows, in terms of progress of the updates, where to run the analytics in the mixed workload, empty => default
     bool m_is_timestamped_graph = false;
     bool m_track_memory = false;
 
     void set_aging_cooloff_seconds(uint64_t value);
     void set_aging_memfp_threshold(uint64_t bytes);
+    void set_aging_partition(const std::string& value); // Either "hash", "source" or "range"
     void set_aging_step_size(double value); // The step in each recording in the progress for the Agin2 experiment. In (0, 1].
     void set_build_frequency(uint64_t millisecs);
     void set_coeff_aging(double value); // Set the coefficient for `aging', i.e. how many updates (insertions/deletions) to perform w.r.t. to the size of the loaded graph
@@ -113,6 +130,11 @@ class Configuration {
     void set_graph(const std::string& graph); // Set the graph to load and run the experiments
     void set_block_size(size_t block_size);
     void set_is_timestamped(bool timestamped);
+    void set_hop_candidates(const std::string& value); // Either "uniform", "degree" or "zipf"
+    void set_mixed_streams(const std::string& value); // <threads>:<kernel>+<kernel>,...
+    void set_mixed_windows(const std::string& value); // <start>:<end>,...
+    void set_short_reads_distribution(const std::string& value); // Either "uniform" or "zipf"
+    void set_short_reads_mix(const std::string& value); // <operation>=<weight>,...
     void set_track_memory(bool track);
 
     // Set the path to the database
@@ -148,12 +170,21 @@ public:
     // Whether the graph is directed or undirected
     bool is_graph_directed() const { return m_graph_directed; }
 
+    // How to draw the candidates of the 1-hop and 2-hop expansions: "uniform", "degree" or "zipf"
+    const std::string& get_hop_candidates() const { return m_hop_candidates; }
+
+    // The exponent of the zipf distribution for the candidates of the 1-hop and 2-hop expansions
+    double get_hop_candidates_zipf() const { return m_hop_candidates_zipf; }
+
     // Whether to validate the execution results of the Graphalytics algorithms
     bool validate_output() const { return m_validate_output; }
 
     // Whether to validate the edges inserted
     bool validate_inserts() const { return m_validate_inserts; }
 
+    // Stop the validation of the edges inserted after the given number of errors (0 = no limit)
+    uint64_t get_validate_max_errors() const { return m_validate_max_errors; }
+
     // The path to the graph with the results to validate
     const std::string& get_validation_graph() const;
 
@@ -217,6 +248,39 @@ public:
     // Whether to release the memory from the driver as the experiment proceeds
     bool get_aging_release_memory() const { return m_aging_release_memory; }
 
+    // How to partition the updates among the writers in the aging2 experiment: "hash", "source" or "range"
+    const std::string& get_aging_partition() const { return m_aging_partition; }
+
+    // Whether the writers in the aging2 experiment can steal updates from the other writers once done with their own
+    bool get_aging_work_stealing() const { return m_aging_work_stealing; }
+
+    // The max number of updates a network client pipelines on each connection, without waiting for their responses
+    uint64_t get_client_max_in_flight() const { return m_client_max_in_flight; }
+
+    // The prefix of the traces where to record the updates performed in the aging2 experiment (empty => do not record)
+    const std::string& get_aging_trace_record() const { return m_aging_trace_record; }
+
+    // The prefix of the traces to replay in the aging2 experiment (empty => execute the updates from the log)
+    const std::string& get_aging_trace_replay() const { return m_aging_trace_replay; }
+
+    // Whether to materialise the snapshot of the library into a CSR before running the analytics kernels, when the library supports it
+    bool get_analytics_csr() const { return m_analytics_csr; }
+
+    // Whether to also refresh PageRank and WCC incrementally, with the updates performed since their last execution, in the mixed workload
+    bool get_analytics_incremental() const { return m_analytics_incremental; }
+
+    // Number of reader threads issuing short reads concurrently with the aging experiment (0 = disabled)
+    uint64_t get_short_reads() const { return m_short_reads; }
+
+    // How the readers pick the vertices to read: "uniform" or "zipf"
+    const std::string& get_short_reads_distribution() const { return m_short_reads_distribution; }
+
+    // The weight of each operation issued by the readers, e.g. "has_edge=40,get_weight=20,one_hop=30,two_hops=10"
+    const std::string& get_short_reads_mix() const { return m_short_reads_mix; }
+
+    // The exponent of the zipf distribution for the short reads
+    double get_short_reads_zipf() const { return m_short_reads_zipf; }
+
     // Check whether the configuration/results need to be stored into a database
     bool has_database() const;
 
@@ -245,6 +309,12 @@ public:
 
     bool is_mixed_workload() const;
 
+    // The analytics streams to run concurrently in the mixed workload, e.g. "4:bfs+pagerank,2:one_hop" (empty => default)
+    const std::string& get_mixed_streams() const { return m_mixed_streams; }
+
+    // The windows where to run the analytics in the mixed workload, e.g. "0.1:0.5,0.6:0.9" (empty => default)
+    const std::string& get_mixed_windows() const { return m_mixed_windows; }
+
     bool is_timestamped_graph() const;
 
     bool track_memory() const;
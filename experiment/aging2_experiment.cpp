@@ -17,6 +17,7 @@
 
 #include "aging2_experiment.hpp"
 
+#include <cassert>
 #include <iostream>
 #include <mutex>
 #include <thread>
@@ -51,6 +52,27 @@ extern mutex _log_mutex [[maybe_unused]];
 
 namespace gfe::experiment {
 
+std::string aging2_partition_to_string(Aging2Partition partition){
+    switch(partition){
+    case Aging2Partition::HASH: return "hash";
+    case Aging2Partition::SOURCE: return "source";
+    case Aging2Partition::RANGE: return "range";
+    default: return "unknown";
+    }
+}
+
+Aging2Partition aging2_partition_from_string(const std::string& partition){
+    if(partition == "hash"){
+        return Aging2Partition::HASH;
+    } else if (partition == "source"){
+        return Aging2Partition::SOURCE;
+    } else if (partition == "range"){
+        return Aging2Partition::RANGE;
+    } else {
+        INVALID_ARGUMENT("Invalid partitioning strategy: `" << partition << "'. Expected either `hash', `source' or `range'");
+    }
+}
+
 Aging2Experiment::Aging2Experiment() : m_master(nullptr) {
 }
 
@@ -113,6 +135,30 @@ void Aging2Experiment::set_worker_granularity(uint64_t value){
     m_worker_granularity = value;
 }
 
+void Aging2Experiment::set_partition(Aging2Partition partition){
+    m_partition = partition;
+}
+
+void Aging2Experiment::set_work_stealing(bool value){
+    m_work_stealing = value;
+}
+
+void Aging2Experiment::set_seed(uint64_t value){
+    m_seed = value;
+}
+
+void Aging2Experiment::set_trace_record(const std::string& prefix){
+    m_trace_record = prefix;
+}
+
+void Aging2Experiment::set_trace_replay(const std::string& prefix){
+    m_trace_replay = prefix;
+}
+
+void Aging2Experiment::set_delta_log(std::shared_ptr<details::DeltaLog> delta_log){
+    m_delta_log = delta_log;
+}
+
 void Aging2Experiment::set_cooloff(std::chrono::seconds secs){
     m_cooloff = secs;
 }
@@ -129,16 +175,81 @@ void Aging2Experiment::set_memfp_threshold(uint64_t value) {
     m_memfp_threshold = value;
 }
 
+void Aging2Experiment::set_num_auxiliary_threads(uint64_t value){
+    m_num_auxiliary_threads = value;
+
+    // the auxiliary threads wait for the library to be initialised by the next execution
+    scoped_lock<mutex> lock(m_auxiliary_mutex);
+    m_auxiliary_state = AuxiliaryState::WAITING;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Auxiliary threads                                                         *
+ *                                                                           *
+ *****************************************************************************/
+// The thread IDs [0, num_threads +3) are used by the workers, the master, the builder service and the analytics runner
+bool Aging2Experiment::auxiliary_thread_init(uint64_t i){
+    assert(i < m_num_auxiliary_threads && "Slot not reserved with #set_num_auxiliary_threads");
+    unique_lock<mutex> lock(m_auxiliary_mutex);
+    m_auxiliary_condvar.wait(lock, [this](){ return m_auxiliary_state != AuxiliaryState::WAITING; });
+    if(m_auxiliary_state == AuxiliaryState::TERMINATING) return false;
+    m_auxiliary_num_active++;
+    lock.unlock();
+
+    m_library->on_thread_init(m_num_threads + 3 + i);
+    return true;
+}
+
+void Aging2Experiment::auxiliary_thread_destroy(uint64_t i){
+    m_library->on_thread_destroy(m_num_threads + 3 + i);
+
+    scoped_lock<mutex> lock(m_auxiliary_mutex);
+    assert(m_auxiliary_num_active > 0);
+    m_auxiliary_num_active--;
+    m_auxiliary_condvar.notify_all();
+}
+
+bool Aging2Experiment::is_auxiliary_terminating() const {
+    scoped_lock<mutex> lock(m_auxiliary_mutex);
+    return m_auxiliary_state == AuxiliaryState::TERMINATING;
+}
+
+void Aging2Experiment::auxiliary_threads_start() const {
+    scoped_lock<mutex> lock(m_auxiliary_mutex);
+    m_auxiliary_state = AuxiliaryState::RUNNING;
+    m_auxiliary_condvar.notify_all();
+}
+
+void Aging2Experiment::auxiliary_threads_stop() const {
+    unique_lock<mutex> lock(m_auxiliary_mutex);
+    m_auxiliary_state = AuxiliaryState::TERMINATING;
+    m_auxiliary_condvar.notify_all();
+    m_auxiliary_condvar.wait(lock, [this](){ return m_auxiliary_num_active == 0; });
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Execution                                                                 *
+ *                                                                           *
+ *****************************************************************************/
 Aging2Result Aging2Experiment::execute(){
     if(m_library.get() == nullptr) ERROR("Library not set. Use #set_library to set it.");
     if(m_path_log.empty()) ERROR("Path to the log file not set. Use #set_log to set it.")
+    if(!m_trace_replay.empty() && m_work_stealing) ERROR("Work stealing cannot be used when replaying a trace, the updates of each worker are already fixed");
+    if(!m_trace_replay.empty() && !m_trace_record.empty()) ERROR("Cannot record and replay a trace at the same time");
 #if HAVE_GTX
    // m_library.get()->set_worker_thread_num(m_num_threads);
 #endif
-    m_master = new details::Aging2Master(*this);
+    try {
+        m_master = new details::Aging2Master(*this);
+    } catch(...){
+        auxiliary_threads_stop(); // release the auxiliary threads waiting for the library
+        throw;
+    }
     //auto result = m_master->execute();
     //auto result = m_master->execute_synchronized(5);
-    auto result = m_master->execute_synchronized_small_batch();
+    auto result = m_trace_replay.empty() ? m_master->execute_synchronized_small_batch() : m_master->execute_replay();
     //auto result = m_master->execute_pure_update_small_batch();
     //auto result = m_master->execute_synchronized_small_batch_even_partition();
     //auto result = m_master->execute_synchronized_evenly_partition(5);
@@ -18,8 +18,10 @@
 #pragma once
 
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "aging2_result.hpp"
@@ -30,10 +32,27 @@ namespace gfe::graph { class WeightedEdgeStream; }
 namespace gfe::experiment { class Aging2Experiment; }
 namespace gfe::experiment::details { class Aging2Master; }
 namespace gfe::experiment::details { class Aging2Worker; }
+namespace gfe::experiment::details { class DeltaLog; }
+namespace gfe::experiment::details { class UpdateShortReadsMaster; }
 namespace gfe::library { class UpdateInterface; }
 
 namespace gfe::experiment {
 
+/**
+ * How the updates of the graphlog are partitioned among the worker threads. Updates referring to the same edge are
+ * always assigned to the same worker, to preserve the order of insertions and deletions.
+ * - HASH: hash of source + destination. Updates to the same vertex are spread among all workers.
+ * - SOURCE: hash of the source vertex. All updates to the same vertex are performed by the same worker.
+ * - RANGE: contiguous ranges of the vertex space, balanced by the (sampled) number of operations per vertex.
+ */
+enum class Aging2Partition { HASH, SOURCE, RANGE };
+
+// Get a string representation of the partitioning strategy
+std::string aging2_partition_to_string(Aging2Partition partition);
+
+// Parse the partitioning strategy from a string ("hash", "source" or "range")
+Aging2Partition aging2_partition_from_string(const std::string& partition);
+
 /**
  * Builder/factory class to create & execute instances of the Aging experiment.
  *
@@ -43,11 +62,18 @@ class Aging2Experiment {
     friend class Aging2Result;
     friend class details::Aging2Master;
     friend class details::Aging2Worker;
+    friend class details::UpdateShortReadsMaster;
 
     std::shared_ptr<gfe::library::UpdateInterface> m_library; // the library to evaluate
     std::string m_path_log; // the path to the log file [graphlog] with the sequence of updates to perform
     uint64_t m_num_threads = 1; // set the number of threads to use
     uint64_t m_worker_granularity = 4096; // the granularity of a task for a worker, that is the number of contiguous operations (inserts/deletes) performed inside the threads between each invocation to the scheduler.
+    Aging2Partition m_partition = Aging2Partition::HASH; // how to partition the updates among the workers
+    bool m_work_stealing = false; // whether idle workers can steal chunks of updates from the other workers
+    uint64_t m_seed = 5051789ull; // seed for the random generators of the workers (random weights, noise)
+    std::string m_trace_record; // if set, record the updates performed by each worker in the traces <prefix>.<worker_id>.trace
+    std::string m_trace_replay; // if set, replay the updates from the traces <prefix>.<worker_id>.trace, rather than the log
+    std::shared_ptr<details::DeltaLog> m_delta_log; // if set, record the updates performed by the workers, for the incremental analytics
     double m_max_weight = 1.0; // set the max weight for the edges to create
     std::chrono::milliseconds m_build_frequency {0}; // the frequency to create a new delta/snapshot, that is invoking the method #build()
     bool m_memfp = false; // whether to measure the memory footprint
@@ -61,7 +87,22 @@ class Aging2Experiment {
     std::chrono::seconds m_timeout {0}; // max time to run the simulation (excl. cool-off time)
     std::chrono::seconds m_cooloff {0}; // number of seconds to wait after the experiment terminates, to check the effectiveness of the GC
 
+    // auxiliary threads, running alongside the workers (e.g. short readers, analytics streams)
+    enum class AuxiliaryState { WAITING, RUNNING, TERMINATING };
+    uint64_t m_num_auxiliary_threads = 0; // number of thread slots reserved for them in the library
+    mutable std::mutex m_auxiliary_mutex; // sync the auxiliary threads with the master
+    mutable std::condition_variable m_auxiliary_condvar; // wait for the library to be initialised, or for the auxiliary threads to unregister
+    mutable AuxiliaryState m_auxiliary_state = AuxiliaryState::WAITING; // whether the auxiliary threads can access the library
+    mutable uint64_t m_auxiliary_num_active = 0; // number of auxiliary threads currently registered with the library
+
     details::Aging2Master* m_master;
+
+    // Invoked by the master once the library has been initialised, the auxiliary threads can register
+    void auxiliary_threads_start() const;
+
+    // Invoked by the master before the library is released, wait for all auxiliary threads to unregister
+    void auxiliary_threads_stop() const;
+
 public:
     // Instantiate the factory class
     Aging2Experiment();
@@ -122,6 +163,40 @@ public:
     // by each worker thread between each invocation to the scheduler.
     void set_worker_granularity(uint64_t value);
 
+    // Set how to partition the updates among the worker threads
+    void set_partition(Aging2Partition partition);
+
+    // Whether workers that completed their own updates can steal chunks of `worker_granularity' updates from the other
+    // workers. All updates to the same edge belong to the same chunk, so that their order is preserved.
+    void set_work_stealing(bool value);
+
+    // Set the seed for the random generators of the workers
+    void set_seed(uint64_t value);
+
+    // Record the updates performed by each worker, in the order they are issued, in the files <prefix>.<worker_id>.trace
+    void set_trace_record(const std::string& prefix);
+
+    // Replay the updates recorded by a previous execution in the files <prefix>.<worker_id>.trace. The same number of workers
+    // must be used. The log file is still required to retrieve the properties of the final graph.
+    void set_trace_replay(const std::string& prefix);
+
+    // Record the edges inserted and removed by the workers in the given log, once the log is enabled
+    void set_delta_log(std::shared_ptr<details::DeltaLog> delta_log);
+
+    // Reserve slots in the library for the given number of threads running alongside the workers, e.g. readers or analytics streams.
+    // It must be invoked before the auxiliary threads are started.
+    void set_num_auxiliary_threads(uint64_t value);
+
+    // Register the i-th auxiliary thread with the library, waiting for the experiment to initialise the library first.
+    // Return false if the experiment is already over: the thread must not access the library.
+    bool auxiliary_thread_init(uint64_t i);
+
+    // Unregister the i-th auxiliary thread from the library
+    void auxiliary_thread_destroy(uint64_t i);
+
+    // Whether the experiment is over or about to be over: the auxiliary threads must stop and unregister
+    bool is_auxiliary_terminating() const;
+
     // Execute the experiment with the given configuration
     // @param reset_graph if true, release the contained graph before running the experiment, to save some memory
     Aging2Result execute();
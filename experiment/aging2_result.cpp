@@ -29,7 +29,7 @@ using namespace std;
 
 namespace gfe::experiment {
 
-Aging2Result::Aging2Result(const Aging2Experiment& parameters) : m_num_threads(parameters.m_num_threads), m_worker_granularity(parameters.m_worker_granularity){
+Aging2Result::Aging2Result(const Aging2Experiment& parameters) : m_num_threads(parameters.m_num_threads), m_worker_granularity(parameters.m_worker_granularity), m_partition(aging2_partition_to_string(parameters.m_partition)), m_work_stealing(parameters.m_work_stealing){
 
 }
 
@@ -44,6 +44,8 @@ void Aging2Result::save(common::Database* handle) {
     auto db = handle->add("aging");
     db.add("granularity", m_worker_granularity);
     db.add("num_threads", m_num_threads);
+    db.add("partition", m_partition);
+    db.add("work_stealing", (int64_t) m_work_stealing);
     db.add("num_updates", m_num_operations_total);
     db.add("num_artificial_vertices", m_num_artificial_vertices);
     db.add("num_vertices_load", m_num_vertices_load);
@@ -71,6 +73,13 @@ void Aging2Result::save(common::Database* handle) {
     db.add("num_operations", m_progress[i]);
   }
 
+  for(uint64_t i = 0, sz = m_progress_per_worker.size(); i < sz; i++){
+    auto db = handle->add("aging_intermediate_throughput_worker");
+    db.add("second", (int64_t) (i / m_num_threads) +1); // 1, 2, 3...
+    db.add("worker_id", i % m_num_threads);
+    db.add("num_operations", m_progress_per_worker[i]);
+  }
+
   for(auto record: m_memory_footprint){
     auto db = handle->add("aging_intermediate_memory_usage_v2");
     db.add("tick", record.m_tick );
@@ -79,6 +88,16 @@ void Aging2Result::save(common::Database* handle) {
     db.add("cooloff", (int64_t) record.m_is_cooloff);
   }
 
+  for(uint64_t i = 0, sz = m_worker_idle_time.size(); i < sz; i++){
+    auto db = handle->add("aging_worker_stats");
+    db.add("worker_id", i);
+    db.add("busy_time", m_worker_busy_time[i]); // microseconds
+    db.add("idle_time", m_worker_idle_time[i]); // microseconds
+    db.add("num_tasks_stolen", m_worker_num_tasks_stolen[i]);
+    db.add("num_operations", m_worker_num_operations[i]);
+    db.add("throughput", m_worker_busy_time[i] == 0 ? 0.0 : m_worker_num_operations[i] * 1000000.0 / m_worker_busy_time[i]); // ops/sec
+  }
+
     if(m_latency_stats.get() != nullptr){
         m_latency_stats[0].save("inserts");
         m_latency_stats[1].save("deletes");
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <vector>
 
 // forward declarations
@@ -38,6 +39,8 @@ class Aging2Result {
 
     const uint64_t m_num_threads; // the total number of threads used for the experiment, that is, the parallelism degree
     const uint64_t m_worker_granularity; // the granularity of a task for a worker, that is the number of contiguous operations (inserts/deletes) performed inside the threads between each invocation to the scheduler.
+    const std::string m_partition; // the strategy used to partition the updates among the workers
+    const bool m_work_stealing; // whether idle workers could steal chunks of updates from the other workers
     uint64_t m_num_artificial_vertices = 0; // the total number of artificial vertices (not present in the loaded graph), inserted during the updates
     uint64_t m_completion_time = 0; // the amount of time to complete all updates, in microsecs
     uint64_t m_num_vertices_load = 0; // the number of vertices loaded from the input graph
@@ -49,6 +52,7 @@ class Aging2Result {
     uint64_t m_num_operations_total = 0; // total number of operations expected to be performed by the workers
     std::vector<uint64_t> m_reported_times; // time to complete 1x, 2x, 3x, ... updates (inserts/deletions) w.r.t. the size of the input graph, in microsecs
     std::vector<uint64_t> m_progress; // number of operations performed after each seconds of the execution
+    std::vector<uint64_t> m_progress_per_worker; // number of operations performed by each worker after each second of the execution, as a (seconds x num_threads) matrix
     struct MemoryFootprint { uint64_t m_tick; uint64_t m_memory_process; uint64_t m_memory_driver; bool m_is_cooloff; };
     std::vector<MemoryFootprint> m_memory_footprint;
     uint64_t m_random_vertex_id = 0; // the ID of a random vertex stored in the graph
@@ -57,6 +61,10 @@ class Aging2Result {
     bool m_memfp_threshold_passed = false; // whether the experiment terminated due to the excessive usage of memory
     bool m_thread_deadlocked = false; // Whether a worker thread deadlocked
     bool m_in_library_code = false; // Whether a worker thread deadlocked in library code
+    std::vector<uint64_t> m_worker_busy_time; // for each worker, the total time spent performing its updates, in microsecs
+    std::vector<uint64_t> m_worker_idle_time; // for each worker, the total time it waited for the other workers to complete their updates, in microsecs
+    std::vector<uint64_t> m_worker_num_tasks_stolen; // for each worker, the number of chunks of updates stolen from the other workers
+    std::vector<uint64_t> m_worker_num_operations; // for each worker, the total number of updates performed
 
 public:
     // Default ctor
@@ -17,6 +17,7 @@
 
 #include "aging2_master.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <fstream>
@@ -24,6 +25,7 @@
 #include <mutex>
 #include <thread>
 #include <utility>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "common/error.hpp"
@@ -93,13 +95,21 @@ namespace gfe::experiment::details {
                                                               ::ceil(static_cast<double>(num_operations_total()) /
                                                                      num_edges_final_graph()) + 1 )]();
         m_parameters.m_library->on_main_init(m_parameters.m_num_threads + /* this + builder service */ 2 +
-                                             /* plus potentially an analytics runner (mixed epxeriment) */ 1);
+                                             /* plus potentially an analytics runner (mixed epxeriment) */ 1 +
+                                             /* readers & analytics streams */ m_parameters.m_num_auxiliary_threads);
 
         init_workers();
+        init_partition();
+        m_results.m_worker_busy_time.resize(m_workers.size(), 0);
+        m_results.m_worker_idle_time.resize(m_workers.size(), 0);
+        m_results.m_worker_num_tasks_stolen.resize(m_workers.size(), 0);
+        m_results.m_worker_num_operations.resize(m_workers.size(), 0);
         m_parameters.m_library->on_thread_init(m_parameters.m_num_threads + 1);
+        m_parameters.auxiliary_threads_start();
     }
 
     Aging2Master::~Aging2Master() {
+        m_parameters.auxiliary_threads_stop();
         for (auto w: m_workers) { delete w; }
         m_workers.clear();
         m_parameters.m_library->on_thread_destroy(m_parameters.m_num_threads + 1);
@@ -132,6 +142,78 @@ namespace gfe::experiment::details {
         LOG("[Aging2] Workers initialised in " << timer);
     }
 
+/*****************************************************************************
+ *                                                                           *
+ * Partitioning                                                              *
+ *                                                                           *
+ *****************************************************************************/
+    // With the source partitioning, in undirected graphs, the same edge may appear as both u -> v and v -> u in the log
+    static uint64_t partition_key(bool is_directed, uint64_t source, uint64_t destination) {
+        return is_directed ? source : std::min(source, destination);
+    }
+
+    void Aging2Master::init_partition() {
+        LOG("[Aging2] Partitioning strategy: " << aging2_partition_to_string(parameters().m_partition));
+        if (parameters().m_partition != Aging2Partition::RANGE || parameters().m_num_threads == 1) return;
+
+        Timer timer;
+        timer.start();
+
+        // sample the number of operations per vertex from the first blocks of the log
+        constexpr uint64_t max_num_samples = (1ull << 24); // 16M
+        unordered_map<uint64_t, uint64_t> num_ops_per_vertex;
+        uint64_t num_samples = 0;
+        fstream handle(m_parameters.m_path_log, ios_base::in | ios_base::binary);
+        auto properties = reader::graphlog::parse_properties(handle);
+        uint64_t array_sz = stoull(properties["internal.edges.block_size"]);
+        unique_ptr<uint64_t[]> ptr_array{new uint64_t[array_sz]};
+        uint64_t *array = ptr_array.get();
+        reader::graphlog::set_marker(properties, handle, reader::graphlog::Section::EDGES);
+        reader::graphlog::EdgeLoader loader(handle);
+        uint64_t num_edges = 0;
+        while (num_samples < max_num_samples && (num_edges = loader.load(array, array_sz / 3)) > 0) {
+            uint64_t *__restrict sources = array;
+            uint64_t *__restrict destinations = sources + num_edges;
+            for (uint64_t i = 0; i < num_edges; i++) {
+                num_ops_per_vertex[partition_key(m_is_directed, sources[i], destinations[i])]++;
+            }
+            num_samples += num_edges;
+        }
+        handle.close();
+
+        // split the vertex space in ranges with roughly the same number of operations
+        vector<pair<uint64_t, uint64_t>> histogram{num_ops_per_vertex.begin(), num_ops_per_vertex.end()};
+        num_ops_per_vertex.clear();
+        sort(histogram.begin(), histogram.end());
+        const uint64_t num_workers = parameters().m_num_threads;
+        m_partition_ranges.clear();
+        m_partition_ranges.reserve(num_workers - 1);
+        uint64_t cumulative_sum = 0;
+        for (uint64_t i = 0, sz = histogram.size(); i < sz && m_partition_ranges.size() < num_workers - 1; i++) {
+            cumulative_sum += histogram[i].second;
+            if (cumulative_sum * num_workers >= num_samples * (m_partition_ranges.size() + 1) && i + 1 < sz) {
+                m_partition_ranges.push_back(histogram[i + 1].first);
+            }
+        }
+
+        timer.stop();
+        LOG("[Aging2] Vertex ranges computed from " << num_samples << " sampled operations in " << timer);
+    }
+
+    int Aging2Master::partition(uint64_t source, uint64_t destination) const {
+        const uint64_t num_workers = parameters().m_num_threads;
+        switch (parameters().m_partition) {
+            case Aging2Partition::SOURCE:
+                return std::hash<uint64_t>()(partition_key(m_is_directed, source, destination)) % num_workers;
+            case Aging2Partition::RANGE: {
+                uint64_t key = partition_key(m_is_directed, source, destination);
+                return upper_bound(m_partition_ranges.begin(), m_partition_ranges.end(), key) - m_partition_ranges.begin();
+            }
+            default: // HASH
+                return std::hash<uint64_t>()(source + destination) % num_workers;
+        }
+    }
+
 /*****************************************************************************
  *                                                                           *
  * Experiment                                                                *
@@ -265,6 +347,11 @@ namespace gfe::experiment::details {
        // BuildThread build_service{parameters().m_library, static_cast<int>(parameters().m_num_threads) + 2,
         //                          parameters().m_build_frequency};
 
+        if (parameters().m_work_stealing) {
+            for (auto w: m_workers) w->prepare_work_stealing();
+            for (auto w: m_workers) w->wait();
+        }
+
         auto start_time = chrono::steady_clock::now();
         Timer timer;
         timer.start();
@@ -272,6 +359,14 @@ namespace gfe::experiment::details {
         for (auto w: m_workers) w->execute_updates();
         m_experiment_running = true;
         wait_and_record();
+        auto end_time = chrono::steady_clock::now();
+        for (uint64_t i = 0; i < m_workers.size(); i++) { // the time each worker was busy & waited idle for the stragglers
+            auto time_completion = min(max(m_workers[i]->time_completion(), start_time), end_time);
+            m_results.m_worker_busy_time[i] += chrono::duration_cast<chrono::microseconds>(time_completion - start_time).count();
+            m_results.m_worker_idle_time[i] += chrono::duration_cast<chrono::microseconds>(end_time - time_completion).count();
+            m_results.m_worker_num_tasks_stolen[i] = m_workers[i]->num_tasks_stolen();
+            m_results.m_worker_num_operations[i] = m_workers[i]->num_operations();
+        }
         //build_service.stop();
         m_parameters.m_library->build(); // flush last changes
         m_parameters.m_library->updates_stop();
@@ -305,7 +400,16 @@ namespace gfe::experiment::details {
         loader.load(vertices, num_vertices);
         m_results.m_num_artificial_vertices = num_vertices;
 
-        for (auto w: m_workers) w->remove_vertices(vertices, num_vertices);
+        // each worker removes a contiguous slice of the array
+        const uint64_t num_workers = m_workers.size();
+        const uint64_t vertices_per_worker = num_vertices / num_workers;
+        const uint64_t odd_workers = num_vertices % num_workers;
+        uint64_t start = 0;
+        for (uint64_t i = 0; i < num_workers; i++) {
+            uint64_t length = vertices_per_worker + (i < odd_workers);
+            m_workers[i]->remove_vertices(vertices + start, length);
+            start += length;
+        }
         for (auto w: m_workers) w->wait();
         m_parameters.m_library->build();
 
@@ -352,6 +456,7 @@ namespace gfe::experiment::details {
     void Aging2Master::wait_and_record() {
         bool done = false;
         m_results.m_progress.clear();
+        m_results.m_progress_per_worker.clear();
         const bool measure_memfp = parameters().m_memfp;
         const bool measure_physical_memory = parameters().m_memfp_physical;
         const bool report_memfp = parameters().m_report_memory_footprint;
@@ -373,7 +478,13 @@ namespace gfe::experiment::details {
             now = tp;
 
             if (!done) {
-                m_results.m_progress.push_back(num_operations_sofar());
+                uint64_t num_operations = 0;
+                for (auto w: m_workers) {
+                    uint64_t num_operations_worker = w->num_operations();
+                    m_results.m_progress_per_worker.push_back(num_operations_worker);
+                    num_operations += num_operations_worker;
+                }
+                m_results.m_progress.push_back(num_operations);
 
                 if (measure_memfp && (/* first tick */ (m_results.m_progress.size() == 1) ||
                                                        tp - last_memory_footprint_recording >= 10s)) {
@@ -517,6 +628,22 @@ namespace gfe::experiment::details {
             m_results.m_random_vertex_id = sources[i];
     }
 
+    void Aging2Master::load_random_vertex_id() {
+        fstream handle(m_parameters.m_path_log, ios_base::in | ios_base::binary);
+        auto properties = reader::graphlog::parse_properties(handle);
+        uint64_t array_sz = stoull(properties["internal.edges.block_size"]);
+        unique_ptr<uint64_t[]> ptr_array{new uint64_t[array_sz]};
+        reader::graphlog::set_marker(properties, handle, reader::graphlog::Section::EDGES);
+
+        // same as #load_edges, the first insertion in the sequence of updates
+        reader::graphlog::EdgeLoader loader(handle);
+        uint64_t num_edges = 0;
+        while (m_results.m_random_vertex_id == 0 && (num_edges = loader.load(ptr_array.get(), array_sz / 3)) > 0) {
+            set_random_vertex_id(ptr_array.get(), num_edges);
+        }
+        handle.close();
+    }
+
     uint64_t Aging2Master::memory_footprint() const {
         uint64_t result = 0;
         // workers
@@ -526,12 +653,14 @@ namespace gfe::experiment::details {
         if (parameters().m_memfp_physical) { // physical memory
             //result += sizeof(uint64_t) * static_cast<uint64_t>( m_parameters.m_num_reports_per_operations * ::ceil( static_cast<double>(num_operations_total())/num_edges_final_graph()) + 1 );
             result += m_results.m_progress.size() * sizeof(m_results.m_progress[0]);
+            result += m_results.m_progress_per_worker.size() * sizeof(m_results.m_progress_per_worker[0]);
             result += m_results.m_memory_footprint.size() * sizeof(m_results.m_memory_footprint[0]);
             if (m_latencies != nullptr) {
                 result += sizeof(uint64_t) * m_results.m_num_operations_total;
             }
         } else { // virtual memory
             result += utility::MemoryUsage::get_allocated_space(m_results.m_progress.data());
+            result += utility::MemoryUsage::get_allocated_space(m_results.m_progress_per_worker.data());
             result += utility::MemoryUsage::get_allocated_space(m_results.m_memory_footprint.data());
             if (m_latencies != nullptr) {
                 result += utility::MemoryUsage::get_allocated_space(m_latencies);
@@ -861,6 +990,29 @@ namespace gfe::experiment::details {
         return m_results;
     }
 
+    Aging2Result Aging2Master::execute_replay() {
+        LOG("[Aging2] Replaying the updates from the traces " << aging2_trace_path(m_parameters.m_trace_replay, 0) << ", ...");
+        if (m_results.m_random_vertex_id == 0) { load_random_vertex_id(); }
+        uint64_t num_batches = 0;
+        bool done = false;
+        while (!done) {
+            for (auto w: m_workers) w->load_trace();
+            for (auto w: m_workers) w->wait();
+
+            done = true;
+            for (auto w: m_workers) done &= w->has_trace_ended();
+
+            if (!done) {
+                if (parameters().m_measure_latency) prepare_latencies();
+                do_run_experiment();
+                num_batches++;
+            }
+        }
+
+        LOG("[Aging2] Batches replayed: " << num_batches << ", total execution time: " << total_time_microseconds << " us");
+        return m_results;
+    }
+
     Aging2Result Aging2Master::execute_pure_update_small_batch() {
         m_workload_index.store(0,std::memory_order_release);
         fstream handle(m_parameters.m_path_log, ios_base::in | ios_base::binary);
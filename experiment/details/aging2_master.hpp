@@ -62,12 +62,17 @@ class Aging2Master {
     std::atomic_bool m_experiment_running = false;
 
     uint64_t total_time_microseconds = 0;
+
+    std::vector<uint64_t> m_partition_ranges; // with the RANGE partitioning, the first vertex assigned to the workers 1, 2, ..., T -1
    // uint64_t read_log_num = 0;
    // uint64_t total_log_num = 2603795200;//for graph500's 10 hour log
 
     // Initialise the set of workers
     void init_workers();
 
+    // Compute the ranges of the vertex space assigned to each worker, with the RANGE partitioning
+    void init_partition();
+
     // Load & partition the edges to insert/remove in the available workers
     void load_edges();
 
@@ -101,6 +106,9 @@ class Aging2Master {
     // Grab the vertex id of a random (final) edge
     void set_random_vertex_id(uint64_t* edges, uint64_t num_edges);
 
+    // Grab the vertex id of a random (final) edge directly from the graphlog, when the updates are not loaded from it (replay)
+    void load_random_vertex_id();
+
     // Get the current memory footprint of the experiment, in bytes
     uint64_t memory_footprint() const;
 
@@ -122,6 +130,9 @@ public:
     // Total number of edges expected in the final graph
     uint64_t num_edges_final_graph() const;
 
+    // Retrieve the ID of the worker responsible to perform the updates for the edge source -> destination
+    int partition(uint64_t source, uint64_t destination) const;
+
     // Access the configuration of this experiment
     const Aging2Experiment& parameters() const { return m_parameters; }
 
@@ -132,6 +143,7 @@ public:
     Aging2Result execute_synchronized_small_batch();
     Aging2Result execute_synchronized_small_batch_even_partition();
     Aging2Result execute_pure_update_small_batch();
+    Aging2Result execute_replay(); // replay the updates from the traces recorded in a previous execution
     std::atomic_uint64_t m_workload_index;
 };
 
@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "aging2_trace.hpp"
+
+#include <cstring>
+#include <limits>
+
+#include "common/error.hpp"
+
+using namespace std;
+
+namespace gfe::experiment::details {
+
+/*****************************************************************************
+ *                                                                           *
+ * Header                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+namespace {
+struct Aging2TraceHeader {
+    char m_magic[8];
+    uint32_t m_worker_id;
+    uint32_t m_num_workers;
+};
+
+constexpr char MAGIC[8] = "GFETRC1";
+constexpr uint64_t BATCH_MARKER = numeric_limits<uint64_t>::max();
+} // anonymous namespace
+
+string aging2_trace_path(const string& prefix, int worker_id){
+    return prefix + "." + to_string(worker_id) + ".trace";
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Writer                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+Aging2TraceWriter::Aging2TraceWriter(const string& path, int worker_id, int num_workers) : m_buffer(new Aging2TraceRecord[m_buffer_capacity]){
+    m_handle.open(path, ios_base::out | ios_base::binary | ios_base::trunc);
+    if(!m_handle.good()) ERROR("Cannot create the trace file: " << path);
+
+    Aging2TraceHeader header;
+    memcpy(header.m_magic, MAGIC, sizeof(MAGIC));
+    header.m_worker_id = worker_id;
+    header.m_num_workers = num_workers;
+    m_handle.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+Aging2TraceWriter::~Aging2TraceWriter(){
+    flush();
+    m_handle.close();
+}
+
+void Aging2TraceWriter::flush(){
+    if(m_buffer_sz == 0) return;
+    m_handle.write(reinterpret_cast<const char*>(m_buffer.get()), m_buffer_sz * sizeof(Aging2TraceRecord));
+    if(!m_handle.good()) ERROR("Cannot write the trace file");
+    m_buffer_sz = 0;
+}
+
+void Aging2TraceWriter::end_batch(){
+    append(BATCH_MARKER, BATCH_MARKER, 0);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Reader                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+Aging2TraceReader::Aging2TraceReader(const string& path, int worker_id, int num_workers){
+    m_handle.open(path, ios_base::in | ios_base::binary);
+    if(!m_handle.good()) ERROR("Cannot open the trace file: " << path);
+
+    Aging2TraceHeader header;
+    m_handle.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if(!m_handle.good() || memcmp(header.m_magic, MAGIC, sizeof(MAGIC)) != 0){
+        ERROR("Invalid trace file: " << path);
+    }
+    if(header.m_worker_id != (uint32_t) worker_id || header.m_num_workers != (uint32_t) num_workers){
+        ERROR("The trace " << path << " was recorded by the worker " << header.m_worker_id << " of " << header.m_num_workers << ", "
+              "while it is being replayed by the worker " << worker_id << " of " << num_workers);
+    }
+}
+
+bool Aging2TraceReader::next_batch(vector<graph::WeightedEdge>& out){
+    constexpr uint64_t buffer_capacity = 4096;
+    unique_ptr<Aging2TraceRecord[]> ptr_buffer { new Aging2TraceRecord[buffer_capacity] };
+    Aging2TraceRecord* buffer = ptr_buffer.get();
+    bool batch_found = false; // whether at least one record has been read
+
+    while(true){
+        // read one record at the time up to the marker would be too slow, read in blocks and rewind at the marker
+        streampos position = m_handle.tellg();
+        m_handle.read(reinterpret_cast<char*>(buffer), buffer_capacity * sizeof(Aging2TraceRecord));
+        uint64_t num_records = m_handle.gcount() / sizeof(Aging2TraceRecord);
+        if(num_records == 0) return batch_found; // end of the trace, the last batch may lack the marker if the recording was interrupted
+        m_handle.clear(); // reset the EOF flag
+        batch_found = true;
+
+        for(uint64_t i = 0; i < num_records; i++){
+            if(buffer[i].m_source == BATCH_MARKER && buffer[i].m_destination == BATCH_MARKER){
+                m_handle.seekg(position + static_cast<streamoff>((i + 1) * sizeof(Aging2TraceRecord)));
+                return true;
+            }
+            out.emplace_back(buffer[i].m_source, buffer[i].m_destination, buffer[i].m_weight);
+        }
+    }
+}
+
+} // namespace
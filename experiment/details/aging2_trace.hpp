@@ -0,0 +1,96 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "graph/edge.hpp"
+
+namespace gfe::experiment::details {
+
+/**
+ * The trace of the updates issued by a single worker of the Aging2 experiment, in the exact order they were performed.
+ *
+ * File format: a header (magic number, worker id, number of workers), followed by a sequence of records
+ * <source, destination, weight>. Insertions have a weight >= 0, deletions a negative weight. The source and destination
+ * are recorded after the noise (random swap of the endpoints in undirected graphs) has been applied. The end of each
+ * batch of updates, that is the synchronisation point between the workers, is recorded with a special marker.
+ */
+struct Aging2TraceRecord {
+    uint64_t m_source;
+    uint64_t m_destination;
+    double m_weight;
+};
+
+// Get the path of the trace for the given worker
+std::string aging2_trace_path(const std::string& prefix, int worker_id);
+
+/**
+ * Append the updates performed by a worker to its trace
+ */
+class Aging2TraceWriter {
+    Aging2TraceWriter(const Aging2TraceWriter&) = delete;
+    Aging2TraceWriter& operator=(const Aging2TraceWriter&) = delete;
+
+    std::fstream m_handle; // the file being written
+    static constexpr uint64_t m_buffer_capacity = (1ull << 16); // number of records buffered before writing to the file
+    std::unique_ptr<Aging2TraceRecord[]> m_buffer; // records not written yet
+    uint64_t m_buffer_sz = 0; // number of records in the buffer
+
+    // Write the content of the buffer in the file
+    void flush();
+
+public:
+    // Create a new trace in the given path
+    Aging2TraceWriter(const std::string& path, int worker_id, int num_workers);
+
+    // Destructor, flush the content of the buffer
+    ~Aging2TraceWriter();
+
+    // Record an update
+    void append(uint64_t source, uint64_t destination, double weight) {
+        if(m_buffer_sz == m_buffer_capacity) flush();
+        m_buffer[m_buffer_sz++] = Aging2TraceRecord{ source, destination, weight };
+    }
+
+    // Record the end of a batch of updates
+    void end_batch();
+};
+
+/**
+ * Read the updates to perform from a trace, one batch at the time
+ */
+class Aging2TraceReader {
+    Aging2TraceReader(const Aging2TraceReader&) = delete;
+    Aging2TraceReader& operator=(const Aging2TraceReader&) = delete;
+
+    std::fstream m_handle; // the file being read
+
+public:
+    // Open the trace at the given path. Check it was recorded by a worker with the same id and the same number of workers.
+    Aging2TraceReader(const std::string& path, int worker_id, int num_workers);
+
+    // Append the updates of the next batch into the given vector. Return false if the trace is over.
+    bool next_batch(std::vector<graph::WeightedEdge>& out);
+};
+
+} // namespace
@@ -34,6 +34,7 @@
 #include "library/interface.hpp"
 #include "utility/memory_usage.hpp"
 #include "aging2_master.hpp"
+#include "incremental_analytics.hpp"
 #include "configuration.hpp"
 
 using namespace common;
@@ -62,9 +63,23 @@ namespace gfe::experiment::details {
     Aging2Worker::Aging2Worker(Aging2Master &master, int worker_id) : m_master(master),
                                                                       m_library(m_master.parameters().m_library.get()),
                                                                       m_worker_id(worker_id),
+                                                                      m_random(m_master.parameters().m_seed + worker_id),
                                                                       m_task{TaskOp::IDLE, nullptr, 0} {
         assert(m_library != nullptr);
 
+        // record & replay
+        const Aging2Experiment &parameters = m_master.parameters();
+        const int num_workers = parameters.m_num_threads;
+        if (!parameters.m_trace_record.empty()) {
+            m_trace_writer.reset(new Aging2TraceWriter(aging2_trace_path(parameters.m_trace_record, m_worker_id), m_worker_id, num_workers));
+        }
+        if (!parameters.m_trace_replay.empty()) {
+            m_trace_reader.reset(new Aging2TraceReader(aging2_trace_path(parameters.m_trace_replay, m_worker_id), m_worker_id, num_workers));
+        }
+        m_delta_log = parameters.m_delta_log.get();
+        // the traces already contain the edges after the noise has been applied
+        m_apply_noise = !m_master.is_directed() && m_trace_reader.get() == nullptr;
+
         // start the background thread
         start();
     }
@@ -115,6 +130,14 @@ namespace gfe::experiment::details {
         set_task_async(TaskOp::EXECUTE_UPDATES);
     }
 
+    void Aging2Worker::load_trace() {
+        set_task_async(TaskOp::LOAD_TRACE);
+    }
+
+    void Aging2Worker::prepare_work_stealing() {
+        set_task_async(TaskOp::PREPARE_WORK_STEALING);
+    }
+
     void Aging2Worker::execute_true_updates(uint64_t *edges, uint64_t num_edges) {
         set_task_async(TaskOp::EXECUTE_TRUE_UPDATES, edges, num_edges);
     }
@@ -211,6 +234,12 @@ namespace gfe::experiment::details {
                 case TaskOp::EXECUTE_TRUE_UPDATES:
                     main_execute_true_updates(task.m_payload, task.m_payload_sz);
                     break;
+                case TaskOp::PREPARE_WORK_STEALING:
+                    main_prepare_work_stealing();
+                    break;
+                case TaskOp::LOAD_TRACE:
+                    main_load_trace();
+                    break;
             }
         } while (!terminate);
 #if HAVE_SORTLEDTON
@@ -230,6 +259,11 @@ namespace gfe::experiment::details {
     }
 
     void Aging2Worker::main_execute_updates() {
+        if (m_master.parameters().m_work_stealing) {
+            main_execute_updates_work_stealing();
+            return;
+        }
+
         // compute the amount of space used by the vectors in m_updates
         //auto start = std::chrono::high_resolution_clock::now();
         for (uint64_t i = 0; i < m_updates.size(); i++) {
@@ -274,16 +308,7 @@ namespace gfe::experiment::details {
                 }*/
 
                 // report how long it took to perform 1x, 2x, ... updates w.r.t. to the size of the final graph
-                int aging_coeff =
-                        (static_cast<double>(num_ops_done) / m_master.num_edges_final_graph()) * reports_per_ops;
-                if (aging_coeff > lastset_coeff) {
-                    if (m_master.m_last_time_reported.compare_exchange_strong(/* updates lastset_coeff */ lastset_coeff,
-                                                                                                          aging_coeff)) {
-                        uint64_t duration = chrono::duration_cast<chrono::microseconds>(
-                                chrono::steady_clock::now() - m_master.m_time_start).count();
-                        m_master.m_reported_times[aging_coeff - 1] = duration;
-                    }
-                }
+                record_aging_coeff(num_ops_done, lastset_coeff);
 
                 // next iteration
                 start = end;
@@ -305,6 +330,8 @@ namespace gfe::experiment::details {
             }
         }
         m_updates.clear();
+        if (m_trace_writer) m_trace_writer->end_batch();
+        m_time_completion = chrono::steady_clock::now();
         //for libin to understand
         //std::cout<<"worker "<<m_worker_id<<" finished updating edges"<<std::endl;
 #if HAVE_GTX
@@ -316,12 +343,149 @@ namespace gfe::experiment::details {
     }
 
 
+    void Aging2Worker::record_aging_coeff(uint64_t num_ops_done, int &lastset_coeff) {
+        const double reports_per_ops = m_master.parameters().m_num_reports_per_operations;
+        int aging_coeff = (static_cast<double>(num_ops_done) / m_master.num_edges_final_graph()) * reports_per_ops;
+        if (aging_coeff > lastset_coeff) {
+            if (m_master.m_last_time_reported.compare_exchange_strong(/* updates lastset_coeff */ lastset_coeff,
+                                                                                                  aging_coeff)) {
+                uint64_t duration = chrono::duration_cast<chrono::microseconds>(
+                        chrono::steady_clock::now() - m_master.m_time_start).count();
+                m_master.m_reported_times[aging_coeff - 1] = duration;
+            }
+        }
+    }
+
+    void Aging2Worker::main_prepare_work_stealing() {
+        uint64_t num_updates = 0;
+        for (uint64_t i = 0; i < m_updates.size(); i++) { num_updates += m_updates[i]->size(); }
+
+        // all updates to the same edge must end up in the same chunk, to preserve their order
+        const uint64_t num_tasks = std::max<uint64_t>(1, num_updates / granularity());
+        auto task_of = [num_tasks](const graph::WeightedEdge &e) {
+            graph::Edge key{std::min(e.source(), e.destination()), std::max(e.source(), e.destination())};
+            return std::hash<graph::Edge>()(key) % num_tasks;
+        };
+
+        // counting sort of the updates by chunk
+        m_tasks_offsets.assign(num_tasks + 1, 0);
+        m_tasks_insertions.assign(num_tasks + 1, 0);
+        for (uint64_t i = 0; i < m_updates.size(); i++) {
+            for (auto &e: *(m_updates[i])) {
+                uint64_t task_id = task_of(e);
+                m_tasks_offsets[task_id + 1]++;
+                if (e.m_weight >= 0) m_tasks_insertions[task_id + 1]++;
+            }
+        }
+        for (uint64_t i = 1; i <= num_tasks; i++) {
+            m_tasks_offsets[i] += m_tasks_offsets[i - 1];
+            m_tasks_insertions[i] += m_tasks_insertions[i - 1];
+        }
+        vector<uint64_t> cursors{m_tasks_offsets.begin(), m_tasks_offsets.end() - 1};
+        m_tasks_updates.resize(num_updates);
+        while (!m_updates.empty()) {
+            for (auto &e: *(m_updates[0])) { m_tasks_updates[cursors[task_of(e)]++] = e; }
+            delete m_updates[0];
+            m_updates.pop();
+        }
+        m_updates.clear();
+
+        if (m_master.parameters().m_memfp_physical) { // physical space
+            m_updates_mem_usage = m_tasks_updates.size() * sizeof(gfe::graph::WeightedEdge);
+        } else { // virtual space
+            m_updates_mem_usage = utility::MemoryUsage::get_allocated_space(m_tasks_updates.data());
+        }
+
+        // the peers may steal the chunks as soon as the execution starts
+        m_tasks_latency_insertions = m_latency_insertions;
+        m_tasks_latency_deletions = m_latency_deletions;
+        m_tasks_num_pending = num_tasks;
+        m_tasks.reset(num_tasks);
+        for (uint64_t i = 0; i < num_tasks; i++) { m_tasks.push(i); }
+        COUT_DEBUG("Updates: " << num_updates << ", chunks: " << num_tasks);
+    }
+
+    void Aging2Worker::main_execute_updates_work_stealing() {
+        int lastset_coeff = 0;
+        uint64_t task_id = 0;
+
+        // first, execute our own chunks
+        while (m_tasks.pop(task_id)) {
+            execute_task(this, task_id);
+            record_aging_coeff(m_master.m_num_operations_performed.load(), lastset_coeff);
+        }
+
+        // then, steal from the peers until all deques are empty
+        const uint64_t num_workers = m_master.m_workers.size();
+        bool work_left = true;
+        while (work_left && !m_master.m_stop_experiment) {
+            work_left = false;
+            for (uint64_t i = 1; i < num_workers; i++) {
+                Aging2Worker *victim = m_master.m_workers[(m_worker_id + i) % num_workers];
+                WorkStealingDeque::StealResult result;
+                while ((result = victim->m_tasks.steal(task_id)) != WorkStealingDeque::StealResult::EMPTY) {
+                    if (result == WorkStealingDeque::StealResult::SUCCESS) {
+                        execute_task(victim, task_id);
+                        m_num_tasks_stolen++;
+                        record_aging_coeff(m_master.m_num_operations_performed.load(), lastset_coeff);
+                    }
+                    work_left = true;
+                }
+            }
+        }
+
+        // move past the latencies of our chunks, as if we executed all of them, ready for the next batch
+        if (m_latency_insertions != nullptr) {
+            const uint64_t num_insertions = m_tasks_insertions.back();
+            m_latency_insertions += num_insertions;
+            m_latency_deletions += m_tasks_offsets.back() - num_insertions;
+        }
+
+        // the buffer m_tasks_updates is released by the worker executing its last chunk, possibly a thief still running
+        if (m_trace_writer) m_trace_writer->end_batch();
+        m_time_completion = chrono::steady_clock::now();
+    }
+
+    void Aging2Worker::execute_task(Aging2Worker *owner, uint64_t task_id) {
+        const uint64_t start = owner->m_tasks_offsets[task_id];
+        const uint64_t end = owner->m_tasks_offsets[task_id + 1];
+
+        // the latencies are recorded in the slots of the owner, our own position is restored afterwards
+        uint64_t* const latency_insertions = m_latency_insertions;
+        uint64_t* const latency_deletions = m_latency_deletions;
+        if (owner->m_tasks_latency_insertions != nullptr) {
+            const uint64_t num_insertions_before = owner->m_tasks_insertions[task_id];
+            m_latency_insertions = owner->m_tasks_latency_insertions + num_insertions_before;
+            m_latency_deletions = owner->m_tasks_latency_deletions + (start - num_insertions_before);
+        }
+
+        graph_execute_batch_updates(owner->m_tasks_updates.data() + start, end - start);
+        m_master.m_num_operations_performed.fetch_add(end - start);
+        m_latency_insertions = latency_insertions;
+        m_latency_deletions = latency_deletions;
+
+        // the last chunk executed releases the updates of the owner
+        if (owner->m_tasks_num_pending.fetch_sub(1) == 1 && m_master.parameters().m_release_driver_memory) {
+            owner->release_tasks_memory();
+        }
+    }
+
+    void Aging2Worker::release_tasks_memory() {
+        COUT_DEBUG("Releasing the buffer of the chunks, cardinality " << m_tasks_updates.size());
+        if (m_master.parameters().m_memfp_physical) {
+            m_updates_mem_usage -= m_tasks_updates.size() * sizeof(gfe::graph::WeightedEdge); // update the memory footprint of this worker
+        } else { // virtual memory
+            m_updates_mem_usage -= utility::MemoryUsage::get_allocated_space(m_tasks_updates.data());
+        }
+        vector<graph::WeightedEdge>{}.swap(m_tasks_updates);
+        COUT_DEBUG("Memory footprint: " << m_updates_mem_usage << " bytes");
+    }
+
     void Aging2Worker::main_load_edges(uint64_t *edges, uint64_t num_edges) {
         if (m_updates.empty()) { m_updates.append(new vector<graph::WeightedEdge>()); }
         vector<graph::WeightedEdge> *last = m_updates[m_updates.size() - 1];
 
         constexpr uint64_t last_max_sz = (1ull << 22); // 4M
-        const uint64_t modulo = m_master.parameters().m_num_threads;
 
         uint64_t *__restrict sources = edges;
         uint64_t *__restrict destinations = sources + num_edges;
@@ -330,8 +494,7 @@ namespace gfe::experiment::details {
         uniform_real_distribution<double> rndweight{0, m_master.parameters().m_max_weight}; // in [0, max_weight)
 
         for (uint64_t i = 0; i < num_edges; i++) {
-            // if(static_cast<int>((sources[i] + destinations[i]) % modulo) == m_worker_id){
-            if (static_cast<int>(std::hash<uint64_t>()((sources[i] + destinations[i])) % modulo) == m_worker_id) {
+            if (m_master.partition(sources[i], destinations[i]) == m_worker_id) {
                 if (last->size() > last_max_sz) {
                     last = new vector<graph::WeightedEdge>();
                     m_updates.append(last);
@@ -357,6 +520,20 @@ namespace gfe::experiment::details {
         }
     }
 
+    void Aging2Worker::main_load_trace() {
+        assert(m_trace_reader.get() != nullptr && "Replay not requested");
+        vector<graph::WeightedEdge> *batch = new vector<graph::WeightedEdge>();
+        m_trace_ended = !m_trace_reader->next_batch(*batch);
+        for (auto &e: *batch) {
+            if (e.m_weight >= 0) {
+                m_num_edge_insertions++;
+            } else {
+                m_num_edge_deletions++;
+            }
+        }
+        m_updates.append(batch);
+    }
+
     void Aging2Worker::main_execute_true_updates(uint64_t *edges, uint64_t num_edges) {
         uint64_t start_index =0;
         uint64_t *__restrict sources = edges;
@@ -455,14 +632,11 @@ namespace gfe::experiment::details {
     }
 
     void Aging2Worker::main_remove_vertices(uint64_t *vertices, uint64_t num_vertices) {
-        auto pardegree = m_master.parameters().m_num_threads;
         m_is_in_library_code = true;
 
         for (uint64_t i = 0; i < num_vertices; i++) {
-            if (static_cast<int>(vertices[i] % pardegree) == m_worker_id) {
-                COUT_DEBUG("Remove vertex: " << vertices[i]);
-                m_library->remove_vertex(vertices[i]);
-            }
+            COUT_DEBUG("Remove vertex: " << vertices[i]);
+            m_library->remove_vertex(vertices[i]);
         }
         m_is_in_library_code = false;
     }
@@ -489,6 +663,8 @@ namespace gfe::experiment::details {
 
     template<bool with_latency>
     void Aging2Worker::graph_execute_batch_updates0(graph::WeightedEdge *__restrict updates, uint64_t num_updates) {
+        static_assert((num_operations_publish_interval & (num_operations_publish_interval - 1)) == 0, "Expected a power of 2");
+        uint64_t num_operations = m_num_operations.load(memory_order_relaxed); // we are the only writer
         for (uint64_t i = 0; i < num_updates; i++) {
             if (m_master.m_stop_experiment) break; // timeout, we're done
 
@@ -498,11 +674,17 @@ namespace gfe::experiment::details {
                 graph_remove_edge<with_latency>(updates[i].edge());
             }
 
-            m_num_operations++;
+            // publish the progress to the master
+            num_operations++;
+            if ((num_operations & (num_operations_publish_interval - 1)) == 0) {
+                m_num_operations.store(num_operations, memory_order_relaxed);
+            }
         }
+        m_num_operations.store(num_operations, memory_order_relaxed);
     }
     template<bool with_latency>
     void Aging2Worker::graph_execute_batch_updates1(graph::WeightedEdge *__restrict updates, uint64_t num_updates) {
+        uint64_t num_operations = m_num_operations.load(memory_order_relaxed); // we are the only writer
         for (uint64_t i = 0; i < num_updates; i++) {
             if (m_master.m_stop_experiment) break; // timeout, we're done
 
@@ -514,13 +696,20 @@ namespace gfe::experiment::details {
                 graph_remove_edge<with_latency>(updates[i].edge());
             }
 
-            m_num_operations++;
+            // publish the progress to the master
+            num_operations++;
+            if ((num_operations & (num_operations_publish_interval - 1)) == 0) {
+                m_num_operations.store(num_operations, memory_order_relaxed);
+            }
         }
+        m_num_operations.store(num_operations, memory_order_relaxed);
     }
     template<bool with_latency>
     void Aging2Worker::graph_insert_edge(graph::WeightedEdge edge) {
-        if (!m_master.is_directed() && m_uniform(m_random) < 0.5) edge.swap_src_dst(); // noise
+        if (m_apply_noise && m_uniform(m_random) < 0.5) edge.swap_src_dst(); // noise
+        if (m_trace_writer) m_trace_writer->append(edge.source(), edge.destination(), edge.weight());
         COUT_DEBUG("edge: " << edge);
+        uint64_t delta_sequence = m_delta_log ? m_delta_log->reserve(m_worker_id) : 0;
         m_is_in_library_code = true;
         if (with_latency == false) {
             // the function returns true if the edge has been inserted. Repeat the loop if it cannot insert the edge as one of
@@ -538,12 +727,15 @@ namespace gfe::experiment::details {
             m_latency_insertions++;
         }
         m_is_in_library_code = false;
+        if (m_delta_log) m_delta_log->append(m_worker_id, delta_sequence, edge.source(), edge.destination(), /* insertion */ true);
     }
 
     template<bool with_latency>
     void Aging2Worker::graph_remove_edge(graph::Edge edge, bool force) {
-        if (!m_master.is_directed() && m_uniform(m_random) < 0.5) edge.swap_src_dst(); // noise
+        if (m_apply_noise && m_uniform(m_random) < 0.5) edge.swap_src_dst(); // noise
+        if (m_trace_writer) m_trace_writer->append(edge.source(), edge.destination(), /* deletion */ -1.0);
         COUT_DEBUG("edge: " << edge);
+        uint64_t delta_sequence = m_delta_log ? m_delta_log->reserve(m_worker_id) : 0;
         m_is_in_library_code = true;
         if (with_latency == false) {
 
@@ -569,6 +761,7 @@ namespace gfe::experiment::details {
             m_latency_deletions++;
         }
         m_is_in_library_code = false;
+        if (m_delta_log) m_delta_log->append(m_worker_id, delta_sequence, edge.source(), edge.destination(), /* insertion */ false);
     }
 
     uint64_t Aging2Worker::granularity() const {
@@ -584,7 +777,7 @@ namespace gfe::experiment::details {
     }
 
     uint64_t Aging2Worker::num_operations() const {
-        return m_num_operations;
+        return m_num_operations.load(memory_order_relaxed);
     }
 
     uint64_t Aging2Worker::memory_footprint() const {
@@ -595,6 +788,18 @@ namespace gfe::experiment::details {
         return m_is_in_library_code;
     }
 
+    bool Aging2Worker::has_trace_ended() const {
+        return m_trace_ended;
+    }
+
+    uint64_t Aging2Worker::num_tasks_stolen() const {
+        return m_num_tasks_stolen;
+    }
+
+    chrono::steady_clock::time_point Aging2Worker::time_completion() const {
+        return m_time_completion;
+    }
+
     void Aging2Worker::print_workload(uint64_t start_entry, uint64_t num) const {
         /* uint64_t start_entry_copy = start_entry;
          std::cout<<"has "<<m_updates.size()<<" vectors"<<std::endl;
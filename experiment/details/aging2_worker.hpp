@@ -18,16 +18,22 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <random>
 #include <thread>
+#include <vector>
 
 #include "common/circular_array.hpp"
 #include "graph/edge.hpp"
+#include "aging2_trace.hpp"
+#include "work_stealing_deque.hpp"
 
 // forward declarations
 namespace gfe::experiment::details { class Aging2Master; }
+namespace gfe::experiment::details { class DeltaLog; }
 namespace gfe::library { class UpdateInterface; }
 
 namespace gfe::experiment::details {
@@ -40,19 +46,40 @@ class Aging2Worker {
     library::UpdateInterface* m_library; // the library being evaluated
     const int m_worker_id; // this id is passed to the interface #on_worker_init and #on_worker_destroy
     common::CircularArray<std::vector<gfe::graph::WeightedEdge>*> m_updates; // the updates to perform
-    uint64_t m_updates_mem_usage {0}; // total amount of space used by the vectors `m_updates', in bytes
-    std::mt19937_64 m_random { std::random_device{}() }; // pseudo-random generator
+    std::atomic<uint64_t> m_updates_mem_usage {0}; // total amount of space used by the vectors `m_updates' or `m_tasks_updates', in bytes. Also updated by the thieves
+    std::mt19937_64 m_random; // pseudo-random generator, seeded with the seed of the experiment and the worker id
     std::uniform_real_distribution<double> m_uniform{ 0., 1. }; // uniform distribution in [0, 1]
     uint64_t* m_latency_insertions {nullptr};
     uint64_t m_num_edge_insertions {0}; // counter, total number of edge insertions to perform, as contained in the array m_updates
     uint64_t* m_latency_deletions {nullptr};
     uint64_t m_num_edge_deletions {0}; // counter, total number of edge deletions to perform, as contained in the array m_updates
     uint64_t m_update_batch_granularity= 16;
-    std::atomic<uint64_t> m_num_operations = 0; // counter, total number of operations performed so far
-
-    std::atomic<bool> m_is_in_library_code = false;
-
-    enum class TaskOp { IDLE, START, STOP, LOAD_EDGES, EXECUTE_UPDATES, REMOVE_VERTICES, SET_ARRAY_LATENCIES, EXECUTE_TRUE_UPDATES };
+    // counter, total number of operations performed so far. Only written by this worker, every num_operations_publish_interval
+    // operations, and read by the master. It sits in its own cache line, to avoid false sharing with the thieves & the master.
+    alignas(64) std::atomic<uint64_t> m_num_operations = 0;
+    static constexpr uint64_t num_operations_publish_interval = 64; // must be a power of 2
+
+    alignas(64) std::atomic<bool> m_is_in_library_code = false;
+    bool m_apply_noise; // whether to randomly swap the source and the destination of the edges (undirected graphs only)
+
+    // record & replay
+    std::unique_ptr<Aging2TraceWriter> m_trace_writer; // record the updates performed, if requested
+    std::unique_ptr<Aging2TraceReader> m_trace_reader; // the trace to replay, if requested
+    bool m_trace_ended = false; // whether all batches of the trace have been replayed
+    DeltaLog* m_delta_log {nullptr}; // record the updates performed for the incremental analytics, if requested
+
+    // work stealing
+    WorkStealingDeque m_tasks; // chunks of updates that can be executed by this worker or stolen by its peers
+    std::vector<graph::WeightedEdge> m_tasks_updates; // the updates of all chunks, sorted by chunk
+    std::vector<uint64_t> m_tasks_offsets; // the updates of the i-th chunk are in m_tasks_updates[m_tasks_offsets[i], m_tasks_offsets[i+1])
+    std::vector<uint64_t> m_tasks_insertions; // number of insertions in the chunks before the i-th chunk, to index the latency arrays
+    uint64_t* m_tasks_latency_insertions {nullptr}; // start of the latency array for the insertions of this worker
+    uint64_t* m_tasks_latency_deletions {nullptr}; // start of the latency array for the deletions of this worker
+    std::atomic<uint64_t> m_tasks_num_pending {0}; // number of chunks of this worker not executed yet. The last to complete releases m_tasks_updates
+    uint64_t m_num_tasks_stolen {0}; // counter, total number of chunks stolen from the other workers
+    std::chrono::steady_clock::time_point m_time_completion; // when this worker completed the last execution of the updates
+
+    enum class TaskOp { IDLE, START, STOP, LOAD_EDGES, EXECUTE_UPDATES, REMOVE_VERTICES, SET_ARRAY_LATENCIES, EXECUTE_TRUE_UPDATES, PREPARE_WORK_STEALING, LOAD_TRACE };
     struct Task { TaskOp m_type; uint64_t* m_payload; uint64_t m_payload_sz; };
     Task m_task; // current task being executed
 
@@ -75,9 +102,27 @@ class Aging2Worker {
     // load a batch of edges in the background thread
     void main_load_edges_even_split(uint64_t* edges, uint64_t num_edges);
 
+    // load the next batch of updates from the trace to replay, in the background thread
+    void main_load_trace();
+
     // execute the insert/delete operations for the graph in the background thread
     void main_execute_updates();
 
+    // split the updates to perform in chunks that can be stolen by the other workers
+    void main_prepare_work_stealing();
+
+    // execute the insert/delete operations, stealing chunks from the other workers once done with its own
+    void main_execute_updates_work_stealing();
+
+    // execute the given chunk of updates, owned by the given worker (possibly this one)
+    void execute_task(Aging2Worker* owner, uint64_t task_id);
+
+    // release the buffer m_tasks_updates, once all its chunks have been executed
+    void release_tasks_memory();
+
+    // record how long it took to perform 1x, 2x, ... updates w.r.t. the size of the final graph
+    void record_aging_coeff(uint64_t num_ops_done, int& lastset_coeff);
+
     void main_execute_true_updates(uint64_t* edges, uint64_t num_edges);
 
     // remote the artificial vertices, those that do not belong to the final graph, in the background thread
@@ -122,6 +167,12 @@ public:
 
     void load_edge(uint64_t source, uint64_t destination, double weight);
 
+    // Load the next batch of updates from the trace to replay
+    void load_trace();
+
+    // Whether all batches of the trace to replay have already been loaded
+    bool has_trace_ended() const;
+
     void execute_true_updates(uint64_t* edges, uint64_t num_edges);
 
     // Set the latency arrays for insertions and deletions
@@ -130,7 +181,10 @@ public:
     // Request the thread to execute all updates
     void execute_updates();
 
-    // Request to remove the vertices that do not belong to the final graph
+    // Request the thread to split the updates in chunks that can be stolen by other workers. It must be invoked before #execute_updates
+    void prepare_work_stealing();
+
+    // Request to remove the given vertices, that do not belong to the final graph. The whole array is processed by this worker.
     void remove_vertices(uint64_t* vertices, uint64_t num_vertices);
 
     // Wait for the last operation issued to complete
@@ -153,6 +207,12 @@ public:
 
     bool is_in_library_code() const;
 
+    // Total number of chunks stolen from the other workers
+    uint64_t num_tasks_stolen() const;
+
+    // When this worker completed the last execution of the updates
+    std::chrono::steady_clock::time_point time_completion() const;
+
     void print_workload(uint64_t start_entry, uint64_t num) const;
 
     void clear_edges();
@@ -0,0 +1,292 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "analytics_stream.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#if defined(HAVE_OPENMP)
+#include "omp.h"
+#endif
+
+#include "common/error.hpp"
+#include "common/system.hpp"
+#include "common/time.hpp"
+#include "common/timer.hpp"
+#include "experiment/aging2_experiment.hpp"
+#include "library/analytics_session.hpp"
+#include "library/interface.hpp"
+#include "utility/timeout_service.hpp"
+#include "utility/vertex_sampler.hpp"
+#include "configuration.hpp"
+#include "incremental_analytics.hpp"
+
+using namespace common;
+using namespace std;
+
+namespace gfe::experiment::details {
+
+/*****************************************************************************
+ *                                                                           *
+ *  Debug                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+//#define DEBUG
+#define COUT_DEBUG_FORCE(msg) { scoped_lock<mutex> lock(_log_mutex); cout << "[AnalyticsStream::" << __FUNCTION__ << "] [stream_id: " << m_stream_id << "] " << msg << endl; }
+#if defined(DEBUG)
+    #define COUT_DEBUG(msg) COUT_DEBUG_FORCE(msg)
+#else
+    #define COUT_DEBUG(msg)
+#endif
+
+/*****************************************************************************
+ *                                                                           *
+ *  Kernels                                                                  *
+ *                                                                           *
+ *****************************************************************************/
+string analytics_kernel_to_string(AnalyticsKernel kernel){
+    switch(kernel){
+    case AnalyticsKernel::BFS: return "bfs";
+    case AnalyticsKernel::PAGERANK: return "pagerank";
+    case AnalyticsKernel::SSSP: return "sssp";
+    case AnalyticsKernel::WCC: return "wcc";
+    case AnalyticsKernel::ONE_HOP: return "one_hop";
+    case AnalyticsKernel::TWO_HOPS: return "two_hops";
+    default: return "unknown";
+    }
+}
+
+AnalyticsKernel analytics_kernel_from_string(const string& name){
+    string kernel = name;
+    kernel.erase(std::remove_if(begin(kernel), end(kernel), ::isspace), end(kernel));
+    transform(begin(kernel), end(kernel), begin(kernel), ::tolower);
+    if(kernel == "bfs"){
+        return AnalyticsKernel::BFS;
+    } else if (kernel == "pagerank" || kernel == "pr"){
+        return AnalyticsKernel::PAGERANK;
+    } else if (kernel == "sssp"){
+        return AnalyticsKernel::SSSP;
+    } else if (kernel == "wcc"){
+        return AnalyticsKernel::WCC;
+    } else if (kernel == "one_hop" || kernel == "1hop"){
+        return AnalyticsKernel::ONE_HOP;
+    } else if (kernel == "two_hops" || kernel == "2hop"){
+        return AnalyticsKernel::TWO_HOPS;
+    } else {
+        INVALID_ARGUMENT("Invalid kernel: `" << name << "'. Expected one of bfs, pagerank, sssp, wcc, one_hop or two_hops");
+    }
+}
+
+vector<AnalyticsStreamSpec> analytics_streams_from_string(const string& value){
+    vector<AnalyticsStreamSpec> streams;
+
+    stringstream ss_streams { value };
+    string stream;
+    while(getline(ss_streams, stream, ',')){
+        auto colon = stream.find(':');
+        if(colon == string::npos){ INVALID_ARGUMENT("Invalid stream: `" << stream << "'. Expected <num_threads>:<kernel>+<kernel>+..."); }
+
+        AnalyticsStreamSpec spec;
+        try {
+            spec.m_num_threads = stoi(stream.substr(0, colon));
+        } catch(std::logic_error& e){
+            INVALID_ARGUMENT("Invalid number of threads in the stream: `" << stream << "'");
+        }
+        if(spec.m_num_threads < 0){ INVALID_ARGUMENT("Negative number of threads in the stream: `" << stream << "'"); }
+
+        stringstream ss_kernels { stream.substr(colon +1) };
+        string kernel;
+        while(getline(ss_kernels, kernel, '+')){
+            spec.m_kernels.push_back( analytics_kernel_from_string(kernel) );
+        }
+        if(spec.m_kernels.empty()){ INVALID_ARGUMENT("No kernels given for the stream: `" << stream << "'"); }
+
+        streams.push_back(spec);
+    }
+
+    return streams;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  AnalyticsStream                                                          *
+ *                                                                           *
+ *****************************************************************************/
+AnalyticsStream::AnalyticsStream(library::GraphalyticsInterface* interface, Aging2Experiment& aging_experiment, std::mutex* kernel_mutex, const GraphalyticsAlgorithms& properties, int stream_id, const AnalyticsStreamSpec& spec, const std::atomic<int>& window, IncrementalAnalytics* incremental) :
+        m_interface(interface), m_aging_experiment(aging_experiment), m_kernel_mutex(kernel_mutex), m_properties(properties), m_stream_id(stream_id), m_spec(spec), m_window(window), m_kernels_enabled(spec.m_kernels.size(), true),
+        m_materialize_csr(configuration().get_analytics_csr()), m_incremental(incremental) {
+    assert(m_interface != nullptr);
+}
+
+AnalyticsStream::~AnalyticsStream(){
+    join();
+}
+
+void AnalyticsStream::start(){
+    assert(!m_thread.joinable() && "Already started");
+    m_thread = thread(&AnalyticsStream::main_thread, this);
+}
+
+void AnalyticsStream::join(){
+    if(m_thread.joinable()){
+        m_thread.join();
+    }
+}
+
+void AnalyticsStream::main_thread(){
+    concurrency::set_thread_name("Analytics #" + to_string(m_stream_id));
+    utility::VertexSampler::set_thread_id(m_stream_id +1); // 0 is the main thread
+
+#if defined(HAVE_OPENMP)
+    // the number of threads is an ICV of the calling thread, it only affects the parallel regions started by this stream
+    if(m_spec.m_num_threads > 0){ omp_set_num_threads(m_spec.m_num_threads); }
+#endif
+
+    uint64_t next_kernel = 0;
+    const uint64_t num_kernels = m_spec.m_kernels.size();
+    bool registered = false; // whether the thread has been registered with the library
+
+    while(true){
+        int window = m_window.load();
+        if(window == WORKLOAD_DONE || (registered && m_aging_experiment.is_auxiliary_terminating())){
+            break;
+        } else if(window == WINDOW_CLOSED || none_of(begin(m_kernels_enabled), end(m_kernels_enabled), [](bool b){ return b; })){
+            this_thread::sleep_for(1ms);
+            continue;
+        }
+
+        // the first window opens once the aging experiment has initialised the library
+        if(!registered){
+            registered = m_aging_experiment.auxiliary_thread_init(m_stream_id);
+            if(!registered) break; // the experiment is already over
+        }
+
+        // pick the next kernel still enabled
+        while(!m_kernels_enabled[next_kernel]){ next_kernel = (next_kernel +1) % num_kernels; }
+        AnalyticsKernel kernel = m_spec.m_kernels[next_kernel];
+
+        int64_t completion_time = -1;
+        int64_t materialization_time = -1;
+        int64_t incremental_time = -1;
+        bool incremental_from_scratch = false;
+        try {
+            unique_lock<mutex> lock;
+            if(m_kernel_mutex != nullptr){ lock = unique_lock<mutex>(*m_kernel_mutex); }
+            completion_time = execute_kernel(kernel, materialization_time);
+            COUT_DEBUG("window: " << window << ", kernel: " << analytics_kernel_to_string(kernel) << ", completion time: " << completion_time << " us");
+            incremental_time = refresh_kernel(kernel, incremental_from_scratch);
+        } catch(library::TimeoutError& e){
+            LOG("[AnalyticsStream] Stream #" << m_stream_id << ", " << analytics_kernel_to_string(kernel) << " TIMEOUT, overrun: " << common::time::to_string(utility::TimeoutService::last_overrun()));
+            m_kernels_enabled[next_kernel] = false;
+        }
+
+        m_executions.push_back(AnalyticsExecution{ window, m_stream_id, kernel, completion_time, materialization_time, incremental_time, incremental_from_scratch });
+        next_kernel = (next_kernel +1) % num_kernels;
+    }
+
+    if(registered){ m_aging_experiment.auxiliary_thread_destroy(m_stream_id); }
+}
+
+int64_t AnalyticsStream::execute_kernel(AnalyticsKernel kernel, int64_t& materialization_time){
+    Timer timer;
+    vector<uint64_t> vertices;
+
+    // copy the current snapshot into a CSR, the following kernel runs on the copy
+    unique_ptr<library::AnalyticsSession> session;
+    if(m_materialize_csr && kernel != AnalyticsKernel::ONE_HOP && kernel != AnalyticsKernel::TWO_HOPS){
+        timer.start();
+        session = m_interface->begin_analytics_session();
+        bool materialized = session->materialize_csr();
+        timer.stop();
+        if(materialized){
+            materialization_time = timer.microseconds();
+        } else {
+            LOG("[AnalyticsStream] Stream #" << m_stream_id << ", the library does not support the materialisation into a CSR, running the kernels on the library");
+            m_materialize_csr = false;
+            session.reset();
+        }
+    }
+
+    switch(kernel){
+    case AnalyticsKernel::BFS:
+        timer.start();
+        if(session){ session->bfs(m_properties.bfs.m_source_vertex); } else { m_interface->bfs(m_properties.bfs.m_source_vertex); }
+        timer.stop();
+        break;
+    case AnalyticsKernel::PAGERANK:
+        timer.start();
+        if(session){
+            session->pagerank(m_properties.pagerank.m_num_iterations, m_properties.pagerank.m_damping_factor);
+        } else {
+            m_interface->pagerank(m_properties.pagerank.m_num_iterations, m_properties.pagerank.m_damping_factor);
+        }
+        timer.stop();
+        break;
+    case AnalyticsKernel::SSSP:
+        timer.start();
+        if(session){ session->sssp(m_properties.sssp.m_source_vertex); } else { m_interface->sssp(m_properties.sssp.m_source_vertex); }
+        timer.stop();
+        break;
+    case AnalyticsKernel::WCC:
+        timer.start();
+        if(session){ session->wcc(); } else { m_interface->wcc(); }
+        timer.stop();
+        break;
+    case AnalyticsKernel::ONE_HOP:
+        m_interface->generate_two_hops_neighbor_candidates(vertices); // not timed
+        timer.start();
+        m_interface->one_hop_neighbors(vertices);
+        timer.stop();
+        break;
+    case AnalyticsKernel::TWO_HOPS:
+        m_interface->generate_two_hops_neighbor_candidates(vertices); // not timed
+        timer.start();
+        m_interface->two_hop_neighbors(vertices);
+        timer.stop();
+        break;
+    }
+
+    return timer.microseconds();
+}
+
+int64_t AnalyticsStream::refresh_kernel(AnalyticsKernel kernel, bool& from_scratch){
+    if(m_incremental == nullptr) return -1;
+
+    Timer timer;
+    switch(kernel){
+    case AnalyticsKernel::PAGERANK:
+        timer.start();
+        from_scratch = !m_incremental->pagerank(m_properties.pagerank.m_num_iterations, m_properties.pagerank.m_damping_factor);
+        timer.stop();
+        break;
+    case AnalyticsKernel::WCC:
+        timer.start();
+        from_scratch = !m_incremental->wcc();
+        timer.stop();
+        break;
+    default:
+        return -1; // only PageRank and WCC can be refreshed
+    }
+
+    return timer.microseconds();
+}
+
+} // namespace
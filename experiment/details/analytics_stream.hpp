@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "experiment/graphalytics.hpp"
+
+// forward declarations
+namespace gfe::experiment { class Aging2Experiment; }
+namespace gfe::library { class GraphalyticsInterface; }
+
+namespace gfe::experiment::details {
+
+class IncrementalAnalytics; // forward declaration
+
+/**
+ * The kernels that can be executed by an analytics stream in the mixed workload
+ */
+enum class AnalyticsKernel { BFS, PAGERANK, SSSP, WCC, ONE_HOP, TWO_HOPS };
+
+// Retrieve the name of the kernel, as used in the command line and in the database
+std::string analytics_kernel_to_string(AnalyticsKernel kernel);
+
+// Parse the name of a kernel: bfs, pagerank (or pr), sssp, wcc, one_hop (or 1hop), two_hops (or 2hop). It throws an exception if the name is not recognised.
+AnalyticsKernel analytics_kernel_from_string(const std::string& name);
+
+/**
+ * The configuration of a single analytics stream
+ */
+struct AnalyticsStreamSpec {
+    int m_num_threads = 0; // the number of OpenMP threads for the kernels of this stream, 0 => default of OpenMP
+    std::vector<AnalyticsKernel> m_kernels; // the kernels to execute, one after the other, in round robin
+};
+
+/**
+ * Parse a comma separated list of streams, each in the form <num_threads>:<kernel>+<kernel>+...
+ * For instance "4:bfs+pagerank,2:one_hop+two_hops" defines two streams, the first with four threads
+ * alternating BFS and PageRank, the second with two threads alternating 1-hop and 2-hop expansions.
+ */
+std::vector<AnalyticsStreamSpec> analytics_streams_from_string(const std::string& value);
+
+/**
+ * A single execution of a kernel in an analytics stream
+ */
+struct AnalyticsExecution {
+    int m_window; // the window when the execution started
+    int m_stream; // the stream that executed the kernel
+    AnalyticsKernel m_kernel; // the kernel executed
+    int64_t m_completion_time; // in microsecs, or -1 if the execution timed out
+    int64_t m_materialization_time; // the time to open the snapshot and copy it into a CSR before the kernel, in microsecs, or -1 if not materialised
+    int64_t m_incremental_time; // the time to refresh the previous results of PageRank and WCC after the kernel, in microsecs, or -1 if not refreshed
+    bool m_incremental_from_scratch; // whether the refresh had to recompute the results from scratch (first execution, edges removed in WCC)
+};
+
+/**
+ * A background thread that keeps executing the kernels of its stream while a window of the mixed workload is open
+ */
+class AnalyticsStream {
+    AnalyticsStream(const AnalyticsStream&) = delete;
+    AnalyticsStream& operator=(const AnalyticsStream&) = delete;
+
+public:
+    constexpr static int WINDOW_CLOSED = -1; // no window is currently open, wait
+    constexpr static int WORKLOAD_DONE = -2; // no more windows to process, terminate the thread
+
+private:
+    library::GraphalyticsInterface* m_interface; // the library being evaluated
+    Aging2Experiment& m_aging_experiment; // the thread is registered with the library as an auxiliary thread of the aging experiment
+    std::mutex* m_kernel_mutex; // if set, the kernels of all streams are executed one at the time
+    const GraphalyticsAlgorithms& m_properties; // the parameters of the kernels (source vertices, iterations, ...)
+    const int m_stream_id; // the ID of this stream
+    const AnalyticsStreamSpec m_spec; // the kernels to execute and the number of threads
+    const std::atomic<int>& m_window; // the window currently open, or one of the special values WINDOW_CLOSED and WORKLOAD_DONE
+    std::vector<bool> m_kernels_enabled; // whether the i-th kernel in m_spec.m_kernels can still be executed, it's disabled after a timeout
+    bool m_materialize_csr; // whether to copy the snapshot into a CSR before BFS, PageRank, SSSP and WCC
+    IncrementalAnalytics* m_incremental; // if set, refresh the previous results of PageRank and WCC after their execution
+    std::vector<AnalyticsExecution> m_executions; // the executions performed so far
+    std::thread m_thread; // the background thread
+
+    // the controller of the background thread
+    void main_thread();
+
+    // execute the given kernel, return its completion time in microsecs. The time to materialise the CSR, if any, is set in `materialization_time'
+    int64_t execute_kernel(AnalyticsKernel kernel, int64_t& materialization_time);
+
+    // refresh the previous results of the given kernel, return the time elapsed in microsecs, or -1 if the kernel cannot be refreshed
+    int64_t refresh_kernel(AnalyticsKernel kernel, bool& from_scratch);
+
+public:
+    /**
+     * Create a new stream. The background thread is not started until #start is invoked.
+     * @param interface the library to evaluate
+     * @param aging_experiment the experiment performing the updates. The stream is its auxiliary thread `stream_id'
+     * @param kernel_mutex if not null, acquired while executing a kernel, for the libraries that cannot run multiple kernels concurrently
+     * @param properties the parameters of the kernels
+     * @param stream_id the ID of this stream, it's only recorded in the executions
+     * @param spec the kernels to execute and the size of the OpenMP team
+     * @param window the window currently open, set by the scheduler
+     * @param incremental if not null, refresh the previous results of PageRank and WCC after their execution
+     */
+    AnalyticsStream(library::GraphalyticsInterface* interface, Aging2Experiment& aging_experiment, std::mutex* kernel_mutex, const GraphalyticsAlgorithms& properties, int stream_id, const AnalyticsStreamSpec& spec, const std::atomic<int>& window, IncrementalAnalytics* incremental = nullptr);
+
+    // Destructor. It waits for the background thread to terminate.
+    ~AnalyticsStream();
+
+    // Start the background thread
+    void start();
+
+    // Wait for the background thread to terminate. The scheduler must set the window to WORKLOAD_DONE beforehand.
+    void join();
+
+    // Retrieve the executions performed, only valid after #join
+    const std::vector<AnalyticsExecution>& executions() const { return m_executions; }
+};
+
+} // namespace
@@ -0,0 +1,447 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "incremental_analytics.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <tuple>
+
+#include "common/error.hpp"
+#include "library/interface.hpp"
+
+using namespace std;
+
+namespace gfe::experiment::details {
+
+/*****************************************************************************
+ *                                                                           *
+ *  DeltaLog                                                                 *
+ *                                                                           *
+ *****************************************************************************/
+DeltaLog::DeltaLog(uint64_t num_shards) : m_num_shards(num_shards), m_shards(new Shard[num_shards]){
+    if(num_shards == 0){ INVALID_ARGUMENT("The number of shards must be positive"); }
+}
+
+void DeltaLog::enable(){
+    m_enabled = true;
+}
+
+void DeltaLog::drain(vector<Entry>& output){
+    // the updates reserved from now on will have a sequence number >= watermark
+    uint64_t watermark = m_next_sequence.load();
+    for(uint64_t i = 0; i < m_num_shards; i++){
+        Shard& shard = m_shards[i];
+        scoped_lock<mutex> lock(shard.m_mutex);
+        for(uint64_t sequence : shard.m_pending){ watermark = min(watermark, sequence); }
+    }
+
+    // only drain the updates preceding the oldest one still in progress
+    const uint64_t output_start = output.size();
+    for(uint64_t i = 0; i < m_num_shards; i++){
+        Shard& shard = m_shards[i];
+        scoped_lock<mutex> lock(shard.m_mutex);
+        auto it = stable_partition(begin(shard.m_entries), end(shard.m_entries), [watermark](const Entry& e){ return e.m_sequence < watermark; });
+        output.insert(end(output), begin(shard.m_entries), it);
+        shard.m_entries.erase(begin(shard.m_entries), it);
+    }
+
+    sort(begin(output) + output_start, end(output), [](const Entry& e1, const Entry& e2){ return e1.m_sequence < e2.m_sequence; });
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Net changes                                                              *
+ *                                                                           *
+ *****************************************************************************/
+namespace {
+
+struct EdgeHash {
+    size_t operator()(const pair<uint64_t, uint64_t>& edge) const {
+        return hash<uint64_t>{}(edge.first * 0x9E3779B97F4A7C15ull ^ edge.second);
+    }
+};
+
+// An edge in the dense vertex IDs, with its net change in the delta: +1 if it has been inserted, -1 if it has been removed
+using EdgeChange = tuple<uint64_t, uint64_t, int>;
+
+} // anon namespace
+
+// Compute the edges whose existence changed in the delta. An edge existed before the delta if its first update is a
+// removal and it exists after the delta if its last update is an insertion. In undirected graphs, the edges are
+// normalised so that source < destination.
+static vector<EdgeChange> net_changes(const vector<DeltaLog::Entry>& delta, const unordered_map<uint64_t, uint64_t>& ext2dense, bool is_directed){
+    unordered_map<pair<uint64_t, uint64_t>, pair<bool, bool>, EdgeHash> edges; // edge -> <first update is an insertion, last update is an insertion>
+    for(const auto& entry : delta){
+        uint64_t source = ext2dense.at(entry.m_source);
+        uint64_t destination = ext2dense.at(entry.m_destination);
+        if(source == destination) continue; // ignore self loops
+        if(!is_directed && source > destination) swap(source, destination);
+
+        auto it = edges.find(make_pair(source, destination));
+        if(it == edges.end()){
+            edges.emplace(make_pair(source, destination), make_pair(entry.m_insertion, entry.m_insertion));
+        } else {
+            it->second.second = entry.m_insertion;
+        }
+    }
+
+    vector<EdgeChange> result;
+    for(const auto& e : edges){
+        bool existed_before = !e.second.first;
+        bool exists_now = e.second.second;
+        if(existed_before != exists_now){
+            result.emplace_back(e.first.first, e.first.second, exists_now ? +1 : -1);
+        }
+    }
+    return result;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Init                                                                     *
+ *                                                                           *
+ *****************************************************************************/
+IncrementalAnalytics::IncrementalAnalytics(library::GraphalyticsInterface* interface, shared_ptr<DeltaLog> delta_log, const vector<uint64_t>& vertices) :
+        m_interface(interface), m_delta_log(delta_log) {
+    assert(m_interface != nullptr);
+    if(m_delta_log.get() == nullptr){ INVALID_ARGUMENT("The delta log is required"); }
+    for(uint64_t vertex : vertices){ add_vertex(vertex); }
+}
+
+uint64_t IncrementalAnalytics::add_vertex(uint64_t external_id){
+    auto it = m_ext2dense.find(external_id);
+    if(it != m_ext2dense.end()) return it->second;
+
+    uint64_t vertex_id = m_vertices.size();
+    m_vertices.push_back(external_id);
+    m_ext2dense[external_id] = vertex_id;
+    if(m_pagerank_valid){ m_ranks.push_back(0.0); }
+    if(m_wcc_valid){ m_parents.push_back(vertex_id); }
+    return vertex_id;
+}
+
+void IncrementalAnalytics::collect_delta(){
+    vector<DeltaLog::Entry> delta;
+    m_delta_log->drain(delta);
+    for(const auto& entry : delta){
+        add_vertex(entry.m_source);
+        add_vertex(entry.m_destination);
+    }
+
+    if(m_pagerank_valid){ m_pagerank_delta.insert(end(m_pagerank_delta), begin(delta), end(delta)); }
+    if(m_wcc_valid){ m_wcc_delta.insert(end(m_wcc_delta), begin(delta), end(delta)); }
+}
+
+void IncrementalAnalytics::discover_vertices(){
+    vector<uint64_t> frontier(m_vertices.size());
+    iota(begin(frontier), end(frontier), 0);
+
+    while(!frontier.empty()){
+        vector<uint64_t> unknown; // external vertex IDs
+
+        #pragma omp parallel
+        {
+            vector<uint64_t> local;
+
+            #pragma omp for schedule(dynamic, 64)
+            for(uint64_t i = 0; i < frontier.size(); i++){
+                m_interface->scan_neighbors(m_vertices[frontier[i]], [&](uint64_t destination, double){
+                    if(m_ext2dense.count(destination) == 0){ local.push_back(destination); }
+                    return true;
+                });
+            }
+
+            #pragma omp critical
+            unknown.insert(end(unknown), begin(local), end(local));
+        }
+
+        frontier.clear();
+        for(uint64_t external_id : unknown){
+            if(m_ext2dense.count(external_id) == 0){
+                frontier.push_back(add_vertex(external_id));
+            }
+        }
+    }
+}
+
+void IncrementalAnalytics::neighbours(uint64_t vertex_id, vector<uint64_t>& output) const {
+    output.clear();
+    m_interface->scan_neighbors(m_vertices[vertex_id], [&](uint64_t destination, double){
+        auto it = m_ext2dense.find(destination);
+        if(it != m_ext2dense.end()){ output.push_back(it->second); } // vertices created after the last delta are skipped
+        return true;
+    });
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  PageRank                                                                 *
+ *                                                                           *
+ *****************************************************************************/
+bool IncrementalAnalytics::pagerank(uint64_t num_iterations, double damping_factor){
+    scoped_lock<mutex> lock(m_mutex);
+    m_delta_log->enable(); // before scanning the graph, the updates performed meanwhile are refreshed by the next execution
+    collect_delta();
+
+    if(!m_pagerank_valid){
+        pagerank_full(num_iterations, damping_factor);
+        return false;
+    } else {
+        pagerank_refresh(num_iterations, damping_factor);
+        return true;
+    }
+}
+
+void IncrementalAnalytics::pagerank_full(uint64_t num_iterations, double damping_factor){
+    discover_vertices();
+    const uint64_t num_vertices = m_vertices.size();
+    m_ranks.assign(num_vertices, num_vertices == 0 ? 0.0 : 1.0 / num_vertices);
+    m_pagerank_delta.clear();
+    m_pagerank_num_vertices = num_vertices;
+    m_pagerank_valid = true;
+    if(num_vertices == 0) return;
+
+    vector<double> next_ranks(num_vertices, 0.0);
+    for(uint64_t iteration = 0; iteration < num_iterations; iteration++){
+        double dangling_sum = 0.0; // the ranks of the vertices without outgoing edges
+
+        #pragma omp parallel
+        {
+            vector<uint64_t> edges;
+
+            #pragma omp for schedule(dynamic, 64) reduction(+:dangling_sum)
+            for(uint64_t v = 0; v < num_vertices; v++){
+                neighbours(v, edges);
+                if(edges.empty()){
+                    dangling_sum += m_ranks[v];
+                } else {
+                    double contribution = damping_factor * m_ranks[v] / edges.size();
+                    for(uint64_t w : edges){
+                        #pragma omp atomic
+                        next_ranks[w] += contribution;
+                    }
+                }
+            }
+        }
+
+        const double base = (1.0 - damping_factor) / num_vertices + damping_factor * dangling_sum / num_vertices;
+        #pragma omp parallel for
+        for(uint64_t v = 0; v < num_vertices; v++){
+            m_ranks[v] = base + next_ranks[v];
+            next_ranks[v] = 0.0;
+        }
+    }
+}
+
+void IncrementalAnalytics::pagerank_refresh(uint64_t num_iterations, double damping_factor){
+    if(m_pagerank_delta.empty()) return;
+    const uint64_t num_vertices = m_vertices.size();
+    const double base = (1.0 - damping_factor) / num_vertices;
+    vector<double> residuals(num_vertices, 0.0);
+
+    // the vertices created since the last execution have a rank of 0 so far
+    for(uint64_t v = m_pagerank_num_vertices; v < num_vertices; v++){ residuals[v] = base; }
+
+    // group the edges changed by their source
+    unordered_map<uint64_t, vector<pair<uint64_t, int>>> changes; // source -> [<destination, +1 inserted or -1 removed>]
+    const bool is_directed = m_interface->is_directed();
+    for(const auto& change : net_changes(m_pagerank_delta, m_ext2dense, is_directed)){
+        changes[get<0>(change)].emplace_back(get<1>(change), get<2>(change));
+        if(!is_directed){ changes[get<1>(change)].emplace_back(get<0>(change), get<2>(change)); }
+    }
+    m_pagerank_delta.clear();
+    vector<uint64_t> sources;
+    sources.reserve(changes.size());
+    for(auto& c : changes){
+        sort(begin(c.second), end(c.second));
+        sources.push_back(c.first);
+    }
+
+    // the contribution of each source updated is now split among its new adjacency. Set the difference with the
+    // contribution received so far as the residual of its neighbours, old and new
+    #pragma omp parallel
+    {
+        vector<uint64_t> edges;
+
+        #pragma omp for schedule(dynamic, 16)
+        for(uint64_t i = 0; i < sources.size(); i++){
+            const uint64_t u = sources[i];
+            const double rank = m_ranks[u];
+            if(rank == 0.0) continue; // nothing to redistribute
+            const auto& delta = changes.at(u);
+            int64_t num_inserted = count_if(begin(delta), end(delta), [](const pair<uint64_t, int>& c){ return c.second > 0; });
+            int64_t num_removed = delta.size() - num_inserted;
+
+            neighbours(u, edges);
+            const int64_t degree_new = edges.size();
+            const int64_t degree_old = max<int64_t>(0, degree_new - num_inserted + num_removed);
+            const double contribution_new = degree_new > 0 ? damping_factor * rank / degree_new : 0.0;
+            const double contribution_old = degree_old > 0 ? damping_factor * rank / degree_old : 0.0;
+
+            for(uint64_t w : edges){
+                auto it = lower_bound(begin(delta), end(delta), make_pair(w, numeric_limits<int>::min()));
+                bool inserted = it != end(delta) && it->first == w && it->second > 0;
+                double residual = inserted ? contribution_new : contribution_new - contribution_old;
+
+                #pragma omp atomic
+                residuals[w] += residual;
+            }
+
+            for(const auto& c : delta){
+                if(c.second > 0) continue;
+
+                #pragma omp atomic
+                residuals[c.first] -= contribution_old;
+            }
+        }
+    }
+
+    // propagate the residuals, at most num_iterations rounds
+    const double threshold = PAGERANK_TOLERANCE * base;
+    vector<uint64_t> frontier;
+    for(uint64_t round = 0; round < num_iterations; round++){
+        frontier.clear();
+        for(uint64_t v = 0; v < num_vertices; v++){
+            if(fabs(residuals[v]) > threshold){ frontier.push_back(v); }
+        }
+        if(frontier.empty()) break;
+
+        #pragma omp parallel
+        {
+            vector<uint64_t> edges;
+
+            #pragma omp for schedule(dynamic, 64)
+            for(uint64_t i = 0; i < frontier.size(); i++){
+                const uint64_t v = frontier[i];
+                double residual;
+                #pragma omp atomic capture
+                { residual = residuals[v]; residuals[v] = 0.0; }
+
+                m_ranks[v] += residual;
+                neighbours(v, edges);
+                if(edges.empty()) continue;
+                const double contribution = damping_factor * residual / edges.size();
+                for(uint64_t w : edges){
+                    #pragma omp atomic
+                    residuals[w] += contribution;
+                }
+            }
+        }
+    }
+
+    m_pagerank_num_vertices = num_vertices;
+}
+
+double IncrementalAnalytics::get_rank(uint64_t external_id) const {
+    scoped_lock<mutex> lock(m_mutex);
+    auto it = m_ext2dense.find(external_id);
+    if(it == m_ext2dense.end() || it->second >= m_ranks.size()) return 0.0;
+    return m_ranks[it->second];
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  WCC                                                                      *
+ *                                                                           *
+ *****************************************************************************/
+bool IncrementalAnalytics::wcc(){
+    scoped_lock<mutex> lock(m_mutex);
+    m_delta_log->enable();
+    collect_delta();
+
+    if(!m_wcc_valid){
+        wcc_full();
+        return false;
+    }
+
+    auto changes = net_changes(m_wcc_delta, m_ext2dense, m_interface->is_directed());
+    m_wcc_delta.clear();
+    if(any_of(begin(changes), end(changes), [](const EdgeChange& c){ return get<2>(c) < 0; })){
+        wcc_full(); // an edge has been removed, a component may have been split
+        return false;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(uint64_t i = 0; i < changes.size(); i++){
+        wcc_link(get<0>(changes[i]), get<1>(changes[i]));
+    }
+
+    return true;
+}
+
+void IncrementalAnalytics::wcc_full(){
+    discover_vertices();
+    const uint64_t num_vertices = m_vertices.size();
+    m_parents.resize(num_vertices);
+    m_wcc_delta.clear();
+    m_wcc_valid = true;
+
+    #pragma omp parallel for
+    for(uint64_t v = 0; v < num_vertices; v++){ m_parents[v] = v; }
+
+    #pragma omp parallel
+    {
+        vector<uint64_t> edges;
+
+        #pragma omp for schedule(dynamic, 64)
+        for(uint64_t v = 0; v < num_vertices; v++){
+            neighbours(v, edges);
+            for(uint64_t w : edges){ wcc_link(v, w); }
+        }
+    }
+}
+
+uint64_t IncrementalAnalytics::wcc_find(uint64_t vertex_id){
+    while(true){
+        uint64_t parent = __atomic_load_n(&m_parents[vertex_id], __ATOMIC_RELAXED);
+        if(parent == vertex_id) return vertex_id;
+        uint64_t grandparent = __atomic_load_n(&m_parents[parent], __ATOMIC_RELAXED);
+        if(grandparent != parent){ // path halving
+            __atomic_compare_exchange_n(&m_parents[vertex_id], &parent, grandparent, /* weak */ false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+        vertex_id = grandparent;
+    }
+}
+
+void IncrementalAnalytics::wcc_link(uint64_t vertex1, uint64_t vertex2){
+    while(true){
+        uint64_t root1 = wcc_find(vertex1);
+        uint64_t root2 = wcc_find(vertex2);
+        if(root1 == root2) return;
+        if(root1 < root2) swap(root1, root2); // the root of a component is always its smallest vertex
+
+        uint64_t expected = root1;
+        if(__atomic_compare_exchange_n(&m_parents[root1], &expected, root2, /* weak */ false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) return;
+
+        // another thread attached root1 meanwhile, try again
+        vertex1 = root1;
+        vertex2 = root2;
+    }
+}
+
+uint64_t IncrementalAnalytics::get_component(uint64_t external_id){
+    scoped_lock<mutex> lock(m_mutex);
+    auto it = m_ext2dense.find(external_id);
+    if(it == m_ext2dense.end() || it->second >= m_parents.size()){ INVALID_ARGUMENT("The components of the vertex " << external_id << " are unknown"); }
+    return m_vertices[wcc_find(it->second)];
+}
+
+} // namespace
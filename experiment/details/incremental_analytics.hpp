@@ -0,0 +1,205 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// forward declarations
+namespace gfe::library { class GraphalyticsInterface; }
+
+namespace gfe::experiment::details {
+
+/**
+ * The edges inserted and removed by the aging workers since the last time the log was drained. The log does not record
+ * anything until it is enabled, so that it does not cost anything to the workers when the incremental analytics are
+ * not executed.
+ *
+ * The log is split in shards, one for each worker, so that the workers do not contend on the same lock. The updates to
+ * the same edge can be performed by different workers, e.g. with work stealing or in different batches, hence each
+ * update is stamped with a global sequence number before it is executed by the library. An update that depends on
+ * another one (e.g. the removal of an edge just inserted) can only start after the latter completed, so the sequence
+ * numbers follow the order of the updates to the same edge. The log is drained up to the oldest update still being
+ * executed, and sorted by sequence number.
+ */
+class DeltaLog {
+    DeltaLog(const DeltaLog&) = delete;
+    DeltaLog& operator=(const DeltaLog&) = delete;
+
+public:
+    struct Entry {
+        uint64_t m_sequence; // the global order of the update
+        uint64_t m_source; // the source of the edge
+        uint64_t m_destination; // the destination of the edge
+        bool m_insertion; // true if the edge has been inserted, false if it has been removed
+    };
+
+private:
+    struct alignas(64) Shard {
+        std::mutex m_mutex; // sync the worker with the consumer
+        std::vector<Entry> m_entries; // the updates recorded so far
+        std::vector<uint64_t> m_pending; // the sequence numbers of the updates reserved but not recorded yet
+    };
+
+    const uint64_t m_num_shards; // the number of shards
+    std::unique_ptr<Shard[]> m_shards; // the updates recorded, split by worker
+    std::atomic<bool> m_enabled = false; // whether to record the updates
+    std::atomic<uint64_t> m_next_sequence = 1; // the sequence number for the next update, 0 is reserved for the updates not recorded
+
+public:
+    // Create a new log, initially disabled
+    DeltaLog(uint64_t num_shards = 64);
+
+    // Start recording the updates
+    void enable();
+
+    // Check whether the updates are being recorded
+    bool is_enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // Reserve the sequence number for an update the given worker is about to execute. It returns 0 if the log is not enabled.
+    uint64_t reserve(uint64_t worker_id){
+        if(!is_enabled()) return 0;
+        Shard& shard = m_shards[worker_id % m_num_shards];
+        std::scoped_lock<std::mutex> lock(shard.m_mutex);
+        uint64_t sequence = m_next_sequence.fetch_add(1);
+        shard.m_pending.push_back(sequence);
+        return sequence;
+    }
+
+    // Record an update performed by the given worker, with the sequence number previously reserved. It is a nop if the
+    // sequence number is 0, that is, the log was not enabled when the update started.
+    void append(uint64_t worker_id, uint64_t sequence, uint64_t source, uint64_t destination, bool insertion){
+        if(sequence == 0) return;
+        Shard& shard = m_shards[worker_id % m_num_shards];
+        std::scoped_lock<std::mutex> lock(shard.m_mutex);
+        shard.m_entries.push_back(Entry{ sequence, source, destination, insertion });
+        shard.m_pending.erase(std::find(std::begin(shard.m_pending), std::end(shard.m_pending), sequence));
+    }
+
+    // Record an update already performed by the given worker. It is a nop if the log is not enabled.
+    void append(uint64_t worker_id, uint64_t source, uint64_t destination, bool insertion){
+        append(worker_id, reserve(worker_id), source, destination, insertion);
+    }
+
+    // Move the entries recorded so far at the end of `output', sorted by sequence number, and remove them from the log.
+    // The entries that follow an update still in progress are retained for the next drain.
+    void drain(std::vector<Entry>& output);
+};
+
+/**
+ * Keep the results of the last execution of PageRank and WCC, and refresh them with the updates recorded in the delta
+ * log since then, rather than recomputing them from scratch:
+ * - PageRank propagates the change in the contributions of the sources updated, as residuals, until all residuals are
+ *   below a tolerance or the given number of rounds elapsed;
+ * - WCC merges the components of the edges inserted with a concurrent union-find. If any edge has been removed, the
+ *   components may split, and they are recomputed from scratch.
+ *
+ * The graph is accessed with GraphalyticsInterface#scan_neighbors, in the external vertex IDs. The first execution of
+ * each kernel always computes the results from scratch, starting from the given population of vertices and from the
+ * vertices reachable from it. The incremental PageRank is an approximation: the changes in the number of vertices and in
+ * the total rank of the sink vertices, which the computation from scratch spreads over the whole graph, are neglected.
+ *
+ * This class is thread safe, the kernels are serialised.
+ */
+class IncrementalAnalytics {
+    IncrementalAnalytics(const IncrementalAnalytics&) = delete;
+    IncrementalAnalytics& operator=(const IncrementalAnalytics&) = delete;
+
+    library::GraphalyticsInterface* m_interface; // the library being evaluated
+    std::shared_ptr<DeltaLog> m_delta_log; // the updates performed by the aging workers
+    mutable std::mutex m_mutex; // serialise the kernels
+    std::vector<uint64_t> m_vertices; // map the dense vertex IDs, used in the results, into the external vertex IDs
+    std::unordered_map<uint64_t, uint64_t> m_ext2dense; // map the external vertex IDs into the dense vertex IDs
+
+    bool m_pagerank_valid = false; // whether the ranks have been computed at least once
+    std::vector<double> m_ranks; // the last ranks computed, for each dense vertex ID
+    uint64_t m_pagerank_num_vertices = 0; // the number of vertices in the last computation of the ranks
+    std::vector<DeltaLog::Entry> m_pagerank_delta; // the updates not yet reflected in the ranks
+
+    bool m_wcc_valid = false; // whether the components have been computed at least once
+    std::vector<uint64_t> m_parents; // union-find of the components, for each dense vertex ID
+    std::vector<DeltaLog::Entry> m_wcc_delta; // the updates not yet reflected in the components
+
+    // Retrieve the dense vertex ID of the given external vertex ID, registering the vertex if it is not known yet
+    uint64_t add_vertex(uint64_t external_id);
+
+    // Move the updates from the delta log into the pending updates of the kernels already computed
+    void collect_delta();
+
+    // Register the vertices reachable from those already known
+    void discover_vertices();
+
+    // Retrieve the dense IDs of the neighbours of the given vertex. Neighbours not known yet are skipped.
+    void neighbours(uint64_t vertex_id, std::vector<uint64_t>& output) const;
+
+    // Compute the ranks from scratch
+    void pagerank_full(uint64_t num_iterations, double damping_factor);
+
+    // Refresh the ranks with the pending updates
+    void pagerank_refresh(uint64_t num_iterations, double damping_factor);
+
+    // Compute the components from scratch
+    void wcc_full();
+
+    // Retrieve the root of the component of the given vertex in the union-find
+    uint64_t wcc_find(uint64_t vertex_id);
+
+    // Merge the components of the two vertices
+    void wcc_link(uint64_t vertex1, uint64_t vertex2);
+
+public:
+    constexpr static double PAGERANK_TOLERANCE = 1e-4; // propagate the residuals above this fraction of the base rank (1-d)/|V|
+
+    /**
+     * Create a new instance. The delta log is enabled when the first kernel is executed.
+     * @param interface the library to evaluate
+     * @param delta_log the updates performed by the aging workers
+     * @param vertices the initial population of vertices, e.g. the final vertices of the aging log
+     */
+    IncrementalAnalytics(library::GraphalyticsInterface* interface, std::shared_ptr<DeltaLog> delta_log, const std::vector<uint64_t>& vertices);
+
+    /**
+     * Refresh the ranks of PageRank with the updates performed since the last execution
+     * @param num_iterations the number of iterations of the computation from scratch, and the max number of rounds to propagate the residuals
+     * @param damping_factor the damping factor of PageRank
+     * @return true if the ranks have been refreshed incrementally, false if they have been computed from scratch
+     */
+    bool pagerank(uint64_t num_iterations, double damping_factor = 0.85);
+
+    /**
+     * Refresh the weakly connected components with the updates performed since the last execution
+     * @return true if the components have been refreshed incrementally, false if they have been computed from scratch
+     */
+    bool wcc();
+
+    // Retrieve the number of vertices known
+    uint64_t num_vertices() const { return m_vertices.size(); }
+
+    // Retrieve the last rank computed for the given vertex, or 0 if the vertex is not known
+    double get_rank(uint64_t external_id) const;
+
+    // Retrieve the representative of the component of the given vertex, as an external vertex ID. The vertex must be known.
+    uint64_t get_component(uint64_t external_id);
+};
+
+} // namespace
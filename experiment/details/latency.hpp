@@ -22,11 +22,13 @@
 #include <cstdint>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace gfe::experiment::details {
 
 class LatencyStatistics {
     friend std::ostream& operator<<(std::ostream& out, const LatencyStatistics& stats);
+
     uint64_t m_num_operations {0};
     uint64_t m_mean {0};
     uint64_t m_stddev {0};
@@ -69,4 +71,36 @@ public:
 
 std::ostream& operator<<(std::ostream& out, const LatencyStatistics& stats);
 
+/**
+ * Keep a uniform sample of up to `capacity' latencies out of an unbounded sequence (reservoir sampling), while
+ * counting exactly the number of latencies observed. It bounds the memory of long running experiments.
+ * The class is not thread safe.
+ */
+class LatencyReservoir {
+    std::vector<uint64_t> m_samples; // the sampled latencies, in nanosecs
+    uint64_t m_count {0}; // total number of latencies observed
+    uint64_t m_capacity; // max number of samples to retain
+
+public:
+    LatencyReservoir(uint64_t capacity = (1ull << 18)) : m_capacity(capacity) { }
+
+    // Record the given latency, in nanosecs
+    template<typename Generator>
+    void add(uint64_t latency, Generator& generator){
+        m_count++;
+        if(m_samples.size() < m_capacity){
+            m_samples.push_back(latency);
+        } else {
+            uint64_t index = generator() % m_count;
+            if(index < m_capacity){ m_samples[index] = latency; }
+        }
+    }
+
+    // Total number of latencies observed
+    uint64_t count() const { return m_count; }
+
+    // The latencies retained
+    const std::vector<uint64_t>& samples() const { return m_samples; }
+};
+
 } // namespace
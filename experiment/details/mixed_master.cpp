@@ -1,26 +1,28 @@
 //
 // Created by zhou822 on 8/6/23.
 //
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <fstream>
 #include <iostream>
 #include <mutex>
+#include <random>
 #include <thread>
 #include <utility>
 
-#include "common/quantity.hpp"
+#include "common/error.hpp"
 #include "common/system.hpp"
 #include "common/timer.hpp"
 #include "mixed_master.hpp"
+#include "experiment/aging2_experiment.hpp"
 #include "experiment/update_short_reads_experiment.hpp"
 #include "experiment/mixed_workload_result.hpp"
 #include "reader/graphlog_reader.hpp"
 #include "library/interface.hpp"
-#include "utility/memory_usage.hpp"
-#include "build_thread.hpp"
 #include "configuration.hpp"
 #include "latency.hpp"
+#include "short_read_worker.hpp"
 
 using namespace common;
 using namespace std;
@@ -44,34 +46,86 @@ extern mutex _log_mutex [[maybe_unused]];
 namespace gfe::experiment::details {
     UpdateShortReadsMaster::UpdateShortReadsMaster(const gfe::experiment::UpdatesShortReadsExperiment &parameters):
     m_parameters(parameters),
-    m_is_directed(m_parameters.m_library->is_directed()),
-    m_results(parameters) {
-        auto properties = reader::graphlog::parse_properties(parameters.m_path_log);
-        m_results.m_num_artificial_vertices = stoull(properties["internal.vertices.temporary.cardinality"]);
-        m_results.m_num_vertices_load = stoull(properties["internal.vertices.final.cardinality"]);
-        m_results.m_num_edges_load = stoull(properties["internal.edges.final"]);
-        m_results.m_num_operations_total = stoull(properties["internal.edges.cardinality"]);
-        // 1024 is a hack to avoid issues with small graphs
-        m_reported_times = new uint64_t[static_cast<uint64_t>( m_parameters.m_num_reports_per_operations * ::ceil( static_cast<double>(num_operations_total())/num_edges_final_graph()) + 1 )]();
-        m_parameters.m_library->on_main_init(m_parameters.m_num_threads + /* this + builder service */ 2 + /* plus potentially an analytics runner (mixed epxeriment) */ 1);
-
-        init_workers();
-        m_parameters.m_library->on_thread_init(m_parameters.m_num_threads + 1);
+    m_library(parameters.m_library.get()),
+    m_library_ga(dynamic_cast<library::GraphalyticsInterface*>(parameters.m_library.get())) {
+        const auto& mix = m_parameters.m_mix;
+        if(m_library_ga == nullptr && (mix[(int) ShortReadOperation::ONE_HOP] > 0 || mix[(int) ShortReadOperation::TWO_HOPS] > 0)){
+            ERROR("The library does not provide the graphalytics interface, required to scan the neighbours in the 1-hop and 2-hop expansions. Set their weight to 0 in the mix of operations");
+        }
     }
+
     UpdateShortReadsMaster::~UpdateShortReadsMaster() {
-        for(auto w : update_workers){
+        m_stop_readers = true;
+        for(auto w: m_readers){
             delete w;
         }
-        for(auto w: read_workers){
-            delete w;
+        m_readers.clear();
+    }
+
+    void UpdateShortReadsMaster::load_vertices() {
+        Timer timer;
+        timer.start();
+
+        fstream handle(m_parameters.m_aging_experiment.m_path_log, ios_base::in | ios_base::binary);
+        auto properties = reader::graphlog::parse_properties(handle);
+        m_num_vertices = stoull(properties["internal.vertices.final.cardinality"]);
+        if(m_num_vertices == 0){ ERROR("The log does not contain any vertex in the final graph"); }
+        m_vertices.reset(new uint64_t[m_num_vertices]);
+        reader::graphlog::set_marker(properties, handle, reader::graphlog::Section::VTX_FINAL);
+        reader::graphlog::VertexLoader loader{handle};
+        loader.load(m_vertices.get(), m_num_vertices);
+
+        // with the zipf distribution, the most popular vertices are those at the start of the array
+        mt19937_64 random { m_parameters.m_seed };
+        shuffle(m_vertices.get(), m_vertices.get() + m_num_vertices, random);
+
+        timer.stop();
+        LOG("[ShortReads] Vertices loaded: " << m_num_vertices << ", time: " << timer);
+    }
+
+    void UpdateShortReadsMaster::init_readers() {
+        for(uint64_t i = 0; i < m_parameters.m_num_readers; i++){
+            m_readers.push_back(new ShortReadWorker(*this, i));
         }
-        update_workers.clear();
-        read_workers.clear();
-        m_parameters.m_library->on_thread_destroy(m_parameters.m_num_threads + 1);
-        m_parameters.m_library->on_main_destroy();
+    }
+
+/*****************************************************************************
+ *                                                                           *
+ * Execution                                                                 *
+ *                                                                           *
+ *****************************************************************************/
+    UpdatesReadsMixedWorkloadResult UpdateShortReadsMaster::execute() {
+        load_vertices();
+        init_readers();
+
+        LOG("[ShortReads] Readers: " << m_parameters.m_num_readers << ", distribution: " << short_reads_distribution_to_string(m_parameters.m_distribution));
+        m_parameters.m_aging_experiment.set_num_auxiliary_threads(m_parameters.m_num_readers); // one thread for each reader
+        Timer timer;
+        timer.start();
+        for(auto w : m_readers){ w->start(); }
+
+        auto aging_result = m_parameters.m_aging_experiment.execute();
 
-        delete[] m_reported_times; m_reported_times = nullptr;
+        m_stop_readers = true;
+        for(auto w : m_readers){ w->join(); }
+        timer.stop();
+        LOG("[ShortReads] Readers stopped after " << timer);
+
+        // merge the latencies of all readers
+        UpdatesReadsMixedWorkloadResult result { aging_result, m_parameters.m_num_readers, short_reads_distribution_to_string(m_parameters.m_distribution), timer.microseconds() };
+        for(int op = 0; op < num_short_read_operations; op++){
+            for(int found = 0; found <= 1; found++){
+                uint64_t count = 0;
+                vector<uint64_t> samples;
+                for(auto w : m_readers){
+                    const auto& reservoir = w->latencies(static_cast<ShortReadOperation>(op), found);
+                    count += reservoir.count();
+                    samples.insert(end(samples), begin(reservoir.samples()), end(reservoir.samples()));
+                }
+                result.set_latencies(static_cast<ShortReadOperation>(op), found, count, LatencyStatistics::compute_statistics(samples.data(), samples.size()));
+            }
+        }
 
-        delete[] m_latencies; m_latencies = nullptr;
+        return result;
     }
-}//namespace
\ No newline at end of file
+}//namespace
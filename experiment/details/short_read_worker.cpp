@@ -0,0 +1,146 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "short_read_worker.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include "common/system.hpp"
+#include "experiment/aging2_experiment.hpp"
+#include "experiment/update_short_reads_experiment.hpp"
+#include "library/interface.hpp"
+#include "configuration.hpp"
+#include "mixed_master.hpp"
+
+using namespace common;
+using namespace std;
+
+/*****************************************************************************
+ *                                                                           *
+ * Debug                                                                     *
+ *                                                                           *
+ *****************************************************************************/
+extern mutex _log_mutex [[maybe_unused]];
+//#define DEBUG
+#define COUT_DEBUG_FORCE(msg) { scoped_lock<mutex> lock(_log_mutex); cout << "[ShortReadWorker::" << __FUNCTION__ << "] [" << concurrency::get_thread_id() << ", worker_id: " << m_worker_id << "] " << msg << endl; }
+#if defined(DEBUG)
+#define COUT_DEBUG(msg) COUT_DEBUG_FORCE(msg)
+#else
+#define COUT_DEBUG(msg)
+#endif
+
+namespace gfe::experiment::details {
+
+/*****************************************************************************
+ *                                                                           *
+ * Init                                                                      *
+ *                                                                           *
+ *****************************************************************************/
+ShortReadWorker::ShortReadWorker(UpdateShortReadsMaster& master, int worker_id) : m_master(master), m_worker_id(worker_id),
+        m_random(master.parameters().m_seed + 1 + worker_id), // + 1 as the seed itself is used to shuffle the vertices
+        m_operations(begin(master.parameters().m_mix), end(master.parameters().m_mix)),
+        m_uniform(0, master.m_num_vertices -1) {
+    if(master.parameters().m_distribution == ShortReadsDistribution::ZIPF){
+        m_zipf.reset(new utility::ZipfDistribution(master.m_num_vertices, master.parameters().m_zipf_exponent));
+    }
+}
+
+ShortReadWorker::~ShortReadWorker(){
+    join();
+}
+
+void ShortReadWorker::start(){
+    assert(!m_thread.joinable() && "Already started");
+    m_thread = thread(&ShortReadWorker::main_thread, this);
+}
+
+void ShortReadWorker::join(){
+    if(m_thread.joinable()){
+        m_thread.join();
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Execution                                                                 *
+ *                                                                           *
+ *****************************************************************************/
+void ShortReadWorker::main_thread(){
+    concurrency::set_thread_name("Reader #" + to_string(m_worker_id));
+    COUT_DEBUG("Started");
+    Aging2Experiment& aging = m_master.parameters().m_aging_experiment;
+    if(!aging.auxiliary_thread_init(m_worker_id)) return; // the experiment is already over
+
+    while(!m_master.m_stop_readers.load(memory_order_relaxed) && !aging.is_auxiliary_terminating()){
+        execute(static_cast<ShortReadOperation>(m_operations(m_random)));
+    }
+
+    aging.auxiliary_thread_destroy(m_worker_id);
+
+    COUT_DEBUG("Terminated, edges visited by the expansions: " << m_num_visited);
+}
+
+uint64_t ShortReadWorker::sample_vertex(){
+    uint64_t index = m_zipf ? (*m_zipf)(m_random) -1 : m_uniform(m_random);
+    return m_master.m_vertices[index];
+}
+
+void ShortReadWorker::execute(ShortReadOperation operation){
+    uint64_t source = sample_vertex();
+    bool found = false;
+    chrono::steady_clock::time_point t0;
+
+    switch(operation){
+    case ShortReadOperation::HAS_EDGE: {
+        uint64_t destination = sample_vertex();
+        t0 = chrono::steady_clock::now();
+        found = m_master.m_library->has_edge(source, destination);
+    } break;
+    case ShortReadOperation::GET_WEIGHT: {
+        uint64_t destination = sample_vertex();
+        t0 = chrono::steady_clock::now();
+        found = !isnan(m_master.m_library->get_weight(source, destination));
+    } break;
+    case ShortReadOperation::ONE_HOP: {
+        t0 = chrono::steady_clock::now();
+        found = m_master.m_library_ga->scan_neighbors(source, [this](uint64_t, double){ m_num_visited++; return true; });
+    } break;
+    case ShortReadOperation::TWO_HOPS: {
+        // buffer the first hop, rather than nesting the scans, as some libraries hold a lock while visiting a vertex
+        m_neighbours.clear();
+        t0 = chrono::steady_clock::now();
+        found = m_master.m_library_ga->scan_neighbors(source, [this](uint64_t destination, double){ m_neighbours.push_back(destination); return true; });
+        for(uint64_t neighbour : m_neighbours){
+            m_master.m_library_ga->scan_neighbors(neighbour, [this](uint64_t, double){ m_num_visited++; return true; });
+        }
+    } break;
+    }
+
+    uint64_t latency = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    m_latencies[(int) operation][found].add(latency, m_random);
+}
+
+const LatencyReservoir& ShortReadWorker::latencies(ShortReadOperation operation, bool found) const {
+    return m_latencies[(int) operation][found];
+}
+
+} // namespace
@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "experiment/update_short_reads_experiment.hpp"
+#include "utility/zipf_distribution.hpp"
+#include "latency.hpp"
+
+// forward declarations
+namespace gfe::experiment::details { class UpdateShortReadsMaster; }
+
+namespace gfe::experiment::details {
+
+/**
+ * A reader in the short reads workload. It keeps issuing point lookups, 1-hop and 2-hop expansions, according to
+ * the mix of operations of the experiment, until the master stops it.
+ */
+class ShortReadWorker {
+    ShortReadWorker(const ShortReadWorker&) = delete;
+    ShortReadWorker& operator=(const ShortReadWorker&) = delete;
+
+    UpdateShortReadsMaster& m_master; // the master coordinating the readers
+    const int m_worker_id; // the id of this reader
+    std::mt19937_64 m_random; // pseudo-random generator, seeded with the seed of the experiment and the worker id
+    std::discrete_distribution<int> m_operations; // pick the next operation to perform, following the mix of the experiment
+    std::uniform_int_distribution<uint64_t> m_uniform; // uniform distribution over the vertices
+    std::unique_ptr<utility::ZipfDistribution> m_zipf; // zipf distribution over the vertices, if requested
+    LatencyReservoir m_latencies[num_short_read_operations][2]; // latency of each operation, [operation][found ? 1 : 0]
+    std::vector<uint64_t> m_neighbours; // the 1-hop neighbours of the current 2-hop expansion, reused across the operations
+    uint64_t m_num_visited = 0; // counter, total number of edges visited by the expansions, so that the scans cannot be elided
+    std::thread m_thread; // the background thread
+
+    // the controller of the background thread
+    void main_thread();
+
+    // pick a vertex of the final graph, according to the distribution of the experiment
+    uint64_t sample_vertex();
+
+    // perform the given operation, record its latency
+    void execute(ShortReadOperation operation);
+
+public:
+    ShortReadWorker(UpdateShortReadsMaster& master, int worker_id);
+
+    // Destructor. It waits for the background thread to terminate.
+    ~ShortReadWorker();
+
+    // Start the background thread
+    void start();
+
+    // Wait for the background thread to terminate. The master must request the readers to stop beforehand.
+    void join();
+
+    // The latencies recorded for the given operation, depending on whether the edge/vertex was found
+    const LatencyReservoir& latencies(ShortReadOperation operation, bool found) const;
+};
+
+} // namespace
@@ -0,0 +1,103 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+namespace gfe::experiment::details {
+
+/**
+ * A bounded Chase-Lev deque of task IDs. The owner pushes and pops tasks at the bottom, while any other
+ * thread can steal tasks from the top. In the Aging2 experiment, all tasks are pushed by the owner before
+ * the execution starts, hence the deque never needs to grow.
+ *
+ * Reference: N. M. Le, A. Pop, A. Cohen and F. Zappa Nardelli, Correct and Efficient Work-Stealing for
+ * Weak Memory Models, PPoPP 2013.
+ */
+class WorkStealingDeque {
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    std::unique_ptr<uint64_t[]> m_tasks; // the content of the deque
+    uint64_t m_capacity = 0; // max number of tasks that can be stored in the deque
+    alignas(64) std::atomic<int64_t> m_top = 0; // next task to steal
+    alignas(64) std::atomic<int64_t> m_bottom = 0; // next slot where to push a task
+
+public:
+    enum class StealResult { SUCCESS, EMPTY, ABORT };
+
+    WorkStealingDeque() { }
+
+    // Remove all tasks and make room for up to `capacity' tasks. It cannot be invoked concurrently with other methods.
+    void reset(uint64_t capacity) {
+        if(capacity > m_capacity){
+            m_tasks.reset(new uint64_t[capacity]);
+            m_capacity = capacity;
+        }
+        m_top = 0;
+        m_bottom = 0;
+    }
+
+    // Append a task at the bottom of the deque. Only invoked by the owner.
+    void push(uint64_t task) {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        assert(static_cast<uint64_t>(bottom) < m_capacity && "Deque full");
+        m_tasks[bottom] = task;
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // Remove a task from the bottom of the deque. Only invoked by the owner. Return false if the deque is empty.
+    bool pop(uint64_t& task) {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if(top < bottom){ // more than one task left
+            task = m_tasks[bottom];
+            return true;
+        } else if (top == bottom) { // last task, race against the thieves
+            task = m_tasks[bottom];
+            bool success = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return success;
+        } else { // empty
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    // Remove a task from the top of the deque. It can be invoked by any thread.
+    StealResult steal(uint64_t& task) {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if(top >= bottom) return StealResult::EMPTY;
+
+        task = m_tasks[top];
+        if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)){
+            return StealResult::ABORT; // lost the race with another thief or the owner
+        }
+        return StealResult::SUCCESS;
+    }
+};
+
+} // namespace
@@ -27,10 +27,13 @@
 
 #include "common/database.hpp"
 #include "common/filesystem.hpp"
+#include "common/time.hpp"
 #include "common/timer.hpp"
+#include "library/analytics_session.hpp"
 #include "library/interface.hpp"
 #include "reader/graphalytics_reader.hpp"
 #include "utility/graphalytics_validate.hpp"
+#include "utility/timeout_service.hpp"
 #include "configuration.hpp"
 #include "statistics.hpp"
 
@@ -129,6 +132,23 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
     t_global.start();
 
     for(uint64_t i = 0; i < m_num_repetitions; i++){
+        // open the snapshot shared by BFS, PageRank, SSSP and WCC in this repetition
+        t_local.start();
+        unique_ptr<library::AnalyticsSession> session = interface->begin_analytics_session();
+        t_local.stop();
+        m_exec_session.push_back(t_local.microseconds());
+
+        if(m_materialize_csr){
+            t_local.start();
+            bool materialized = session->materialize_csr();
+            t_local.stop();
+            if(materialized){
+                m_exec_csr.push_back(t_local.microseconds());
+            } else {
+                LOG("[GraphalyticsSequential] The library does not support the materialisation into a CSR, running the kernels on the library");
+                m_materialize_csr = false;
+            }
+        }
 
         if(m_properties.bfs.m_enabled){
             //LOG("Execution " << (i+1) << "/" << m_num_repetitions << ": BFS from source vertex: " << m_properties.bfs.m_source_vertex);
@@ -136,7 +156,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
             const char* path_result = m_validate_output_enabled ? path_tmp.c_str() : nullptr;
             try {
                 t_local.start();
-                interface->bfs(m_properties.bfs.m_source_vertex, path_result);
+                session->bfs(m_properties.bfs.m_source_vertex, path_result);
                 t_local.stop();
               //  LOG(">> BFS Execution time: " << t_local);
                 m_exec_bfs.push_back(t_local.microseconds());
@@ -155,7 +175,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
                     }
                 }
             } catch (library::TimeoutError& e){
-                LOG(">> BFS TIMEOUT");
+                LOG(">> BFS TIMEOUT, overrun: " << common::time::to_string(utility::TimeoutService::last_overrun()));
                 m_exec_bfs.push_back(-1);
                 m_properties.bfs.m_enabled = false;
             } catch (utility::GraphalyticsValidateError& e){
@@ -197,7 +217,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
                     }
                 }
             } catch(library::TimeoutError& e){
-                LOG(">> CDLP TIMEOUT");
+                LOG(">> CDLP TIMEOUT, overrun: " << common::time::to_string(utility::TimeoutService::last_overrun()));
                 m_exec_cdlp.push_back(-1);
                 m_properties.cdlp.m_enabled = false;
             } catch(utility::GraphalyticsValidateError& e){
@@ -237,7 +257,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
                     }
                 }
             } catch(library::TimeoutError& e){
-                LOG(">> LCC TIMEOUT");
+                LOG(">> LCC TIMEOUT, overrun: " << common::time::to_string(utility::TimeoutService::last_overrun()));
                 m_exec_lcc.push_back(-1);
                 m_properties.lcc.m_enabled = false;
             } catch(utility::GraphalyticsValidateError& e){
@@ -253,7 +273,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
             const char* path_result = m_validate_output_enabled ? path_tmp.c_str() : nullptr;
             try {
                 t_local.start();
-                interface->pagerank(m_properties.pagerank.m_num_iterations, m_properties.pagerank.m_damping_factor, path_result);
+                session->pagerank(m_properties.pagerank.m_num_iterations, m_properties.pagerank.m_damping_factor, path_result);
                 t_local.stop();
                // LOG(">> PageRank Execution time: " << t_local);
                 m_exec_pagerank.push_back(t_local.microseconds());
@@ -271,7 +291,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
                     }
                 }
             } catch(library::TimeoutError& e){
-                LOG(">> PageRank TIMEOUT");
+                LOG(">> PageRank TIMEOUT, overrun: " << common::time::to_string(utility::TimeoutService::last_overrun()));
                 m_exec_pagerank.push_back(-1);
                 m_properties.pagerank.m_enabled = false;
             } catch(utility::GraphalyticsValidateError& e){
@@ -288,7 +308,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
             try {
                 t_local.start();
                 //std::cout<<"executing sssp from "<<m_properties.sssp.m_source_vertex<<std::endl;
-                interface->sssp(2592222, path_result);
+                session->sssp(2592222, path_result);
                 //interface->sssp(m_properties.sssp.m_source_vertex, path_result);//2592222
                 t_local.stop();
                 //LOG(">> SSSP Execution time: " << t_local);
@@ -307,7 +327,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
                     }
                 }
             } catch(library::TimeoutError& e){
-                LOG(">> SSSP TIMEOUT");
+                LOG(">> SSSP TIMEOUT, overrun: " << common::time::to_string(utility::TimeoutService::last_overrun()));
                 m_exec_sssp.push_back(-1);
                 m_properties.sssp.m_enabled = false;
             } catch(utility::GraphalyticsValidateError& e){
@@ -322,7 +342,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
             const char* path_result = m_validate_output_enabled ? path_tmp.c_str() : nullptr;
             try {
                 t_local.start();
-                interface->wcc(path_result);
+                session->wcc(path_result);
                 t_local.stop();
                // LOG(">> WCC Execution time: " << t_local);
                 m_exec_wcc.push_back(t_local.microseconds());
@@ -340,7 +360,7 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
                     }
                 }
             } catch(library::TimeoutError& e){
-                LOG(">> WCC TIMEOUT");
+                LOG(">> WCC TIMEOUT, overrun: " << common::time::to_string(utility::TimeoutService::last_overrun()));
                 m_exec_wcc.push_back(-1);
                 m_properties.wcc.m_enabled = false;
             } catch(utility::GraphalyticsValidateError& e){
@@ -357,6 +377,16 @@ std::chrono::microseconds GraphalyticsSequential::execute(){
 }
 
 void GraphalyticsSequential::report(bool save_in_db){
+    if(!m_exec_session.empty()){
+        ExecStatistics stats { m_exec_session };
+        cout << ">> Analytics session " << stats << "\n";
+        if(save_in_db) stats.save("analytics_session");
+    }
+    if(!m_exec_csr.empty()){
+        ExecStatistics stats { m_exec_csr };
+        cout << ">> CSR materialisation " << stats << "\n";
+        if(save_in_db) stats.save("csr_materialization");
+    }
     if(!m_exec_bfs.empty()){
         ExecStatistics stats { m_exec_bfs };
         cout << ">> BFS " << stats << "\n";
@@ -448,6 +478,10 @@ void GraphalyticsSequential::set_validate_output(const std::string& path_propert
     m_validate_output_enabled = true;
 }
 
+void GraphalyticsSequential::set_materialize_csr(bool value){
+    m_materialize_csr = value;
+}
+
 void GraphalyticsSequential::set_validate_remap_vertices(const std::string& path_property_file){
     string path_results = path_property_file;
     if(!common::filesystem::file_exists(path_results)){
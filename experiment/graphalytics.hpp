@@ -75,6 +75,7 @@ class GraphalyticsSequential{
     GraphalyticsAlgorithms m_properties; // the properties of the graphalytics algorithms
 
     bool m_validate_output_enabled = false; // whether to validate the output of the graphalytics algorithms
+    bool m_materialize_csr = false; // whether to copy the snapshot of each session into a CSR before running the kernels
     std::string m_validate_path_expected; // the full path to the .properties file for the graph
     std::string m_validate_output_temp_dir; // the path where to store the output files from the Graphalytics algorithm
     std::unordered_map<uint64_t, uint64_t> m_validation_map; // map each vertex of the expected file to a vertex of the generated results
@@ -82,6 +83,8 @@ class GraphalyticsSequential{
     std::vector<std::pair<std::string /* algorithm */, ValidationResult >> m_validate_results;
 
     // the completion times for each execution
+    std::vector<int64_t> m_exec_session; // the time to open the snapshot and materialise its shared state, in each repetition
+    std::vector<int64_t> m_exec_csr; // the time to copy the snapshot into a CSR, in each repetition
     std::vector<int64_t> m_exec_bfs;
     std::vector<int64_t> m_exec_cdlp;
     std::vector<int64_t> m_exec_lcc;
@@ -128,6 +131,12 @@ public:
      */
     void set_validate_remap_vertices(const std::string& path_properties_file);
 
+    /**
+     * Copy the snapshot of each session into a CSR and run BFS, PageRank, SSSP and WCC on the CSR. The time to materialise
+     * the CSR is reported separately from the kernels. It's ignored if the library does not support the materialisation.
+     */
+    void set_materialize_csr(bool value);
+
     /**
      * Execute the experiment
      */
@@ -6,59 +6,144 @@
 
 #include <future>
 #include <chrono>
+#include <mutex>
+#include <sstream>
 
-#if defined(HAVE_OPENMP)
-  #include "omp.h"
-#endif
-
-#include "graphalytics.hpp"
+#include "common/error.hpp"
+#include "library/interface.hpp"
 #include "aging2_experiment.hpp"
+#include "configuration.hpp"
 #include "mixed_workload_result.hpp"
 
 namespace gfe::experiment {
 
     using namespace std;
 
-    MixedWorkloadResult MixedWorkload::execute() {
-      auto aging_result_future = std::async(std::launch::async, &Aging2Experiment::execute, &m_aging_experiment);
+    vector<MixedWorkloadWindow> mixed_workload_windows_from_string(const string& value) {
+      vector<MixedWorkloadWindow> windows;
 
-      chrono::seconds progress_check_interval( 1 );
-      this_thread::sleep_for( progress_check_interval );  // Poor mans synchronization to ensure AgingExperiment was able to setup the master etc
-      while (true) {
-        if (m_aging_experiment.progress_so_far() > 0.1 || aging_result_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready) { // The graph reached its final size
-          break;
+      stringstream ss { value };
+      string window;
+      while (getline(ss, window, ',')) {
+        auto colon = window.find(':');
+        if (colon == string::npos) { INVALID_ARGUMENT("Invalid window: `" << window << "'. Expected <start>:<end>"); }
+        MixedWorkloadWindow w;
+        try {
+          w.m_progress_start = stod(window.substr(0, colon));
+          w.m_progress_end = stod(window.substr(colon + 1));
+        } catch (std::logic_error& e) {
+          INVALID_ARGUMENT("Invalid window: `" << window << "'. Expected <start>:<end>");
+        }
+        if (w.m_progress_start < 0 || w.m_progress_end > 1 || w.m_progress_start >= w.m_progress_end) {
+          INVALID_ARGUMENT("Invalid window: `" << window << "'. Expected 0 <= start < end <= 1");
         }
-        this_thread::sleep_for( progress_check_interval ) ;
+        if (!windows.empty() && windows.back().m_progress_end > w.m_progress_start) {
+          INVALID_ARGUMENT("The window `" << window << "' overlaps or precedes the previous window");
+        }
+        windows.push_back(w);
       }
-      m_graphalytics.mixed_workload_finished_loading();
-      cout << "Graph reached final size, executing graphaltyics now" << endl;
-      // TODO change this to also work for LCC, generally this solution is very ugly
-#if defined(HAVE_OPENMP)
-      if(m_read_threads != 0 ){
-                        cout << "[driver] OpenMP, number of threads for the Graphalytics suite: " << m_read_threads << endl;
-                        omp_set_num_threads(m_read_threads);
-                    }
-#endif
 
+      return windows;
+    }
+
+    MixedWorkload::MixedWorkload(Aging2Experiment& aging_experiment, shared_ptr<library::GraphalyticsInterface> interface, const GraphalyticsAlgorithms& properties, int read_threads)
+      : m_aging_experiment(aging_experiment), m_interface(interface), m_properties(properties), m_read_threads(read_threads) {
 #if HAVE_LIVEGRAPH
-      while (m_aging_experiment.progress_so_far() < 0.16 && aging_result_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
-        m_graphalytics.execute();
-      }
+      m_windows.push_back(MixedWorkloadWindow{ 0.1, 0.16 });
 #else
-      while (m_aging_experiment.progress_so_far() < 0.9 && aging_result_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
-        m_graphalytics.execute();
-      }
+      m_windows.push_back(MixedWorkloadWindow{ 0.1, 0.9 });
 #endif
-      m_graphalytics.mixed_workload_read_finish();
-      cout << "Waiting for aging experiment to finish" << endl;
-      aging_result_future.wait();
-      cout << "Getting aging experiment results" << endl;
-      auto aging_result = aging_result_future.get();
 
-      return MixedWorkloadResult { aging_result, m_graphalytics };
+      // by default, a single stream executing the enabled algorithms in the same order of GraphalyticsSequential
+      details::AnalyticsStreamSpec stream;
+      stream.m_num_threads = m_read_threads;
+      if (m_properties.bfs.m_enabled) stream.m_kernels.push_back(details::AnalyticsKernel::BFS);
+      if (m_properties.cdlp.m_enabled) stream.m_kernels.push_back(details::AnalyticsKernel::TWO_HOPS);
+      if (m_properties.lcc.m_enabled) stream.m_kernels.push_back(details::AnalyticsKernel::ONE_HOP);
+      if (m_properties.pagerank.m_enabled) stream.m_kernels.push_back(details::AnalyticsKernel::PAGERANK);
+      if (m_properties.sssp.m_enabled) stream.m_kernels.push_back(details::AnalyticsKernel::SSSP);
+      if (m_properties.wcc.m_enabled) stream.m_kernels.push_back(details::AnalyticsKernel::WCC);
+      if (!stream.m_kernels.empty()) m_streams.push_back(stream);
     }
 
-    void MixedWorkload::report_graphalytics() {
-        m_graphalytics.report(false);
+    void MixedWorkload::set_windows(const vector<MixedWorkloadWindow>& windows) {
+      if (windows.empty()) { INVALID_ARGUMENT("No windows given"); }
+      m_windows = windows;
+    }
+
+    void MixedWorkload::set_streams(const vector<details::AnalyticsStreamSpec>& streams) {
+      for (const auto& stream : streams) {
+        for (auto kernel : stream.m_kernels) {
+          if ((kernel == details::AnalyticsKernel::BFS && !m_properties.bfs.m_enabled) ||
+              (kernel == details::AnalyticsKernel::PAGERANK && !m_properties.pagerank.m_enabled) ||
+              (kernel == details::AnalyticsKernel::SSSP && !m_properties.sssp.m_enabled)) {
+            INVALID_ARGUMENT("The kernel " << details::analytics_kernel_to_string(kernel) << " is not enabled in the properties of the graph, its parameters are unknown");
+          }
+        }
+      }
+      m_streams = streams;
+    }
+
+    void MixedWorkload::set_incremental_analytics(const vector<uint64_t>& vertices) {
+      auto delta_log = make_shared<details::DeltaLog>();
+      m_aging_experiment.set_delta_log(delta_log);
+      m_incremental.reset(new details::IncrementalAnalytics(m_interface.get(), delta_log, vertices));
+    }
+
+    MixedWorkloadResult MixedWorkload::execute() {
+      m_aging_experiment.set_num_auxiliary_threads(m_streams.size()); // one thread for each stream
+      auto aging_result_future = std::async(std::launch::async, &Aging2Experiment::execute, &m_aging_experiment);
+      auto aging_done = [&aging_result_future]() { return aging_result_future.wait_for(chrono::seconds(0)) == future_status::ready; };
+      const chrono::milliseconds progress_check_interval( 100 );
+
+      atomic<int> window_id = details::AnalyticsStream::WINDOW_CLOSED;
+      mutex kernel_mutex; // serialise the kernels, if the library cannot run them concurrently
+      mutex* ptr_kernel_mutex = (m_streams.size() > 1 && !m_interface->can_run_kernels_concurrently()) ? &kernel_mutex : nullptr;
+      if (ptr_kernel_mutex != nullptr) { LOG("[MixedWorkload] The library cannot run multiple kernels concurrently, the streams execute one kernel at the time"); }
+      vector<unique_ptr<details::AnalyticsStream>> streams;
+      for (uint64_t i = 0; i < m_streams.size(); i++) {
+        LOG("[MixedWorkload] Stream #" << i << ", threads: " << m_streams[i].m_num_threads << ", kernels: " << m_streams[i].m_kernels.size());
+        streams.emplace_back(new details::AnalyticsStream(m_interface.get(), m_aging_experiment, ptr_kernel_mutex, m_properties, i, m_streams[i], window_id, m_incremental.get()));
+        streams.back()->start();
+      }
+
+      bool loading_finished = false;
+      vector<uint64_t> window_durations; // microsecs
+      for (uint64_t i = 0; i < m_windows.size() && !aging_done(); i++) {
+        while (m_aging_experiment.progress_so_far() < m_windows[i].m_progress_start && !aging_done()) {
+          this_thread::sleep_for(progress_check_interval);
+        }
+        if (aging_done()) break;
+
+        if (!loading_finished) {
+          m_interface->mixed_workload_finish_loading();
+          loading_finished = true;
+        }
+
+        LOG("[MixedWorkload] Window #" << i << " opened, progress: " << m_aging_experiment.progress_so_far());
+        auto time_start = chrono::steady_clock::now();
+        window_id = i;
+        while (m_aging_experiment.progress_so_far() < m_windows[i].m_progress_end && !aging_done()) {
+          this_thread::sleep_for(progress_check_interval);
+        }
+        window_id = details::AnalyticsStream::WINDOW_CLOSED;
+        window_durations.push_back(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - time_start).count());
+        LOG("[MixedWorkload] Window #" << i << " closed, progress: " << m_aging_experiment.progress_so_far());
+      }
+
+      window_id = details::AnalyticsStream::WORKLOAD_DONE;
+      vector<details::AnalyticsExecution> executions;
+      for (auto& stream : streams) {
+        stream->join();
+        executions.insert(end(executions), begin(stream->executions()), end(stream->executions()));
+      }
+      if (loading_finished) {
+        m_interface->on_openmp_workloads_finish();
+      }
+
+      LOG("[MixedWorkload] Waiting for the aging experiment to finish");
+      auto aging_result = aging_result_future.get();
+
+      return MixedWorkloadResult { aging_result, m_windows, window_durations, executions };
     }
-}
\ No newline at end of file
+}
@@ -1,22 +1,54 @@
 #ifndef GFE_DRIVER_MIXED_WORKLOAD_H
 #define GFE_DRIVER_MIXED_WORKLOAD_H
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "details/analytics_stream.hpp"
+#include "details/incremental_analytics.hpp"
+#include "graphalytics.hpp"
+
 namespace gfe::experiment { class Aging2Experiment; }
-namespace gfe::experiment { class GraphalyticsSequential; }
 namespace gfe::experiment { class MixedWorkloadResult; }
+namespace gfe::library { class GraphalyticsInterface; }
 
 namespace gfe::experiment {
 
+    /**
+     * A window of the mixed workload, in terms of the progress of the aging experiment. The analytics streams
+     * are executed while the progress is in [m_progress_start, m_progress_end).
+     */
+    struct MixedWorkloadWindow {
+        double m_progress_start;
+        double m_progress_end;
+    };
+
+    // Parse a comma separated list of windows, each in the form <start>:<end>, e.g. "0.1:0.5,0.5:0.9". The windows must be sorted and cannot overlap.
+    std::vector<MixedWorkloadWindow> mixed_workload_windows_from_string(const std::string& value);
+
     class MixedWorkload {
     public:
-        MixedWorkload(Aging2Experiment& aging_experiment, GraphalyticsSequential& graphalytics, int read_threads)
-          : m_aging_experiment(aging_experiment), m_graphalytics(graphalytics), m_read_threads(read_threads) {}
+        MixedWorkload(Aging2Experiment& aging_experiment, std::shared_ptr<library::GraphalyticsInterface> interface, const GraphalyticsAlgorithms& properties, int read_threads);
+
+        // Set the windows where to run the analytics. By default, a single window in [0.1, 0.9) of the progress of the aging experiment
+        void set_windows(const std::vector<MixedWorkloadWindow>& windows);
+
+        // Set the analytics streams to run concurrently. By default, a single stream with `read_threads' executing the algorithms enabled in the properties
+        void set_streams(const std::vector<details::AnalyticsStreamSpec>& streams);
+
+        // After each execution of PageRank and WCC, also refresh their previous results with the updates performed since then.
+        // The vertices are the initial population for the computations from scratch, e.g. the final vertices of the log.
+        void set_incremental_analytics(const std::vector<uint64_t>& vertices);
 
         MixedWorkloadResult execute();
-        void report_graphalytics();
     private:
         Aging2Experiment& m_aging_experiment;
-        GraphalyticsSequential& m_graphalytics;
+        std::shared_ptr<library::GraphalyticsInterface> m_interface;
+        const GraphalyticsAlgorithms m_properties;
+        std::vector<MixedWorkloadWindow> m_windows;
+        std::vector<details::AnalyticsStreamSpec> m_streams;
+        std::unique_ptr<details::IncrementalAnalytics> m_incremental; // refresh PageRank and WCC incrementally, if requested
 
         int m_read_threads = 0;
     };
@@ -6,23 +6,190 @@
 
 #include "common/database.hpp"
 #include "aging2_result.hpp"
-#include "graphalytics.hpp"
+#include "statistics.hpp"
 #include "iostream"
 
 namespace gfe::experiment {
     using namespace std;
+    using details::AnalyticsKernel;
 
-    MixedWorkloadResult::MixedWorkloadResult(Aging2Result aging_result, GraphalyticsSequential& analytics)
-      : m_aging_result(aging_result), m_graphalytics(analytics) {
+    static const AnalyticsKernel all_kernels[] = { AnalyticsKernel::BFS, AnalyticsKernel::PAGERANK, AnalyticsKernel::SSSP, AnalyticsKernel::WCC, AnalyticsKernel::ONE_HOP, AnalyticsKernel::TWO_HOPS };
 
+    MixedWorkloadResult::MixedWorkloadResult(Aging2Result aging_result, const vector<MixedWorkloadWindow>& windows, const vector<uint64_t>& window_durations, const vector<details::AnalyticsExecution>& executions)
+      : m_aging_result(aging_result), m_windows(windows), m_window_durations(window_durations), m_executions(executions) {
+
+    }
+
+    vector<int64_t> MixedWorkloadResult::completion_times(int window, AnalyticsKernel kernel) const {
+      vector<int64_t> result;
+      for (const auto& e : m_executions) {
+        if ((window < 0 || e.m_window == window) && e.m_kernel == kernel) {
+          result.push_back(e.m_completion_time);
+        }
+      }
+      return result;
+    }
+
+    vector<int64_t> MixedWorkloadResult::materialization_times(int window, AnalyticsKernel kernel) const {
+      vector<int64_t> result;
+      for (const auto& e : m_executions) {
+        if ((window < 0 || e.m_window == window) && e.m_kernel == kernel && e.m_materialization_time >= 0) {
+          result.push_back(e.m_materialization_time);
+        }
+      }
+      return result;
+    }
+
+    vector<int64_t> MixedWorkloadResult::incremental_times(int window, AnalyticsKernel kernel) const {
+      vector<int64_t> result;
+      for (const auto& e : m_executions) {
+        if ((window < 0 || e.m_window == window) && e.m_kernel == kernel && e.m_incremental_time >= 0) {
+          result.push_back(e.m_incremental_time);
+        }
+      }
+      return result;
+    }
+
+    uint64_t MixedWorkloadResult::num_incremental_from_scratch(int window, AnalyticsKernel kernel) const {
+      uint64_t result = 0;
+      for (const auto& e : m_executions) {
+        if ((window < 0 || e.m_window == window) && e.m_kernel == kernel && e.m_incremental_time >= 0 && e.m_incremental_from_scratch) {
+          result++;
+        }
+      }
+      return result;
+    }
+
+    void MixedWorkloadResult::report() const {
+      for (uint64_t i = 0; i < m_window_durations.size(); i++) {
+        cout << ">> Window #" << i << " [" << m_windows[i].m_progress_start << ", " << m_windows[i].m_progress_end << "), duration: " << m_window_durations[i] << " us\n";
+        for (auto kernel : all_kernels) {
+          auto times = completion_times(i, kernel);
+          if (times.empty()) continue;
+          ExecStatistics stats { times };
+          double throughput = m_window_durations[i] == 0 ? 0.0 : (stats.num_trials() - stats.num_timeouts()) * 1000000.0 / m_window_durations[i];
+          cout << ">> >> " << details::analytics_kernel_to_string(kernel) << " " << stats << ", throughput: " << throughput << " exec/sec\n";
+          auto materialization = materialization_times(i, kernel);
+          if (!materialization.empty()) {
+            cout << ">> >> >> CSR materialisation " << ExecStatistics { materialization } << "\n";
+          }
+          auto incremental = incremental_times(i, kernel);
+          if (!incremental.empty()) {
+            cout << ">> >> >> incremental refresh " << ExecStatistics { incremental } << ", from scratch: " << num_incremental_from_scratch(i, kernel) << "\n";
+          }
+        }
+      }
+      cout << flush;
     }
 
     void MixedWorkloadResult::save(common::Database* db) {
       cout << "Start saving results" << endl;
-      m_graphalytics.report(true);
-      cout << "Saved graphalytics" << endl;
+
+      // overall statistics, as in the Graphalytics suite
+      for (auto kernel : all_kernels) {
+        auto times = completion_times(-1, kernel);
+        if (times.empty()) continue;
+        ExecStatistics stats { times };
+        stats.save(details::analytics_kernel_to_string(kernel));
+
+        auto materialization = materialization_times(-1, kernel);
+        if (!materialization.empty()) {
+          ExecStatistics { materialization }.save(details::analytics_kernel_to_string(kernel) + "_csr_materialization");
+        }
+
+        auto incremental = incremental_times(-1, kernel);
+        if (!incremental.empty()) {
+          ExecStatistics { incremental }.save(details::analytics_kernel_to_string(kernel) + "_incremental");
+        }
+      }
+
+      for (uint64_t i = 0; i < m_window_durations.size(); i++) {
+        auto store = db->add("mixed_windows");
+        store.add("window_id", i);
+        store.add("progress_start", m_windows[i].m_progress_start);
+        store.add("progress_end", m_windows[i].m_progress_end);
+        store.add("duration", m_window_durations[i]); // microsecs
+
+        for (auto kernel : all_kernels) {
+          auto times = completion_times(i, kernel);
+          if (times.empty()) continue;
+          ExecStatistics stats { times };
+          auto store = db->add("mixed_analytics");
+          store.add("window_id", i);
+          store.add("kernel", details::analytics_kernel_to_string(kernel));
+          store.add("num_executions", stats.num_trials());
+          store.add("num_timeouts", stats.num_timeouts());
+          store.add("throughput", m_window_durations[i] == 0 ? 0.0 : (stats.num_trials() - stats.num_timeouts()) * 1000000.0 / m_window_durations[i]); // executions/sec
+          store.add("mean", stats.mean()); // microsecs
+          store.add("median", stats.median());
+          store.add("p90", stats.percentile90());
+          store.add("p95", stats.percentile95());
+          store.add("p99", stats.percentile99());
+
+          ExecStatistics stats_materialization { materialization_times(i, kernel) }; // all zeros if the kernels did not run on a CSR
+          store.add("materialization_mean", stats_materialization.mean()); // microsecs
+          store.add("materialization_median", stats_materialization.median());
+
+          ExecStatistics stats_incremental { incremental_times(i, kernel) }; // all zeros if the results were not refreshed incrementally
+          store.add("incremental_mean", stats_incremental.mean()); // microsecs
+          store.add("incremental_median", stats_incremental.median());
+          store.add("incremental_from_scratch", num_incremental_from_scratch(i, kernel));
+        }
+      }
+      cout << "Saved analytics" << endl;
+
       m_aging_result.save(db);
       cout << "Saved aging" << endl;
-      cout << "Saved aging" << endl;
     }
-}
\ No newline at end of file
+}
+
+namespace gfe::experiment {
+    using namespace std;
+
+    UpdatesReadsMixedWorkloadResult::UpdatesReadsMixedWorkloadResult(Aging2Result aging_result, uint64_t num_readers, const string& distribution, uint64_t completion_time)
+      : m_aging_result(aging_result), m_num_readers(num_readers), m_distribution(distribution), m_completion_time(completion_time) {
+
+    }
+
+    void UpdatesReadsMixedWorkloadResult::set_latencies(ShortReadOperation operation, bool found, uint64_t count, const details::LatencyStatistics& latencies) {
+      m_num_operations[(int) operation][found] = count;
+      m_latencies[(int) operation][found] = latencies;
+    }
+
+    void UpdatesReadsMixedWorkloadResult::report() const {
+      cout << ">> Short reads, readers: " << m_num_readers << ", distribution: " << m_distribution << ", duration: " << m_completion_time << " us\n";
+      for (int op = 0; op < num_short_read_operations; op++) {
+        uint64_t num_operations = m_num_operations[op][0] + m_num_operations[op][1];
+        if (num_operations == 0) continue;
+        string name = short_read_operation_to_string(static_cast<ShortReadOperation>(op));
+        double throughput = m_completion_time == 0 ? 0.0 : num_operations * 1000000.0 / m_completion_time;
+        cout << ">> >> " << name << ", throughput: " << throughput << " ops/sec, found: " << m_num_operations[op][1] << ", missing: " << m_num_operations[op][0] << "\n";
+        if (m_num_operations[op][1] > 0) cout << ">> >> >> found " << m_latencies[op][1] << "\n";
+        if (m_num_operations[op][0] > 0) cout << ">> >> >> missing " << m_latencies[op][0] << "\n";
+      }
+      cout << flush;
+    }
+
+    void UpdatesReadsMixedWorkloadResult::save(common::Database* db) {
+      for (int op = 0; op < num_short_read_operations; op++) {
+        uint64_t num_operations = m_num_operations[op][0] + m_num_operations[op][1];
+        if (num_operations == 0) continue;
+        string name = short_read_operation_to_string(static_cast<ShortReadOperation>(op));
+
+        auto store = db->add("short_reads");
+        store.add("operation", name);
+        store.add("num_readers", m_num_readers);
+        store.add("distribution", m_distribution);
+        store.add("completion_time", m_completion_time); // microsecs
+        store.add("num_found", m_num_operations[op][1]);
+        store.add("num_missing", m_num_operations[op][0]);
+        store.add("throughput", m_completion_time == 0 ? 0.0 : num_operations * 1000000.0 / m_completion_time); // ops/sec
+
+        // the latencies are computed on a sample of the operations
+        if (m_num_operations[op][1] > 0) m_latencies[op][1].save("short_reads_" + name + "_found");
+        if (m_num_operations[op][0] > 0) m_latencies[op][0].save("short_reads_" + name + "_missing");
+      }
+
+      m_aging_result.save(db);
+    }
+}
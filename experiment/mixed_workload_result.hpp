@@ -1,34 +1,67 @@
 #ifndef GFE_DRIVER_MIXED_WORKLOAD_RESULT_H
 #define GFE_DRIVER_MIXED_WORKLOAD_RESULT_H
 
+#include <vector>
+
+#include "details/latency.hpp"
 #include "aging2_result.hpp"
-namespace gfe::experiment { class GraphalyticsSequential; }
+#include "mixed_workload.hpp"
+#include "update_short_reads_experiment.hpp"
 namespace common { class Database; }
 
 namespace gfe::experiment {
 
     class MixedWorkloadResult {
     public:
-        MixedWorkloadResult(Aging2Result aging_result, GraphalyticsSequential& analytics);
+        MixedWorkloadResult(Aging2Result aging_result, const std::vector<MixedWorkloadWindow>& windows, const std::vector<uint64_t>& window_durations, const std::vector<details::AnalyticsExecution>& executions);
+
+        // Print to stdout the statistics of each kernel in each window
+        void report() const;
 
         void save(common::Database* db);
 
     private:
         Aging2Result m_aging_result;
-        GraphalyticsSequential& m_graphalytics;
+        std::vector<MixedWorkloadWindow> m_windows; // the windows requested
+        std::vector<uint64_t> m_window_durations; // how long each window was open, in microsecs. Windows never opened are not present.
+        std::vector<details::AnalyticsExecution> m_executions; // all kernel executions from all streams
+
+        // Retrieve the completion times of the given kernel in the given window, or in all windows if window < 0
+        std::vector<int64_t> completion_times(int window, details::AnalyticsKernel kernel) const;
+
+        // Retrieve the times to materialise the CSR before the given kernel in the given window, or in all windows if window < 0
+        std::vector<int64_t> materialization_times(int window, details::AnalyticsKernel kernel) const;
+
+        // Retrieve the times to refresh incrementally the results of the given kernel in the given window, or in all windows if window < 0
+        std::vector<int64_t> incremental_times(int window, details::AnalyticsKernel kernel) const;
+
+        // Retrieve how many refreshes of the given kernel in the given window, or in all windows if window < 0, recomputed the results from scratch
+        uint64_t num_incremental_from_scratch(int window, details::AnalyticsKernel kernel) const;
     };
 
     class UpdatesReadsMixedWorkloadResult {
     public:
-       // UpdatesReadsMixedWorkloadResult(Aging2Result aging_result, GraphalyticsSequential& analytics);
+        UpdatesReadsMixedWorkloadResult(Aging2Result aging_result, uint64_t num_readers, const std::string& distribution, uint64_t completion_time);
+
+        // Set the latencies observed for the given operation (ShortReadOperation), depending on whether the edge/vertex was found
+        void set_latencies(ShortReadOperation operation, bool found, uint64_t count, const details::LatencyStatistics& latencies);
+
+        // Print to stdout the throughput and the latencies of each operation
+        void report() const;
+
+        // Get a random vertex stored in the graph by the aging experiment
+        uint64_t get_random_vertex_id() const { return m_aging_result.get_random_vertex_id(); }
 
         void save(common::Database* db);
 
     private:
         Aging2Result m_aging_result;
-        //GraphalyticsSequential& m_graphalytics;
+        const uint64_t m_num_readers; // number of reader threads
+        const std::string m_distribution; // how the vertices to read were picked
+        const uint64_t m_completion_time; // how long the readers were active, in microsecs
+        uint64_t m_num_operations[num_short_read_operations][2] = {}; // [operation][found ? 1 : 0]
+        details::LatencyStatistics m_latencies[num_short_read_operations][2]; // [operation][found ? 1 : 0]
     };
-
 }
 
 #endif //GFE_DRIVER_MIXED_WORKLOAD_RESULT_H
@@ -56,6 +56,15 @@ public:
      * Save the computed statistics in the database
      */
     void save(const std::string& name);
+
+    // Accessors, all times are in microsecs
+    uint64_t num_trials() const { return m_num_trials; }
+    uint64_t num_timeouts() const { return m_num_timeouts; }
+    uint64_t mean() const { return m_mean; }
+    uint64_t median() const { return m_median; }
+    uint64_t percentile90() const { return m_percentile90; }
+    uint64_t percentile95() const { return m_percentile95; }
+    uint64_t percentile99() const { return m_percentile99; }
 };
 
 // Print the statistics into the given output stream, for reporting or debugging purposes
@@ -1,12 +1,19 @@
+//
+// Created by zhou822 on 8/6/23.
+//
+
 #include "update_short_reads_experiment.hpp"
+
+#include <algorithm>
 #include <iostream>
 #include <mutex>
+#include <sstream>
 #include <thread>
 
 #include "configuration.hpp"
 #include "common/error.hpp"
-//#include "details/aging2_master.hpp"
-#include "graph/edge_stream.hpp"
+#include "details/mixed_master.hpp"
+#include "mixed_workload_result.hpp"
 #include "library/interface.hpp"
 
 using namespace std;
@@ -18,7 +25,7 @@ using namespace std;
  *****************************************************************************/
 extern mutex _log_mutex [[maybe_unused]];
 //#define DEBUG
-#define COUT_DEBUG_FORCE(msg) { scoped_lock<mutex> lock(_log_mutex); cout << "[Aging2Experiment::" << __FUNCTION__ << "] [" << concurrency::get_thread_id() << "] " << msg << endl; }
+#define COUT_DEBUG_FORCE(msg) { scoped_lock<mutex> lock(_log_mutex); cout << "[UpdatesShortReadsExperiment::" << __FUNCTION__ << "] [" << concurrency::get_thread_id() << "] " << msg << endl; }
 #if defined(DEBUG)
 #define COUT_DEBUG(msg) COUT_DEBUG_FORCE(msg)
 #else
@@ -27,102 +34,105 @@ extern mutex _log_mutex [[maybe_unused]];
 
 namespace gfe::experiment {
 
-UpdatesShortReadsExperiment::UpdatesShortReadsExperiment():m_master(nullptr) {
-}
-
-UpdatesShortReadsExperiment::~UpdatesShortReadsExperiment() {
-    if (m_master != nullptr) {
-        delete m_master;
-        m_master = nullptr;
+string short_read_operation_to_string(ShortReadOperation operation){
+    switch(operation){
+    case ShortReadOperation::HAS_EDGE: return "has_edge";
+    case ShortReadOperation::GET_WEIGHT: return "get_weight";
+    case ShortReadOperation::ONE_HOP: return "one_hop";
+    case ShortReadOperation::TWO_HOPS: return "two_hops";
+    default: return "unknown";
     }
 }
 
-void UpdatesShortReadsExperiment::set_library(std::shared_ptr<gfe::library::UpdateInterface> library) {
-    m_library = library;
-}
-
-void UpdatesShortReadsExperiment::set_log(const std::string& path){
-    m_path_log = path;
-}
-
-void UpdatesShortReadsExperiment::set_max_weight(double value){
-    if(value <= 0){ INVALID_ARGUMENT("value <= 0: " << value); }
-    m_max_weight = value;
-}
-
-void UpdatesShortReadsExperiment::set_parallelism_degree(uint64_t num_threads) {
-    if(num_threads < 1){ INVALID_ARGUMENT("num_threads < 1: " << num_threads); }
-    m_num_threads = num_threads;
-}
-
-void UpdatesShortReadsExperiment::set_build_frequency(std::chrono::milliseconds millisecs){
-    m_build_frequency = millisecs;
-}
+vector<double> short_reads_mix_from_string(const string& value){
+    vector<double> weights(num_short_read_operations, 0.0);
+
+    stringstream ss { value };
+    string entry;
+    while(getline(ss, entry, ',')){
+        entry.erase(std::remove_if(begin(entry), end(entry), ::isspace), end(entry));
+        auto equal = entry.find('=');
+        if(equal == string::npos){ INVALID_ARGUMENT("Invalid entry: `" << entry << "'. Expected <operation>=<weight>"); }
+        string name = entry.substr(0, equal);
+        int operation = 0;
+        while(operation < num_short_read_operations && short_read_operation_to_string(static_cast<ShortReadOperation>(operation)) != name){ operation++; }
+        if(operation == num_short_read_operations){ INVALID_ARGUMENT("Invalid operation: `" << name << "'. Expected one of has_edge, get_weight, one_hop or two_hops"); }
+        try {
+            weights[operation] = stod(entry.substr(equal +1));
+        } catch(std::logic_error& e){
+            INVALID_ARGUMENT("Invalid weight in the entry: `" << entry << "'");
+        }
+        if(weights[operation] < 0){ INVALID_ARGUMENT("Negative weight in the entry: `" << entry << "'"); }
+    }
 
-void UpdatesShortReadsExperiment::set_release_memory(bool value){
-    m_release_driver_memory = value;
-}
+    if(all_of(begin(weights), end(weights), [](double w){ return w == 0; })){
+        INVALID_ARGUMENT("All operations have weight 0: `" << value << "'");
+    }
 
-void UpdatesShortReadsExperiment::set_report_progress(bool value){
-    m_report_progress = value;
+    return weights;
 }
 
-void UpdatesShortReadsExperiment::set_report_memory_footprint(bool value) {
-    m_report_memory_footprint = value;
+string short_reads_distribution_to_string(ShortReadsDistribution distribution){
+    switch(distribution){
+    case ShortReadsDistribution::UNIFORM: return "uniform";
+    case ShortReadsDistribution::ZIPF: return "zipf";
+    default: return "unknown";
+    }
 }
 
-void UpdatesShortReadsExperiment::set_num_reports_per_ops(uint64_t value){
-    if(value <= 0){ INVALID_ARGUMENT("The value specified must be >= 1, given: " << value); }
-    m_num_reports_per_operations = value;
+ShortReadsDistribution short_reads_distribution_from_string(const string& distribution){
+    if(distribution == "uniform"){
+        return ShortReadsDistribution::UNIFORM;
+    } else if (distribution == "zipf"){
+        return ShortReadsDistribution::ZIPF;
+    } else {
+        INVALID_ARGUMENT("Invalid distribution: `" << distribution << "'. Expected either `uniform' or `zipf'");
+    }
 }
 
-void UpdatesShortReadsExperiment::set_measure_latency(bool value){
-    m_measure_latency = value;
+UpdatesShortReadsExperiment::UpdatesShortReadsExperiment(Aging2Experiment& aging_experiment, shared_ptr<gfe::library::Interface> library) :
+        m_aging_experiment(aging_experiment), m_library(library), m_mix(short_reads_mix_from_string("has_edge=40,get_weight=20,one_hop=30,two_hops=10")), m_master(nullptr) {
 }
 
-void UpdatesShortReadsExperiment::set_timeout(std::chrono::seconds secs){
-    m_timeout = secs;
+UpdatesShortReadsExperiment::~UpdatesShortReadsExperiment() {
+    if (m_master != nullptr) {
+        delete m_master;
+        m_master = nullptr;
+    }
 }
 
-void UpdatesShortReadsExperiment::set_worker_granularity(uint64_t value){
-    if(value < 1){ INVALID_ARGUMENT("value < 1: " << value); }
-    m_worker_granularity = value;
+void UpdatesShortReadsExperiment::set_num_readers(uint64_t num_readers){
+    if(num_readers < 1){ INVALID_ARGUMENT("num_readers < 1: " << num_readers); }
+    m_num_readers = num_readers;
 }
 
-void UpdatesShortReadsExperiment::set_cooloff(std::chrono::seconds secs){
-    m_cooloff = secs;
+void UpdatesShortReadsExperiment::set_distribution(ShortReadsDistribution distribution){
+    m_distribution = distribution;
 }
 
-void UpdatesShortReadsExperiment::set_memfp(bool value){
-    m_memfp = value;
+void UpdatesShortReadsExperiment::set_zipf_exponent(double value){
+    if(value <= 0){ INVALID_ARGUMENT("value <= 0: " << value); }
+    m_zipf_exponent = value;
 }
 
-void UpdatesShortReadsExperiment::set_memfp_physical(bool value){
-    m_memfp_physical = value;
+void UpdatesShortReadsExperiment::set_mix(const vector<double>& weights){
+    if(weights.size() != num_short_read_operations){ INVALID_ARGUMENT("Expected " << num_short_read_operations << " weights, given: " << weights.size()); }
+    m_mix = weights;
 }
 
-void UpdatesShortReadsExperiment::set_memfp_threshold(uint64_t value) {
-    m_memfp_threshold = value;
+void UpdatesShortReadsExperiment::set_seed(uint64_t seed){
+    m_seed = seed;
 }
 
 UpdatesReadsMixedWorkloadResult UpdatesShortReadsExperiment::execute(){
-    if(m_library.get() == nullptr) ERROR("Library not set. Use #set_library to set it.");
-    if(m_path_log.empty()) ERROR("Path to the log file not set. Use #set_log to set it.")
-    m_master = new details::Aging2Master(*this);
+    if(m_library.get() == nullptr) ERROR("Library not set");
+    m_master = new details::UpdateShortReadsMaster(*this);
     auto result = m_master->execute();
 
     // Master should be deleted here to ensure the same thread that called the constructor it also calls the destructor
-    // So, the on_thread_init matches the on_thread_destroy.
     delete m_master;
     m_master = nullptr;
     return result;
 }
 
-double UpdatesShortReadsExperiment::progress_so_far() {
-    if (m_master == nullptr) {
-        return 0.0;
-    } else {
-        return m_master->progress_so_far();
-    }
-}
-}//namespace
\ No newline at end of file
+}//namespace
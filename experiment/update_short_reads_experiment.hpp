@@ -2,112 +2,90 @@
 // Created by zhou822 on 8/6/23.
 //
 
+#pragma once
+
 #include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
-
-#include"mixed_workload_result.hpp"
+#include <vector>
 
 // forward declarations
-namespace gfe::graph { class WeightedEdgeStream; }
+namespace gfe::experiment { class UpdatesReadsMixedWorkloadResult; }
+namespace gfe::experiment { class Aging2Experiment; }
 namespace gfe::experiment { class UpdatesShortReadsExperiment; }
-namespace gfe::experiment::details { class UpdateReadMaster; }
-namespace gfe::experiment::details { class Aging2Worker; }
-namespace gfe::experiment::details { class ReadWorker; }
-namespace gfe::library { class UpdateInterface; }
+namespace gfe::experiment::details { class UpdateShortReadsMaster; }
+namespace gfe::experiment::details { class ShortReadWorker; }
+namespace gfe::library { class Interface; }
 
 namespace gfe::experiment{
+
+    /**
+     * The operations issued by the readers in the short reads workload
+     * - HAS_EDGE: check whether an edge between two sampled vertices exists
+     * - GET_WEIGHT: retrieve the weight of the edge between two sampled vertices
+     * - ONE_HOP: retrieve the neighbours of a sampled vertex
+     * - TWO_HOPS: retrieve the neighbours of the neighbours of a sampled vertex
+     */
+    enum class ShortReadOperation { HAS_EDGE, GET_WEIGHT, ONE_HOP, TWO_HOPS };
+    constexpr int num_short_read_operations = 4;
+
+    // Get a string representation of the operation
+    std::string short_read_operation_to_string(ShortReadOperation operation);
+
+    // Parse the weights of the operations from a comma separated list of <operation>=<weight>, e.g. "has_edge=40,one_hop=60". Operations not given have weight 0.
+    std::vector<double> short_reads_mix_from_string(const std::string& value);
+
+    /**
+     * How the readers pick the vertices to read, among the vertices of the final graph
+     */
+    enum class ShortReadsDistribution { UNIFORM, ZIPF };
+
+    // Get a string representation of the distribution
+    std::string short_reads_distribution_to_string(ShortReadsDistribution distribution);
+
+    // Parse the distribution from a string ("uniform" or "zipf")
+    ShortReadsDistribution short_reads_distribution_from_string(const std::string& distribution);
+
+    /**
+     * Execute an aging experiment, while a pool of readers concurrently issues short, interactive reads (point lookups,
+     * 1-hop and 2-hop expansions) to the same library. The readers stop as soon as the aging experiment terminates.
+     *
+     * This class is not thread-safe.
+     */
     class UpdatesShortReadsExperiment {
-        //friend class Aging2Result;
-        friend class details::UpdateReadMaster;
-        friend class details::Aging2Worker;
-        friend class details::ReadWorker;
-
-        std::shared_ptr<gfe::library::UpdateInterface> m_library; // the library to evaluate
-        std::string m_path_log; // the path to the log file [graphlog] with the sequence of updates to perform
-        uint64_t m_num_threads = 1; // set the number of threads to use
-        uint64_t m_worker_granularity = 1024; // the granularity of a task for a worker, that is the number of contiguous operations (inserts/deletes) performed inside the threads between each invocation to the scheduler.
-        double m_max_weight = 1.0; // set the max weight for the edges to create
-        std::chrono::milliseconds m_build_frequency {0}; // the frequency to create a new delta/snapshot, that is invoking the method #build()
-        bool m_memfp = false; // whether to measure the memory footprint
-        bool m_memfp_physical = false; // whether to consider the physical or the virtual memory in the memory footprint
-        uint64_t m_memfp_threshold = 0; // forcedly stop the execution of the experiment when the readings of the memory footprint are above this threshold (0 = infinite)
-        bool m_release_driver_memory = true; // whether to release the driver's memory as the experiment proceeds. Otherwise, it's only released at the end of the experiment
-        bool m_report_memory_footprint = false; // whether to print to stdout the measurements observed for the memory footprint
-        bool m_report_progress = false; // whether to report the current progress
-        uint64_t m_num_reports_per_operations = 1; // how often to save in the database progress done
-        bool m_measure_latency = false; // whether to measure the latency of updates
-        std::chrono::seconds m_timeout {0}; // max time to run the simulation (excl. cool-off time)
-        std::chrono::seconds m_cooloff {0}; // number of seconds to wait after the experiment terminates, to check the effectiveness of the GC
-
-        details::UpdateReadMaster* m_master;
+        friend class details::UpdateShortReadsMaster;
+        friend class details::ShortReadWorker;
+
+        Aging2Experiment& m_aging_experiment; // the writers
+        std::shared_ptr<gfe::library::Interface> m_library; // the library to evaluate
+        uint64_t m_num_readers = 1; // number of reader threads
+        ShortReadsDistribution m_distribution = ShortReadsDistribution::UNIFORM; // how to pick the vertices to read
+        double m_zipf_exponent = 0.99; // the skew of the Zipf distribution
+        std::vector<double> m_mix; // the weight of each operation, indexed by ShortReadOperation
+        uint64_t m_seed = 5051789ull; // seed for the random generators of the readers
+
+        details::UpdateShortReadsMaster* m_master;
     public:
-        UpdatesShortReadsExperiment();
+        UpdatesShortReadsExperiment(Aging2Experiment& aging_experiment, std::shared_ptr<gfe::library::Interface> library);
         ~UpdatesShortReadsExperiment();
 
-        // Set the library to evaluate
-        void set_library(std::shared_ptr<gfe::library::UpdateInterface> library);
-
-        // Set the path to the log file with all updates
-        void set_log(const std::string& path_log);
-
-        // Set the max weight for the edges created
-        void set_max_weight(double value);
-
-        // Set the number of client threads to use in the experiment, that is, the parallelism degree
-        void set_parallelism_degree(uint64_t num_threads);
-
-        // Set how frequently create a new snapshot/delta in the library (0 = do not create new snapshots)
-        void set_build_frequency(std::chrono::milliseconds millisecs);
-
-        // whether to release the driver's memory as the experiment proceeds. Otherwise, it's only released at the end of the experiment
-        void set_release_memory(bool value);
-
-        // Whether to print to stdout the current progress of the experiment
-        void set_report_progress(bool value);
+        // Set the number of reader threads
+        void set_num_readers(uint64_t num_readers);
 
-        // Whether to print to stdout the measurements observed for the memory footprint
-        void set_report_memory_footprint(bool value);
+        // Set how the readers pick the vertices to read
+        void set_distribution(ShortReadsDistribution distribution);
 
-        // Set how often to save in the database the progress done. The minimum value is 1.
-        // A value of N, implies that there will N reports every `num_edges' operations. For instance:
-        // with N = 1, it will save the progress after 1x, 2x, 3x, 4x, ..., 9x, 10x operations
-        // with N = 2, it will save the progress after 0.5x, 1x, 1.5x, 2x, ..., 9x, 9.5x, 10x operations
-        // with N = 4, it will save the progress after 0.25x, 0.5x, 0.75, 1x, 1.25x, ... operations
-        void set_num_reports_per_ops(uint64_t value);
+        // Set the exponent of the Zipf distribution
+        void set_zipf_exponent(double value);
 
-        // Measure the latency of updates?
-        void set_measure_latency(bool value);
+        // Set the weights of the operations, indexed by ShortReadOperation
+        void set_mix(const std::vector<double>& weights);
 
-        // Set the max time to run the experiment
-        void set_timeout(std::chrono::seconds secs);
-
-        // Cool-off period. Number of seconds to wait idle after the simulation terminated, measuring the memory footprint
-        void set_cooloff(std::chrono::seconds secs);
-
-        // Measure the memory footprint?
-        void set_memfp(bool value);
-        void set_measure_memfp(bool value){ set_memfp(value); }
-
-        // Whether to measure the phyical memory or the virtual memory in the memory footprint
-        void set_memfp_physical(bool value);
-
-        // Forcedly stop the execution of the experiment when the readings of the memory footprint are above this threshold (0 = infinite)
-        void set_memfp_threshold(uint64_t value);
-
-        // [Internal parameter]
-        // Set the granularity of a task for a worker thread. This is the number of contiguos operations (inserts/deletes) done
-        // by each worker thread between each invocation to the scheduler.
-        void set_worker_granularity(uint64_t value);
+        // Set the seed for the random generators of the readers
+        void set_seed(uint64_t seed);
 
         // Execute the experiment with the given configuration
-        // @param reset_graph if true, release the contained graph before running the experiment, to save some memory
         UpdatesReadsMixedWorkloadResult execute();
-
-        double progress_so_far();
     };
 }//namespace
-
-
-
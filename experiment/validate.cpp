@@ -17,79 +17,92 @@
 
 #include "validate.hpp"
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "common/timer.hpp"
 #include "graph/edge_stream.hpp"
 #include "library/interface.hpp"
 #include "configuration.hpp"
 
+using namespace common;
 using namespace std;
 
 namespace gfe::experiment {
 
-uint64_t validate_updates(shared_ptr<gfe::library::Interface> ptr_interface, shared_ptr<gfe::graph::WeightedEdgeStream> ptr_stream) {
+uint64_t validate_updates(shared_ptr<gfe::library::Interface> ptr_interface, shared_ptr<gfe::graph::WeightedEdgeStream> ptr_stream, uint64_t max_errors, uint64_t num_threads) {
     auto interface = ptr_interface.get();
-    auto stream = ptr_stream;
+    auto stream = ptr_stream.get();
 
     LOG("Validation started");
+    Timer timer;
+    timer.start();
 
-    uint64_t num_threads = thread::hardware_concurrency();
+    if(num_threads == 0) num_threads = thread::hardware_concurrency();
     interface->on_main_init(num_threads);
-    atomic<int64_t> num_errors = 0;
+    constexpr uint64_t shard_sz = 1ull << 16; // number of edges checked at the time by a thread
+    constexpr uint64_t max_errors_logged = 100; // do not flood the stdout
+    const uint64_t num_edges = stream->num_edges();
+    const bool has_weights = interface->has_weights();
+    const bool is_undirected = interface->is_undirected();
+    atomic<uint64_t> next_shard = 0;
+    atomic<uint64_t> num_errors = 0;
+
+    auto report_error = [&num_errors](uint64_t i, const graph::WeightedEdge& edge, const char* direction, double retrieved){
+        uint64_t error_id = num_errors++;
+        if(error_id < max_errors_logged){
+            LOG("ERROR [" << i << "] Edge mismatch " << edge.source() << direction << edge.destination() << ", retrieved weight: " << retrieved << ", expected: " << edge.weight());
+        } else if (error_id == max_errors_logged){
+            LOG("Too many validation errors, further errors will not be reported ...");
+        }
+    };
 
-    auto routine = [stream, interface, &num_errors](int thread_id, uint64_t from, uint64_t to){
+    auto routine = [&](int thread_id){
         interface->on_thread_init(thread_id);
 
-        for(uint64_t i = from; i < to; i++){
-            auto edge = stream->get(i);
-            if (interface->has_weights()) {
-              auto w1 = interface->get_weight(edge.source(), edge.destination());
-              if(w1 != edge.m_weight){
-                LOG("ERROR [" << i << "] Edge mismatch " << edge.source() << " -> " << edge.destination() << ", retrieved weight: " << w1 << ", expected: " << edge.weight());
-                num_errors++;
-              }
-              if(interface->is_undirected()){
-                auto w2 = interface->get_weight(edge.destination(), edge.source());
-                if(w2 != edge.m_weight){
-                  LOG("ERROR [" << i << "] Edge mismatch " << edge.source() << " <- " << edge.destination() << ", retrieved weight: " << w1 << ", expected: " << edge.weight());
-                  num_errors++;
+        uint64_t from = 0;
+        while((from = next_shard.fetch_add(shard_sz)) < num_edges){
+            if(max_errors > 0 && num_errors.load(memory_order_relaxed) >= max_errors) break; // early exit
+            uint64_t to = min(num_edges, from + shard_sz);
+
+            for(uint64_t i = from; i < to; i++){
+                auto edge = stream->get(i);
+                if (has_weights) {
+                    auto w1 = interface->get_weight(edge.source(), edge.destination());
+                    if(w1 != edge.m_weight){ report_error(i, edge, " -> ", w1); }
+                    if(is_undirected){
+                        auto w2 = interface->get_weight(edge.destination(), edge.source());
+                        if(w2 != edge.m_weight){ report_error(i, edge, " <- ", w2); }
+                    }
+                } else {
+                    auto w1 = interface->has_edge(edge.source(), edge.destination());
+                    if(!w1){ report_error(i, edge, " -> ", w1); }
+                    if(is_undirected) {
+                        auto w2 = interface->has_edge(edge.destination(), edge.source());
+                        if (!w2) { report_error(i, edge, " <- ", w2); }
+                    }
                 }
-              }
-            } else {
-              auto w1 = interface->has_edge(edge.source(), edge.destination());
-              if(!w1){
-                  LOG("ERROR [" << i << "] Edge mismatch " << edge.source() << " -> " << edge.destination() << ", retrieved weight: " << w1 << ", expected: " << edge.weight());
-                  num_errors++;
-              }
-              if(interface->is_undirected()) {
-                auto w2 = interface->has_edge(edge.destination(), edge.source());
-                if (!w2) {
-                  LOG("ERROR [" << i << "] Edge mismatch " << edge.source() << " <- " << edge.destination()
-                                << ", retrieved weight: " << w1 << ", expected: " << edge.weight());
-                  num_errors++;
-                }
-              }
             }
         }
+
         interface->on_thread_destroy(thread_id);
     };
 
-
-    uint64_t edges_per_thread = stream->num_edges() / num_threads;
-    uint64_t odd_threads = stream->num_edges() % num_threads;
-
     vector<thread> threads;
-    uint64_t from = 0;
     for(uint64_t i = 0; i < num_threads; i++){
-        uint64_t to = from + edges_per_thread + (i < odd_threads);
-        threads.emplace_back(routine, i, from, to);
-        from = to;
+        threads.emplace_back(routine, i);
     }
 
     for(auto& t: threads) t.join();
 
     interface->on_main_destroy();
+    timer.stop();
 
     if(num_errors == 0){
-        LOG("Validation succeeded");
+        LOG("Validation succeeded in " << timer);
+    } else if (max_errors > 0 && num_errors >= max_errors) {
+        LOG("Validation interrupted after " << num_errors << " errors (limit: " << max_errors << ")");
     } else {
         LOG("Number of validation errors: " << num_errors);
     }
@@ -98,6 +111,3 @@ uint64_t validate_updates(shared_ptr<gfe::library::Interface> ptr_interface, sha
 }
 
 } // namespace
-
-
-
@@ -27,7 +27,9 @@ namespace gfe::experiment {
 
 /**
  * Check that all edges in the stream are contained in the interface. Report the number of missing vertices (0 => validation successful).
+ * The stream is split in shards, processed in parallel by `num_threads' threads (0 => number of hardware threads).
+ * The validation stops as soon as `max_errors' have been found (0 => no limit).
  */
-uint64_t validate_updates(std::shared_ptr<gfe::library::Interface> interface, std::shared_ptr<gfe::graph::WeightedEdgeStream> stream);
+uint64_t validate_updates(std::shared_ptr<gfe::library::Interface> interface, std::shared_ptr<gfe::graph::WeightedEdgeStream> stream, uint64_t max_errors = 0, uint64_t num_threads = 0);
 
 } // namespace
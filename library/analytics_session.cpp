@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "analytics_session.hpp"
+
+#include <cassert>
+
+#include "baseline/csr.hpp"
+#include "interface.hpp"
+
+using namespace std;
+
+namespace gfe::library {
+
+/*****************************************************************************
+ *                                                                           *
+ *  AnalyticsSession                                                         *
+ *                                                                           *
+ *****************************************************************************/
+AnalyticsSession::AnalyticsSession() { }
+AnalyticsSession::~AnalyticsSession() { }
+
+bool AnalyticsSession::materialize_csr(){
+    return false; // not supported
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  ForwardingAnalyticsSession                                               *
+ *                                                                           *
+ *****************************************************************************/
+ForwardingAnalyticsSession::ForwardingAnalyticsSession(GraphalyticsInterface* interface) : m_interface(interface) {
+    assert(m_interface != nullptr);
+}
+
+void ForwardingAnalyticsSession::bfs(uint64_t source_vertex_id, const char* dump2file){
+    m_interface->bfs(source_vertex_id, dump2file);
+}
+
+void ForwardingAnalyticsSession::pagerank(uint64_t num_iterations, double damping_factor, const char* dump2file){
+    m_interface->pagerank(num_iterations, damping_factor, dump2file);
+}
+
+void ForwardingAnalyticsSession::wcc(const char* dump2file){
+    m_interface->wcc(dump2file);
+}
+
+void ForwardingAnalyticsSession::sssp(uint64_t source_vertex_id, const char* dump2file){
+    m_interface->sssp(source_vertex_id, dump2file);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  AnalyticsSnapshot                                                        *
+ *                                                                           *
+ *****************************************************************************/
+AnalyticsSnapshot::AnalyticsSnapshot(uint64_t max_vertex_id) : m_max_vertex_id(max_vertex_id),
+        m_int2ext(new uint64_t[max_vertex_id]), m_degrees(new uint64_t[max_vertex_id]){
+    #pragma omp parallel for
+    for(uint64_t v = 0; v < m_max_vertex_id; v++){
+        m_int2ext[v] = NO_VERTEX;
+        m_degrees[v] = NO_VERTEX;
+    }
+}
+
+void AnalyticsSnapshot::seal(bool is_directed){
+    uint64_t num_vertices = 0;
+    uint64_t sum_degrees = 0;
+
+    #pragma omp parallel for reduction(+:num_vertices, sum_degrees)
+    for(uint64_t v = 0; v < m_max_vertex_id; v++){
+        if(m_int2ext[v] == NO_VERTEX) continue;
+        num_vertices++;
+        sum_degrees += m_degrees[v];
+    }
+
+    m_num_vertices = num_vertices;
+    m_num_edges = is_directed ? sum_degrees : sum_degrees / 2;
+}
+
+} // namespace
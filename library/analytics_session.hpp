@@ -0,0 +1,196 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace gfe::library {
+
+// forward declarations
+class CSR;
+class GraphalyticsInterface;
+
+/**
+ * A session to run a suite of Graphalytics kernels over the same snapshot of the graph. The session is created with
+ * GraphalyticsInterface#begin_analytics_session and the snapshot is released when the session is destroyed.
+ *
+ * Implementations open the snapshot once and materialise the state shared by the kernels, such as the mapping between
+ * the internal and the external vertex IDs and the degree of each vertex, so that this cost is paid once per session
+ * rather than once per kernel. The semantics of the kernels are the same of the homonym methods in GraphalyticsInterface.
+ *
+ * Optionally, the snapshot can be copied into the CSR of the baseline with #materialize_csr. Afterwards, the kernels of the
+ * session run on the CSR rather than on the native data structures of the library.
+ */
+class AnalyticsSession {
+    AnalyticsSession(const AnalyticsSession&) = delete;
+    AnalyticsSession& operator=(const AnalyticsSession&) = delete;
+
+protected:
+    std::unique_ptr<CSR> m_csr; // the snapshot materialised into a CSR, if requested with #materialize_csr
+
+public:
+    AnalyticsSession();
+
+    // Release the snapshot
+    virtual ~AnalyticsSession();
+
+    /**
+     * Copy the snapshot into a CSR, scanning the library in parallel. The following kernels of the session run on the CSR.
+     * @return false if the library does not support the materialisation, true otherwise
+     */
+    virtual bool materialize_csr();
+
+    // Retrieve the CSR with the materialised snapshot, or nullptr if #materialize_csr has not been invoked
+    CSR* csr() const { return m_csr.get(); }
+
+    /**
+     * Perform a BFS from source_vertex_id to all the other vertices in the graph.
+     * @param source_vertex_id the vertex where to start the search
+     * @param dump2file if not null, dump the result in the given path, following the format expected by the benchmark specification
+     */
+    virtual void bfs(uint64_t source_vertex_id, const char* dump2file = nullptr) = 0;
+
+    /**
+     * Execute the PageRank algorithm for the specified number of iterations.
+     * @param num_iterations the number of iterations to execute the algorithm
+     * @param damping_factor weight for the PageRank algorithm, it affects the score associated to the sink nodes in the graphs
+     * @param dump2file if not null, dump the result in the given path, following the format expected by the benchmark specification
+     */
+    virtual void pagerank(uint64_t num_iterations, double damping_factor = 0.85, const char* dump2file = nullptr) = 0;
+
+    /**
+     * Weakly connected components (WCC), associate each node to a connected component of the graph
+     * @param dump2file if not null, dump the result in the given path, following the format expected by the benchmark specification
+     */
+    virtual void wcc(const char* dump2file = nullptr) = 0;
+
+    /**
+     * Single-source shortest paths. Compute the weight related to the shortest path from the source to any other vertex in the graph.
+     * @param source_vertex_id the vertex where to start the search
+     * @param dump2file if not null, dump the result in the given path, following the format expected by the benchmark specification
+     */
+    virtual void sssp(uint64_t source_vertex_id, const char* dump2file = nullptr) = 0;
+};
+
+/**
+ * The default session, for the libraries without a shared snapshot: each kernel is forwarded to the interface and
+ * opens its own snapshot, as in the standalone execution.
+ */
+class ForwardingAnalyticsSession : public AnalyticsSession {
+    GraphalyticsInterface* m_interface; // the library where to forward the kernels
+
+public:
+    ForwardingAnalyticsSession(GraphalyticsInterface* interface);
+
+    void bfs(uint64_t source_vertex_id, const char* dump2file = nullptr) override;
+    void pagerank(uint64_t num_iterations, double damping_factor = 0.85, const char* dump2file = nullptr) override;
+    void wcc(const char* dump2file = nullptr) override;
+    void sssp(uint64_t source_vertex_id, const char* dump2file = nullptr) override;
+};
+
+/**
+ * The state of a snapshot shared by the kernels of an analytics session, over the dense domain [0, max_vertex_id) of
+ * the internal vertex IDs of the library. Slots of the domain without a vertex in the snapshot are marked as NO_VERTEX.
+ *
+ * The state is filled by the implementation with #set_vertex, in parallel over distinct vertices, and then frozen with #seal.
+ */
+class AnalyticsSnapshot {
+    AnalyticsSnapshot(const AnalyticsSnapshot&) = delete;
+    AnalyticsSnapshot& operator=(const AnalyticsSnapshot&) = delete;
+
+public:
+    constexpr static uint64_t NO_VERTEX = std::numeric_limits<uint64_t>::max(); // marker for the slots without a vertex
+
+private:
+    const uint64_t m_max_vertex_id; // the size of the domain of the internal vertex IDs
+    std::unique_ptr<uint64_t[]> m_int2ext; // map each internal vertex ID into its external vertex ID, or NO_VERTEX
+    std::unique_ptr<uint64_t[]> m_degrees; // the out degree of each internal vertex ID, or NO_VERTEX
+    uint64_t m_num_vertices = 0; // the number of vertices in the snapshot, set by #seal
+    uint64_t m_num_edges = 0; // the number of edges in the snapshot, set by #seal
+
+public:
+    /**
+     * Create the state for the given domain of internal vertex IDs. Initially all slots are marked as NO_VERTEX.
+     */
+    AnalyticsSnapshot(uint64_t max_vertex_id);
+
+    // Record the given vertex. Thread safe, as long as different threads record distinct vertices.
+    void set_vertex(uint64_t internal_id, uint64_t external_id, uint64_t degree){
+        m_int2ext[internal_id] = external_id;
+        m_degrees[internal_id] = degree;
+    }
+
+    /**
+     * Compute the number of vertices and edges in the snapshot, once all vertices have been recorded.
+     * @param is_directed whether the graph is directed. In undirected graphs, each edge is counted once, although it appears
+     *        in the degrees of both its endpoints.
+     */
+    void seal(bool is_directed);
+
+    // Retrieve the size of the domain of the internal vertex IDs
+    uint64_t max_vertex_id() const { return m_max_vertex_id; }
+
+    // Retrieve the number of vertices in the snapshot
+    uint64_t num_vertices() const { return m_num_vertices; }
+
+    // Retrieve the number of edges in the snapshot
+    uint64_t num_edges() const { return m_num_edges; }
+
+    // Check whether the given internal vertex ID exists in the snapshot
+    bool has_vertex(uint64_t internal_id) const { return internal_id < m_max_vertex_id && m_int2ext[internal_id] != NO_VERTEX; }
+
+    // Retrieve the out degree of each internal vertex ID, or NO_VERTEX
+    const uint64_t* degrees() const { return m_degrees.get(); }
+
+    // Retrieve the external vertex ID of each internal vertex ID, or NO_VERTEX
+    const uint64_t* int2ext() const { return m_int2ext.get(); }
+
+    /**
+     * Translate the result of a kernel, indexed by the internal vertex IDs, into pairs <external vertex ID, value>. The slots
+     * without a vertex are mapped into the pair <NO_VERTEX, numeric_limits<T>::max()>.
+     */
+    template<typename T>
+    std::vector<std::pair<uint64_t, T>> translate(const T* values) const;
+};
+
+/*****************************************************************************
+ *                                                                           *
+ *  Implementation details                                                   *
+ *                                                                           *
+ *****************************************************************************/
+template<typename T>
+std::vector<std::pair<uint64_t, T>> AnalyticsSnapshot::translate(const T* values) const {
+    std::vector<std::pair<uint64_t, T>> output(m_max_vertex_id);
+
+    #pragma omp parallel for
+    for(uint64_t v = 0; v < m_max_vertex_id; v++){
+        if(m_int2ext[v] == NO_VERTEX){
+            output[v] = std::make_pair(NO_VERTEX, std::numeric_limits<T>::max());
+        } else {
+            output[v] = std::make_pair(m_int2ext[v], values[v]);
+        }
+    }
+
+    return output;
+}
+
+} // namespace
@@ -120,6 +120,18 @@ double AdjacencyList::get_weight(uint64_t source, uint64_t destination) const {
     return result->second;
 }
 
+bool AdjacencyList::scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const {
+    shared_lock<mutex_t> lock(m_mutex);
+    auto vertex_src = m_adjacency_list.find(vertex);
+    if(vertex_src == end(m_adjacency_list)) return false;
+
+    for(const auto& edge : vertex_src->second.first){
+        if(!visitor(edge.first, edge.second)) break;
+    }
+
+    return true;
+}
+
 uint64_t AdjacencyList::get_degree(uint64_t vertex_id) const {
     auto vertex = m_adjacency_list.find(vertex_id);
     assert(vertex != end(m_adjacency_list) && "The given edge does not exist");
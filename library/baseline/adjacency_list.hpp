@@ -120,6 +120,11 @@ public:
      */
     virtual double get_weight(uint64_t source, uint64_t destination) const;
 
+    /**
+     * Visit the outgoing edges of the given vertex
+     */
+    virtual bool scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const;
+
     /**
      * Dump the content of the graph to the given output stream
      */
@@ -37,8 +37,10 @@
 #include "common/timer.hpp"
 #include "graph/edge_stream.hpp"
 #include "graph/vertex_list.hpp"
+#include "library/analytics_session.hpp"
 #include "third-party/gapbs/gapbs.hpp"
 #include "third-party/libcuckoo/cuckoohash_map.hh"
+#include "utility/result_writer.hpp"
 #include "utility/timeout_service.hpp"
 
 using namespace common;
@@ -172,6 +174,18 @@ double CSR::get_weight(uint64_t source, uint64_t destination) const {
     return numeric_limits<double>::signaling_NaN();
 }
 
+bool CSR::scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const {
+    auto it = m_ext2log.find(vertex);
+    if(it == m_ext2log.end()) return false;
+
+    auto offset = get_out_interval(it->second);
+    for(uint64_t i = offset.first, end = offset.second; i < end; i++){
+        if(!visitor(m_log2ext[m_out_e[i]], m_out_w[i])) break;
+    }
+
+    return true;
+}
+
 pair<uint64_t, uint64_t> CSR::get_out_interval(uint64_t logical_vertex_id) const {
     return get_interval_impl(m_out_v, logical_vertex_id);
 }
@@ -396,6 +410,113 @@ void CSR::load_undirected(gfe::graph::WeightedEdgeStream& stream){
     m_out_w = m_in_w = ptr_out_w_undirected.release();
 }
 
+/*****************************************************************************
+ *                                                                           *
+ *  Materialisation of a snapshot                                            *
+ *                                                                           *
+ *****************************************************************************/
+void CSR::materialize_begin(const AnalyticsSnapshot& snapshot){
+    if(m_out_v != nullptr) ERROR("Already initialised & loaded");
+
+    const uint64_t max_vertex_id = snapshot.max_vertex_id();
+    const uint64_t* __restrict int2ext = snapshot.int2ext();
+    const uint64_t* __restrict degrees = snapshot.degrees();
+    m_num_vertices = snapshot.num_vertices();
+    m_num_edges = snapshot.num_edges();
+
+    // assign the logical IDs in the same order of the internal IDs, the vertex array is the prefix sum of the degrees
+    m_materialize_int2log.reset(new uint64_t[max_vertex_id]);
+    m_log2ext = alloca_array<uint64_t>(m_num_vertices);
+    m_out_v = alloca_array<uint64_t>(m_num_vertices);
+    m_ext2log.reserve(m_num_vertices);
+    uint64_t logical_id = 0;
+    uint64_t sum_degrees = 0;
+    for(uint64_t v = 0; v < max_vertex_id; v++){
+        if(int2ext[v] == AnalyticsSnapshot::NO_VERTEX){
+            m_materialize_int2log[v] = numeric_limits<uint64_t>::max();
+        } else {
+            m_materialize_int2log[v] = logical_id;
+            m_log2ext[logical_id] = int2ext[v];
+            m_ext2log[int2ext[v]] = logical_id;
+            sum_degrees += degrees[v];
+            m_out_v[logical_id] = sum_degrees;
+            logical_id++;
+        }
+    }
+    assert(logical_id == m_num_vertices);
+
+    m_out_e = alloca_array<uint64_t>(sum_degrees);
+    m_out_w = alloca_array<double>(sum_degrees);
+}
+
+// Sort the edges of each vertex by their destination, as expected by #get_weight and the intersections in LCC
+static void materialize_sort(uint64_t num_vertices, const uint64_t* __restrict vertex_array, uint64_t* __restrict edge_array, double* __restrict weight_array){
+    #pragma omp parallel
+    {
+        vector<pair<uint64_t, double>> edges; // reused across the vertices of the thread
+
+        #pragma omp for schedule(dynamic, 4096)
+        for(uint64_t v = 0; v < num_vertices; v++){
+            uint64_t start = v == 0 ? 0 : vertex_array[v -1];
+            uint64_t end = vertex_array[v];
+            if(is_sorted(edge_array + start, edge_array + end)) continue; // e.g. Teseo
+
+            edges.clear();
+            for(uint64_t i = start; i < end; i++){ edges.emplace_back(edge_array[i], weight_array[i]); }
+            sort(edges.begin(), edges.end());
+            for(uint64_t i = start; i < end; i++){
+                edge_array[i] = edges[i - start].first;
+                weight_array[i] = edges[i - start].second;
+            }
+        }
+    }
+}
+
+void CSR::materialize_end(){
+    m_materialize_int2log.reset();
+    materialize_sort(m_num_vertices, m_out_v, m_out_e, m_out_w);
+
+    if(!m_is_directed){ // the incoming edges are the outgoing edges
+        m_in_v = m_out_v;
+        m_in_e = m_out_e;
+        m_in_w = m_out_w;
+        return;
+    }
+
+    // count the incoming edges of each vertex
+    m_in_v = alloca_array<uint64_t>(m_num_vertices); // init to 0
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for(uint64_t v = 0; v < m_num_vertices; v++){
+        auto interval = get_out_interval(v);
+        for(uint64_t i = interval.first; i < interval.second; i++){
+            __atomic_add_fetch(m_in_v + m_out_e[i], 1, __ATOMIC_RELAXED);
+        }
+    }
+    for(uint64_t v = 1; v < m_num_vertices; v++){
+        m_in_v[v] += m_in_v[v -1];
+    }
+
+    // place each edge in the interval of its destination, the cursors start at the beginning of the intervals
+    unique_ptr<uint64_t[]> ptr_cursors { new uint64_t[m_num_vertices] };
+    uint64_t* __restrict cursors = ptr_cursors.get();
+    #pragma omp parallel for
+    for(uint64_t v = 0; v < m_num_vertices; v++){
+        cursors[v] = v == 0 ? 0 : m_in_v[v -1];
+    }
+    m_in_e = alloca_array<uint64_t>(m_num_edges);
+    m_in_w = alloca_array<double>(m_num_edges);
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for(uint64_t v = 0; v < m_num_vertices; v++){
+        auto interval = get_out_interval(v);
+        for(uint64_t i = interval.first; i < interval.second; i++){
+            uint64_t position = __atomic_fetch_add(cursors + m_out_e[i], 1, __ATOMIC_RELAXED);
+            m_in_e[position] = v;
+            m_in_w[position] = m_out_w[i];
+        }
+    }
+    materialize_sort(m_num_vertices, m_in_v, m_in_e, m_in_w);
+}
+
 /*****************************************************************************
  *                                                                           *
  *  Dump                                                                     *
@@ -452,22 +573,7 @@ template <typename T, bool negative_scores>
 void CSR::save_results(const vector<pair<uint64_t, T>>& result, const char* dump2file) {
     assert(dump2file != nullptr);
     COUT_DEBUG("save the results to: " << dump2file);
-
-    fstream handle(dump2file, ios_base::out);
-    if (!handle.good()) ERROR("Cannot save the result to `" << dump2file << "'");
-
-    for (const auto &p : result) {
-        handle << p.first << " ";
-
-        if(!negative_scores && p.second < 0){
-            handle << numeric_limits<T>::max();
-        } else {
-            handle << p.second;
-        }
-
-        handle << "\n";
-    }
-    handle.close();
+    utility::save_results(result, dump2file, negative_scores);
 }
 
 /*****************************************************************************
@@ -1260,6 +1366,7 @@ gapbs::pvector<WeightT> CSR::do_sssp(uint64_t source, double delta, utility::Tim
     // two element arrays for double buffering curr=iter&1, next=(iter+1)&1
     size_t shared_indexes[2] = {0, kMaxBin};
     size_t frontier_tails[2] = {1, 0};
+    bool timed_out = false; // set by a single thread, read by all threads after the barrier at the end of each iteration
     frontier[0] = source;
     uint64_t* __restrict out_e = m_out_e;
     double* __restrict out_w = m_out_w;
@@ -1269,13 +1376,14 @@ gapbs::pvector<WeightT> CSR::do_sssp(uint64_t source, double delta, utility::Tim
         vector<vector<NodeID> > local_bins(0);
         size_t iter = 0;
 
-        while (shared_indexes[iter&1] != kMaxBin) {
+        while (shared_indexes[iter&1] != kMaxBin && !timed_out) {
             size_t &curr_bin_index = shared_indexes[iter&1];
             size_t &next_bin_index = shared_indexes[(iter+1)&1];
             size_t &curr_frontier_tail = frontier_tails[iter&1];
             size_t &next_frontier_tail = frontier_tails[(iter+1)&1];
             #pragma omp for nowait schedule(dynamic, 64)
             for (size_t i=0; i < curr_frontier_tail; i++) {
+                if (timer.is_timeout()) continue; // exhausted the budget of available time
                 NodeID u = frontier[i];
                 if (dist[u] >= delta * static_cast<WeightT>(curr_bin_index)) {
                     const auto u_interval = get_out_interval(u);
@@ -1319,6 +1427,7 @@ gapbs::pvector<WeightT> CSR::do_sssp(uint64_t source, double delta, utility::Tim
             {
                 curr_bin_index = kMaxBin;
                 curr_frontier_tail = 0;
+                timed_out = timer.is_timeout();
             }
 
             if (next_bin_index < local_bins.size()) {
@@ -18,8 +18,10 @@
 #pragma once
 
 #include <atomic>
+#include <cassert>
 #include <chrono>
 #include <cinttypes>
+#include <limits>
 #include <memory>
 #include <thread>
 #include <unordered_map>
@@ -38,6 +40,8 @@ void _bm_run_csr(); // bm experiment
 
 namespace gfe::library {
 
+class AnalyticsSnapshot; // forward declaration
+
 class CSR : public virtual LoaderInterface, public virtual RandomVertexInterface, public virtual GraphalyticsInterface  {
     friend void ::_bm_run_csr();
 
@@ -55,6 +59,7 @@ protected:
     double* m_in_w {nullptr}; // weights associated to the incoming edges
     uint64_t m_timeout = 0; // max time to complete a kernel of the graphalytics suite, in seconds
     const bool m_numa_interleaved; // whether to use libnuma to allocate the internal arrays
+    std::unique_ptr<uint64_t[]> m_materialize_int2log; // map the internal vertex IDs of the library into logical vertex IDs, only while materialising a snapshot
 
     // Retrieve the [start, end) interval for the outgoing edges associated to the given logical vertex
     std::pair<uint64_t, uint64_t> get_out_interval(uint64_t logical_vertex_id) const;
@@ -149,6 +154,11 @@ public:
      */
     double get_weight(uint64_t source, uint64_t destination) const;
 
+    /**
+     * Visit the outgoing edges of the given vertex
+     */
+    bool scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const;
+
     /**
      * Check whether the graph is directed
      */
@@ -160,6 +170,24 @@ public:
     void load(const std::string& path);
     void load(gfe::graph::WeightedEdgeStream& stream); // it modifies the stream
 
+    /**
+     * Materialise the snapshot of a dynamic library into the CSR, to run the kernels of the baseline on it.
+     * 1. #materialize_begin maps the vertices of the snapshot into logical vertex IDs and allocates the arrays from their degrees;
+     * 2. the library invokes #materialize_edge for each outgoing edge in the snapshot, in parallel over the source vertices;
+     * 3. #materialize_end sorts the edges of each vertex and, in directed graphs, builds the incoming edges.
+     * The vertex IDs given to #materialize_edge are the internal vertex IDs of the library, as in the snapshot.
+     */
+    void materialize_begin(const AnalyticsSnapshot& snapshot);
+    void materialize_edge(uint64_t internal_source, uint64_t position /* in the adjacency of the source, < its degree */, uint64_t internal_destination, double weight){
+        uint64_t source = m_materialize_int2log[internal_source];
+        uint64_t offset = (source == 0 ? 0 : m_out_v[source -1]) + position;
+        assert(offset < m_out_v[source] && "The degree of the vertex in the snapshot is smaller than the number of edges visited");
+        assert(m_materialize_int2log[internal_destination] != std::numeric_limits<uint64_t>::max() && "The destination does not exist in the snapshot");
+        m_out_e[offset] = m_materialize_int2log[internal_destination];
+        m_out_w[offset] = weight;
+    }
+    void materialize_end();
+
     /**
      * Set the timeout for the Graphalytics kernels
      */
@@ -1987,6 +1987,7 @@ static gapbs::pvector<WeightT> graphone_execute_sssp(uint64_t num_vertices, uint
     // two element arrays for double buffering curr=iter&1, next=(iter+1)&1
     size_t shared_indexes[2] = {0, kMaxBin};
     size_t frontier_tails[2] = {1, 0};
+    bool timed_out = false; // set by a single thread, read by all threads after the barrier at the end of each iteration
     frontier[0] = source;
 
     #pragma omp parallel
@@ -1996,13 +1997,14 @@ static gapbs::pvector<WeightT> graphone_execute_sssp(uint64_t num_vertices, uint
         lite_edge_t* neighbours = nullptr;
         uint64_t neighbours_sz = 0;
 
-        while (shared_indexes[iter&1] != kMaxBin) {
+        while (shared_indexes[iter&1] != kMaxBin && !timed_out) {
             size_t &curr_bin_index = shared_indexes[iter&1];
             size_t &next_bin_index = shared_indexes[(iter+1)&1];
             size_t &curr_frontier_tail = frontier_tails[iter&1];
             size_t &next_frontier_tail = frontier_tails[(iter+1)&1];
             #pragma omp for nowait schedule(dynamic, 64)
             for (size_t i=0; i < curr_frontier_tail; i++) {
+                if (timer.is_timeout()) continue; // exhausted the budget of available time
                 NodeID u = frontier[i];
                 if (dist[u] >= delta * static_cast<WeightT>(curr_bin_index)) {
 
@@ -2054,6 +2056,7 @@ static gapbs::pvector<WeightT> graphone_execute_sssp(uint64_t num_vertices, uint
             {
                 curr_bin_index = kMaxBin;
                 curr_frontier_tail = 0;
+                timed_out = timer.is_timeout();
             }
 
             if (next_bin_index < local_bins.size()) {
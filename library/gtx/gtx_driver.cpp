@@ -8,8 +8,10 @@
 
 #include "gtx_driver.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <iostream>
@@ -21,19 +23,21 @@
 
 #include "../../third-party/libcommon/include/lib/common/system.hpp"
 #include "../../third-party/libcommon/include/lib/common/timer.hpp"
-#include "tbb/concurrent_hash_map.h"
 #include "../../third-party/gapbs/gapbs.hpp"
 #include "../../third-party/libcuckoo/cuckoohash_map.hh"
 #include "GTX.hpp"
+#include "../vertex_dictionary.hpp"
+#include "../../configuration.hpp"
+#include "../../reader/reader.hpp"
+#include "../../utility/result_writer.hpp"
 #include "../../utility/timeout_service.hpp"
+#include "../../utility/vertex_sampler.hpp"
 
 using namespace common;
 using namespace libcuckoo;
 using namespace std;
 
 #define GTX reinterpret_cast<gt::Graph*>(m_pImpl)
-using vertex_dictionary_t = tbb::concurrent_hash_map<uint64_t, gt::vertex_t>;
-#define VertexDictionary reinterpret_cast<vertex_dictionary_t*>(m_pHashMap)
 
 /*****************************************************************************
  *                                                                           *
@@ -50,14 +54,14 @@ namespace gfe { extern mutex _log_mutex [[maybe_unused]]; }
 #endif
 
 namespace gfe::library {
-    GTXDriver::GTXDriver(bool is_directed, bool read_only):m_pImpl(nullptr), m_pHashMap(nullptr), m_is_directed(is_directed),m_read_only(read_only) {
+    GTXDriver::GTXDriver(bool is_directed, bool read_only):m_pImpl(nullptr), m_vertex_dictionary(nullptr), m_is_directed(is_directed),m_read_only(read_only) {
         m_pImpl = new gt::Graph();
-        m_pHashMap = new tbb::concurrent_hash_map<uint64_t, /* vertex_t */ uint64_t>();
+        m_vertex_dictionary = new VertexDictionary();
     }
 
     GTXDriver::~GTXDriver() noexcept {
         delete GTX; m_pImpl = nullptr;
-        delete VertexDictionary; m_pHashMap = nullptr;
+        delete m_vertex_dictionary; m_vertex_dictionary = nullptr;
     }
 
     void GTXDriver::set_worker_thread_num(uint64_t new_num) {
@@ -106,8 +110,8 @@ namespace gfe::library {
         return m_pImpl;
     }
 
-    void* GTXDriver::vertex_dictionary() {
-        return m_pHashMap;
+    VertexDictionary* GTXDriver::vertex_dictionary() {
+        return m_vertex_dictionary;
     }
 
     void GTXDriver::analytical_workload_end(){
@@ -118,9 +122,9 @@ namespace gfe::library {
         GTX->whole_label_graph_eager_consolidation(1);
     }
     uint64_t GTXDriver::ext2int(uint64_t external_vertex_id) const {
-        vertex_dictionary_t::const_accessor accessor;
-        if ( VertexDictionary->find(accessor, external_vertex_id ) ){
-            return accessor->second;
+        uint64_t internal_vertex_id = m_vertex_dictionary->find(external_vertex_id);
+        if ( internal_vertex_id != VertexDictionary::NOT_FOUND ){
+            return internal_vertex_id;
         } else {
             std::cout<<"unable to find the vertex "<<external_vertex_id<<std::endl;
             //ERROR("The given vertex does not exist: " << external_vertex_id);
@@ -128,65 +132,88 @@ namespace gfe::library {
             return 0;
         }
     }
-    //todo: check what should we do to support both read only and rw transaction here
-    uint64_t GTXDriver::int2ext(void* opaque_transaction, uint64_t internal_vertex_id) const {
-        //todo: if read_only, else
-        if(m_read_only){
-            auto transaction = reinterpret_cast<gt::SharedROTransaction*>(opaque_transaction);
-            string_view payload = transaction->get_vertex(internal_vertex_id);//they store external vid in the vertex data for experiments
-            if(payload.empty()){ // the vertex does not exist
-                return numeric_limits<uint64_t>::max();
-            } else {
-                return *(reinterpret_cast<const uint64_t*>(payload.data()));
-            }
-        }else{
-            //auto transaction = reinterpret_cast<gt::RWTransaction*>(opaque_transaction);
-            //todo:: libin changed it here, just always use this one for our experiment?
-            auto transaction = reinterpret_cast<gt::SharedROTransaction*>(opaque_transaction);
-            string_view payload = transaction->get_vertex(internal_vertex_id);//they store external vid in the vertex data for experiments
-            if(payload.empty()){ // the vertex does not exist
-                return numeric_limits<uint64_t>::max();
-            } else {
-                return *(reinterpret_cast<const uint64_t*>(payload.data()));
+    uint64_t GTXDriver::int2ext(uint64_t internal_vertex_id) const {
+        return m_vertex_dictionary->int2ext(internal_vertex_id);
+    }
+
+    uint64_t GTXDriver::create_vertex(uint64_t external_id) {
+        while(true){
+            auto tx = GTX->begin_read_write_transaction();
+            try {
+                gt::vertex_t internal_id = tx.new_vertex();
+                string_view data { (char*) &external_id, sizeof(external_id) };
+                tx.put_vertex(internal_id, data);
+                tx.commit();
+                return internal_id;
+            } catch(gt::RollbackExcept& e){
+                tx.abort();
+                COUT_DEBUG("Rollback, vertex id: " << external_id);
+                // retry ...
             }
         }
     }
 
-    uint64_t GTXDriver::int2ext_openmp(void *opaque_transaction, uint64_t internal_vertex_id, uint8_t thread_id) const {
-        auto transaction = reinterpret_cast<gt::SharedROTransaction*>(opaque_transaction);
-        string_view payload = transaction->get_vertex(internal_vertex_id,thread_id);//they store external vid in the vertex data for experiments
-        if(payload.empty()){ // the vertex does not exist
-            return numeric_limits<uint64_t>::max();
-        } else {
-            return *(reinterpret_cast<const uint64_t*>(payload.data()));
+    uint64_t GTXDriver::find_or_create_vertex(uint64_t external_id, bool* out_created) {
+        auto [internal_id, created] = m_vertex_dictionary->find_or_insert(external_id);
+
+        if(created){ // other threads looking for this vertex wait until it is published
+            internal_id = create_vertex(external_id);
+            m_vertex_dictionary->publish(external_id, internal_id);
+            m_num_vertices++;
         }
+
+        if(out_created != nullptr){ *out_created = created; }
+        return internal_id;
     }
+
     bool GTXDriver::add_vertex(uint64_t external_id) {
-        vertex_dictionary_t::accessor accessor; // xlock
-        bool inserted = VertexDictionary->insert(accessor, external_id);
-        if ( inserted ){
-            gt::vertex_t internal_id = 0;
-            bool done = false;
-            do {
-                auto tx = GTX->begin_read_write_transaction();
-                try {
-                    internal_id = tx.new_vertex();
-                    string_view data { (char*) &external_id, sizeof(external_id) };
-                    tx.put_vertex(internal_id, data);
-                    tx.commit();
-                    done = true;
-                } catch(gt::RollbackExcept& e){
-                    tx.abort();
-                    COUT_DEBUG("Rollback, vertex id: " << external_id);
-                    // retry ...
-                }
-            } while(!done);
+        bool inserted = false;
+        find_or_create_vertex(external_id, &inserted);
+        return inserted;
+    }
 
-            accessor->second = internal_id;
-            m_num_vertices++;
+    void GTXDriver::load(const string& path) {
+        auto reader = reader::Reader::open(path);
+        if(reader->is_directed() != is_directed()){ ERROR("The graph in " << path << " is " << (reader->is_directed() ? "directed" : "undirected") << ", while the driver is " << (is_directed() ? "directed" : "undirected")); }
+
+        vector<gfe::graph::WeightedEdge> edges;
+        gfe::graph::WeightedEdge edge;
+        while(reader->read(edge)){ edges.push_back(edge); }
+
+        // create all vertices first and register them in the dictionary at once
+        vector<uint64_t> external_ids;
+        external_ids.reserve(edges.size() * 2);
+        for(const auto& e : edges){
+            external_ids.push_back(e.source());
+            external_ids.push_back(e.destination());
         }
-        return inserted;
+        sort(external_ids.begin(), external_ids.end());
+        external_ids.erase(unique(external_ids.begin(), external_ids.end()), external_ids.end());
+        external_ids.erase(remove_if(external_ids.begin(), external_ids.end(), [this](uint64_t id){ return has_vertex(id); }), external_ids.end());
+
+        vector<uint64_t> internal_ids(external_ids.size());
+        for(uint64_t i = 0; i < external_ids.size(); i++){
+            internal_ids[i] = create_vertex(external_ids[i]);
+        }
+        auto start = chrono::steady_clock::now();
+        m_vertex_dictionary->preload(external_ids.data(), internal_ids.data(), external_ids.size());
+        m_vertex_dictionary->add_time(chrono::steady_clock::now() - start);
+        m_num_vertices += external_ids.size();
+
+        for(const auto& e : edges){ add_edge(e); }
+        build();
+    }
+
+    void GTXDriver::updates_start() {
+        m_vertex_dictionary->reset_statistics();
     }
+
+    void GTXDriver::updates_stop() {
+        stringstream ss;
+        m_vertex_dictionary->dump_statistics(ss);
+        LOG("[GTX] Vertex dictionary, " << ss.str());
+    }
+
     //todo:: currently gtx did not implement delete vertex, it should be much more complicated
     bool GTXDriver::remove_vertex(uint64_t vertex_id) {
         m_num_vertices --;
@@ -194,16 +221,13 @@ namespace gfe::library {
     }
 
     bool GTXDriver::has_vertex(uint64_t vertex_id) const {
-        vertex_dictionary_t::const_accessor accessor;
-        return VertexDictionary->find(accessor, vertex_id);
+        return m_vertex_dictionary->find(vertex_id) != VertexDictionary::NOT_FOUND;
     }
 
     bool GTXDriver::add_edge(gfe::graph::WeightedEdge e) {
-        vertex_dictionary_t::const_accessor accessor1, accessor2;  // shared lock on the dictionary
-        if(!VertexDictionary->find(accessor1, e.source())){ return false; }
-        if(!VertexDictionary->find(accessor2, e.destination())) { return false; }
-        gt::vertex_t internal_source_id = accessor1->second;
-        gt::vertex_t internal_destination_id = accessor2->second;
+        gt::vertex_t internal_source_id = m_vertex_dictionary->find(e.source());
+        gt::vertex_t internal_destination_id = m_vertex_dictionary->find(e.destination());
+        if(internal_source_id == VertexDictionary::NOT_FOUND || internal_destination_id == VertexDictionary::NOT_FOUND){ return false; }
 
         bool done = false;
         do {
@@ -243,51 +267,16 @@ namespace gfe::library {
 
     bool GTXDriver::add_edge_v2(gfe::graph::WeightedEdge edge){
         //for the experiment comparing with sortledton and teseo, we just assume it has to be undirected.
-        uint64_t internal_source_id = numeric_limits<uint64_t>::max();
-        uint64_t internal_destination_id = 0;
-        bool insert_source = false;
-        bool insert_destination = false;
-        vertex_dictionary_t::const_accessor slock1, slock2;
-        vertex_dictionary_t::accessor xlock1, xlock2;
+        // the vertices are created in their own transactions, rather than together with the edge, so that the threads
+        // inserting edges attached to the same new vertices only wait for the vertices to be created
+        uint64_t internal_source_id = find_or_create_vertex(edge.m_source);
+        uint64_t internal_destination_id = find_or_create_vertex(edge.m_destination);
         bool result = false;
-        if(VertexDictionary->find(slock1, edge.m_source)){ // insert the vertex e.m_source
-            internal_source_id = slock1->second;
-        } else {
-            slock1.release();
-            if ( VertexDictionary->insert(xlock1, edge.m_source) ) {
-                insert_source = true;
-            } else {
-                internal_source_id = xlock1->second;
-            }
-        }
-
-        if(VertexDictionary->find(slock2, edge.m_destination)){ // insert the vertex e.m_destination
-            internal_destination_id = slock2->second;
-        } else {
-            slock2.release();
-            if( VertexDictionary->insert(xlock2, edge.m_destination) ) {
-                insert_destination = true;
-            } else {
-                internal_destination_id = xlock2->second;
-            }
-        }
 
         bool done = false;
         do {
             auto tx = GTX->begin_read_write_transaction();
             try {
-                // create the vertices in GTX
-                if(insert_source){
-                    internal_source_id = tx.new_vertex();
-                    string_view data { (char*) &edge.m_source, sizeof(edge.m_source) };
-                    tx.put_vertex(internal_source_id, data);
-                }
-                if(insert_destination){
-                    internal_destination_id = tx.new_vertex();
-                    string_view data { (char*) &edge.m_destination, sizeof(edge.m_destination) };
-                    tx.put_vertex(internal_destination_id, data);
-                }
-
                 // insert the edge
                 string_view weight { (char*) &edge.m_weight, sizeof(edge.m_weight) };
                 //string weight = "weight";//todo:: change this back
@@ -315,68 +304,22 @@ namespace gfe::library {
             }
         } while(!done);
 
-        if(insert_source){
-            //assert(internal_source_id != numeric_limits<uint64_t>::max());
-            xlock1->second = internal_source_id;
-            m_num_vertices++;
-        }
-        if(insert_destination){
-            //assert(internal_destination_id != numeric_limits<uint64_t>::max());
-            xlock2->second = internal_destination_id;
-            m_num_vertices++;
-        }
-
         return result;
     }
 /*
  * gtx version is the same as v2
  */
     bool GTXDriver::add_edge_v3(gfe::graph::WeightedEdge edge){
-        uint64_t internal_source_id = numeric_limits<uint64_t>::max();
-        uint64_t internal_destination_id = 0;
-        bool insert_source = false;
-        bool insert_destination = false;
-        vertex_dictionary_t::const_accessor slock1, slock2;
-        vertex_dictionary_t::accessor xlock1, xlock2;
+        // the vertices are created in their own transactions, rather than together with the edge, so that the threads
+        // inserting edges attached to the same new vertices only wait for the vertices to be created
+        uint64_t internal_source_id = find_or_create_vertex(edge.m_source);
+        uint64_t internal_destination_id = find_or_create_vertex(edge.m_destination);
         bool result = false;
-        if(VertexDictionary->find(slock1, edge.m_source)){ // insert the vertex e.m_source
-            internal_source_id = slock1->second;
-        } else {
-            slock1.release();
-            if ( VertexDictionary->insert(xlock1, edge.m_source) ) {
-                insert_source = true;
-            } else {
-                internal_source_id = xlock1->second;
-            }
-        }
-
-        if(VertexDictionary->find(slock2, edge.m_destination)){ // insert the vertex e.m_destination
-            internal_destination_id = slock2->second;
-        } else {
-            slock2.release();
-            if( VertexDictionary->insert(xlock2, edge.m_destination) ) {
-                insert_destination = true;
-            } else {
-                internal_destination_id = xlock2->second;
-            }
-        }
 
         bool done = false;
         do {
             auto tx = GTX->begin_read_write_transaction();
             try {
-                // create the vertices in GTX
-                if(insert_source){
-                    internal_source_id = tx.new_vertex();
-                    string_view data { (char*) &edge.m_source, sizeof(edge.m_source) };
-                    tx.put_vertex(internal_source_id, data);
-                }
-                if(insert_destination){
-                    internal_destination_id = tx.new_vertex();
-                    string_view data { (char*) &edge.m_destination, sizeof(edge.m_destination) };
-                    tx.put_vertex(internal_destination_id, data);
-                }
-
                 // insert the edge
                 string_view weight { (char*) &edge.m_weight, sizeof(edge.m_weight) };
                 //string weight = "weight";//todo:: change this back
@@ -403,17 +346,6 @@ namespace gfe::library {
             }
         } while(!done);
 
-        if(insert_source){
-            assert(internal_source_id != numeric_limits<uint64_t>::max());
-            xlock1->second = internal_source_id;
-            m_num_vertices++;
-        }
-        if(insert_destination){
-            assert(internal_destination_id != numeric_limits<uint64_t>::max());
-            xlock2->second = internal_destination_id;
-            m_num_vertices++;
-        }
-
         return true;
     }
 
@@ -421,54 +353,18 @@ namespace gfe::library {
      * lookup the edge, and then insert/update
      */
     bool GTXDriver::update_edge_v1(gfe::graph::WeightedEdge edge) {
-        uint64_t internal_source_id = numeric_limits<uint64_t>::max();
-        uint64_t internal_destination_id = 0;
         bool insert_source = false;
         bool insert_destination = false;
-        vertex_dictionary_t::const_accessor slock1, slock2;
-        vertex_dictionary_t::accessor xlock1, xlock2;
+        uint64_t internal_source_id = find_or_create_vertex(edge.m_source, &insert_source);
+        uint64_t internal_destination_id = find_or_create_vertex(edge.m_destination, &insert_destination);
         bool result = false;
-        if(VertexDictionary->find(slock1, edge.m_source)){ // insert the vertex e.m_source
-            internal_source_id = slock1->second;
-        } else {
-            slock1.release();
-            if ( VertexDictionary->insert(xlock1, edge.m_source) ) {
-                insert_source = true;
-            } else {
-                internal_source_id = xlock1->second;
-            }
-        }
-
-        if(VertexDictionary->find(slock2, edge.m_destination)){ // insert the vertex e.m_destination
-            internal_destination_id = slock2->second;
-        } else {
-            slock2.release();
-            if( VertexDictionary->insert(xlock2, edge.m_destination) ) {
-                insert_destination = true;
-            } else {
-                internal_destination_id = xlock2->second;
-            }
-        }
 
         bool done = false;
-        bool need_check = true;
+        bool need_check = !insert_source && !insert_destination; // a new vertex has no edges yet
         do {
             auto tx = GTX->begin_read_write_transaction();
             double update_weight = edge.m_weight;
             try {
-                // create the vertices in GTX
-                if(insert_source){
-                    internal_source_id = tx.new_vertex();
-                    string_view data { (char*) &edge.m_source, sizeof(edge.m_source) };
-                    tx.put_vertex(internal_source_id, data);
-                    need_check= false;
-                }
-                if(insert_destination){
-                    internal_destination_id = tx.new_vertex();
-                    string_view data { (char*) &edge.m_destination, sizeof(edge.m_destination) };
-                    tx.put_vertex(internal_destination_id, data);
-                    need_check= false;
-                }
                 if(need_check){
                     std::string_view read_result = tx.get_edge(internal_source_id,internal_destination_id,1);
                     if(!read_result.empty()){
@@ -502,25 +398,13 @@ namespace gfe::library {
             }
         } while(!done);
 
-        if(insert_source){
-            assert(internal_source_id != numeric_limits<uint64_t>::max());
-            xlock1->second = internal_source_id;
-            m_num_vertices++;
-        }
-        if(insert_destination){
-            assert(internal_destination_id != numeric_limits<uint64_t>::max());
-            xlock2->second = internal_destination_id;
-            m_num_vertices++;
-        }
         return true;
     }
 
     bool GTXDriver::remove_edge(gfe::graph::Edge e){
-        vertex_dictionary_t::const_accessor slock1, slock2;
-        if(!VertexDictionary->find(slock1, e.source())){ return false; }
-        if(!VertexDictionary->find(slock2, e.destination())){ return false; }
-        gt::vertex_t internal_source_id = slock1->second;
-        gt::vertex_t internal_destination_id = slock2->second;
+        gt::vertex_t internal_source_id = m_vertex_dictionary->find(e.source());
+        gt::vertex_t internal_destination_id = m_vertex_dictionary->find(e.destination());
+        if(internal_source_id == VertexDictionary::NOT_FOUND || internal_destination_id == VertexDictionary::NOT_FOUND){ return false; }
 
         while(true){
             auto tx = GTX->begin_read_write_transaction();
@@ -552,11 +436,9 @@ namespace gfe::library {
 
     double GTXDriver::get_weight(uint64_t source, uint64_t destination) const {
         // check whether the referred vertices exist
-        vertex_dictionary_t::const_accessor slock1, slock2;
-        if(!VertexDictionary->find(slock1, source)){ return numeric_limits<double>::signaling_NaN(); }
-        if(!VertexDictionary->find(slock2, destination)){ return numeric_limits<double>::signaling_NaN(); }
-        gt::vertex_t internal_source_id = slock1->second;
-        gt::vertex_t internal_destination_id = slock2->second;
+        gt::vertex_t internal_source_id = m_vertex_dictionary->find(source);
+        gt::vertex_t internal_destination_id = m_vertex_dictionary->find(destination);
+        if(internal_source_id == VertexDictionary::NOT_FOUND || internal_destination_id == VertexDictionary::NOT_FOUND){ return numeric_limits<double>::signaling_NaN(); }
 
         auto tx = GTX->begin_read_only_transaction();
        /*string_view bg_weight = tx.get_edge(internal_source_id, internal_destination_id, 1);
@@ -569,6 +451,26 @@ namespace gfe::library {
         return weight;
     }
 
+    bool GTXDriver::scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const {
+        gt::vertex_t internal_source_id = m_vertex_dictionary->find(vertex);
+        if(internal_source_id == VertexDictionary::NOT_FOUND){ return false; }
+
+        auto tx = GTX->begin_read_only_transaction();
+        auto it = tx.get_edges(internal_source_id, 1);
+        while(it.valid()){
+            string_view payload = tx.get_vertex(it.dst_id()); // the external vertex id is stored in the vertex data
+            double weight = *(reinterpret_cast<const double*>(it.edge_delta_data().data()));
+            if(!payload.empty() && !visitor(*(reinterpret_cast<const uint64_t*>(payload.data())), weight)) break;
+            it.next();
+        }
+        tx.commit(); //read-only txn should not abort in gtx
+        return true;
+    }
+
+    bool GTXDriver::can_run_kernels_concurrently() const {
+        return false;
+    }
+
     /*****************************************************************************
     *                                                                           *
     *  Dump                                                                     *
@@ -593,7 +495,7 @@ namespace gfe::library {
                     uint64_t internal_destination_id = it.dst_id();
                     auto bg_weight = it.edge_delta_data();
                     double weight = * ((double*) bg_weight.data());
-                    out << "<" << internal_destination_id << " [external: " << int2ext(&tx, internal_destination_id) << "], " << weight << ">";
+                    out << "<" << internal_destination_id << " [external: " << int2ext(internal_destination_id) << "], " << weight << ">";
                     it.next();
                 }
             }
@@ -608,63 +510,33 @@ namespace gfe::library {
     *                                                                           *
     *****************************************************************************/
     template <typename T>
-    vector<pair<uint64_t, T>> GTXDriver::translate(void* /* transaction object */ opaque_transaction, const T* __restrict data, uint64_t data_sz) {
+    vector<pair<uint64_t, T>> GTXDriver::translate(void* /* transaction object */ opaque_transaction, uint64_t dictionary_version, const T* __restrict data, uint64_t data_sz, utility::TimeoutService& timer) {
         assert(opaque_transaction != nullptr && "Transaction object not specified");
-        vector<pair<uint64_t, T>> output(data_sz);
         auto transaction = reinterpret_cast<gt::SharedROTransaction*>(opaque_transaction);
-       /* for(uint64_t logical_id = 1; logical_id <= data_sz; logical_id++){
-            uint64_t external_id = int2ext(transaction, logical_id);
-            if(external_id == numeric_limits<uint64_t>::max()) { // the vertex does not exist
-                output[logical_id-1] = make_pair(numeric_limits<uint64_t>::max(), numeric_limits<T>::max()); // special marker
-            } else {
-                output[logical_id-1] = make_pair(external_id, data[logical_id-1]);
-            }
-        }*/
+        vector<pair<uint64_t, T>> output(data_sz);
+
         auto graph = transaction->get_graph();
 #pragma omp parallel
         {
             uint8_t thread_id = graph->get_openmp_worker_thread_id();
 #pragma omp for
             for(uint64_t logical_id = 1; logical_id <= data_sz; logical_id++){
-                string_view payload = transaction->get_vertex(logical_id,thread_id);//they store external vid in the vertex data for experiments
-                if(payload.empty()){ // the vertex does not exist
-                    output[logical_id-1] = make_pair(numeric_limits<uint64_t>::max(), numeric_limits<T>::max());
+                if(timer.is_timeout()) continue; // exhausted the budget of available time
+                uint64_t external_id = m_vertex_dictionary->int2ext(logical_id, dictionary_version);
+                if(external_id == VertexDictionary::NOT_FOUND){ // removed or created concurrently to the kernel, ask the snapshot
+                    string_view payload = transaction->get_vertex(logical_id, thread_id); // they store external vid in the vertex data for experiments
+                    if(!payload.empty()){ external_id = *(reinterpret_cast<const uint64_t*>(payload.data())); }
+                }
+                if(external_id == numeric_limits<uint64_t>::max()) { // the vertex does not exist
+                    output[logical_id-1] = make_pair(numeric_limits<uint64_t>::max(), numeric_limits<T>::max()); // special marker
                 } else {
-                    output[logical_id-1] = make_pair(*(reinterpret_cast<const uint64_t*>(payload.data())), data[logical_id-1]);
+                    output[logical_id-1] = make_pair(external_id, data[logical_id-1]);
                 }
             }
             transaction->thread_on_openmp_section_finish(thread_id);
         }
         graph->on_openmp_section_finishing();
-        return output;
-    }
 
-    template<typename T>
-    std::vector<std::pair<uint64_t, T>>
-    GTXDriver::static_translate(void *opaque_transaction, const T *__restrict data, uint64_t data_sz) {
-        assert(opaque_transaction != nullptr && "Transaction object not specified");
-        vector<pair<uint64_t, T>> output(data_sz);
-        auto transaction = reinterpret_cast<gt::SharedROTransaction*>(opaque_transaction);
-        /* for(uint64_t logical_id = 1; logical_id <= data_sz; logical_id++){
-             uint64_t external_id = int2ext(transaction, logical_id);
-             if(external_id == numeric_limits<uint64_t>::max()) { // the vertex does not exist
-                 output[logical_id-1] = make_pair(numeric_limits<uint64_t>::max(), numeric_limits<T>::max()); // special marker
-             } else {
-                 output[logical_id-1] = make_pair(external_id, data[logical_id-1]);
-             }
-         }*/
-#pragma omp parallel
-        {
-#pragma omp for
-            for(uint64_t logical_id = 1; logical_id <= data_sz; logical_id++){
-                string_view payload = transaction->static_get_vertex(logical_id);//they store external vid in the vertex data for experiments
-                if(payload.empty()){ // the vertex does not exist
-                    output[logical_id-1] = make_pair(numeric_limits<uint64_t>::max(), numeric_limits<T>::max());
-                } else {
-                    output[logical_id-1] = make_pair(*(reinterpret_cast<const uint64_t*>(payload.data())), data[logical_id-1]);
-                }
-            }
-        }
         return output;
     }
 
@@ -672,25 +544,7 @@ namespace gfe::library {
     void GTXDriver::save_results(const vector<pair<uint64_t, T>>& result, const char* dump2file) {
         assert(dump2file != nullptr);
         COUT_DEBUG("save the results to: " << dump2file);
-
-        fstream handle(dump2file, ios_base::out);
-        if (!handle.good()) ERROR("Cannot save the result to `" << dump2file << "'");
-
-        for (const auto &p : result) {
-            if(p.first == numeric_limits<uint64_t>::max()) continue; // invalid node
-
-            handle << p.first << " ";
-
-            if(!negative_scores && p.second < 0){
-                handle << numeric_limits<T>::max();
-            } else {
-                handle << p.second;
-            }
-
-            handle << "\n";
-        }
-
-        handle.close();
+        utility::save_results(result, dump2file, negative_scores);
     }
 
     /*****************************************************************************
@@ -1196,6 +1050,7 @@ namespace gfe::library {
         // Init
         utility::TimeoutService timeout { m_timeout };
         Timer timer; timer.start();
+        uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
         gt::SharedROTransaction transaction =  GTX->begin_shared_read_only_transaction();
         uint64_t max_vertex_id = GTX->get_max_allocated_vid();
         uint64_t num_vertices = m_num_vertices;
@@ -1219,8 +1074,7 @@ namespace gfe::library {
         }
 
         // translate the logical vertex IDs into the external vertex IDs
-        auto external_ids = translate(&transaction, ptr_result.get(), max_vertex_id);
-        //auto external_ids = static_translate(&transaction, ptr_result.get(), max_vertex_id);
+        auto external_ids = translate(&transaction, dictionary_version, ptr_result.get(), max_vertex_id, timeout);
         //cout << "Translation took " << t << endl;
         transaction.commit(); // not sure if strictly necessary
         if(timeout.is_timeout()){
@@ -1517,6 +1371,7 @@ updates in the pull direction to remove the need for atomics.
         // Init
         utility::TimeoutService timeout { m_timeout };
         Timer timer; timer.start();
+        //uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
         //gt::SharedROTransaction transaction = GTX->begin_shared_read_only_transaction();
         uint64_t num_vertices = m_num_vertices;
         //reuse data structures
@@ -1536,8 +1391,7 @@ updates in the pull direction to remove the need for atomics.
         if(timeout.is_timeout()){ transaction.commit(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);  }
 
         // Retrieve the external node ids
-        auto external_ids = translate(&transaction, ptr_result.get(), max_vertex_id);
-        //auto external_ids = static_translate(&transaction, ptr_result.get(), max_vertex_id);
+        auto external_ids = translate(&transaction, dictionary_version, ptr_result.get(), max_vertex_id, timeout);
         transaction.commit(); // read-only transaction, abort == commit
         if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
@@ -1721,6 +1575,7 @@ more consistent performance for undirected graphs.
     void GTXDriver::wcc(const char* dump2file) {
         /*utility::TimeoutService timeout { m_timeout };
         Timer timer; timer.start();
+        uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
         auto transaction =GTX->begin_shared_read_only_transaction();
         uint64_t max_vertex_id = GTX->get_max_allocated_vid();
 
@@ -1729,7 +1584,7 @@ more consistent performance for undirected graphs.
         if(timeout.is_timeout()){ transaction.commit(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
         // translate the vertex IDs
-        auto external_ids = translate(&transaction, ptr_components.get(), max_vertex_id);
+        auto external_ids = translate(&transaction, dictionary_version, ptr_components.get(), max_vertex_id, timeout);
         transaction.commit(); // read-only transaction, abort == commit
         if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
@@ -1846,17 +1701,35 @@ more consistent performance for undirected graphs.
     }
     
     void GTXDriver::generate_two_hops_neighbor_candidates(std::vector<uint64_t>&vertices){
-        vertices.resize(two_hop_neighbor_size);
-        uint64_t max_vertex_id = GTX->get_max_allocated_vid();
-        std::unordered_set<uint64_t> unique_vertices;
-        for(uint64_t i=0; i<two_hop_neighbor_size;i++){
-            uint64_t vid = rand()%max_vertex_id+1;
-            auto result = unique_vertices.emplace(vid);
-            if(result.second){
-                vertices[i]=vid;
-            }else{
-                i--;
+        auto sampler = vertex_sampler();
+
+        if(sampler->has_population()){ // external vertex IDs, translate them into the internal IDs
+            sampler->sample(two_hop_neighbor_size, vertices);
+            uint64_t num_vertices = 0;
+            for(uint64_t external_id : vertices){
+                uint64_t internal_id = m_vertex_dictionary->find(external_id);
+                if(internal_id != VertexDictionary::NOT_FOUND){ vertices[num_vertices++] = internal_id; } // skip the vertices not inserted yet
+            }
+            vertices.resize(num_vertices);
+        } else { // draw from the live vertices of the graph
+            const bool with_degrees = sampler->distribution() == utility::VertexSamplerDistribution::DEGREE;
+            vector<uint64_t> population;
+            vector<uint64_t> degrees;
+            auto tx = GTX->begin_read_only_transaction();
+            const uint64_t max_vertex_id = GTX->get_max_allocated_vid();
+            for(uint64_t internal_id = 1; internal_id <= max_vertex_id; internal_id++){
+                if(tx.get_vertex(internal_id).size() == 0) continue; // the vertex has been deleted
+                population.push_back(internal_id);
+                if(with_degrees){
+                    uint64_t degree = 0;
+                    auto it = tx.get_edges(internal_id, 1);
+                    while(it.valid()){ degree++; it.next(); }
+                    degrees.push_back(degree);
+                }
             }
+            tx.commit(); //read-only txn should not abort in gtx
+
+            sampler->sample(population.data(), with_degrees ? degrees.data() : nullptr, population.size(), two_hop_neighbor_size, vertices);
         }
     }
     void GTXDriver::one_hop_neighbors(std::vector<uint64_t>&vertices){
@@ -1884,6 +1757,7 @@ more consistent performance for undirected graphs.
 
         utility::TimeoutService timeout { m_timeout };
         Timer timer; timer.start();
+        uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
         auto transaction =GTX->begin_shared_read_only_transaction();
         uint64_t max_vertex_id = GTX->get_max_allocated_vid();
 
@@ -1892,7 +1766,7 @@ more consistent performance for undirected graphs.
         if(timeout.is_timeout()){ transaction.commit(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);  }
 
         // Translate the vertex IDs
-        auto external_ids = translate(&transaction, labels.get(), max_vertex_id);
+        auto external_ids = translate(&transaction, dictionary_version, labels.get(), max_vertex_id, timeout);
         transaction.commit(); // read-only transaction, abort == commit
         if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
@@ -2005,6 +1879,7 @@ more consistent performance for undirected graphs.
 
         utility::TimeoutService timeout { m_timeout };
         Timer timer; timer.start();
+        uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
         gt::SharedROTransaction transaction = GTX->begin_shared_read_only_transaction();
         uint64_t max_vertex_id = GTX->get_max_allocated_vid();
 
@@ -2013,7 +1888,7 @@ more consistent performance for undirected graphs.
         if(timeout.is_timeout()){ transaction.commit(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);  }
 
         // Translate the vertex IDs
-        auto external_ids = translate(&transaction, scores.get(), max_vertex_id);
+        auto external_ids = translate(&transaction, dictionary_version, scores.get(), max_vertex_id, timeout);
         transaction.commit(); // read-only transaction, abort == commit
         if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
@@ -2067,6 +1942,7 @@ more consistent performance for undirected graphs.
         // two element arrays for double buffering curr=iter&1, next=(iter+1)&1
         size_t shared_indexes[2] = {0, kMaxBin};
         size_t frontier_tails[2] = {1, 0};
+        bool timed_out = false; // set by a single thread, read by all threads after the barrier at the end of each iteration
         frontier[0] = source;
          auto graph = transaction.get_graph();
 #pragma omp parallel
@@ -2076,13 +1952,14 @@ more consistent performance for undirected graphs.
             vector<vector<NodeID> > local_bins(0);
             size_t iter = 0;
 
-            while (shared_indexes[iter&1] != kMaxBin) {
+            while (shared_indexes[iter&1] != kMaxBin && !timed_out) {
                 size_t &curr_bin_index = shared_indexes[iter&1];
                 size_t &next_bin_index = shared_indexes[(iter+1)&1];
                 size_t &curr_frontier_tail = frontier_tails[iter&1];
                 size_t &next_frontier_tail = frontier_tails[(iter+1)&1];
 #pragma omp for nowait schedule(dynamic, 64)
                 for (size_t i=0; i < curr_frontier_tail; i++) {
+                    if (timer.is_timeout()) continue; // exhausted the budget of available time
                     NodeID u = frontier[i];
                     if (dist[u-1] >= delta * static_cast<WeightT>(curr_bin_index)) {
                         //auto iterator = transaction.simple_get_edges(u, /* label */ 1,thread_id);
@@ -2131,6 +2008,7 @@ more consistent performance for undirected graphs.
                 {
                     curr_bin_index = kMaxBin;
                     curr_frontier_tail = 0;
+                    timed_out = timer.is_timeout();
                 }
 
                 if (next_bin_index < local_bins.size()) {
@@ -2163,6 +2041,7 @@ more consistent performance for undirected graphs.
         // two element arrays for double buffering curr=iter&1, next=(iter+1)&1
         size_t shared_indexes[2] = {0, kMaxBin};
         size_t frontier_tails[2] = {1, 0};
+        bool timed_out = false; // set by a single thread, read by all threads after the barrier at the end of each iteration
         frontier[0] = source;
          //auto graph = transaction.get_graph();
 #pragma omp parallel
@@ -2172,13 +2051,14 @@ more consistent performance for undirected graphs.
             vector<vector<NodeID> > local_bins(0);
             size_t iter = 0;
 
-            while (shared_indexes[iter&1] != kMaxBin) {
+            while (shared_indexes[iter&1] != kMaxBin && !timed_out) {
                 size_t &curr_bin_index = shared_indexes[iter&1];
                 size_t &next_bin_index = shared_indexes[(iter+1)&1];
                 size_t &curr_frontier_tail = frontier_tails[iter&1];
                 size_t &next_frontier_tail = frontier_tails[(iter+1)&1];
 #pragma omp for nowait schedule(dynamic, 64)
                 for (size_t i=0; i < curr_frontier_tail; i++) {
+                    if (timer.is_timeout()) continue; // exhausted the budget of available time
                     NodeID u = frontier[i];
                     if (dist[u-1] >= delta * static_cast<WeightT>(curr_bin_index)) {
                         //auto iterator = transaction.static_get_edges(u, /* label */ 1);
@@ -2227,6 +2107,7 @@ more consistent performance for undirected graphs.
                 {
                     curr_bin_index = kMaxBin;
                     curr_frontier_tail = 0;
+                    timed_out = timer.is_timeout();
                 }
 
                 if (next_bin_index < local_bins.size()) {
@@ -2264,6 +2145,7 @@ more consistent performance for undirected graphs.
         //std::cout<<"sssp ran"<<std::endl;
        /*utility::TimeoutService timeout { m_timeout };
         Timer timer; timer.start();
+        uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
         gt::SharedROTransaction transaction = GTX->begin_shared_read_only_transaction();
         uint64_t num_edges = m_num_edges;
         uint64_t max_vertex_id = GTX->get_max_allocated_vid();
@@ -2276,8 +2158,7 @@ more consistent performance for undirected graphs.
         if(timeout.is_timeout()){ transaction.commit(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);  }
 
         // Translate the vertex IDs
-        //auto external_ids = translate(&transaction, distances.data(), max_vertex_id);
-        auto external_ids = static_translate(&transaction, distances.data(), max_vertex_id);
+        auto external_ids = translate(&transaction, dictionary_version, distances.data(), max_vertex_id, timeout);
         transaction.commit(); // read-only transaction, abort == commit
         if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
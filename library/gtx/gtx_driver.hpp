@@ -11,7 +11,9 @@
 #include "../../graph/edge.hpp"
 #include <tbb/enumerable_thread_specific.h>//to count the time
 #define GTX_SET_THREAD_NUM true
+namespace gfe::utility { class TimeoutService; } // forward declaration
 namespace gfe::library {
+    class VertexDictionary; // forward declaration
 #define COUT_DEBUG_FORCE(msg) { std::scoped_lock<std::mutex> lock{::gfe::_log_mutex}; std::cout << "[TeseoDriver::" << __FUNCTION__ << "] " << msg << std::endl; }
 #if defined(DEBUG)
 #define COUT_DEBUG(msg) COUT_DEBUG_FORCE(msg)
@@ -24,7 +26,7 @@ namespace gfe::library {
 
     protected:
         void* m_pImpl; // pointer to the GTX handle
-        void* m_pHashMap; // pointer to the TBB HashMap to translate the vertex identifiers into the dense IDs for gtx
+        VertexDictionary* m_vertex_dictionary; // translate the vertex identifiers into the dense IDs for gtx
         const bool m_is_directed; // whether the underlying graph is directed or undirected
         const bool m_read_only; // whether to used read only transactions for graphalytics
         std::atomic<uint64_t> m_num_vertices {0}; // keep track of the total number of vertices
@@ -34,17 +36,19 @@ namespace gfe::library {
         // Retrieve the internal vertex ID for the given external vertex. If the vertex does not exist, it raises an internal error
         uint64_t ext2int(uint64_t external_vertex_id) const;
 
-        // Retrieve the internal vertex ID for the given internal vertex ID. If the vertex does not exist, it returns uint64_t::max()
-        uint64_t int2ext(void* transaction, uint64_t internal_vertex_id) const;
-        // Retrieve the internal vertex ID for the given internal vertex ID. If the vertex does not exist, it returns uint64_t::max()
-        uint64_t int2ext_openmp(void* transaction, uint64_t internal_vertex_id,uint8_t thread_id) const;
+        // Create a new vertex in GTX, storing its external ID as vertex data. Return its internal vertex ID
+        uint64_t create_vertex(uint64_t external_vertex_id);
 
-        // Helper for Graphalytics: translate the logical IDs into external IDs
-        template <typename T>
-        std::vector<std::pair<uint64_t, T>> translate(void* /* transaction object */ lgtxn, const T* __restrict data, uint64_t data_sz);
-        // Helper for Graphalytics: translate the logical IDs into external IDs, assuming pure reads
+        // Retrieve the internal vertex ID for the given external vertex, creating the vertex if it does not exist
+        uint64_t find_or_create_vertex(uint64_t external_vertex_id, bool* out_created = nullptr);
+
+        // Retrieve the external vertex ID for the given internal vertex ID. If the vertex does not exist, it returns uint64_t::max()
+        uint64_t int2ext(uint64_t internal_vertex_id) const;
+
+        // Helper for Graphalytics: translate the logical IDs into external IDs, with the inverse mapping of the vertex dictionary. The vertices the dictionary
+        // cannot vouch for, as they were removed or published after `dictionary_version', are looked up in the snapshot of the transaction. It stops early if the timer expires.
         template <typename T>
-        std::vector<std::pair<uint64_t, T>> static_translate(void* /* transaction object */ lgtxn, const T* __restrict data, uint64_t data_sz);
+        std::vector<std::pair<uint64_t, T>> translate(void* /* transaction object */ transaction, uint64_t dictionary_version, const T* __restrict data, uint64_t data_sz, utility::TimeoutService& timer);
 
         // Helper, save the content of the vector to the given output file
         template <typename T, bool negative_scores = true>
@@ -93,6 +97,21 @@ namespace gfe::library {
          */
         virtual void set_timeout(uint64_t seconds);
 
+        /**
+         * Load the whole graph from the given path. The vertices are registered in the vertex dictionary in bulk.
+         */
+        virtual void load(const std::string& path);
+
+        /**
+         * Reset the statistics of the vertex dictionary
+         */
+        virtual void updates_start();
+
+        /**
+         * Report the time spent in the vertex dictionary, separately from the time spent in GTX
+         */
+        virtual void updates_stop();
+
         /**
          * Add the given vertex to the graph
          * @return true if the vertex has been inserted, false otherwise (that is, the vertex already exists)
@@ -142,7 +161,7 @@ namespace gfe::library {
         * For Debugging & Testing only
         */
         void* gtx();
-        void* vertex_dictionary(); // tbb::concurrent_hash_map<uint64_t, lg::vertex_t>
+        VertexDictionary* vertex_dictionary();
 
         /**
      * Perform a BFS from source_vertex_id to all the other vertices in the graph.
@@ -193,6 +212,16 @@ namespace gfe::library {
 
         virtual void two_hop_neighbors(std::vector<uint64_t>&vertices);
 
+        /**
+         * Visit the outgoing edges of the given vertex, inside a read-only transaction
+         */
+        virtual bool scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const;
+
+        /**
+         * The kernels share the OpenMP worker ids of GTX and end with #on_openmp_section_finishing, they cannot run concurrently
+         */
+        virtual bool can_run_kernels_concurrently() const;
+
     };
 }//namspace
 
@@ -30,11 +30,13 @@
 #include "common/system.hpp"
 #include "common/timer.hpp"
 
+#include "analytics_session.hpp"
 #include "baseline/adjacency_list.hpp"
 #include "baseline/csr.hpp"
 #include "baseline/dummy.hpp"
 
 #include "../configuration.hpp"
+#include "../utility/vertex_sampler.hpp"
 
 #if defined(HAVE_LLAMA)
 #include "llama/llama_class.hpp"
@@ -626,4 +628,34 @@ uint64_t UpdateInterface::num_levels() const {
     return 0; // by default, we assume that the implementation is not LSM/delta based, and it doesn`t create new levels/deltas/snapshots
 }
 
+/*****************************************************************************
+ *                                                                           *
+ *  Graphalytics interface                                                   *
+ *                                                                           *
+ *****************************************************************************/
+void GraphalyticsInterface::set_vertex_sampler(shared_ptr<const utility::VertexSampler> sampler){
+    m_vertex_sampler = sampler;
+}
+
+shared_ptr<const utility::VertexSampler> GraphalyticsInterface::vertex_sampler() const {
+    if(m_vertex_sampler){
+        return m_vertex_sampler;
+    } else {
+        static shared_ptr<const utility::VertexSampler> default_sampler = make_shared<utility::VertexSampler>( utility::VertexSamplerDistribution::UNIFORM, 1.0, configuration().seed() );
+        return default_sampler;
+    }
+}
+
+bool GraphalyticsInterface::scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const {
+    ERROR("The library does not support the visit of the neighbours of a single vertex");
+}
+
+bool GraphalyticsInterface::can_run_kernels_concurrently() const {
+    return true;
+}
+
+unique_ptr<AnalyticsSession> GraphalyticsInterface::begin_analytics_session(){
+    return make_unique<ForwardingAnalyticsSession>(this);
+}
+
 } // namespace library
@@ -20,14 +20,18 @@
 #include <iostream>
 #include <memory>
 #include <ostream>
+#include <type_traits>
 #include <vector>
 
 #include "common/error.hpp"
 #include "graph/edge.hpp"
 
+namespace gfe::utility { class VertexSampler; } // forward declaration
+
 namespace gfe::library {
 
 // Forward declarations
+class AnalyticsSession;
 class Interface;
 class UpdateInterface;
 class LoaderInterface;
@@ -286,13 +290,46 @@ public:
     virtual bool batch(const SingleUpdate* array, size_t array_sz, bool force = true);
 };
 
+/**
+ * A non owning reference to a callable `bool (uint64_t destination, double weight)', invoked by GraphalyticsInterface#scan_neighbors
+ * for each edge visited. The callable returns false to stop the scan. Unlike std::function, it never allocates: the callable must
+ * outlive the visitor, which is always the case when a lambda is passed directly to #scan_neighbors.
+ */
+class NeighbourVisitor {
+    void* m_callable; // the callable to invoke
+    bool (*m_invoke)(void* callable, uint64_t destination, double weight); // type-erased trampoline to the callable
+
+public:
+    template<typename Callable, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, NeighbourVisitor>>>
+    NeighbourVisitor(Callable&& callable) : m_callable((void*) &callable), m_invoke([](void* callable, uint64_t destination, double weight){
+        return static_cast<bool>( (*reinterpret_cast<std::remove_reference_t<Callable>*>(callable))(destination, weight) );
+    }) { }
+
+    // Visit the edge to the given destination. Return false to stop the scan.
+    bool operator()(uint64_t destination, double weight) const { return m_invoke(m_callable, destination, weight); }
+};
+
 /**
  * The six algorithms required by the Graphalytics benchmark suite
  * See https://github.com/ldbc/ldbc_graphalytics_docs/
  */
 class GraphalyticsInterface : public virtual Interface {
+    std::shared_ptr<const utility::VertexSampler> m_vertex_sampler; // draw the candidates of the 1-hop and 2-hop expansions
+
 public:
     const uint64_t two_hop_neighbor_size = 2000;
+
+    /**
+     * Set the sampler for the candidates of the 1-hop and 2-hop expansions. If the sampler has a fixed population, it consists
+     * of external vertex IDs, otherwise the implementation draws from the live vertices in its own vertex dictionary.
+     */
+    void set_vertex_sampler(std::shared_ptr<const utility::VertexSampler> sampler);
+
+    /**
+     * Retrieve the sampler for the candidates of the 1-hop and 2-hop expansions. If none was set, it returns a sampler
+     * with the uniform distribution, seeded with the seed of the experiment.
+     */
+    std::shared_ptr<const utility::VertexSampler> vertex_sampler() const;
     /*
      * Libin add this for gtx
      */
@@ -328,11 +365,31 @@ public:
      */
     virtual void cdlp(uint64_t max_iterations, const char* dump2file = nullptr) = 0;
 
+    /**
+     * Draw the candidates for the 1-hop and 2-hop expansions, two_hop_neighbor_size distinct live vertices, according to
+     * the vertex sampler. The candidates are expressed in the internal vertex IDs of the implementation.
+     */
     virtual void generate_two_hops_neighbor_candidates(std::vector<uint64_t>&vertices){}
 
     virtual void one_hop_neighbors(std::vector<uint64_t>&vertices){}
 
     virtual void two_hop_neighbors(std::vector<uint64_t>&vertices){}
+
+    /**
+     * Visit the outgoing edges of the given vertex, in a consistent snapshot of the graph, invoking visitor(destination, weight)
+     * for each edge, directly from the native iterator of the library. In undirected graphs, all edges attached to the vertex
+     * are visited. The vertex IDs are the external (user) IDs. The default implementation raises an error.
+     * @param vertex the vertex whose neighbours to visit
+     * @param visitor invoked for each edge, it returns false to stop the scan
+     * @return true if the vertex exists, false otherwise
+     */
+    virtual bool scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const;
+
+    /**
+     * Check whether multiple kernels can be executed at the same time, by different threads. Otherwise the concurrent
+     * analytics streams of the mixed workload execute one kernel at the time. The default implementation returns true.
+     */
+    virtual bool can_run_kernels_concurrently() const;
     
     /**
      * Local clustering coefficient. Associate to each vertex the ratio between the number of its outgoing edges and the number of
@@ -347,6 +404,13 @@ public:
      * @param dump2file if not null, dump the result in the given path, following the format expected by the benchmark specification
      */
     virtual void sssp(uint64_t source_vertex_id, const char* dump2file = nullptr) = 0;
+
+    /**
+     * Open a snapshot of the graph to run a suite of kernels, sharing the state materialised once for the snapshot, such as
+     * the vertex mapping and the degrees. The default implementation returns a session where each kernel is forwarded
+     * to this interface and opens its own snapshot.
+     */
+    virtual std::unique_ptr<AnalyticsSession> begin_analytics_session();
 };
 
 } // namespace
@@ -17,8 +17,10 @@
 
 #include "livegraph_driver.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <iostream>
@@ -30,19 +32,23 @@
 
 #include "common/system.hpp"
 #include "common/timer.hpp"
-#include "tbb/concurrent_hash_map.h"
+#include "library/analytics_session.hpp"
+#include "library/baseline/csr.hpp"
+#include "library/vertex_dictionary.hpp"
+#include "reader/reader.hpp"
 #include "third-party/gapbs/gapbs.hpp"
 #include "third-party/libcuckoo/cuckoohash_map.hh"
 #include "third-party/livegraph/livegraph.hpp"
+#include "utility/result_writer.hpp"
 #include "utility/timeout_service.hpp"
+#include "utility/vertex_sampler.hpp"
+#include "configuration.hpp"
 
 using namespace common;
 using namespace libcuckoo;
 using namespace std;
 
 #define LiveGraph reinterpret_cast<lg::Graph*>(m_pImpl)
-using vertex_dictionary_t = tbb::concurrent_hash_map<uint64_t, lg::vertex_t>;
-#define VertexDictionary reinterpret_cast<vertex_dictionary_t*>(m_pHashMap)
 
 /*****************************************************************************
  *                                                                           *
@@ -65,14 +71,14 @@ namespace gfe::library {
  *  Init                                                                     *
  *                                                                           *
  *****************************************************************************/
-LiveGraphDriver::LiveGraphDriver(bool is_directed, bool read_only) : m_pImpl(nullptr), m_pHashMap(nullptr), m_is_directed(is_directed), m_read_only(read_only) {
+LiveGraphDriver::LiveGraphDriver(bool is_directed, bool read_only) : m_pImpl(nullptr), m_vertex_dictionary(nullptr), m_is_directed(is_directed), m_read_only(read_only) {
     m_pImpl = new lg::Graph();
-    m_pHashMap = new tbb::concurrent_hash_map<uint64_t, /* vertex_t */ uint64_t>();
+    m_vertex_dictionary = new VertexDictionary();
 }
 
 LiveGraphDriver::~LiveGraphDriver(){
     delete LiveGraph; m_pImpl = nullptr;
-    delete VertexDictionary; m_pHashMap = nullptr;
+    delete m_vertex_dictionary; m_vertex_dictionary = nullptr;
 }
 
 /*****************************************************************************
@@ -100,27 +106,20 @@ void* LiveGraphDriver::livegraph() {
     return m_pImpl;
 }
 
-void* LiveGraphDriver::vertex_dictionary() {
-    return m_pHashMap;
+VertexDictionary* LiveGraphDriver::vertex_dictionary() {
+    return m_vertex_dictionary;
 }
 
 uint64_t LiveGraphDriver::ext2int(uint64_t external_vertex_id) const {
-    vertex_dictionary_t::const_accessor accessor;
-    if ( VertexDictionary->find(accessor, external_vertex_id ) ){
-        return accessor->second;
-    } else {
+    uint64_t internal_vertex_id = m_vertex_dictionary->find(external_vertex_id);
+    if(internal_vertex_id == VertexDictionary::NOT_FOUND){
         ERROR("The given vertex does not exist: " << external_vertex_id);
     }
+    return internal_vertex_id;
 }
 
-uint64_t LiveGraphDriver::int2ext(void* opaque_transaction, uint64_t internal_vertex_id) const {
-    auto transaction = reinterpret_cast<lg::Transaction*>(opaque_transaction);
-    string_view payload = transaction->get_vertex(internal_vertex_id);
-    if(payload.empty()){ // the vertex does not exist
-        return numeric_limits<uint64_t>::max();
-    } else {
-        return *(reinterpret_cast<const uint64_t*>(payload.data()));
-    }
+uint64_t LiveGraphDriver::int2ext(uint64_t internal_vertex_id) const {
+    return m_vertex_dictionary->int2ext(internal_vertex_id);
 }
 
 /*****************************************************************************
@@ -128,40 +127,48 @@ uint64_t LiveGraphDriver::int2ext(void* opaque_transaction, uint64_t internal_ve
  *  Updates                                                                  *
  *                                                                           *
  *****************************************************************************/
-bool LiveGraphDriver::add_vertex(uint64_t external_id){
-    //COUT_DEBUG("vertex_id: " << external_id);
-    vertex_dictionary_t::accessor accessor; // xlock
-    bool inserted = VertexDictionary->insert(accessor, external_id);
-    if ( inserted ){
-        lg::vertex_t internal_id = 0;
-        bool done = false;
-        do {
-            try {
-                auto tx = LiveGraph->begin_transaction();
-                internal_id = tx.new_vertex();
-                string_view data { (char*) &external_id, sizeof(external_id) };
-                tx.put_vertex(internal_id, data);
-                tx.commit();
-                done = true;
-            } catch(lg::Transaction::RollbackExcept& e){
-                COUT_DEBUG("Rollback, vertex id: " << external_id);
-                // retry ...
-            }
-        } while(!done);
+uint64_t LiveGraphDriver::create_vertex(uint64_t external_id){
+    while(true){
+        try {
+            auto tx = LiveGraph->begin_transaction();
+            lg::vertex_t internal_id = tx.new_vertex();
+            string_view data { (char*) &external_id, sizeof(external_id) };
+            tx.put_vertex(internal_id, data);
+            tx.commit();
+            return internal_id;
+        } catch(lg::Transaction::RollbackExcept& e){
+            COUT_DEBUG("Rollback, vertex id: " << external_id);
+            // retry ...
+        }
+    }
+}
+
+uint64_t LiveGraphDriver::find_or_create_vertex(uint64_t external_id, bool* out_created){
+    auto [internal_id, created] = m_vertex_dictionary->find_or_insert(external_id);
 
-        accessor->second = internal_id;
+    if(created){ // other threads looking for this vertex wait until it is published
+        internal_id = create_vertex(external_id);
+        m_vertex_dictionary->publish(external_id, internal_id);
         m_num_vertices++;
     }
 
+    if(out_created != nullptr){ *out_created = created; }
+    return internal_id;
+}
+
+bool LiveGraphDriver::add_vertex(uint64_t external_id){
+    //COUT_DEBUG("vertex_id: " << external_id);
+    bool inserted = false;
+    find_or_create_vertex(external_id, &inserted);
     return inserted;
 }
 
 bool LiveGraphDriver::remove_vertex(uint64_t external_id){
     COUT_DEBUG("vertex_id: " << external_id);
-    vertex_dictionary_t::accessor accessor; // xlock
-    bool found = VertexDictionary->find(accessor, external_id);
+    uint64_t internal_id = m_vertex_dictionary->remove(external_id);
+
+    bool found = internal_id != VertexDictionary::NOT_FOUND;
     if(found){
-        lg::vertex_t internal_id = accessor->second;
         bool done = false;
         do {
             try {
@@ -173,26 +180,63 @@ bool LiveGraphDriver::remove_vertex(uint64_t external_id){
                 // retry ...
             }
         } while(!done);
-
-        VertexDictionary->erase(accessor);
     }
     m_num_vertices--;
     return found;
 }
 
 bool LiveGraphDriver::has_vertex(uint64_t vertex_id) const {
-    vertex_dictionary_t::const_accessor accessor;
-    return VertexDictionary->find(accessor, vertex_id);
+    return m_vertex_dictionary->find(vertex_id) != VertexDictionary::NOT_FOUND;
+}
+
+void LiveGraphDriver::load(const string& path){
+    auto reader = reader::Reader::open(path);
+    if(reader->is_directed() != is_directed()){ ERROR("The graph in " << path << " is " << (reader->is_directed() ? "directed" : "undirected") << ", while the driver is " << (is_directed() ? "directed" : "undirected")); }
+
+    vector<gfe::graph::WeightedEdge> edges;
+    gfe::graph::WeightedEdge edge;
+    while(reader->read(edge)){ edges.push_back(edge); }
+
+    // create all vertices first and register them in the dictionary at once
+    vector<uint64_t> external_ids;
+    external_ids.reserve(edges.size() * 2);
+    for(const auto& e : edges){
+        external_ids.push_back(e.source());
+        external_ids.push_back(e.destination());
+    }
+    sort(external_ids.begin(), external_ids.end());
+    external_ids.erase(unique(external_ids.begin(), external_ids.end()), external_ids.end());
+    external_ids.erase(remove_if(external_ids.begin(), external_ids.end(), [this](uint64_t id){ return has_vertex(id); }), external_ids.end());
+
+    vector<uint64_t> internal_ids(external_ids.size());
+    for(uint64_t i = 0; i < external_ids.size(); i++){
+        internal_ids[i] = create_vertex(external_ids[i]);
+    }
+    auto start = chrono::steady_clock::now();
+    m_vertex_dictionary->preload(external_ids.data(), internal_ids.data(), external_ids.size());
+    m_vertex_dictionary->add_time(chrono::steady_clock::now() - start);
+    m_num_vertices += external_ids.size();
+
+    for(const auto& e : edges){ add_edge(e); }
+    build();
+}
+
+void LiveGraphDriver::updates_start(){
+    m_vertex_dictionary->reset_statistics();
+}
+
+void LiveGraphDriver::updates_stop(){
+    stringstream ss;
+    m_vertex_dictionary->dump_statistics(ss);
+    LOG("[LiveGraph] Vertex dictionary, " << ss.str());
 }
 
 bool LiveGraphDriver::add_edge(gfe::graph::WeightedEdge e){
     //COUT_DEBUG("Edge: " << e);
 
-    vertex_dictionary_t::const_accessor accessor1, accessor2;  // shared lock on the dictionary
-    if(!VertexDictionary->find(accessor1, e.source())){ return false; }
-    if(!VertexDictionary->find(accessor2, e.destination())) { return false; }
-    lg::vertex_t internal_source_id = accessor1->second;
-    lg::vertex_t internal_destination_id = accessor2->second;
+    lg::vertex_t internal_source_id = m_vertex_dictionary->find(e.source());
+    lg::vertex_t internal_destination_id = m_vertex_dictionary->find(e.destination());
+    if(internal_source_id == VertexDictionary::NOT_FOUND || internal_destination_id == VertexDictionary::NOT_FOUND){ return false; }
 
     bool done = false;
     do {
@@ -228,52 +272,16 @@ bool LiveGraphDriver::add_edge(gfe::graph::WeightedEdge e){
 }
 
 bool LiveGraphDriver::add_edge_v2(gfe::graph::WeightedEdge edge){
-    uint64_t internal_source_id = numeric_limits<uint64_t>::max();
-    uint64_t internal_destination_id = 0;
-    bool insert_source = false;
-    bool insert_destination = false;
-    vertex_dictionary_t::const_accessor slock1, slock2;
-    vertex_dictionary_t::accessor xlock1, xlock2;
-
-    if(VertexDictionary->find(slock1, edge.m_source)){ // insert the vertex e.m_source
-        internal_source_id = slock1->second;
-    } else {
-        slock1.release();
-        if ( VertexDictionary->insert(xlock1, edge.m_source) ) {
-            insert_source = true;
-        } else {
-            internal_source_id = xlock1->second;
-        }
-    }
-
-    if(VertexDictionary->find(slock2, edge.m_destination)){ // insert the vertex e.m_destination
-        internal_destination_id = slock2->second;
-    } else {
-        slock2.release();
-        if( VertexDictionary->insert(xlock2, edge.m_destination) ) {
-            insert_destination = true;
-        } else {
-            internal_destination_id = xlock2->second;
-        }
-    }
+    // the vertices are created in their own transactions, rather than together with the edge, so that the threads
+    // inserting edges attached to the same new vertices only wait for the vertices to be created
+    uint64_t internal_source_id = find_or_create_vertex(edge.m_source);
+    uint64_t internal_destination_id = find_or_create_vertex(edge.m_destination);
 
     bool done = false;
     do {
         try {
             auto tx = LiveGraph->begin_transaction();
 
-            // create the vertices in LiveGraph
-            if(insert_source){
-                internal_source_id = tx.new_vertex();
-                string_view data { (char*) &edge.m_source, sizeof(edge.m_source) };
-                tx.put_vertex(internal_source_id, data);
-            }
-            if(insert_destination){
-                internal_destination_id = tx.new_vertex();
-                string_view data { (char*) &edge.m_destination, sizeof(edge.m_destination) };
-                tx.put_vertex(internal_destination_id, data);
-            }
-
             // insert the edge
             string_view weight { (char*) &edge.m_weight, sizeof(edge.m_weight) };
             tx.put_edge(internal_source_id, /* label */ 0, internal_destination_id, weight);
@@ -294,26 +302,13 @@ bool LiveGraphDriver::add_edge_v2(gfe::graph::WeightedEdge edge){
         }
     } while(!done);
 
-    if(insert_source){
-        assert(internal_source_id != numeric_limits<uint64_t>::max());
-        xlock1->second = internal_source_id;
-        m_num_vertices++;
-    }
-    if(insert_destination){
-        assert(internal_destination_id != numeric_limits<uint64_t>::max());
-        xlock2->second = internal_destination_id;
-       m_num_vertices++;
-    }
-
     return true;
 }
 
 bool LiveGraphDriver::remove_edge(gfe::graph::Edge e){
-    vertex_dictionary_t::const_accessor slock1, slock2;
-    if(!VertexDictionary->find(slock1, e.source())){ return false; }
-    if(!VertexDictionary->find(slock2, e.destination())){ return false; }
-    lg::vertex_t internal_source_id = slock1->second;
-    lg::vertex_t internal_destination_id = slock2->second;
+    lg::vertex_t internal_source_id = m_vertex_dictionary->find(e.source());
+    lg::vertex_t internal_destination_id = m_vertex_dictionary->find(e.destination());
+    if(internal_source_id == VertexDictionary::NOT_FOUND || internal_destination_id == VertexDictionary::NOT_FOUND){ return false; }
 
     while(true){
         try {
@@ -333,11 +328,9 @@ bool LiveGraphDriver::remove_edge(gfe::graph::Edge e){
 
 double LiveGraphDriver::get_weight(uint64_t source, uint64_t destination) const {
     // check whether the referred vertices exist
-    vertex_dictionary_t::const_accessor slock1, slock2;
-    if(!VertexDictionary->find(slock1, source)){ return numeric_limits<double>::signaling_NaN(); }
-    if(!VertexDictionary->find(slock2, destination)){ return numeric_limits<double>::signaling_NaN(); }
-    lg::vertex_t internal_source_id = slock1->second;
-    lg::vertex_t internal_destination_id = slock2->second;
+    lg::vertex_t internal_source_id = m_vertex_dictionary->find(source);
+    lg::vertex_t internal_destination_id = m_vertex_dictionary->find(destination);
+    if(internal_source_id == VertexDictionary::NOT_FOUND || internal_destination_id == VertexDictionary::NOT_FOUND){ return numeric_limits<double>::signaling_NaN(); }
 
     auto tx = LiveGraph->begin_read_only_transaction();
     string_view lg_weight = tx.get_edge(internal_source_id, /* label */ 0, internal_destination_id);
@@ -350,6 +343,23 @@ double LiveGraphDriver::get_weight(uint64_t source, uint64_t destination) const
     return weight;
 }
 
+bool LiveGraphDriver::scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const {
+    lg::vertex_t internal_source_id = m_vertex_dictionary->find(vertex);
+    if(internal_source_id == VertexDictionary::NOT_FOUND){ return false; }
+
+    auto tx = LiveGraph->begin_read_only_transaction();
+    auto it = tx.get_edges(internal_source_id, /* label */ 0);
+    while(it.valid()){
+        string_view lg_external_id = tx.get_vertex(it.dst_id()); // the external vertex id is stored in the vertex data
+        double weight = *(reinterpret_cast<const double*>(it.edge_data().data()));
+        if(lg_external_id.size() > 0 && !visitor(*(reinterpret_cast<const uint64_t*>(lg_external_id.data())), weight)) break;
+        it.next();
+    }
+    tx.abort(); // commit() fires the exception `The transaction is read-only without cache.'
+
+    return true;
+}
+
 
 /*****************************************************************************
  *                                                                           *
@@ -375,7 +385,7 @@ void LiveGraphDriver::dump_ostream(std::ostream& out) const {
                 uint64_t internal_destination_id = it.dst_id();
                 auto lg_weight = it.edge_data();
                 double weight = * ((double*) lg_weight.data());
-                out << "<" << internal_destination_id << " [external: " << int2ext(&tx, internal_destination_id) << "], " << weight << ">";
+                out << "<" << internal_destination_id << " [external: " << int2ext(internal_destination_id) << "], " << weight << ">";
                 it.next();
             }
         }
@@ -391,12 +401,19 @@ void LiveGraphDriver::dump_ostream(std::ostream& out) const {
  *****************************************************************************/
 
 template <typename T>
-vector<pair<uint64_t, T>> LiveGraphDriver::translate(void* /* transaction object */ transaction, const T* __restrict data, uint64_t data_sz) {
-    assert(transaction != nullptr && "Transaction object not specified");
+vector<pair<uint64_t, T>> LiveGraphDriver::translate(void* /* transaction object */ opaque_transaction, uint64_t dictionary_version, const T* __restrict data, uint64_t data_sz, utility::TimeoutService& timer) {
+    assert(opaque_transaction != nullptr && "Transaction object not specified");
+    auto transaction = reinterpret_cast<lg::Transaction*>(opaque_transaction);
     vector<pair<uint64_t, T>> output(data_sz);
 
+    #pragma omp parallel for
     for(uint64_t logical_id = 0; logical_id < data_sz; logical_id++){
-        uint64_t external_id = int2ext(transaction, logical_id);
+        if(timer.is_timeout()) continue; // exhausted the budget of available time
+        uint64_t external_id = m_vertex_dictionary->int2ext(logical_id, dictionary_version);
+        if(external_id == VertexDictionary::NOT_FOUND){ // removed or created concurrently to the kernel, ask the snapshot
+            string_view payload = transaction->get_vertex(logical_id);
+            if(!payload.empty()){ external_id = *(reinterpret_cast<const uint64_t*>(payload.data())); }
+        }
         if(external_id == numeric_limits<uint64_t>::max()) { // the vertex does not exist
             output[logical_id] = make_pair(numeric_limits<uint64_t>::max(), numeric_limits<T>::max()); // special marker
         } else {
@@ -411,25 +428,7 @@ template <typename T, bool negative_scores>
 void LiveGraphDriver::save_results(const vector<pair<uint64_t, T>>& result, const char* dump2file) {
     assert(dump2file != nullptr);
     COUT_DEBUG("save the results to: " << dump2file);
-
-    fstream handle(dump2file, ios_base::out);
-    if (!handle.good()) ERROR("Cannot save the result to `" << dump2file << "'");
-
-    for (const auto &p : result) {
-        if(p.first == numeric_limits<uint64_t>::max()) continue; // invalid node
-
-        handle << p.first << " ";
-
-        if(!negative_scores && p.second < 0){
-            handle << numeric_limits<T>::max();
-        } else {
-            handle << p.second;
-        }
-
-        handle << "\n";
-    }
-
-    handle.close();
+    utility::save_results(result, dump2file, negative_scores);
 }
 
 
@@ -584,12 +583,20 @@ void do_bfs_BitmapToQueue(lg::Transaction& transaction, uint64_t max_vertex_id,
     queue.slide_window();
 }
 
+// If given, `degrees' are the out degrees already materialised in an analytics session, or max() if the vertex does not exist
 static
-unique_ptr<int64_t[]> do_bfs_init_distances(lg::Transaction& transaction, uint64_t max_vertex_id) {
+unique_ptr<int64_t[]> do_bfs_init_distances(lg::Transaction& transaction, uint64_t max_vertex_id, const uint64_t* degrees) {
     unique_ptr<int64_t[]> distances{ new int64_t[max_vertex_id] };
     #pragma omp parallel for
     for (uint64_t n = 0; n < max_vertex_id; n++){
-        if(transaction.get_vertex(n).empty()){ // the vertex does not exist
+        if(degrees != nullptr){
+            if(degrees[n] == numeric_limits<uint64_t>::max()){ // the vertex does not exist
+                distances[n] = numeric_limits<int64_t>::max();
+            } else {
+                int64_t out_degree = degrees[n];
+                distances[n] = out_degree != 0 ? - out_degree : -1;
+            }
+        } else if(transaction.get_vertex(n).empty()){ // the vertex does not exist
             distances[n] = numeric_limits<int64_t>::max();
         } else { // the vertex exists
             // Retrieve the out degree for the vertex n
@@ -608,10 +615,10 @@ unique_ptr<int64_t[]> do_bfs_init_distances(lg::Transaction& transaction, uint64
 }
 
 static
-unique_ptr<int64_t[]> do_bfs(lg::Transaction& transaction, uint64_t num_vertices, uint64_t num_edges, uint64_t max_vertex_id, uint64_t root, utility::TimeoutService& timer, int alpha = 15, int beta = 18) {
+unique_ptr<int64_t[]> do_bfs(lg::Transaction& transaction, uint64_t num_vertices, uint64_t num_edges, uint64_t max_vertex_id, uint64_t root, utility::TimeoutService& timer, const uint64_t* degrees = nullptr, int alpha = 15, int beta = 18) {
     // The implementation from GAP BS reports the parent (which indeed it should make more sense), while the one required by
     // Graphalytics only returns the distance
-    unique_ptr<int64_t[]> ptr_distances = do_bfs_init_distances(transaction, max_vertex_id);
+    unique_ptr<int64_t[]> ptr_distances = do_bfs_init_distances(transaction, max_vertex_id, degrees);
     int64_t* __restrict distances = ptr_distances.get();
     distances[root] = 0;
 
@@ -626,7 +633,9 @@ unique_ptr<int64_t[]> do_bfs(lg::Transaction& transaction, uint64_t num_vertices
 
 
     int64_t scout_count = 0;
-    { // retrieve the out degree of the root
+    if(degrees != nullptr){
+        scout_count = degrees[root];
+    } else { // retrieve the out degree of the root
         auto iterator = transaction.get_edges(root, 0);
         while(iterator.valid()){ scout_count++; iterator.next(); }
     }
@@ -664,6 +673,7 @@ void LiveGraphDriver::bfs(uint64_t external_source_id, const char* dump2file) {
     // Init
     utility::TimeoutService timeout { m_timeout };
     Timer timer; timer.start();
+    uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
     lg::Transaction transaction = m_read_only ? LiveGraph->begin_read_only_transaction() : LiveGraph->begin_transaction();
     uint64_t max_vertex_id = LiveGraph->get_max_vertex_id();
     uint64_t num_vertices = m_num_vertices;
@@ -679,7 +689,7 @@ void LiveGraphDriver::bfs(uint64_t external_source_id, const char* dump2file) {
     }
 
     // translate the logical vertex IDs into the external vertex IDs
-    auto external_ids = translate(&transaction, ptr_result.get(), max_vertex_id);
+    auto external_ids = translate(&transaction, dictionary_version, ptr_result.get(), max_vertex_id, timeout);
     transaction.abort(); // not sure if strictly necessary
     if(timeout.is_timeout()){
         RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);
@@ -743,15 +753,16 @@ it is not necessarily the fastest way to implement it. It does perform the
 updates in the pull direction to remove the need for atomics.
 */
 
+// If given, `snapshot_degrees' are the out degrees already materialised in an analytics session, or max() if the vertex does not exist
 static
-unique_ptr<double[]> do_pagerank(lg::Transaction& transaction, uint64_t num_vertices, uint64_t max_vertex_id, uint64_t num_iterations, double damping_factor, utility::TimeoutService& timer) {
+unique_ptr<double[]> do_pagerank(lg::Transaction& transaction, uint64_t num_vertices, uint64_t max_vertex_id, uint64_t num_iterations, double damping_factor, utility::TimeoutService& timer, const uint64_t* snapshot_degrees = nullptr) {
     const double init_score = 1.0 / num_vertices;
     const double base_score = (1.0 - damping_factor) / num_vertices;
 
     unique_ptr<double[]> ptr_scores{ new double[max_vertex_id]() }; // avoid memory leaks
-    unique_ptr<uint64_t[]> ptr_degrees{ new uint64_t[max_vertex_id]() }; // avoid memory leaks
+    unique_ptr<uint64_t[]> ptr_degrees{ snapshot_degrees == nullptr ? new uint64_t[max_vertex_id]() : nullptr }; // avoid memory leaks
     double* scores = ptr_scores.get();
-    uint64_t* __restrict degrees = ptr_degrees.get();
+    const uint64_t* __restrict degrees = snapshot_degrees != nullptr ? snapshot_degrees : ptr_degrees.get();
 
 
     #pragma omp parallel for
@@ -759,13 +770,15 @@ unique_ptr<double[]> do_pagerank(lg::Transaction& transaction, uint64_t num_vert
         scores[v] = init_score;
 
         // compute the outdegree of the vertex
-        if(!transaction.get_vertex(v).empty()){ // check the vertex exists
+        if(snapshot_degrees != nullptr){
+            continue; // already computed
+        } else if(!transaction.get_vertex(v).empty()){ // check the vertex exists
             uint64_t degree = 0;
             auto iterator = transaction.get_edges(v, /* label ? */ 0);
             while(iterator.valid()){ degree++; iterator.next(); }
-            degrees[v] = degree;
+            ptr_degrees[v] = degree;
         } else {
-            degrees[v] = numeric_limits<uint64_t>::max();
+            ptr_degrees[v] = numeric_limits<uint64_t>::max();
         }
     }
 
@@ -818,6 +831,7 @@ void LiveGraphDriver::pagerank(uint64_t num_iterations, double damping_factor, c
     // Init
     utility::TimeoutService timeout { m_timeout };
     Timer timer; timer.start();
+    uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
     lg::Transaction transaction = m_read_only? LiveGraph->begin_read_only_transaction() : LiveGraph->begin_transaction();
     uint64_t num_vertices = m_num_vertices;
     uint64_t max_vertex_id = LiveGraph->get_max_vertex_id();
@@ -827,7 +841,7 @@ void LiveGraphDriver::pagerank(uint64_t num_iterations, double damping_factor, c
     if(timeout.is_timeout()){ transaction.abort(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);  }
 
     // Retrieve the external node ids
-    auto external_ids = translate(&transaction, ptr_result.get(), max_vertex_id);
+    auto external_ids = translate(&transaction, dictionary_version, ptr_result.get(), max_vertex_id, timeout);
     transaction.abort(); // read-only transaction, abort == commit
     if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
@@ -905,8 +919,10 @@ more consistent performance for undirected graphs.
 // The hooking condition (comp_u < comp_v) may not coincide with the edge's
 // direction, so we use a min-max swap such that lower component IDs propagate
 // independent of the edge's direction.
+//
+// If given, `degrees' are the out degrees already materialised in an analytics session, only used to check whether a vertex exists
 static
-unique_ptr<uint64_t[]> do_wcc(lg::Transaction& transaction, uint64_t max_vertex_id, utility::TimeoutService& timer) {
+unique_ptr<uint64_t[]> do_wcc(lg::Transaction& transaction, uint64_t max_vertex_id, utility::TimeoutService& timer, const uint64_t* degrees = nullptr) {
     // init
     COUT_DEBUG_WCC("max_vertex_id: " << max_vertex_id);
     unique_ptr<uint64_t[]> ptr_components { new uint64_t[max_vertex_id] };
@@ -914,7 +930,7 @@ unique_ptr<uint64_t[]> do_wcc(lg::Transaction& transaction, uint64_t max_vertex_
 
     #pragma omp parallel for
     for (uint64_t n = 0; n < max_vertex_id; n++){
-        if(transaction.get_vertex(n).empty()){ // the vertex does not exist
+        if(degrees != nullptr ? degrees[n] == numeric_limits<uint64_t>::max() : transaction.get_vertex(n).empty()){ // the vertex does not exist
             COUT_DEBUG_WCC("Vertex #" << n << " does not exist");
             comp[n] = numeric_limits<uint64_t>::max();
         } else {
@@ -1002,6 +1018,7 @@ static void do_weight_scan(lg::Transaction& transaction, uint64_t max_vertex_id)
 void LiveGraphDriver::wcc(const char* dump2file) {
     /*utility::TimeoutService timeout { m_timeout };
     Timer timer; timer.start();
+    uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
     auto transaction = m_read_only ? LiveGraph->begin_read_only_transaction() : LiveGraph->begin_transaction();
     uint64_t max_vertex_id = LiveGraph->get_max_vertex_id();
 
@@ -1010,7 +1027,7 @@ void LiveGraphDriver::wcc(const char* dump2file) {
     if(timeout.is_timeout()){ transaction.abort(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
     // translate the vertex IDs
-    auto external_ids = translate(&transaction, ptr_components.get(), max_vertex_id);
+    auto external_ids = translate(&transaction, dictionary_version, ptr_components.get(), max_vertex_id, timeout);
     transaction.abort(); // read-only transaction, abort == commit
     if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
@@ -1147,6 +1164,7 @@ void LiveGraphDriver::cdlp(uint64_t max_iterations, const char* dump2file) {
 
     utility::TimeoutService timeout { m_timeout };
     Timer timer; timer.start();
+    uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
     auto transaction = m_read_only ?  LiveGraph->begin_read_only_transaction() : LiveGraph->begin_transaction();
     uint64_t max_vertex_id = LiveGraph->get_max_vertex_id();
 
@@ -1155,7 +1173,7 @@ void LiveGraphDriver::cdlp(uint64_t max_iterations, const char* dump2file) {
     if(timeout.is_timeout()){ transaction.abort(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);  }
 
     // Translate the vertex IDs
-    auto external_ids = translate(&transaction, labels.get(), max_vertex_id);
+    auto external_ids = translate(&transaction, dictionary_version, labels.get(), max_vertex_id, timeout);
     transaction.abort(); // read-only transaction, abort == commit
     if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
@@ -1269,6 +1287,7 @@ void LiveGraphDriver::lcc(const char* dump2file) {
 
     utility::TimeoutService timeout { m_timeout };
     Timer timer; timer.start();
+    uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
     lg::Transaction transaction = m_read_only ? LiveGraph->begin_read_only_transaction() : LiveGraph->begin_transaction();
     uint64_t max_vertex_id = LiveGraph->get_max_vertex_id();
 
@@ -1277,7 +1296,7 @@ void LiveGraphDriver::lcc(const char* dump2file) {
     if(timeout.is_timeout()){ transaction.abort(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);  }
 
     // Translate the vertex IDs
-    auto external_ids = translate(&transaction, scores.get(), max_vertex_id);
+    auto external_ids = translate(&transaction, dictionary_version, scores.get(), max_vertex_id, timeout);
     transaction.abort(); // read-only transaction, abort == commit
     if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
@@ -1333,6 +1352,7 @@ gapbs::pvector<WeightT> do_sssp(lg::Transaction& transaction, uint64_t num_edges
     // two element arrays for double buffering curr=iter&1, next=(iter+1)&1
     size_t shared_indexes[2] = {0, kMaxBin};
     size_t frontier_tails[2] = {1, 0};
+    bool timed_out = false; // set by a single thread, read by all threads after the barrier at the end of each iteration
     frontier[0] = source;
 
     #pragma omp parallel
@@ -1340,13 +1360,14 @@ gapbs::pvector<WeightT> do_sssp(lg::Transaction& transaction, uint64_t num_edges
         vector<vector<NodeID> > local_bins(0);
         size_t iter = 0;
 
-        while (shared_indexes[iter&1] != kMaxBin) {
+        while (shared_indexes[iter&1] != kMaxBin && !timed_out) {
             size_t &curr_bin_index = shared_indexes[iter&1];
             size_t &next_bin_index = shared_indexes[(iter+1)&1];
             size_t &curr_frontier_tail = frontier_tails[iter&1];
             size_t &next_frontier_tail = frontier_tails[(iter+1)&1];
             #pragma omp for nowait schedule(dynamic, 64)
             for (size_t i=0; i < curr_frontier_tail; i++) {
+                if (timer.is_timeout()) continue; // exhausted the budget of available time
                 NodeID u = frontier[i];
                 if (dist[u] >= delta * static_cast<WeightT>(curr_bin_index)) {
                     auto iterator = transaction.get_edges(u, /* label */ 0);
@@ -1393,6 +1414,7 @@ gapbs::pvector<WeightT> do_sssp(lg::Transaction& transaction, uint64_t num_edges
             {
                 curr_bin_index = kMaxBin;
                 curr_frontier_tail = 0;
+                timed_out = timer.is_timeout();
             }
 
             if (next_bin_index < local_bins.size()) {
@@ -1417,6 +1439,7 @@ gapbs::pvector<WeightT> do_sssp(lg::Transaction& transaction, uint64_t num_edges
 void LiveGraphDriver::sssp(uint64_t source_vertex_id, const char* dump2file) {
     utility::TimeoutService timeout { m_timeout };
     Timer timer; timer.start();
+    uint64_t dictionary_version = m_vertex_dictionary->version(); // before opening the snapshot, see #translate
     lg::Transaction transaction = m_read_only ? LiveGraph->begin_read_only_transaction() : LiveGraph->begin_transaction();
      uint64_t max_vertex_id = LiveGraph->get_max_vertex_id();
     //uint64_t num_edges = m_num_edges;
@@ -1429,7 +1452,7 @@ void LiveGraphDriver::sssp(uint64_t source_vertex_id, const char* dump2file) {
     if(timeout.is_timeout()){ transaction.abort(); RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);  }
 
     // Translate the vertex IDs
-    auto external_ids = translate(&transaction, distances.data(), max_vertex_id);
+    auto external_ids = translate(&transaction, dictionary_version, distances.data(), max_vertex_id, timeout);
     transaction.abort(); // read-only transaction, abort == commit
     if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
@@ -1438,22 +1461,174 @@ void LiveGraphDriver::sssp(uint64_t source_vertex_id, const char* dump2file) {
         save_results(external_ids, dump2file);
 }
 
+/*****************************************************************************
+ *                                                                           *
+ *  Analytics session                                                        *
+ *                                                                           *
+ *****************************************************************************/
+/**
+ * Run the kernels on the same transaction, with the external IDs and the degrees of the vertices materialised once
+ */
+class LiveGraphAnalyticsSession : public AnalyticsSession {
+    LiveGraphDriver* m_driver; // the instance that created this session
+    lg::Transaction m_transaction; // the snapshot shared by the kernels
+    AnalyticsSnapshot m_snapshot; // external IDs and degrees of the vertices in the snapshot
+
+    // Retrieve the internal ID of the given source vertex, it must exist in the snapshot
+    uint64_t source(uint64_t external_vertex_id) const;
+
+public:
+    LiveGraphAnalyticsSession(LiveGraphDriver* driver);
+    ~LiveGraphAnalyticsSession();
+    bool materialize_csr() override;
+    void bfs(uint64_t source_vertex_id, const char* dump2file) override;
+    void pagerank(uint64_t num_iterations, double damping_factor, const char* dump2file) override;
+    void wcc(const char* dump2file) override;
+    void sssp(uint64_t source_vertex_id, const char* dump2file) override;
+};
+
+LiveGraphAnalyticsSession::LiveGraphAnalyticsSession(LiveGraphDriver* driver) : m_driver(driver),
+        m_transaction(driver->m_read_only ? reinterpret_cast<lg::Graph*>(driver->m_pImpl)->begin_read_only_transaction() : reinterpret_cast<lg::Graph*>(driver->m_pImpl)->begin_transaction()),
+        m_snapshot(reinterpret_cast<lg::Graph*>(driver->m_pImpl)->get_max_vertex_id()) {
+
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for(uint64_t v = 0; v < m_snapshot.max_vertex_id(); v++){
+        string_view payload = m_transaction.get_vertex(v);
+        if(payload.empty()) continue; // the vertex does not exist
+
+        uint64_t degree = 0;
+        auto iterator = m_transaction.get_edges(v, /* label */ 0);
+        while(iterator.valid()){ degree++; iterator.next(); }
+
+        m_snapshot.set_vertex(v, *(reinterpret_cast<const uint64_t*>(payload.data())), degree);
+    }
+
+    m_snapshot.seal(m_driver->m_is_directed);
+}
+
+LiveGraphAnalyticsSession::~LiveGraphAnalyticsSession(){
+    m_transaction.abort(); // read-only transaction, abort == commit
+}
+
+bool LiveGraphAnalyticsSession::materialize_csr(){
+    if(m_csr) return true; // already materialised
+
+    auto csr = make_unique<CSR>(m_driver->m_is_directed);
+    csr->set_timeout(m_driver->m_timeout.count());
+    csr->materialize_begin(m_snapshot);
+
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for(uint64_t v = 0; v < m_snapshot.max_vertex_id(); v++){
+        if(!m_snapshot.has_vertex(v)) continue;
+
+        uint64_t position = 0;
+        auto iterator = m_transaction.get_edges(v, /* label */ 0);
+        while(iterator.valid()){
+            string_view payload = iterator.edge_data();
+            csr->materialize_edge(v, position++, iterator.dst_id(), *reinterpret_cast<const double*>(payload.data()));
+            iterator.next();
+        }
+    }
+
+    csr->materialize_end();
+    m_csr = move(csr);
+    return true;
+}
+
+uint64_t LiveGraphAnalyticsSession::source(uint64_t external_vertex_id) const {
+    uint64_t root = m_driver->ext2int(external_vertex_id);
+    if(!m_snapshot.has_vertex(root)){ ERROR("The vertex " << external_vertex_id << " does not exist in the snapshot of the session"); }
+    return root;
+}
+
+void LiveGraphAnalyticsSession::bfs(uint64_t external_source_id, const char* dump2file){
+    if(m_csr){ return m_csr->bfs(external_source_id, dump2file); }
+    if(m_driver->m_is_directed) { ERROR("This implementation of the BFS does not support directed graphs"); }
+
+    utility::TimeoutService timeout { m_driver->m_timeout };
+    Timer timer; timer.start();
+    uint64_t root = source(external_source_id);
+
+    unique_ptr<int64_t[]> ptr_result = do_bfs(m_transaction, m_snapshot.num_vertices(), m_snapshot.num_edges(), m_snapshot.max_vertex_id(), root, timeout, m_snapshot.degrees());
+    if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+
+    auto external_ids = m_snapshot.translate(ptr_result.get()); // the timed kernels always translate the results, as the kernels of the driver
+    if(dump2file != nullptr){
+        m_driver->save_results<int64_t, false>(external_ids, dump2file);
+    }
+}
+
+void LiveGraphAnalyticsSession::pagerank(uint64_t num_iterations, double damping_factor, const char* dump2file){
+    if(m_csr){ return m_csr->pagerank(num_iterations, damping_factor, dump2file); }
+    if(m_driver->m_is_directed) { ERROR("This implementation of PageRank does not support directed graphs"); }
+
+    utility::TimeoutService timeout { m_driver->m_timeout };
+    Timer timer; timer.start();
+
+    unique_ptr<double[]> ptr_result = do_pagerank(m_transaction, m_snapshot.num_vertices(), m_snapshot.max_vertex_id(), num_iterations, damping_factor, timeout, m_snapshot.degrees());
+    if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+
+    auto external_ids = m_snapshot.translate(ptr_result.get());
+    if(dump2file != nullptr){
+        m_driver->save_results(external_ids, dump2file);
+    }
+}
+
+void LiveGraphAnalyticsSession::wcc(const char* dump2file){
+    if(m_csr){ return m_csr->wcc(dump2file); }
+    do_weight_scan(m_transaction, m_snapshot.max_vertex_id()); // same kernel of LiveGraphDriver::wcc
+}
+
+void LiveGraphAnalyticsSession::sssp(uint64_t source_vertex_id, const char* dump2file){
+    if(m_csr){ return m_csr->sssp(source_vertex_id, dump2file); }
+    utility::TimeoutService timeout { m_driver->m_timeout };
+    Timer timer; timer.start();
+    uint64_t root = source(source_vertex_id);
+
+    double delta = 2.0; // same value used in the GAPBS, at least for most graphs
+    auto distances = do_sssp(m_transaction, m_snapshot.num_edges(), m_snapshot.max_vertex_id(), root, delta, timeout);
+    if(timeout.is_timeout()){ RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+
+    auto external_ids = m_snapshot.translate(distances.data());
+    if(dump2file != nullptr){
+        m_driver->save_results(external_ids, dump2file);
+    }
+}
+
+unique_ptr<AnalyticsSession> LiveGraphDriver::begin_analytics_session(){
+    return make_unique<LiveGraphAnalyticsSession>(this);
+}
+
 void LiveGraphDriver::generate_two_hops_neighbor_candidates(std::vector<uint64_t>&vertices){
-    uint64_t max_vertex_id = LiveGraph->get_max_vertex_id();
-     vertices.resize(two_hop_neighbor_size);
-      std::unordered_set<uint64_t> unique_vertices;
-    for (uint64_t i = 0; i < two_hop_neighbor_size; i++)
-    {
-      uint64_t vid = rand() % max_vertex_id;
-      auto result = unique_vertices.emplace(vid);
-      if (result.second)
-      {
-        vertices[i] = vid;
-      }
-      else
-      {
-        i--;
-      }
+    auto sampler = vertex_sampler();
+
+    if(sampler->has_population()){ // external vertex IDs, translate them into the internal IDs
+        sampler->sample(two_hop_neighbor_size, vertices);
+        uint64_t num_vertices = 0;
+        for(uint64_t external_id : vertices){
+            uint64_t internal_id = m_vertex_dictionary->find(external_id);
+            if(internal_id != VertexDictionary::NOT_FOUND){ vertices[num_vertices++] = internal_id; } // skip the vertices not inserted yet
+        }
+        vertices.resize(num_vertices);
+    } else { // draw from the live vertices of the graph
+        const bool with_degrees = sampler->distribution() == utility::VertexSamplerDistribution::DEGREE;
+        vector<uint64_t> population;
+        vector<uint64_t> degrees;
+        auto tx = LiveGraph->begin_read_only_transaction();
+        const uint64_t max_vertex_id = LiveGraph->get_max_vertex_id();
+        for(uint64_t internal_id = 0; internal_id < max_vertex_id; internal_id++){
+            if(tx.get_vertex(internal_id).size() == 0) continue; // the vertex has been deleted
+            population.push_back(internal_id);
+            if(with_degrees){
+                uint64_t degree = 0;
+                auto it = tx.get_edges(internal_id, /* label */ 0);
+                while(it.valid()){ degree++; it.next(); }
+                degrees.push_back(degree);
+            }
+        }
+        tx.abort(); // commit() fires the exception `The transaction is read-only without cache.'
+
+        sampler->sample(population.data(), with_degrees ? degrees.data() : nullptr, population.size(), two_hop_neighbor_size, vertices);
     }
 }
 
@@ -21,18 +21,23 @@
 #include <chrono>
 #include "library/interface.hpp"
 
+namespace gfe::utility { class TimeoutService; } // forward declaration
+
 namespace gfe::library {
 
+class VertexDictionary; // forward declaration
+
 /**
  * Wrapper to evaluate the LiveGraph library
  */
 class LiveGraphDriver : public virtual UpdateInterface, public virtual GraphalyticsInterface {
     LiveGraphDriver(const LiveGraphDriver&) = delete;
     LiveGraphDriver& operator=(const LiveGraphDriver&) = delete;
+    friend class LiveGraphAnalyticsSession;
 
 protected:
     void* m_pImpl; // pointer to the LiveGraph handle
-    void* m_pHashMap; // pointer to the TBB HashMap to translate the vertex identifiers into the dense IDs for livegraph
+    VertexDictionary* m_vertex_dictionary; // translate the vertex identifiers into the dense IDs for livegraph
     const bool m_is_directed; // whether the underlying graph is directed or undirected
     const bool m_read_only; // whether to used read only transactions for graphalytics
     std::atomic<uint64_t> m_num_vertices {0}; // keep track of the total number of vertices
@@ -43,12 +48,19 @@ protected:
     // Retrieve the internal vertex ID for the given external vertex. If the vertex does not exist, it raises an internal error
     uint64_t ext2int(uint64_t external_vertex_id) const;
 
-    // Retrieve the internal vertex ID for the given internal vertex ID. If the vertex does not exist, it returns uint64_t::max()
-    uint64_t int2ext(void* transaction, uint64_t internal_vertex_id) const;
+    // Create a new vertex in LiveGraph, storing its external ID as vertex data. Return its internal vertex ID
+    uint64_t create_vertex(uint64_t external_vertex_id);
+
+    // Retrieve the internal vertex ID for the given external vertex, creating the vertex if it does not exist
+    uint64_t find_or_create_vertex(uint64_t external_vertex_id, bool* out_created = nullptr);
 
-    // Helper for Graphalytics: translate the logical IDs into external IDs
+    // Retrieve the external vertex ID for the given internal vertex ID. If the vertex does not exist, it returns uint64_t::max()
+    uint64_t int2ext(uint64_t internal_vertex_id) const;
+
+    // Helper for Graphalytics: translate the logical IDs into external IDs, with the inverse mapping of the vertex dictionary. The vertices the dictionary
+    // cannot vouch for, as they were removed or published after `dictionary_version', are looked up in the snapshot of the transaction. It stops early if the timer expires.
     template <typename T>
-    std::vector<std::pair<uint64_t, T>> translate(void* /* transaction object */ lgtxn, const T* __restrict data, uint64_t data_sz);
+    std::vector<std::pair<uint64_t, T>> translate(void* /* transaction object */ transaction, uint64_t dictionary_version, const T* __restrict data, uint64_t data_sz, utility::TimeoutService& timer);
 
     // Helper, save the content of the vector to the given output file
     template <typename T, bool negative_scores = true>
@@ -96,6 +108,21 @@ public:
      */
     virtual void set_timeout(uint64_t seconds);
 
+    /**
+     * Load the whole graph from the given path. The vertices are registered in the vertex dictionary in bulk.
+     */
+    virtual void load(const std::string& path);
+
+    /**
+     * Reset the statistics of the vertex dictionary
+     */
+    virtual void updates_start();
+
+    /**
+     * Report the time spent in the vertex dictionary, separately from the time spent in LiveGraph
+     */
+    virtual void updates_stop();
+
     /**
      * Add the given vertex to the graph
      * @return true if the vertex has been inserted, false otherwise (that is, the vertex already exists)
@@ -139,7 +166,7 @@ public:
      * For Debugging & Testing only
      */
     void* livegraph(); // lg::Graph*
-    void* vertex_dictionary(); // tbb::concurrent_hash_map<uint64_t, lg::vertex_t>
+    VertexDictionary* vertex_dictionary();
 
     /**
      * Perform a BFS from source_vertex_id to all the other vertices in the graph.
@@ -188,6 +215,16 @@ public:
     virtual void generate_two_hops_neighbor_candidates(std::vector<uint64_t>&vertices);
     virtual void one_hop_neighbors(std::vector<uint64_t>&vertices);
     virtual void two_hop_neighbors(std::vector<uint64_t>&vertices);
+
+    /**
+     * Visit the outgoing edges of the given vertex, inside a read-only transaction
+     */
+    virtual bool scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const;
+
+    /**
+     * Open a transaction shared by the kernels of the session, materialising the external IDs and the degrees of the vertices once
+     */
+    virtual std::unique_ptr<AnalyticsSession> begin_analytics_session();
 };
 
 } // namespace
@@ -12,6 +12,7 @@
 
 #include "common/timer.hpp"
 #include "utility/timeout_service.hpp"
+#include "utility/vertex_sampler.hpp"
 
 #include "not_implemented.hpp"
 
@@ -123,6 +124,44 @@ namespace gfe::library
     return has_edge ? w : nan("");
   }
 
+  bool SortledtonDriver::scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const
+  {
+    SortledtonDriver *non_const_this = const_cast<SortledtonDriver *>(this);
+    SnapshotTransaction tx = non_const_this->tm.getSnapshotTransaction(ds, false);
+
+    if (!tx.has_vertex(vertex))
+    {
+      non_const_this->tm.transactionCompleted(tx);
+      return false;
+    }
+
+    bool proceed = true;
+    VersionedBlockedPropertyEdgeIterator _iter = tx.neighbourhood_with_properties_blocked_p(tx.physical_id(vertex));
+    while (proceed && _iter.has_next_block())
+    {
+      auto [_versioned, _bs, _be, _ws, _we] = _iter.next_block_with_properties();
+      if (_versioned)
+      {
+        while (proceed && _iter.has_next_edge())
+        {
+          auto [edge_name, properties_name] = _iter.next_with_properties();
+          proceed = visitor(tx.logical_id(edge_name), properties_name);
+        }
+      }
+      else
+      {
+        auto _p = _ws;
+        for (auto _i = _bs; proceed && _i < _be; _i++, _p++)
+        {
+          proceed = visitor(tx.logical_id(*_i), *_p);
+        }
+      }
+    }
+
+    non_const_this->tm.transactionCompleted(tx);
+    return true;
+  }
+
   /**
    * Check whether the graph is directed
    */
@@ -481,34 +520,35 @@ namespace gfe::library
     }
   }
 
+  // If the budget of time of the current kernel expired, release its transaction and thread, then raise a TimeoutError
+  static void check_timeout(TransactionManager &tm, SnapshotTransaction &tx, utility::TimeoutService &timeout, const Timer &timer)
+  {
+    if (timeout.is_timeout())
+    {
+      tm.transactionCompleted(tx);
+      tm.deregister_thread(0);
+      RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);
+    }
+  }
+
   static void save_bfs(vector<pair<uint64_t, uint>> &result, const char *dump2file)
   {
     assert(dump2file != nullptr);
     COUT_DEBUG("save the results to: " << dump2file)
 
-    fstream handle(dump2file, ios_base::out);
-    if (!handle.good())
-      ERROR("Cannot save the result to `" << dump2file << "'");
-
-    for (const auto &p : result)
+    // if  the vertex was not reached, the algorithm sets its distance to < 0
+    vector<pair<uint64_t, int64_t>> distances(result.size());
+#pragma omp parallel for
+    for (uint64_t i = 0; i < result.size(); i++)
     {
-      handle << p.first << " ";
-
-      // if  the vertex was not reached, the algorithm sets its distance to < 0
-      if (p.second == numeric_limits<uint>::max())
-      {
-        handle << numeric_limits<int64_t>::max();
-      }
-      else
-      {
-        handle << (int64_t)p.second;
-      }
-      handle << "\n";
+      const auto &p = result[i];
+      distances[i] = make_pair(p.first, p.second == numeric_limits<uint>::max() ? numeric_limits<int64_t>::max() : (int64_t)p.second);
     }
-    handle.close();
+
+    utility::save_results(distances, dump2file, /* negative scores */ true, /* skip invalid vertices */ false);
   }
 
-  static vector<pair<uint64_t, uint>> translate_bfs(SnapshotTransaction &tx, pvector<int64_t> &values)
+  static vector<pair<uint64_t, uint>> translate_bfs(SnapshotTransaction &tx, pvector<int64_t> &values, utility::TimeoutService &timeout)
   {
     auto N = values.size();
 
@@ -517,6 +557,8 @@ namespace gfe::library
 #pragma omp parallel for
     for (uint v = 0; v < N; v++)
     {
+      if (timeout.is_timeout())
+        continue; // exhausted the budget of available time
       if (tx.has_vertex_p(v))
       {
         if (values[v] >= 0)
@@ -538,6 +580,9 @@ namespace gfe::library
 
   void SortledtonDriver::bfs(uint64_t source_vertex_id, const char *dump2file)
   {
+    utility::TimeoutService timeout{m_timeout};
+    Timer timer;
+    timer.start();
     tm.register_thread(0);
     SnapshotTransaction tx = tm.getSnapshotTransaction(ds, false);
 
@@ -548,9 +593,11 @@ namespace gfe::library
     // Timer t;
     // t.start();
     auto distances = GAPBSAlgorithms::bfs(tx, physical_src, false);
+    check_timeout(tm, tx, timeout, timer);
 
     // cout << "BFS took " << t << endl;
-    auto external_ids = translate_bfs(tx, distances);
+    auto external_ids = translate_bfs(tx, distances, timeout);
+    check_timeout(tm, tx, timeout, timer);
     // cout << "Translation took " << t << endl;
     tm.transactionCompleted(tx);
 
@@ -563,14 +610,18 @@ namespace gfe::library
 
   void SortledtonDriver::pagerank(uint64_t num_iterations, double damping_factor, const char *dump2file)
   {
+    utility::TimeoutService timeout{m_timeout};
+    Timer timer;
+    timer.start();
     tm.register_thread(0);
     SnapshotTransaction tx = tm.getSnapshotTransaction(ds, false);
 
     // run_gc();
 
     auto pr = PageRank::page_rank_bs(tx, num_iterations, damping_factor);
-    ;
-    auto external_ids = translate<double>(tx, pr);
+    check_timeout(tm, tx, timeout, timer);
+    auto external_ids = translate<double>(tx, pr, timeout);
+    check_timeout(tm, tx, timeout, timer);
 
     tm.transactionCompleted(tx);
 
@@ -583,6 +634,9 @@ namespace gfe::library
 
   void SortledtonDriver::wcc(const char *dump2file)
   {
+    utility::TimeoutService timeout{m_timeout};
+    Timer timer;
+    timer.start();
     tm.register_thread(0);
     /*SnapshotTransaction tx = tm.getSnapshotTransaction(ds, false);
 
@@ -599,6 +653,10 @@ namespace gfe::library
     }*/
     do_weight_scan();
     tm.deregister_thread(0);
+    if (timeout.is_timeout())
+    {
+      RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);
+    }
   }
   void SortledtonDriver::do_topology_scan()
   {
@@ -657,6 +715,9 @@ namespace gfe::library
 
   void SortledtonDriver::cdlp(uint64_t max_iterations, const char *dump2file)
   {
+    utility::TimeoutService timeout{m_timeout};
+    Timer timer;
+    timer.start();
     tm.register_thread(0);
     /*SnapshotTransaction tx = tm.getSnapshotTransaction(ds, false);
 
@@ -673,10 +734,17 @@ namespace gfe::library
     // run_gc();
     do_topology_scan();
     tm.deregister_thread(0);
+    if (timeout.is_timeout())
+    {
+      RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer);
+    }
   }
 
   void SortledtonDriver::sssp(uint64_t source_vertex_id, const char *dump2file)
   {
+    utility::TimeoutService timeout{m_timeout};
+    Timer timer;
+    timer.start();
     tm.register_thread(0);
     SnapshotTransaction tx = tm.getSnapshotTransaction(ds, false);
 
@@ -685,8 +753,10 @@ namespace gfe::library
     auto physical_src = tx.physical_id(source_vertex_id);
 
     auto distances = SSSP::gabbs_sssp(tx, physical_src, 2.0);
+    check_timeout(tm, tx, timeout, timer);
 
-    auto external_ids = translate<double>(tx, distances);
+    auto external_ids = translate<double>(tx, distances, timeout);
+    check_timeout(tm, tx, timeout, timer);
 
     tm.transactionCompleted(tx);
 
@@ -702,6 +772,11 @@ namespace gfe::library
     return true;
   }
 
+  bool SortledtonDriver::can_run_kernels_concurrently() const
+  {
+    return false;
+  }
+
   /*****************************************************************************
    *                                                                           *
    *  LCC, sort-merge implementation, taken from Teseo, adapted to Sortledton  *
@@ -719,6 +794,7 @@ namespace gfe::library
     class Master
     {
       SnapshotTransaction &ds;           // CSR data structure
+      utility::TimeoutService &m_timeout; // the budget of time of the kernel
       atomic<uint64_t> *m_num_triangles; // number of triangles counted so far for the given vertex, array of num_vertices
       std::atomic<uint64_t> m_next;      // counter to select the next task among the workers
 
@@ -730,7 +806,7 @@ namespace gfe::library
 
     public:
       // Constructor
-      Master(SnapshotTransaction &ds);
+      Master(SnapshotTransaction &ds, utility::TimeoutService &timeout);
 
       // Destructor
       ~Master();
@@ -773,12 +849,12 @@ namespace gfe::library
     class GFELCC
     {
     public:
-      static vector<double> execute(SnapshotTransaction &tx);
+      static vector<double> execute(SnapshotTransaction &tx, utility::TimeoutService &timeout);
     };
 
-    vector<double> GFELCC::execute(SnapshotTransaction &tx)
+    vector<double> GFELCC::execute(SnapshotTransaction &tx, utility::TimeoutService &timeout)
     {
-      Master algorithm(tx);
+      Master algorithm(tx, timeout);
       return algorithm.execute();
     }
 
@@ -791,7 +867,7 @@ namespace gfe::library
      *  LCC_Master                                                               *
      *                                                                           *
      *****************************************************************************/
-    Master::Master(SnapshotTransaction &ds) : ds(ds), m_num_triangles(nullptr), m_next(0)
+    Master::Master(SnapshotTransaction &ds, utility::TimeoutService &timeout) : ds(ds), m_timeout(timeout), m_num_triangles(nullptr), m_next(0)
     {
     }
 
@@ -856,6 +932,8 @@ namespace gfe::library
     bool Master::next_task(uint64_t *output_vtx_start /* inclusive */,
                            uint64_t *output_vtx_end /* exclusive */)
     {
+      if (m_timeout.is_timeout())
+        return false; // exhausted the budget of available time
       uint64_t logical_start = m_next.fetch_add(LCC_TASK_SIZE); /* return the previous value of m_next */
       uint64_t num_vertices = ds.vertex_count();
       if (logical_start >= num_vertices)
@@ -955,15 +1033,20 @@ namespace gfe::library
 
   void SortledtonDriver::lcc(const char *dump2file)
   {
+    utility::TimeoutService timeout{m_timeout};
+    Timer timer;
+    timer.start();
     tm.register_thread(0);
     SnapshotTransaction tx = tm.getSnapshotTransaction(ds, false);
 
     run_gc();
 
-    auto lcc_values = GFELCC::execute(tx);
+    auto lcc_values = GFELCC::execute(tx, timeout);
+    check_timeout(tm, tx, timeout, timer);
 
     //      auto lcc_values = LCC::lcc_merge_sort(tx);
-    auto external_ids = translate<double>(tx, lcc_values);
+    auto external_ids = translate<double>(tx, lcc_values, timeout);
+    check_timeout(tm, tx, timeout, timer);
 
     tm.transactionCompleted(tx);
 
@@ -1035,22 +1118,40 @@ namespace gfe::library
   // two hop neighbors
   void SortledtonDriver::generate_two_hops_neighbor_candidates(std::vector<uint64_t> &vertices)
   {
-    vertices.resize(two_hop_neighbor_size);
-    const uint64_t max_physical_vertices = ds->max_physical_vertex();
-    std::unordered_set<uint64_t> unique_vertices;
-    for (uint64_t i = 0; i < two_hop_neighbor_size; i++)
-    {
-      uint64_t vid = rand() % max_physical_vertices;
-      auto result = unique_vertices.emplace(vid);
-      if (result.second)
+    tm.register_thread(0);
+    auto sampler = vertex_sampler();
+    SnapshotTransaction tx = tm.getSnapshotTransaction(ds, false);
+
+    if (sampler->has_population())
+    { // external vertex IDs, translate them into the physical IDs
+      sampler->sample(two_hop_neighbor_size, vertices);
+      uint64_t num_vertices = 0;
+      for (uint64_t external_id : vertices)
       {
-        vertices[i] = vid;
+        if (tx.has_vertex(external_id)) // skip the vertices not inserted yet
+        {
+          vertices[num_vertices++] = tx.physical_id(external_id);
+        }
       }
-      else
+      vertices.resize(num_vertices);
+    }
+    else
+    { // draw from the live vertices of the graph
+      const bool with_degrees = sampler->distribution() == utility::VertexSamplerDistribution::DEGREE;
+      std::vector<uint64_t> population;
+      std::vector<uint64_t> degrees;
+      const uint64_t max_physical_vertices = ds->max_physical_vertex();
+      for (uint64_t v = 0; v < max_physical_vertices; v++)
       {
-        i--;
+        if (!tx.has_vertex_p(v)) continue;
+        population.push_back(v);
+        if (with_degrees) { degrees.push_back(tx.neighbourhood_size_p(v)); }
       }
+      sampler->sample(population.data(), with_degrees ? degrees.data() : nullptr, population.size(), two_hop_neighbor_size, vertices);
     }
+
+    tm.transactionCompleted(tx);
+    tm.deregister_thread(0);
     std::sort(vertices.begin(), vertices.end());
   }
 
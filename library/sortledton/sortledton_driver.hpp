@@ -11,6 +11,8 @@
 #include "third-party/libcuckoo/cuckoohash_map.hh"
 
 #include "library/interface.hpp"
+#include "utility/result_writer.hpp"
+#include "utility/timeout_service.hpp"
 
 #include "data-structure/TransactionManager.h"
 #include "data-structure/VersioningBlockedSkipListAdjacencyList.h"
@@ -40,13 +42,14 @@ namespace gfe::library {
         bool gced = false;
 
         template <typename T>
-        vector<pair<uint64_t, T>> translate(SnapshotTransaction& tx, vector<T>& values) {
+        vector<pair<uint64_t, T>> translate(SnapshotTransaction& tx, vector<T>& values, utility::TimeoutService& timeout) {
           int N = values.size();
 
           vector<pair<vertex_id_t , T>> logical_result(N);
 
 #pragma omp parallel for
           for (uint v = 0; v <  N; v++) {
+            if (timeout.is_timeout()) continue; // exhausted the budget of available time
             if (tx.has_vertex_p(v)) {
               logical_result[v] = make_pair(tx.logical_id(v), values[v]);
             } else {
@@ -61,15 +64,7 @@ namespace gfe::library {
           assert(dump2file != nullptr);
           COUT_DEBUG("save the results to: " << dump2file)
 
-          fstream handle(dump2file, ios_base::out);
-          if (!handle.good()) ERROR("Cannot save the result to `" << dump2file << "'");
-
-          for (const auto &p : result) {
-            handle << p.first << " ";
-            handle << p.second;
-            handle << "\n";
-          }
-          handle.close();
+          utility::save_results(result, dump2file, /* negative scores */ true, /* skip invalid vertices */ false);
         }
 
         void run_gc();
@@ -213,6 +208,9 @@ namespace gfe::library {
 
         virtual bool can_be_validated() const;
 
+        // The kernels always register their transaction with the thread id 0, they cannot run concurrently
+        virtual bool can_run_kernels_concurrently() const;
+
         //libin add this
         void do_topology_scan();
         
@@ -222,7 +220,11 @@ namespace gfe::library {
         virtual void one_hop_neighbors(std::vector<uint64_t>&vertices);
         virtual void two_hop_neighbors(std::vector<uint64_t>&vertices);
 
-        
+        /**
+         * Visit the outgoing edges of the given vertex, inside a snapshot transaction
+         */
+        virtual bool scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const;
+
     };
 
 }
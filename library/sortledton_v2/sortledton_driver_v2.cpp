@@ -283,30 +283,25 @@ namespace gfe::library {
       assert(dump2file != nullptr);
       COUT_DEBUG("save the results to: " << dump2file)
 
-      fstream handle(dump2file, ios_base::out);
-      if (!handle.good()) ERROR("Cannot save the result to `" << dump2file << "'");
-
-      for (const auto &p : result) {
-        handle << p.first << " ";
-
-        // if  the vertex was not reached, the algorithm sets its distance to < 0
-        if (p.second == numeric_limits<uint>::max()) {
-          handle << numeric_limits<int64_t>::max();
-        } else {
-          handle << (int64_t) p.second;
-        }
-        handle << "\n";
+      // if  the vertex was not reached, the algorithm sets its distance to < 0
+      vector <pair<uint64_t, int64_t>> distances(result.size());
+#pragma omp parallel for
+      for (uint64_t i = 0; i < result.size(); i++) {
+        const auto &p = result[i];
+        distances[i] = make_pair(p.first, p.second == numeric_limits<uint>::max() ? numeric_limits<int64_t>::max() : (int64_t) p.second);
       }
-      handle.close();
+
+      utility::save_results(distances, dump2file, /* negative scores */ true, /* skip invalid vertices */ false);
     }
 
-    static vector <pair<uint64_t, uint>> translate_bfs(sortledton::storage::GraphStorageForwarder &tx, pvector <int64_t> &values) {
+    static vector <pair<uint64_t, uint>> translate_bfs(sortledton::storage::GraphStorageForwarder &tx, pvector <int64_t> &values, utility::TimeoutService &timeout) {
       auto N = values.size();
 
       vector <pair<sortledton::vertex_id_t, uint>> logical_result(N);
 
 #pragma omp parallel for
       for (uint v = 0; v < N; v++) {
+        if (timeout.is_timeout()) continue; // exhausted the budget of available time
         if (tx.has_vertex_p(v)) {
           if (values[v] >= 0) {
             logical_result[v] = make_pair(tx.logical_id(v), values[v]);
@@ -322,11 +317,16 @@ namespace gfe::library {
 
 
     void SortledtonDriverV2::bfs(uint64_t source_vertex_id, const char *dump2file) {
+      utility::TimeoutService timeout{m_timeout};
+      Timer timer;
+      timer.start();
       run_gc();
 
       auto physical_src = tx.physical_id(source_vertex_id);
       auto distances = sortledton::algorithms::BFS::bfs(tx, physical_src);
-      auto external_ids = translate_bfs(tx, distances);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+      auto external_ids = translate_bfs(tx, distances, timeout);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
       if (dump2file != nullptr) {
         save_bfs(external_ids, dump2file);
@@ -335,10 +335,15 @@ namespace gfe::library {
 
 
     void SortledtonDriverV2::pagerank(uint64_t num_iterations, double damping_factor, const char *dump2file) {
+      utility::TimeoutService timeout{m_timeout};
+      Timer timer;
+      timer.start();
       run_gc();
 
       auto pr = sortledton::algorithms::PageRank::page_rank_bs(tx, num_iterations, damping_factor);
-      auto external_ids = translate<double>(tx, pr);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+      auto external_ids = translate<double>(tx, pr, timeout);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
       if (dump2file != nullptr) {
         save_result<double>(external_ids, dump2file);
@@ -346,10 +351,15 @@ namespace gfe::library {
     }
 
     void SortledtonDriverV2::wcc(const char *dump2file) {
+      utility::TimeoutService timeout{m_timeout};
+      Timer timer;
+      timer.start();
       run_gc();
 
       auto clusters = sortledton::algorithms::WCC::gapbs_wcc(tx);
-      auto external_ids = translate<uint64_t>(tx, clusters);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+      auto external_ids = translate<uint64_t>(tx, clusters, timeout);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
       if (dump2file != nullptr) {
         save_result<uint64_t>(external_ids, dump2file);
@@ -357,10 +367,15 @@ namespace gfe::library {
     }
 
     void SortledtonDriverV2::cdlp(uint64_t max_iterations, const char *dump2file) {
+      utility::TimeoutService timeout{m_timeout};
+      Timer timer;
+      timer.start();
       run_gc();
 
       auto clusters = sortledton::algorithms::CDLP::teseo_cdlp(tx, max_iterations);
-      auto external_ids = translate<uint64_t>(tx, clusters);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+      auto external_ids = translate<uint64_t>(tx, clusters, timeout);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
       if (dump2file != nullptr) {
         save_result<uint64_t>(external_ids, dump2file);
@@ -368,11 +383,16 @@ namespace gfe::library {
     }
 
     void SortledtonDriverV2::sssp(uint64_t source_vertex_id, const char *dump2file) {
+      utility::TimeoutService timeout{m_timeout};
+      Timer timer;
+      timer.start();
       run_gc();
 
       auto physical_src = tx.physical_id(source_vertex_id);
       auto distances = sortledton::algorithms::SSSP::gabbs_sssp(tx, physical_src, 2.0);
-      auto external_ids = translate<double>(tx, distances);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+      auto external_ids = translate<double>(tx, distances, timeout);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
       if (dump2file != nullptr) {
         save_result<double>(external_ids, dump2file);
@@ -402,6 +422,7 @@ namespace gfe::library {
 
         class Master {
             sortledton::storage::GraphStorageForwarder &ds;
+            utility::TimeoutService &m_timeout; // the budget of time of the kernel
             atomic <uint64_t> *m_num_triangles; // number of triangles counted so far for the given vertex, array of num_vertices
             std::atomic <uint64_t> m_next; // counter to select the next task among the workers
 
@@ -413,7 +434,7 @@ namespace gfe::library {
 
         public:
             // Constructor
-            Master(sortledton::storage::GraphStorageForwarder &ds);
+            Master(sortledton::storage::GraphStorageForwarder &ds, utility::TimeoutService &timeout);
 
             // Destructor
             ~Master();
@@ -454,11 +475,11 @@ namespace gfe::library {
 
         class GFELCC {
         public:
-            static vector<double> execute(sortledton::storage::GraphStorageForwarder &tx);
+            static vector<double> execute(sortledton::storage::GraphStorageForwarder &tx, utility::TimeoutService &timeout);
         };
 
-        vector<double> GFELCC::execute(sortledton::storage::GraphStorageForwarder &tx) {
-          Master algorithm(tx);
+        vector<double> GFELCC::execute(sortledton::storage::GraphStorageForwarder &tx, utility::TimeoutService &timeout) {
+          Master algorithm(tx, timeout);
           return algorithm.execute();
         }
 
@@ -467,8 +488,8 @@ namespace gfe::library {
  *  LCC_Master                                                               *
  *                                                                           *
  *****************************************************************************/
-        Master::Master(sortledton::storage::GraphStorageForwarder &ds) :
-                ds(ds), m_num_triangles(nullptr), m_next(0) {
+        Master::Master(sortledton::storage::GraphStorageForwarder &ds, utility::TimeoutService &timeout) :
+                ds(ds), m_timeout(timeout), m_num_triangles(nullptr), m_next(0) {
         }
 
         Master::~Master() {
@@ -522,6 +543,7 @@ namespace gfe::library {
 
         bool Master::next_task(uint64_t *output_vtx_start /* inclusive */,
                                uint64_t *output_vtx_end /* exclusive */) {
+          if (m_timeout.is_timeout()) return false; // exhausted the budget of available time
           uint64_t logical_start = m_next.fetch_add(LCC_TASK_SIZE); /* return the previous value of m_next */
           uint64_t num_vertices = ds.vertex_count();
           if (logical_start >= num_vertices) {
@@ -603,10 +625,15 @@ namespace gfe::library {
     }
 
     void SortledtonDriverV2::lcc(const char *dump2file) {
+      utility::TimeoutService timeout{m_timeout};
+      Timer timer;
+      timer.start();
       run_gc();
 
-      auto lcc_values = GFELCC::execute(tx);
-      auto external_ids = translate<double>(tx, lcc_values);
+      auto lcc_values = GFELCC::execute(tx, timeout);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+      auto external_ids = translate<double>(tx, lcc_values, timeout);
+      if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
       if (dump2file != nullptr) {
         save_result<double>(external_ids, dump2file);
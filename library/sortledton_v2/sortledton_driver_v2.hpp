@@ -8,6 +8,8 @@
 #include "third-party/libcuckoo/cuckoohash_map.hh"
 
 #include "library/interface.hpp"
+#include "utility/result_writer.hpp"
+#include "utility/timeout_service.hpp"
 
 #include "sortledton.hpp"
 
@@ -34,13 +36,14 @@ using namespace std;
         bool gced = false;
 
         template <typename T>
-        vector<pair<uint64_t, T>> translate(sortledton::storage::GraphStorageForwarder& tx, vector<T>& values) {
+        vector<pair<uint64_t, T>> translate(sortledton::storage::GraphStorageForwarder& tx, vector<T>& values, utility::TimeoutService& timeout) {
           int N = values.size();
 
           vector<pair<sortledton::vertex_id_t , T>> logical_result(N);
 
 #pragma omp parallel for
           for (uint v = 0; v <  N; v++) {
+            if (timeout.is_timeout()) continue; // exhausted the budget of available time
             if (tx.has_vertex_p(v)) {
               logical_result[v] = make_pair(tx.logical_id(v), values[v]);
             } else {
@@ -55,15 +58,7 @@ using namespace std;
           assert(dump2file != nullptr);
           COUT_DEBUG("save the results to: " << dump2file)
 
-          fstream handle(dump2file, ios_base::out);
-          if (!handle.good()) ERROR("Cannot save the result to `" << dump2file << "'");
-
-          for (const auto &p : result) {
-            handle << p.first << " ";
-            handle << p.second;
-            handle << "\n";
-          }
-          handle.close();
+          utility::save_results(result, dump2file, /* negative scores */ true, /* skip invalid vertices */ false);
         }
 
         void run_gc();
@@ -25,8 +25,11 @@
 #include <unordered_set>
 
 #include "common/timer.hpp"
+#include "library/analytics_session.hpp"
+#include "library/baseline/csr.hpp"
 #include "third-party/gapbs/gapbs.hpp"
 #include "third-party/libcuckoo/cuckoohash_map.hh"
+#include "utility/result_writer.hpp"
 #include "utility/timeout_service.hpp"
 #include "teseo_openmp.hpp"
 #include "teseo/context/global_context.hpp"
@@ -117,6 +120,19 @@ namespace gfe::library {
         }
     }
 
+    bool TeseoDriver::scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const {
+        auto tx = TESEO->start_transaction();
+        auto iterator = tx.iterator();
+        try {
+            iterator.edges(vertex, /* logical ? */ false, [&visitor](uint64_t destination, double weight){
+                return visitor(destination, weight);
+            });
+            return true;
+        } catch (LogicalError &e) { // the vertex does not exist
+            return false;
+        }
+    }
+
     bool TeseoDriver::is_directed() const {
         return m_is_directed;
     }
@@ -304,13 +320,14 @@ Libin: may need to search exist, if so, remove and insert, otherwise direct inse
  *  Helpers                                                                  *
  *                                                                           *
  *****************************************************************************/
-// Translate the logical into real vertices IDs. Materialization step at the end of a Graphalytics algorithm
+// Translate the logical into real vertices IDs. Materialization step at the end of a Graphalytics algorithm. It stops early if the timer expires.
     template<typename T>
-    static vector <pair<uint64_t, T>> translate(OpenMP &openmp, T *values, uint64_t N) {
+    static vector <pair<uint64_t, T>> translate(OpenMP &openmp, T *values, uint64_t N, utility::TimeoutService &timer) {
         vector<pair<uint64_t, T>> external_ids(N);
 
 #pragma omp parallel for firstprivate(openmp)
         for (uint64_t v = 0; v < N; v++) {
+            if (timer.is_timeout()) continue; // exhausted the budget of available time
             external_ids[v] = make_pair(openmp.transaction().vertex_id(v), values[v]);
         }
 
@@ -320,24 +337,8 @@ Libin: may need to search exist, if so, remove and insert, otherwise direct inse
     template<typename T, bool negative_scores = true>
     void TeseoDriver::save_results(std::vector<std::pair<uint64_t, T>> &result, const char *dump2file) {
         if (dump2file == nullptr) return; // nop
-
         COUT_DEBUG("save the results to: " << dump2file);
-
-        fstream handle(dump2file, ios_base::out);
-        if (!handle.good()) ERROR("Cannot save the result to `" << dump2file << "'");
-
-        for (const auto &p: result) {
-            handle << p.first << " ";
-
-            if (!negative_scores && p.second < 0) {
-                handle << numeric_limits<T>::max();
-            } else {
-                handle << p.second;
-            }
-
-            handle << "\n";
-        }
-        handle.close();
+        utility::save_results(result, dump2file, negative_scores);
     }
 
 /*****************************************************************************
@@ -449,13 +450,14 @@ them in parent array as negative numbers. Thus the encoding of parent is:
             queue.slide_window();
         }
 
+        // If given, `degrees' are the out degrees already materialised in an analytics session
         static
-        pvector <int64_t> InitDistances(OpenMP &openmp) {
+        pvector <int64_t> InitDistances(OpenMP &openmp, const uint64_t *degrees) {
             const int64_t N = openmp.transaction().num_vertices();
             pvector <int64_t> distances(N);
 #pragma omp parallel for firstprivate(openmp)
             for (int64_t n = 0; n < N; n++) {
-                int64_t out_degree = openmp.transaction().degree(n, /* logical ? */ true);
+                int64_t out_degree = degrees != nullptr ? degrees[n] : openmp.transaction().degree(n, /* logical ? */ true);
                 distances[n] = out_degree != 0 ? -out_degree : -1;
             }
             return distances;
@@ -465,11 +467,11 @@ them in parent array as negative numbers. Thus the encoding of parent is:
 
     static
     pvector <int64_t>
-    teseo_bfs(OpenMP &openmp, int64_t source, utility::TimeoutService &timer, int alpha = 15, int beta = 18) {
+    teseo_bfs(OpenMP &openmp, int64_t source, utility::TimeoutService &timer, const uint64_t *degrees = nullptr, int alpha = 15, int beta = 18) {
         // The implementation from GAP BS reports the parent (which indeed it should make more sense), while the one required by
         // Graphalytics only returns the distance
 
-        pvector <int64_t> distances = InitDistances(openmp);
+        pvector <int64_t> distances = InitDistances(openmp, degrees);
         distances[source] = 0;
 
         SlidingQueue <int64_t> queue(openmp.transaction().num_vertices());
@@ -480,7 +482,7 @@ them in parent array as negative numbers. Thus the encoding of parent is:
         Bitmap front(openmp.transaction().num_vertices());
         front.reset();
         int64_t edges_to_check = openmp.transaction().num_edges();
-        int64_t scout_count = openmp.transaction().degree(source, true);
+        int64_t scout_count = degrees != nullptr ? degrees[source] : openmp.transaction().degree(source, true);
         int64_t distance = 1; // current distance
         while (!timer.is_timeout() && !queue.empty()) {
 
@@ -525,8 +527,10 @@ them in parent array as negative numbers. Thus the encoding of parent is:
         vector<pair<uint64_t, int64_t>> external_ids(N);
 #pragma omp parallel for firstprivate(openmp)
         for (int64_t v = 0; v < N; v++) {
+            if (tcheck.is_timeout()) continue; // exhausted the budget of available time
             external_ids[v] = make_pair(openmp.transaction().vertex_id(v), result[v]);
         }
+        if (tcheck.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
         // store the results in the given file
         if (dump2file != nullptr)
@@ -587,9 +591,10 @@ it is not necesarily the fastest way to implement it. It does perform the
 updates in the pull direction to remove the need for atomics.
 */
 
+    // If given, `degrees' are the out degrees already materialised in an analytics session
     static
     unique_ptr<double[]>
-    teseo_pagerank(OpenMP &openmp, uint64_t num_iterations, double damping_factor, utility::TimeoutService &timer) {
+    teseo_pagerank(OpenMP &openmp, uint64_t num_iterations, double damping_factor, utility::TimeoutService &timer, const uint64_t *degrees = nullptr) {
         // init
         const uint64_t num_vertices = openmp.transaction().num_vertices();
         COUT_DEBUG("num vertices: " << num_vertices);
@@ -613,7 +618,7 @@ updates in the pull direction to remove the need for atomics.
             // add its rank to the `dangling sum' (to be added to all nodes).
 #pragma omp parallel for reduction(+:dangling_sum) firstprivate(openmp)
             for (uint64_t v = 0; v < num_vertices; v++) {
-                uint64_t out_degree = openmp.transaction().degree(v, /* logical */ true);
+                uint64_t out_degree = degrees != nullptr ? degrees[v] : openmp.transaction().degree(v, /* logical */ true);
                 if (out_degree == 0) { // this is a sink
                     dangling_sum += scores[v];
                 } else {
@@ -655,7 +660,7 @@ updates in the pull direction to remove the need for atomics.
 
         // translate the vertex IDs
         const uint64_t N = openmp.transaction().num_vertices();
-        auto external_ids = translate(openmp, ptr_rank.get(), N);
+        auto external_ids = translate(openmp, ptr_rank.get(), N, timeout);
         if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
         // store the results in the given file
@@ -792,7 +797,7 @@ more consistent performance for undirected graphs.
 
         // translate the vertex IDs
         const uint64_t N = openmp.transaction().num_vertices();
-        auto external_ids = translate<uint64_t>(openmp, ptr_components.get(), N);
+        auto external_ids = translate<uint64_t>(openmp, ptr_components.get(), N, timeout);
         if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
         // store the results in the given file
@@ -873,7 +878,7 @@ more consistent performance for undirected graphs.
 
         // translate the vertex IDs
         const uint64_t N = openmp.transaction().num_vertices();
-        auto external_ids = translate<uint64_t>(openmp, labels.get(), N);
+        auto external_ids = translate<uint64_t>(openmp, labels.get(), N, timeout);
         if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
         // store the results in the given file
@@ -955,7 +960,7 @@ more consistent performance for undirected graphs.
 
         // translate the vertex IDs
         const uint64_t N = openmp.transaction().num_vertices();
-        auto external_ids = translate<double>(openmp, scores.get(), N);
+        auto external_ids = translate<double>(openmp, scores.get(), N, timeout);
         if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
         // store the results in the given file
@@ -1013,6 +1018,7 @@ more consistent performance for undirected graphs.
         // two element arrays for double buffering curr=iter&1, next=(iter+1)&1
         size_t shared_indexes[2] = {0, kMaxBin};
         size_t frontier_tails[2] = {1, 0};
+        bool timed_out = false; // set by a single thread, read by all threads after the barrier at the end of each iteration
         frontier[0] = source;
 
 #pragma omp parallel firstprivate(openmp)
@@ -1020,7 +1026,7 @@ more consistent performance for undirected graphs.
             vector<vector<NodeID> > local_bins(0);
             size_t iter = 0;
 
-            while (shared_indexes[iter & 1] != kMaxBin) {
+            while (shared_indexes[iter & 1] != kMaxBin && !timed_out) {
                 size_t &curr_bin_index = shared_indexes[iter & 1];
                 size_t &next_bin_index = shared_indexes[(iter + 1) & 1];
                 size_t &curr_frontier_tail = frontier_tails[iter & 1];
@@ -1028,6 +1034,7 @@ more consistent performance for undirected graphs.
 
 #pragma omp for nowait schedule(dynamic, 64)
                 for (size_t i = 0; i < curr_frontier_tail; i++) {
+                    if (timer.is_timeout()) continue; // exhausted the budget of available time
                     NodeID u = frontier[i];
                     if (dist[u] >= delta * static_cast<WeightT>(curr_bin_index)) {
                         openmp.iterator().edges(u, /* logical ? */ true,
@@ -1072,6 +1079,7 @@ more consistent performance for undirected graphs.
                 {
                     curr_bin_index = kMaxBin;
                     curr_frontier_tail = 0;
+                    timed_out = timer.is_timeout();
                 }
 
                 if (next_bin_index < local_bins.size()) {
@@ -1112,6 +1120,7 @@ more consistent performance for undirected graphs.
         vector<pair<uint64_t, double>> external_ids(N);
 #pragma omp parallel for firstprivate(openmp)
         for (uint64_t v = 0; v < N; v++) {
+            if (timeout.is_timeout()) continue; // exhausted the budget of available time
             external_ids[v] = make_pair(openmp.transaction().vertex_id(v), distances[v]);
         }
         if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
@@ -1121,6 +1130,130 @@ more consistent performance for undirected graphs.
             save_results(external_ids, dump2file);
     }
 
+/*****************************************************************************
+ *                                                                           *
+ *  Analytics session                                                        *
+ *                                                                           *
+ *****************************************************************************/
+    /**
+     * Run the kernels on the same transaction, with the external IDs and the degrees of the vertices materialised once
+     */
+    class TeseoAnalyticsSession : public AnalyticsSession {
+        TeseoDriver *m_driver; // the instance that created this session
+        OpenMP m_openmp; // the transaction shared by the kernels
+        AnalyticsSnapshot m_snapshot; // external IDs and degrees of the logical vertices in the snapshot
+
+    public:
+        TeseoAnalyticsSession(TeseoDriver *driver);
+        bool materialize_csr() override;
+        void bfs(uint64_t source_vertex_id, const char *dump2file) override;
+        void pagerank(uint64_t num_iterations, double damping_factor, const char *dump2file) override;
+        void wcc(const char *dump2file) override;
+        void sssp(uint64_t source_vertex_id, const char *dump2file) override;
+    };
+
+    TeseoAnalyticsSession::TeseoAnalyticsSession(TeseoDriver *driver) : m_driver(driver), m_openmp(driver),
+            m_snapshot(m_openmp.transaction().num_vertices()) {
+        OpenMP &openmp = m_openmp;
+        const uint64_t N = m_snapshot.max_vertex_id();
+
+#pragma omp parallel for firstprivate(openmp)
+        for (uint64_t v = 0; v < N; v++) {
+            m_snapshot.set_vertex(v, openmp.transaction().vertex_id(v), openmp.transaction().degree(v, /* logical ? */ true));
+        }
+
+        m_snapshot.seal(m_driver->is_directed());
+    }
+
+    bool TeseoAnalyticsSession::materialize_csr() {
+        if (m_csr) return true; // already materialised
+
+        auto csr = make_unique<CSR>(m_driver->is_directed());
+        csr->set_timeout(m_driver->m_timeout.count());
+        csr->materialize_begin(m_snapshot);
+
+        OpenMP &openmp = m_openmp;
+        CSR *ptr_csr = csr.get();
+        const uint64_t N = m_snapshot.max_vertex_id();
+#pragma omp parallel for schedule(dynamic, 4096) firstprivate(openmp)
+        for (uint64_t v = 0; v < N; v++) {
+            uint64_t position = 0;
+            openmp.iterator().edges(v, /* logical ? */ true, [ptr_csr, v, &position](uint64_t destination, double weight) {
+                ptr_csr->materialize_edge(v, position++, destination, weight);
+                return true;
+            });
+        }
+
+        csr->materialize_end();
+        m_csr = move(csr);
+        return true;
+    }
+
+    void TeseoAnalyticsSession::bfs(uint64_t source_vertex_id, const char *dump2file) {
+        if (m_csr) { return m_csr->bfs(source_vertex_id, dump2file); }
+        utility::TimeoutService tcheck{m_driver->m_timeout};
+        common::Timer timer;
+        timer.start();
+
+        auto result = teseo_bfs(m_openmp, m_openmp.transaction().logical_id(source_vertex_id), tcheck, m_snapshot.degrees());
+        if (tcheck.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+
+        auto external_ids = m_snapshot.translate(result.data()); // the timed kernels always translate the results, as the kernels of the driver
+        if (dump2file != nullptr) {
+            m_driver->save_results<int64_t, false>(external_ids, dump2file);
+        }
+    }
+
+    void TeseoAnalyticsSession::pagerank(uint64_t num_iterations, double damping_factor, const char *dump2file) {
+        if (m_csr) { return m_csr->pagerank(num_iterations, damping_factor, dump2file); }
+        utility::TimeoutService timeout{m_driver->m_timeout};
+        Timer timer;
+        timer.start();
+
+        unique_ptr<double[]> ptr_rank = teseo_pagerank(m_openmp, num_iterations, damping_factor, timeout, m_snapshot.degrees());
+        if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+
+        auto external_ids = m_snapshot.translate(ptr_rank.get());
+        if (dump2file != nullptr) {
+            m_driver->save_results(external_ids, dump2file);
+        }
+    }
+
+    void TeseoAnalyticsSession::wcc(const char *dump2file) {
+        if (m_csr) { return m_csr->wcc(dump2file); }
+        utility::TimeoutService timeout{m_driver->m_timeout};
+        Timer timer;
+        timer.start();
+
+        unique_ptr<uint64_t[]> ptr_components = teseo_wcc(m_openmp, timeout);
+        if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+
+        auto external_ids = m_snapshot.translate(ptr_components.get());
+        if (dump2file != nullptr) {
+            m_driver->save_results(external_ids, dump2file);
+        }
+    }
+
+    void TeseoAnalyticsSession::sssp(uint64_t source_vertex_id, const char *dump2file) {
+        if (m_csr) { return m_csr->sssp(source_vertex_id, dump2file); }
+        utility::TimeoutService timeout{m_driver->m_timeout};
+        Timer timer;
+        timer.start();
+
+        double delta = 2.0; // same value used in the GAPBS, at least for most graphs
+        auto distances = teseo_sssp(m_openmp, m_openmp.transaction().logical_id(source_vertex_id), delta, timeout);
+        if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
+
+        auto external_ids = m_snapshot.translate(distances.data());
+        if (dump2file != nullptr) {
+            m_driver->save_results(external_ids, dump2file);
+        }
+    }
+
+    unique_ptr<AnalyticsSession> TeseoDriver::begin_analytics_session() {
+        return make_unique<TeseoAnalyticsSession>(this);
+    }
+
 /*****************************************************************************
  *                                                                           *
  *  LCC, sort-merge implementation                                           *
@@ -1431,9 +1564,10 @@ more consistent performance for undirected graphs.
         // translate the vertex IDs
         uint64_t N = transaction.num_vertices();
         vector<pair<uint64_t, double>> external_ids(N);
-        for (uint64_t v = 0; v < N; v++) {
+        for (uint64_t v = 0; v < N && !timeout.is_timeout(); v++) {
             external_ids[v] = make_pair(transaction.vertex_id(v), scores[v]);
         }
+        if (timeout.is_timeout()) { RAISE_EXCEPTION(TimeoutError, "Timeout occurred after " << timer); }
 
         // store the results in the given file
         if (dump2file != nullptr)
@@ -30,6 +30,7 @@ namespace gfe::library {
 class TeseoDriver : public virtual UpdateInterface, public virtual GraphalyticsInterface {
     TeseoDriver(const TeseoDriver&) = delete;
     TeseoDriver& operator=(const TeseoDriver&) = delete;
+    friend class TeseoAnalyticsSession;
 
 protected:
     void* m_pImpl; // pointer to the teseo library
@@ -79,6 +80,11 @@ public:
      */
     virtual double get_weight(uint64_t source, uint64_t destination) const;
 
+    /**
+     * Visit the outgoing edges of the given vertex
+     */
+    virtual bool scan_neighbors(uint64_t vertex, NeighbourVisitor visitor) const;
+
     /**
      * Check whether the graph is directed
      */
@@ -192,6 +198,11 @@ public:
      */
     virtual void sssp(uint64_t source_vertex_id, const char* dump2file = nullptr);
 
+    /**
+     * Open a transaction shared by the kernels of the session, materialising the external IDs and the degrees of the vertices once
+     */
+    virtual std::unique_ptr<AnalyticsSession> begin_analytics_session();
+
     /**
      * Retrieve the handle to the Teseo implementation
      */
@@ -0,0 +1,401 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vertex_dictionary.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#include "common/error.hpp"
+
+using namespace std;
+
+namespace gfe::library {
+
+/*****************************************************************************
+ *                                                                           *
+ *  Table                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+VertexDictionary::Table::Table(uint64_t capacity) : m_capacity(capacity), m_shift(64 - __builtin_ctzll(capacity)), m_slots(new Slot[capacity]) {
+    assert(capacity >= 2 && (capacity & (capacity -1)) == 0 && "The capacity must be a power of 2");
+    for(uint64_t i = 0; i < capacity; i++){
+        m_slots[i].m_key.store(EMPTY, memory_order_relaxed);
+        m_slots[i].m_value.store(PENDING, memory_order_relaxed);
+    }
+}
+
+VertexDictionary::Table::~Table(){
+    delete[] m_slots; m_slots = nullptr;
+}
+
+VertexDictionary::Slot* VertexDictionary::lookup(Table* table, uint64_t external_id){
+    const uint64_t mask = table->m_capacity -1;
+    uint64_t position = (external_id * 0x9E3779B97F4A7C15ull) >> table->m_shift; // fibonacci hashing
+    while(true){
+        Slot* slot = table->m_slots + position;
+        uint64_t key = slot->m_key.load(memory_order_acquire);
+        if(key == external_id){
+            return slot;
+        } else if(key == EMPTY){
+            return nullptr;
+        }
+        position = (position +1) & mask;
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Init                                                                     *
+ *                                                                           *
+ *****************************************************************************/
+VertexDictionary::VertexDictionary(uint64_t capacity) {
+    capacity = max<uint64_t>(capacity, 2);
+    capacity = 1ull << (64 - __builtin_clzll(capacity -1)); // next power of 2
+    m_table = new Table(capacity);
+    m_int2ext.reset(new atomic<Int2Ext*>[INT2EXT_NUM_SEGMENTS]);
+    for(uint64_t i = 0; i < INT2EXT_NUM_SEGMENTS; i++){ m_int2ext[i].store(nullptr, memory_order_relaxed); }
+}
+
+VertexDictionary::~VertexDictionary(){
+    delete m_table.load(); m_table = nullptr;
+    for(uint64_t i = 0; i < INT2EXT_NUM_SEGMENTS; i++){ delete[] m_int2ext[i].load(); }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Epochs                                                                   *
+ *                                                                           *
+ *****************************************************************************/
+VertexDictionary::Shard& VertexDictionary::shard() const {
+    static atomic<uint64_t> next_thread_id { 0 };
+    static thread_local uint64_t thread_id = next_thread_id++;
+    return m_shards[thread_id % NUM_SHARDS];
+}
+
+class VertexDictionary::SampledTimer {
+    const VertexDictionary* m_dictionary;
+    bool m_sampled;
+    chrono::steady_clock::time_point m_start;
+
+    static bool next_sample(){
+        static thread_local uint64_t num_operations = 0;
+        return (num_operations++ % TIME_SAMPLING) == 0;
+    }
+
+public:
+    SampledTimer(const VertexDictionary* dictionary, bool enabled = true) : m_dictionary(dictionary), m_sampled(enabled && next_sample()) {
+        if(m_sampled){ m_start = chrono::steady_clock::now(); }
+    }
+
+    ~SampledTimer(){
+        stop();
+    }
+
+    // Record the time elapsed so far, the rest of the operation is not timed
+    void stop(){
+        if(m_sampled){
+            auto time = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - m_start);
+            m_dictionary->shard().m_time.fetch_add(time.count() * TIME_SAMPLING, memory_order_relaxed);
+            m_sampled = false;
+        }
+    }
+};
+
+uint64_t VertexDictionary::enter() const {
+    Shard& shard = this->shard();
+    while(true){
+        uint64_t epoch = m_epoch.load();
+        shard.m_num_active[epoch % 2].fetch_add(1);
+        if(m_epoch.load() == epoch) return epoch;
+        shard.m_num_active[epoch % 2].fetch_sub(1); // a resize started in the meanwhile, join the new epoch
+    }
+}
+
+void VertexDictionary::leave(uint64_t epoch) const {
+    shard().m_num_active[epoch % 2].fetch_sub(1, memory_order_release);
+}
+
+void VertexDictionary::synchronize(){
+    // the new operations enter the next epoch, those in the current epoch only need to terminate
+    uint64_t epoch = m_epoch.load();
+    m_epoch.store(epoch +1);
+    for(auto& shard : m_shards){
+        while(shard.m_num_active[epoch % 2].load() > 0){ this_thread::yield(); }
+    }
+}
+
+void VertexDictionary::grow(Table* table, uint64_t min_capacity){
+    scoped_lock<mutex> lock(m_mutex_resize);
+    if(m_table.load() != table) return; // already replaced by another thread
+
+    // prevent the writers from altering the table while it is copied
+    table->m_frozen = true;
+    synchronize();
+
+    // the slots of the vertices removed are not copied, if they are the majority the capacity does not change
+    uint64_t num_live_keys = 0;
+    for(uint64_t i = 0; i < table->m_capacity; i++){
+        const Slot& slot = table->m_slots[i];
+        num_live_keys += slot.m_key.load(memory_order_relaxed) != EMPTY && slot.m_value.load(memory_order_relaxed) != REMOVED;
+    }
+    uint64_t capacity = table->m_capacity;
+    while(capacity < num_live_keys * 4 || capacity < min_capacity){ capacity *= 2; }
+
+    Table* new_table = new Table(capacity);
+    const uint64_t mask = capacity -1;
+    for(uint64_t i = 0; i < table->m_capacity; i++){
+        const Slot& slot = table->m_slots[i];
+        const uint64_t key = slot.m_key.load(memory_order_relaxed);
+        const uint64_t value = slot.m_value.load(memory_order_relaxed); // including the vertices still pending
+        if(key == EMPTY || value == REMOVED) continue;
+        uint64_t position = (key * 0x9E3779B97F4A7C15ull) >> new_table->m_shift;
+        while(new_table->m_slots[position].m_key.load(memory_order_relaxed) != EMPTY){ position = (position +1) & mask; }
+        new_table->m_slots[position].m_key.store(key, memory_order_relaxed);
+        new_table->m_slots[position].m_value.store(value, memory_order_relaxed);
+    }
+    new_table->m_num_keys.store(num_live_keys, memory_order_relaxed);
+    m_table = new_table;
+
+    // wait for the readers still accessing the old table
+    synchronize();
+    delete table;
+    m_num_resizes++;
+}
+
+void VertexDictionary::wait_resize() const {
+    scoped_lock<mutex> lock(m_mutex_resize); // a table is frozen only while its resize holds the mutex
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Operations                                                               *
+ *                                                                           *
+ *****************************************************************************/
+uint64_t VertexDictionary::find(uint64_t external_id) const {
+    SampledTimer timer { this };
+    uint64_t epoch = enter();
+    Slot* slot = lookup(m_table.load(), external_id);
+    uint64_t value = (slot != nullptr) ? slot->m_value.load(memory_order_acquire) : NOT_FOUND;
+    leave(epoch);
+    return value >= REMOVED ? NOT_FOUND : value; // PENDING or REMOVED
+}
+
+pair<uint64_t, bool> VertexDictionary::find_or_insert(uint64_t external_id){
+    return find_or_insert(external_id, /* sampled */ true);
+}
+
+pair<uint64_t, bool> VertexDictionary::find_or_insert(uint64_t external_id, bool sampled){
+    assert(external_id != EMPTY && "This vertex ID is reserved");
+    SampledTimer timer { this, sampled };
+    bool waited = false;
+
+    while(true){
+        uint64_t epoch = enter();
+        Table* table = m_table.load();
+        Slot* slot = lookup(table, external_id);
+
+        if(slot != nullptr){
+            uint64_t value = slot->m_value.load(memory_order_acquire);
+            if(value < REMOVED){ // the vertex exists
+                leave(epoch);
+                return make_pair(value, false);
+            } else if(value == PENDING){ // another thread is creating the vertex, do not hold the epoch while waiting
+                leave(epoch);
+                timer.stop(); // the time spent waiting for the library to create the vertex is not spent in the dictionary
+                if(!waited){ shard().m_num_waits.fetch_add(1, memory_order_relaxed); waited = true; }
+                this_thread::yield();
+            } else if(table->m_frozen.load()){
+                leave(epoch);
+                wait_resize();
+            } else if(slot->m_value.compare_exchange_strong(value, PENDING)){ // take over the slot of a vertex removed
+                leave(epoch);
+                shard().m_num_inserts.fetch_add(1, memory_order_relaxed);
+                return make_pair(NOT_FOUND, true);
+            } else {
+                leave(epoch);
+            }
+            continue;
+        }
+
+        if(table->m_frozen.load()){
+            leave(epoch);
+            wait_resize();
+            continue;
+        }
+
+        // reserve a slot before claiming it, so that the concurrent inserters cannot fill the table beyond the load factor of 1/2
+        if((table->m_num_keys.fetch_add(1, memory_order_relaxed) +1) * 2 > table->m_capacity){
+            table->m_num_keys.fetch_sub(1, memory_order_relaxed);
+            leave(epoch);
+            grow(table);
+            continue;
+        }
+
+        // claim an empty slot
+        const uint64_t mask = table->m_capacity -1;
+        uint64_t position = (external_id * 0x9E3779B97F4A7C15ull) >> table->m_shift;
+        bool inserted = false;
+        while(true){
+            Slot& candidate = table->m_slots[position];
+            uint64_t key = candidate.m_key.load(memory_order_acquire);
+            if(key == EMPTY && candidate.m_key.compare_exchange_strong(key, external_id)){
+                inserted = true;
+                break;
+            } else if(key == external_id){ // inserted by another thread in the meanwhile
+                table->m_num_keys.fetch_sub(1, memory_order_relaxed); // release the reservation
+                break;
+            } else if(key != EMPTY){
+                position = (position +1) & mask;
+            } // else, the CAS failed and `key' has been reloaded, check it again
+        }
+        leave(epoch);
+
+        if(inserted){
+            shard().m_num_inserts.fetch_add(1, memory_order_relaxed);
+            return make_pair(NOT_FOUND, true);
+        }
+    }
+}
+
+void VertexDictionary::publish(uint64_t external_id, uint64_t internal_id){
+    publish(external_id, internal_id, m_version.fetch_add(1));
+}
+
+void VertexDictionary::publish(uint64_t external_id, uint64_t internal_id, uint64_t version){
+    assert(internal_id < REMOVED && "Invalid internal vertex ID");
+    while(true){
+        uint64_t epoch = enter();
+        Table* table = m_table.load();
+        if(table->m_frozen.load()){
+            leave(epoch);
+            wait_resize();
+            continue;
+        }
+
+        Slot* slot = lookup(table, external_id);
+        assert(slot != nullptr && slot->m_value.load() == PENDING && "The vertex has not been registered with #find_or_insert");
+        Int2Ext* entry = int2ext_entry(internal_id); // before the vertex becomes visible in the dictionary
+        entry->m_version.store(version, memory_order_relaxed);
+        entry->m_external_id.store(external_id, memory_order_release);
+        slot->m_value.store(internal_id, memory_order_release);
+        leave(epoch);
+        return;
+    }
+}
+
+uint64_t VertexDictionary::remove(uint64_t external_id){
+    SampledTimer timer { this };
+    while(true){
+        uint64_t epoch = enter();
+        Table* table = m_table.load();
+        if(table->m_frozen.load()){
+            leave(epoch);
+            wait_resize();
+            continue;
+        }
+
+        Slot* slot = lookup(table, external_id);
+        uint64_t value = (slot != nullptr) ? slot->m_value.load(memory_order_acquire) : REMOVED;
+        if(value == REMOVED){ // the vertex does not exist
+            leave(epoch);
+            return NOT_FOUND;
+        } else if(value == PENDING){ // wait for the vertex to be created
+            leave(epoch);
+            timer.stop();
+            this_thread::yield();
+        } else if(slot->m_value.compare_exchange_strong(value, REMOVED)){
+            leave(epoch);
+            int2ext_entry(value)->m_external_id.store(NOT_FOUND, memory_order_release); // tombstone
+            return value;
+        } else {
+            leave(epoch);
+        }
+    }
+}
+
+void VertexDictionary::preload(const uint64_t* external_ids, const uint64_t* internal_ids, uint64_t num_vertices){
+    Table* table = m_table.load();
+    uint64_t min_capacity = (table->m_num_keys.load() + num_vertices) * 2 + 2;
+    if(min_capacity > table->m_capacity){ grow(table, min_capacity); }
+
+    // the caller times the whole preload with #add_time, do not sample the single operations as well
+    const uint64_t version = m_version.fetch_add(1); // a single version for the whole batch, rather than contending on the counter
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for(uint64_t i = 0; i < num_vertices; i++){
+        if(find_or_insert(external_ids[i], /* sampled */ false).second){
+            publish(external_ids[i], internal_ids[i], version);
+        }
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Inverse mapping                                                          *
+ *                                                                           *
+ *****************************************************************************/
+VertexDictionary::Int2Ext* VertexDictionary::int2ext_entry(uint64_t internal_id){
+    if(internal_id >= INT2EXT_SEGMENT_SIZE * INT2EXT_NUM_SEGMENTS) ERROR("Internal vertex ID too large: " << internal_id);
+    auto& ptr_segment = m_int2ext[internal_id / INT2EXT_SEGMENT_SIZE];
+    Int2Ext* segment = ptr_segment.load(memory_order_acquire);
+    if(segment == nullptr){ // allocate the segment, unless another thread does it first
+        Int2Ext* new_segment = new Int2Ext[INT2EXT_SEGMENT_SIZE];
+        for(uint64_t i = 0; i < INT2EXT_SEGMENT_SIZE; i++){
+            new_segment[i].m_external_id.store(NOT_FOUND, memory_order_relaxed);
+            new_segment[i].m_version.store(0, memory_order_relaxed);
+        }
+        if(ptr_segment.compare_exchange_strong(segment, new_segment, memory_order_acq_rel)){
+            segment = new_segment;
+        } else { // `segment' has been reloaded with the one installed by the other thread
+            delete[] new_segment;
+        }
+    }
+    return segment + internal_id % INT2EXT_SEGMENT_SIZE;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Statistics                                                               *
+ *                                                                           *
+ *****************************************************************************/
+void VertexDictionary::add_time(chrono::nanoseconds time){
+    shard().m_time.fetch_add(time.count(), memory_order_relaxed);
+}
+
+void VertexDictionary::reset_statistics(){
+    for(auto& shard : m_shards){
+        shard.m_time = 0;
+        shard.m_num_inserts = 0;
+        shard.m_num_waits = 0;
+    }
+    m_num_resizes = 0;
+}
+
+void VertexDictionary::dump_statistics(ostream& out) const {
+    uint64_t time = 0, num_inserts = 0, num_waits = 0;
+    for(auto& shard : m_shards){
+        time += shard.m_time.load(memory_order_relaxed);
+        num_inserts += shard.m_num_inserts.load(memory_order_relaxed);
+        num_waits += shard.m_num_waits.load(memory_order_relaxed);
+    }
+    out << "time: " << time / 1000 << " us (cumulative over all threads, estimated by sampling 1/" << TIME_SAMPLING << " operations), vertices inserted: " << num_inserts << ", "
+            "waits for the vertices being inserted by other threads: " << num_waits << ", resizes: " << m_num_resizes.load() << ", "
+            "capacity: " << m_table.load()->m_capacity;
+}
+
+} // namespace
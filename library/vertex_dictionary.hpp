@@ -0,0 +1,230 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <utility>
+
+namespace gfe::library {
+
+/**
+ * A concurrent dictionary from the external vertex IDs to the internal vertex IDs of a library, shared by the drivers
+ * that need to keep their own mapping (e.g. LiveGraph and GTX).
+ *
+ * The dictionary is an open addressing hash table with linear probing, where each slot is a pair of atomic words:
+ * - the lookups are lock free, they only read the slots;
+ * - a new vertex is registered with a CAS on the key of an empty slot, leaving a placeholder as value. The thread that
+ *   wins the CAS creates the vertex in the library and publishes its internal ID with #publish. Other threads looking
+ *   for the same vertex wait for the placeholder to be resolved, the rest of the table is never locked;
+ * - the table grows by doubling its capacity. Each operation runs inside an epoch: the thread growing the table
+ *   freezes the old table, waits for the writers in the current epoch to leave, copies the slots, and releases the old
+ *   table once the readers still accessing it left as well.
+ *
+ * The dictionary also keeps the inverse mapping, from the internal to the external vertex IDs, in a dense array indexed
+ * by the internal vertex ID, so that the results of the Graphalytics kernels can be translated without asking the
+ * library for each vertex. The array is append only: it is split in segments, allocated on demand and never moved, and
+ * the entries of the vertices removed are reset to NOT_FOUND. It reflects the latest state of the dictionary, not the
+ * snapshot of a transaction: each entry also records the #version of the dictionary when it was published, so that a
+ * driver can tell apart the vertices that surely belong to its snapshot from those it must look up in the library. The
+ * internal vertex IDs must be dense and never reused, as assigned by LiveGraph and GTX.
+ *
+ * The external vertex ID numeric_limits<uint64_t>::max() cannot be stored, it marks the empty slots.
+ */
+class VertexDictionary {
+    VertexDictionary(const VertexDictionary&) = delete;
+    VertexDictionary& operator=(const VertexDictionary&) = delete;
+
+public:
+    constexpr static uint64_t NOT_FOUND = std::numeric_limits<uint64_t>::max(); // returned by the lookups when the vertex does not exist
+
+private:
+    constexpr static uint64_t EMPTY = std::numeric_limits<uint64_t>::max(); // key of the slots never used
+    constexpr static uint64_t PENDING = std::numeric_limits<uint64_t>::max(); // value of a vertex being created
+    constexpr static uint64_t REMOVED = std::numeric_limits<uint64_t>::max() -1; // value of a vertex removed
+    constexpr static int NUM_SHARDS = 64; // number of shards for the epoch & statistics counters
+    constexpr static uint64_t INT2EXT_SEGMENT_SIZE = 1ull << 20; // number of entries in each segment of the inverse mapping
+    constexpr static uint64_t INT2EXT_NUM_SEGMENTS = 1ull << 16; // max number of segments of the inverse mapping
+    constexpr static uint64_t TIME_SAMPLING = 64; // each thread times one operation every TIME_SAMPLING, to keep the clock out of the hot path
+
+    struct Int2Ext {
+        std::atomic<uint64_t> m_external_id; // the external vertex ID, or NOT_FOUND
+        std::atomic<uint64_t> m_version; // the version of the dictionary when the vertex was published
+    };
+
+    struct Slot {
+        std::atomic<uint64_t> m_key; // the external vertex ID, or EMPTY
+        std::atomic<uint64_t> m_value; // the internal vertex ID, or PENDING/REMOVED
+    };
+
+    struct Table {
+        const uint64_t m_capacity; // number of slots, a power of 2
+        const int m_shift; // right shift to compute the position of a key from its hash
+        std::atomic<bool> m_frozen { false }; // set when the table is being copied into a new table, it cannot be altered anymore
+        std::atomic<uint64_t> m_num_keys { 0 }; // number of slots used or reserved by the inserters, including those of the vertices removed
+        Slot* m_slots; // the content of the table
+
+        Table(uint64_t capacity);
+        ~Table();
+    };
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> m_num_active[2] { {0}, {0} }; // number of threads inside an operation, for each epoch
+        std::atomic<uint64_t> m_time { 0 }; // nanosecs spent in the dictionary, estimated from the operations sampled, plus those reported with #add_time
+        std::atomic<uint64_t> m_num_inserts { 0 }; // number of vertices registered
+        std::atomic<uint64_t> m_num_waits { 0 }; // number of lookups that waited for a vertex being created by another thread
+    };
+
+    std::atomic<Table*> m_table; // the current table
+    std::atomic<uint64_t> m_epoch { 0 }; // the parity selects the counters of the active threads
+    mutable Shard m_shards[NUM_SHARDS];
+    mutable std::mutex m_mutex_resize; // only one thread at the time can grow the table, held for the whole resize
+    std::atomic<uint64_t> m_num_resizes { 0 }; // number of times the table has grown
+    std::atomic<uint64_t> m_version { 0 }; // incremented each time a vertex is published
+    std::unique_ptr<std::atomic<Int2Ext*>[]> m_int2ext; // the segments of the inverse mapping, internal -> external vertex IDs
+
+    // Retrieve the shard of the current thread
+    Shard& shard() const;
+
+    // Time an operation of the dictionary, if sampled
+    class SampledTimer;
+
+    // Implementation of #find_or_insert, `sampled' is false to never time the operation
+    std::pair<uint64_t, bool> find_or_insert(uint64_t external_id, bool sampled);
+
+    // Enter an operation, return the epoch to pass to #leave
+    uint64_t enter() const;
+
+    // Leave an operation
+    void leave(uint64_t epoch) const;
+
+    // Wait for all threads that entered an operation in the current epoch to leave
+    void synchronize();
+
+    // Double the capacity of the given table, unless it has already been replaced
+    void grow(Table* table, uint64_t min_capacity = 0);
+
+    // Wait for the resize in progress to complete, after observing a frozen table outside of an epoch. It does not check
+    // the table pointer, as the old table may have been released and its address reused by a new table
+    void wait_resize() const;
+
+    // Retrieve the slot of the given key in the table, or nullptr if it is not present
+    static Slot* lookup(Table* table, uint64_t external_id);
+
+    // Implementation of #publish, with the version to record in the inverse mapping
+    void publish(uint64_t external_id, uint64_t internal_id, uint64_t version);
+
+    // Retrieve the entry of the given internal vertex ID in the inverse mapping, allocating its segment if needed
+    Int2Ext* int2ext_entry(uint64_t internal_id);
+
+public:
+    /**
+     * Create a new dictionary
+     * @param capacity the initial number of slots, rounded up to a power of 2
+     */
+    VertexDictionary(uint64_t capacity = 1024);
+
+    /**
+     * Destructor
+     */
+    ~VertexDictionary();
+
+    /**
+     * Retrieve the internal vertex ID of the given vertex. It is lock free.
+     * @return the internal vertex ID, or NOT_FOUND if the vertex does not exist or it is still being created
+     */
+    uint64_t find(uint64_t external_id) const;
+
+    /**
+     * Retrieve the current version of the dictionary, the number of #publish so far. A driver reads it before opening
+     * the snapshot of a transaction, to later pass it to #int2ext.
+     */
+    uint64_t version() const { return m_version.load(); }
+
+    /**
+     * Retrieve the external vertex ID of the given internal vertex ID. It is lock free and it does not enter an epoch,
+     * to translate the results of the Graphalytics kernels with a parallel gather.
+     * If a version is given, the vertices published at or after that version are reported as NOT_FOUND as well. As the
+     * vertices are published after they have been committed in the library, any other vertex returned was already
+     * part of the snapshots opened after reading the version. Conversely, a vertex reported as NOT_FOUND may still be
+     * part of such a snapshot, if it has been removed or published later: the caller must look it up in the snapshot.
+     * @return the external vertex ID, or NOT_FOUND if the vertex does not exist, it has been removed, it is still being
+     *         created or it has been published at or after the given version
+     */
+    uint64_t int2ext(uint64_t internal_id, uint64_t version = NOT_FOUND) const {
+        if(internal_id >= INT2EXT_SEGMENT_SIZE * INT2EXT_NUM_SEGMENTS) return NOT_FOUND;
+        Int2Ext* segment = m_int2ext[internal_id / INT2EXT_SEGMENT_SIZE].load(std::memory_order_acquire);
+        if(segment == nullptr) return NOT_FOUND;
+        Int2Ext& entry = segment[internal_id % INT2EXT_SEGMENT_SIZE];
+        uint64_t external_id = entry.m_external_id.load(std::memory_order_acquire);
+        return (external_id == NOT_FOUND || entry.m_version.load(std::memory_order_relaxed) >= version) ? NOT_FOUND : external_id;
+    }
+
+    /**
+     * Retrieve the internal vertex ID of the given vertex, or register it if it does not exist. If another thread is
+     * creating the vertex, wait for it to publish its internal ID.
+     * @return a pair <internal vertex ID, false> if the vertex already exists, or <NOT_FOUND, true> if the vertex has
+     *         been registered by this call. In the latter case, the caller must create the vertex in the library and
+     *         invoke #publish with its internal vertex ID.
+     */
+    std::pair<uint64_t, bool> find_or_insert(uint64_t external_id);
+
+    /**
+     * Set the internal vertex ID of a vertex registered by #find_or_insert, and record the vertex in the inverse mapping.
+     * It must be invoked once the vertex has been committed in the library.
+     */
+    void publish(uint64_t external_id, uint64_t internal_id);
+
+    /**
+     * Remove the given vertex. Its entry in the inverse mapping is reset to NOT_FOUND.
+     * @return the internal vertex ID of the vertex removed, or NOT_FOUND if the vertex did not exist
+     */
+    uint64_t remove(uint64_t external_id);
+
+    /**
+     * Register multiple vertices at once, e.g. when the graph is loaded. The table is resized at most once, then the
+     * vertices are inserted in parallel. Vertices already present are skipped. The insertions are not sampled, the
+     * caller is expected to time the whole preload with #add_time. All vertices are published with the same version,
+     * they must have been committed in the library already.
+     */
+    void preload(const uint64_t* external_ids, const uint64_t* internal_ids, uint64_t num_vertices);
+
+    /**
+     * Record the time a driver spent to access the dictionary outside of the single operations, e.g. to preload the
+     * vertices. The time of the single operations is already sampled by the dictionary itself.
+     */
+    void add_time(std::chrono::nanoseconds time);
+
+    /**
+     * Reset the statistics
+     */
+    void reset_statistics();
+
+    /**
+     * Print the statistics: the time spent in the dictionary (an estimate), the number of vertices registered, the number of waits
+     * for the vertices being created by other threads and the number of resizes
+     */
+    void dump_statistics(std::ostream& out) const;
+};
+
+} // namespace
@@ -23,13 +23,16 @@
 #include "experiment/aging2_experiment.hpp"
 #include "experiment/mixed_workload.hpp"
 #include "experiment/mixed_workload_result.hpp"
+#include "experiment/update_short_reads_experiment.hpp"
 #include "experiment/insert_only.hpp"
 #include "experiment/graphalytics.hpp"
 #include "experiment/validate.hpp"
 #include "graph/edge_stream.hpp"
 #include "library/interface.hpp"
+#include "reader/graphlog_reader.hpp"
 #include "third-party/cxxopts/cxxopts.hpp"
 #include "utility/memory_usage.hpp"
+#include "utility/vertex_sampler.hpp"
 
 #include "configuration.hpp"
 #if defined(HAVE_OPENMP)
@@ -79,6 +82,16 @@ static void run_standalone(int argc, char* argv[]){
 
     LOG("[driver] The library is set for a directed graph: " << (configuration().is_graph_directed() ? "yes" : "no"));
 
+    if(impl_ga.get() != nullptr){ // candidates of the 1-hop and 2-hop expansions
+        auto sampler = make_shared<utility::VertexSampler>(utility::vertex_sampler_distribution_from_string(configuration().get_hop_candidates()), configuration().get_hop_candidates_zipf(), configuration().seed());
+        // the degrees are only known to the library, otherwise draw from the final vertices of the log, when available
+        if(!configuration().get_update_log().empty() && sampler->distribution() != utility::VertexSamplerDistribution::DEGREE){
+            sampler->set_population(reader::graphlog::load_vertices_final(configuration().get_update_log()));
+        }
+        LOG("[driver] Candidates of the 1-hop and 2-hop expansions: " << configuration().get_hop_candidates() << ", population: " << (sampler->has_population() ? "final vertices of the log" : "vertex dictionary of the library"));
+        impl_ga->set_vertex_sampler(sampler);
+    }
+
     uint64_t random_vertex = numeric_limits<uint64_t>::max();
     int64_t num_validation_errors = -1; // -1 => no validation performed
     if(configuration().is_load()){
@@ -95,7 +108,7 @@ static void run_standalone(int argc, char* argv[]){
 
         if(configuration().validate_inserts() && impl_load->can_be_validated()){
             auto stream = make_shared<graph::WeightedEdgeStream> ( configuration().get_path_graph() );
-            num_validation_errors = validate_updates(impl_load, stream);
+            num_validation_errors = validate_updates(impl_load, stream, configuration().get_validate_max_errors());
         }
 
         random_vertex = impl_rndvtx->get_random_vertex_id();
@@ -125,7 +138,7 @@ static void run_standalone(int argc, char* argv[]){
             if(configuration().has_database()) experiment.save();
 
           if(configuration().validate_inserts() && impl_upd->can_be_validated()){
-              num_validation_errors = validate_updates(impl_upd, stream);
+              num_validation_errors = validate_updates(impl_upd, stream, configuration().get_validate_max_errors());
           }
         } else {
             if (configuration().is_mixed_workload()) {
@@ -150,6 +163,11 @@ static void run_standalone(int argc, char* argv[]){
               agingExperiment.set_memfp_physical(configuration().get_aging_memfp_physical());
               agingExperiment.set_memfp_threshold(configuration().get_aging_memfp_threshold());
               agingExperiment.set_cooloff(chrono::seconds{configuration().get_aging_cooloff_seconds()});
+              agingExperiment.set_partition(aging2_partition_from_string(configuration().get_aging_partition()));
+              agingExperiment.set_work_stealing(configuration().get_aging_work_stealing());
+              agingExperiment.set_seed(configuration().seed());
+              agingExperiment.set_trace_record(configuration().get_aging_trace_record());
+              agingExperiment.set_trace_replay(configuration().get_aging_trace_replay());
               
               // Configure analytics experiment
               GraphalyticsAlgorithms properties { path_graph };
@@ -160,11 +178,16 @@ static void run_standalone(int argc, char* argv[]){
               }
 
               configuration().blacklist(properties);
-              GraphalyticsSequential exp_seq { impl_ga, configuration().num_repetitions(), properties };
 
-              MixedWorkload experiment(agingExperiment, exp_seq, configuration().num_threads(ThreadsType::THREADS_READ));
+              MixedWorkload experiment(agingExperiment, impl_ga, properties, configuration().num_threads(ThreadsType::THREADS_READ));
+              if(!configuration().get_mixed_windows().empty()) experiment.set_windows(mixed_workload_windows_from_string(configuration().get_mixed_windows()));
+              if(!configuration().get_mixed_streams().empty()) experiment.set_streams(gfe::experiment::details::analytics_streams_from_string(configuration().get_mixed_streams()));
+              if(configuration().get_analytics_incremental()){
+                LOG("[driver] Refreshing PageRank and WCC incrementally after each execution");
+                experiment.set_incremental_analytics(reader::graphlog::load_vertices_final(configuration().get_update_log()));
+              }
               auto result = experiment.execute();
-              experiment.report_graphalytics();
+              result.report();
               cout << "Saving result" << endl;
               if (configuration().has_database()) result.save(configuration().db());
               cout << "Done saving" << endl;
@@ -190,15 +213,34 @@ static void run_standalone(int argc, char* argv[]){
               experiment.set_memfp_physical(configuration().get_aging_memfp_physical());
               experiment.set_memfp_threshold(configuration().get_aging_memfp_threshold());
               experiment.set_cooloff(chrono::seconds{configuration().get_aging_cooloff_seconds()});
-
-              auto result = experiment.execute();
-              if (configuration().has_database()) result.save(configuration().db());
-              random_vertex = result.get_random_vertex_id();
+              experiment.set_partition(aging2_partition_from_string(configuration().get_aging_partition()));
+              experiment.set_work_stealing(configuration().get_aging_work_stealing());
+              experiment.set_seed(configuration().seed());
+              experiment.set_trace_record(configuration().get_aging_trace_record());
+              experiment.set_trace_replay(configuration().get_aging_trace_replay());
+
+              if (configuration().get_short_reads() > 0) {
+                LOG("[driver] Short reads, number of readers: " << configuration().get_short_reads());
+                UpdatesShortReadsExperiment exp_reads { experiment, impl };
+                exp_reads.set_num_readers(configuration().get_short_reads());
+                exp_reads.set_distribution(short_reads_distribution_from_string(configuration().get_short_reads_distribution()));
+                exp_reads.set_zipf_exponent(configuration().get_short_reads_zipf());
+                exp_reads.set_mix(short_reads_mix_from_string(configuration().get_short_reads_mix()));
+                exp_reads.set_seed(configuration().seed());
+                auto result = exp_reads.execute();
+                result.report();
+                if (configuration().has_database()) result.save(configuration().db());
+                random_vertex = result.get_random_vertex_id();
+              } else {
+                auto result = experiment.execute();
+                if (configuration().has_database()) result.save(configuration().db());
+                random_vertex = result.get_random_vertex_id();
+              }
 
               if (configuration().validate_inserts() && impl_upd->can_be_validated()) {
                 LOG("[driver] Validation of updates requested, loading the original graph from: " << path_graph);
                 auto stream = make_shared<graph::WeightedEdgeStream>(configuration().get_path_graph());
-                num_validation_errors = validate_updates(impl_upd, stream);
+                num_validation_errors = validate_updates(impl_upd, stream, configuration().get_validate_max_errors());
               }
             }
         }
@@ -246,6 +288,10 @@ static void run_standalone(int argc, char* argv[]){
                 exp_seq.set_validate_remap_vertices( path_graph );
             }
         }
+        if(configuration().get_analytics_csr()){
+            LOG("[driver] Materialising the snapshots into a CSR before running the kernels");
+            exp_seq.set_materialize_csr(true);
+        }
 
         exp_seq.execute();
         exp_seq.report(configuration().has_database());
@@ -19,14 +19,22 @@
 
 #include <arpa/inet.h>
 #include <cassert>
+#include <atomic>
 #include <cstring>
 #include <netdb.h> // gethostbyname
+#include <netinet/in.h>
+#include <netinet/tcp.h> // TCP_NODELAY
 #include <sys/socket.h>
 #include <type_traits>
 #include <unistd.h>
 
+#include "common/timer.hpp"
+#include "reader/reader.hpp"
+#include "utility/result_writer.hpp"
 #include "configuration.hpp"
+#include "edge_frame.hpp"
 #include "internal.hpp"
+#include "result_frame.hpp"
 
 using namespace std;
 
@@ -43,11 +51,18 @@ namespace gfe::network {
 
 thread_local int Client::m_worker_id { 0 };
 
-Client::Client(const std::string& host, int port) : m_server_host(host), m_server_port(port) {
+Client::Client(const std::string& host, int port, uint64_t max_in_flight, bool shared_memory) : m_server_host(host), m_server_port(port), m_max_in_flight(max_in_flight > 0 ? max_in_flight : configuration().get_client_max_in_flight()), m_shared_memory(shared_memory) {
+    if(m_max_in_flight == 0) ERROR("Invalid value for max_in_flight: " << m_max_in_flight);
+
     // reset the content of the connections
     for(int i = 0; i < max_num_connections; i++){
         m_connections[i].m_fd = -1;
         m_connections[i].m_buffer_read = m_connections[i].m_buffer_write = nullptr;
+        m_connections[i].m_next_sequence_id = 0;
+        m_connections[i].m_bytes_in_flight = 0;
+        m_connections[i].m_num_failed_updates = 0;
+        m_connections[i].m_results_mode = 0;
+        m_connections[i].m_scatter_sequence_id = 0;
     }
 
 //    LOG("[client] Connecting to " << m_server_host << ":" << m_server_port << " ...");
@@ -92,6 +107,10 @@ void Client::connect(){
         ERROR_ERRNO("Cannot connect to the remote server " << m_server_host << ":" << m_server_port);
     }
 
+    // pipelined requests are sent one by one, do not wait to coalesce them with the next ones
+    int nodelay_value = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void*) &nodelay_value, sizeof(nodelay_value));
+
     constexpr uint32_t buffer_default_sz = 4096; // bytes
 
     m_connections[m_worker_id].m_fd = fd;
@@ -99,6 +118,29 @@ void Client::connect(){
     m_connections[m_worker_id].m_buffer_write_sz = buffer_default_sz;
     m_connections[m_worker_id].m_buffer_read = (char*) malloc(sizeof(char) * buffer_default_sz);
     m_connections[m_worker_id].m_buffer_write = (char*) malloc(sizeof(char) * buffer_default_sz);
+    m_connections[m_worker_id].m_next_sequence_id = 0;
+    m_connections[m_worker_id].m_pending.clear();
+    m_connections[m_worker_id].m_bytes_in_flight = 0;
+    m_connections[m_worker_id].m_num_failed_updates = 0;
+
+    if(m_shared_memory){ attach_shared_memory(); }
+}
+
+void Client::attach_shared_memory(){
+    constexpr uint64_t capacity = 1ull << 20; // 1 MB for each ring
+    static atomic<uint64_t> num_segments { 0 }; // make the name unique among the clients in the same process
+    string name = "/gfe.client." + to_string(getpid()) + "." + to_string(num_segments++);
+    unique_ptr<SharedMemoryChannel> channel { new SharedMemoryChannel(name, capacity) };
+
+    request(RequestType::SHARED_MEMORY, name);
+    if(response()->type() == ResponseType::OK){
+        channel->unlink(); // the server has already mapped it
+        m_connections[m_worker_id].m_channel = move(channel);
+    } else if(response()->type() == ResponseType::ERROR){
+        LOG("[client] Cannot attach to the shared memory segment, continuing over TCP: " << response()->get_string(0));
+    } else {
+        LOG("[client] Shared memory not supported by the remote server, continuing over TCP");
+    }
 }
 
 void Client::disconnect(){
@@ -111,6 +153,9 @@ void Client::disconnect(int worker_id){
     close(m_connections[worker_id].m_fd); m_connections[worker_id].m_fd = -1;
     free(m_connections[worker_id].m_buffer_read); m_connections[worker_id].m_buffer_read = nullptr;
     free(m_connections[worker_id].m_buffer_write); m_connections[worker_id].m_buffer_write = nullptr;
+    m_connections[worker_id].m_pending.clear();
+    m_connections[worker_id].m_bytes_in_flight = 0;
+    m_connections[worker_id].m_channel.reset();
 }
 
 void Client::terminate_server_on_exit(){
@@ -125,29 +170,230 @@ void Client::terminate_server_on_exit(){
  *****************************************************************************/
 
 template<typename... Args>
-void Client::request(RequestType type, Args... args){
+uint64_t Client::send_request(RequestType type, Args... args){
     assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
-    char* buffer = m_connections[m_worker_id].m_buffer_write;
-    new (buffer) Request(type, forward<Args>(args)...);
-    uint32_t message_sz = reinterpret_cast<uint32_t*>(buffer)[0];
+    ConnectionState& connection = m_connections[m_worker_id];
+    char* buffer = connection.m_buffer_write;
+    Request* message = new (buffer) Request(type, forward<Args>(args)...);
+    uint64_t sequence_id = connection.m_next_sequence_id++;
+    message->set_sequence_id(sequence_id);
+    uint32_t message_sz = message->message_size();
 //    cout << "send message_sz: " << message_sz << endl;
 
     // send the request to the server
-    ssize_t bytes_sent = send(m_connections[m_worker_id].m_fd, buffer, message_sz, /* flags */ 0);
-    if(bytes_sent == -1) ERROR_ERRNO("send_request, connection error");
-    assert(bytes_sent == message_sz && "Message not fully sent");
+    send_data(buffer, message_sz);
+
+    return sequence_id;
+}
+
+// Check whether the server is still there, with the shared memory the TCP connection is only closed when the server goes away
+static bool is_server_alive(int fd){
+    char c;
+    ssize_t rc = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return rc > 0 || (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+}
+
+void Client::send_data(const char* buffer, uint32_t buffer_sz){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+    if(connection.m_channel){
+        int fd = connection.m_fd;
+        if(!connection.m_channel->requests().write(buffer, buffer_sz, [fd](){ return is_server_alive(fd); })){
+            ERROR("send_request, connection closed by the remote server");
+        }
+    } else {
+        ssize_t bytes_sent = send(connection.m_fd, buffer, buffer_sz, /* flags */ 0);
+        if(bytes_sent == -1) ERROR_ERRNO("send_request, connection error");
+        assert(bytes_sent == buffer_sz && "Message not fully sent");
+    }
+}
+
+void Client::recv_data(char* buffer, uint32_t buffer_sz){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+    if(connection.m_channel){
+        int fd = connection.m_fd;
+        if(!connection.m_channel->responses().read(buffer, buffer_sz, [fd](){ return is_server_alive(fd); })){
+            ERROR("recv, connection closed by the remote server");
+        }
+    } else {
+        uint32_t num_bytes_read = 0;
+        while(num_bytes_read < buffer_sz){
+            ssize_t recv_bytes = recv(connection.m_fd, buffer + num_bytes_read, buffer_sz - num_bytes_read, /* flags */ 0);
+            if(recv_bytes == -1) ERROR_ERRNO("recv, connection interrupted?");
+            if(recv_bytes == 0) ERROR("recv, connection closed by the remote server");
+            num_bytes_read += recv_bytes;
+        }
+    }
+}
+
+template<typename... Args>
+uint64_t Client::request(RequestType type, Args... args){
+    drain(0); // the responses are received in order, first collect those of the updates in flight
+
+    uint64_t sequence_id = send_request(type, forward<Args>(args)...);
 
     // receive the reply from the server
     wait_response();
+    check_response(sequence_id);
+
+    return sequence_id;
+}
+
+template<typename T, typename... Args>
+void Client::request_graphalytics(RequestType type, const char* dump2file, Args... args){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+    const bool remote_results = m_remote_results && dump2file != nullptr;
+    const int results_mode = remote_results ? (m_frame_compression ? 2 : 1) : 0;
+    if(connection.m_results_mode != results_mode){
+        request(RequestType::REMOTE_RESULTS, remote_results, m_frame_compression);
+        assert(response()->type() == ResponseType::OK);
+        connection.m_results_mode = results_mode;
+    }
+
+    uint64_t sequence_id = request(type, forward<Args>(args)...);
+    if(!remote_results) return;
+
+    // receive the frames of results, until the final response
+    common::Timer t_receive;
+    t_receive.start();
+    connection.m_result_vertices.clear();
+    connection.m_result_values.clear();
+    uint64_t num_bytes_received = 0;
+    while(response()->type() == ResponseType::RESULT_FRAME){
+        num_bytes_received += response()->message_size();
+        decode_result_frame(response()->buffer(), response()->message_size() - sizeof(Response), connection.m_result_vertices, connection.m_result_values, connection.m_frame_scratch);
+        wait_response();
+        check_response(sequence_id);
+    }
+    t_receive.stop();
+    if(response()->type() != ResponseType::OK) return; // the error is reported by the caller
+    uint64_t server_time = response()->get(0); // microseconds spent by the server to parse and encode the results
+
+    // save the results in the client's file system
+    common::Timer t_save;
+    t_save.start();
+    const uint64_t num_entries = connection.m_result_vertices.size();
+    vector<pair<uint64_t, T>> results(num_entries);
+    for(uint64_t i = 0; i < num_entries; i++){
+        results[i].first = connection.m_result_vertices[i];
+        memcpy(&(results[i].second), &(connection.m_result_values[i]), sizeof(T));
+    }
+    utility::save_results(results, dump2file);
+    t_save.stop();
+
+    LOG("[Client] " << type << ", results of " << num_entries << " vertices received in " << num_bytes_received << " bytes, "
+            "serialisation in the server: " << server_time << " us, transfer and decoding: " << t_receive << ", save: " << t_save);
+}
+
+void Client::request_update(RequestType type, uint64_t arg0, uint64_t arg1, double weight){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+
+    // encode the request, it is sent once there is room in the window
+    Request* message { nullptr };
+    switch(type){
+    case RequestType::ADD_VERTEX:
+    case RequestType::REMOVE_VERTEX:
+        message = new (connection.m_buffer_write) Request(type, arg0);
+        break;
+    case RequestType::ADD_EDGE:
+    case RequestType::ADD_EDGE_V2:
+        message = new (connection.m_buffer_write) Request(type, arg0, arg1, weight);
+        break;
+    case RequestType::REMOVE_EDGE:
+        message = new (connection.m_buffer_write) Request(type, arg0, arg1);
+        break;
+    default:
+        ERROR("Invalid update type: " << type);
+    }
+    const uint64_t message_sz = message->message_size();
+
+    // make room in the window, the responses of the updates in flight must fit in the buffers of the connection
+    drain_ready();
+    drain(m_max_in_flight -1, max_bytes_in_flight - message_sz);
+
+    uint64_t sequence_id = connection.m_next_sequence_id++;
+    message->set_sequence_id(sequence_id);
+    send_data(connection.m_buffer_write, message_sz);
+
+    connection.m_pending.push_back(PendingRequest{ sequence_id, type, arg0, arg1, message_sz });
+    connection.m_bytes_in_flight += message_sz;
+}
+
+bool Client::has_response() const {
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    const ConnectionState& connection = m_connections[m_worker_id];
+    if(connection.m_channel){
+        return connection.m_channel->responses().size() > 0;
+    } else {
+        char c;
+        return recv(connection.m_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) > 0;
+    }
+}
+
+void Client::drain_ready(){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+    while(!connection.m_pending.empty() && has_response()){
+        drain(connection.m_pending.size() -1);
+    }
+}
+
+void Client::drain(uint64_t num_pending, uint64_t num_bytes){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+
+    while(connection.m_pending.size() > num_pending || connection.m_bytes_in_flight > num_bytes){
+        PendingRequest request = connection.m_pending.front();
+        connection.m_pending.pop_front();
+        connection.m_bytes_in_flight -= request.m_size;
+        wait_response();
+        check_response(request.m_sequence_id);
+
+        switch(response()->type()){
+        case ResponseType::OK:
+            if(!response()->get<bool>(0)){ connection.m_num_failed_updates++; }
+            break;
+        case ResponseType::NOT_SUPPORTED:
+            if(request.m_type == RequestType::LOAD_FRAME || request.m_type == RequestType::BATCH_FRAME_FORCE_NO || request.m_type == RequestType::BATCH_FRAME_FORCE_YES){
+                ERROR(request.m_type << ", frame of " << request.m_arg0 << " edges: operation not supported by the remote interface");
+            } else if(request.m_type == RequestType::ADD_EDGE || request.m_type == RequestType::ADD_EDGE_V2 || request.m_type == RequestType::REMOVE_EDGE){
+                ERROR(request.m_type << "(" << request.m_arg0 << ", " << request.m_arg1 << "): operation not supported by the remote interface");
+            } else {
+                ERROR(request.m_type << "(" << request.m_arg0 << "): operation not supported by the remote interface");
+            }
+            break;
+        case ResponseType::ERROR:
+            RPC_ERROR(response()->get_string(0));
+            break;
+        case ResponseType::TIMEOUT:
+            assert(request.m_type == RequestType::BATCH_FRAME_FORCE_YES && "Only with the flag force == true, the interface is allowed to timeout");
+            RAISE_EXCEPTION(library::TimeoutError, "Batch timeout");
+            break;
+        default:
+            ERROR("Invalid response type: " << response()->type())
+        }
+    }
+}
+
+uint64_t Client::flush(){
+    drain(0);
+    uint64_t num_failed_updates = m_connections[m_worker_id].m_num_failed_updates;
+    m_connections[m_worker_id].m_num_failed_updates = 0;
+    return num_failed_updates;
+}
+
+void Client::check_response(uint64_t sequence_id) const {
+    if(response()->sequence_id() != sequence_id){
+        ERROR("Protocol error, expected the response for the request #" << sequence_id << ", received the response for the request #" << response()->sequence_id());
+    }
 }
 
 void Client::wait_response() {
-    int64_t num_bytes_read { 0 }, recv_bytes { 0 };
     char* buffer = m_connections[m_worker_id].m_buffer_read;
-    recv_bytes = recv(m_connections[m_worker_id].m_fd, buffer + num_bytes_read, sizeof(uint32_t), /* flags */ 0);
-    if(recv_bytes == -1) ERROR_ERRNO("recv, connection interrupted?");
-    assert(recv_bytes == sizeof(uint32_t) && "What the heck have we read?");
-    num_bytes_read += recv_bytes;
+    recv_data(buffer, sizeof(uint32_t));
     uint32_t message_sz = *(reinterpret_cast<uint32_t*>(buffer));
     if(message_sz > m_connections[m_worker_id].m_buffer_read_sz){ // realloc the buffer if it's not large enough
         LOG("realloc buffer, from " << m_connections[m_worker_id].m_buffer_read_sz << " to " << message_sz);
@@ -158,12 +404,7 @@ void Client::wait_response() {
         (reinterpret_cast<uint32_t*>(buffer))[0] = message_sz;
     }
     // read the rest of the message
-    while(num_bytes_read < message_sz){
-        recv_bytes = read(m_connections[m_worker_id].m_fd, buffer + num_bytes_read, message_sz - num_bytes_read);
-        if(recv_bytes == -1) ERROR_ERRNO("recv, connection interrupted?");
-        num_bytes_read += recv_bytes;
-    }
-    assert(num_bytes_read == message_sz && "Message read");
+    recv_data(buffer + sizeof(uint32_t), message_sz - sizeof(uint32_t));
 }
 
 const Response* Client::response() const {
@@ -191,6 +432,7 @@ void Client::on_thread_init(int thread_id) {
 }
 
 void Client::on_thread_destroy(int thread_id) {
+    m_num_failed_updates += flush(); // reported by #updates_stop
     request(RequestType::ON_THREAD_DESTROY, thread_id);
     assert(response()->type() == ResponseType::OK);
     if(thread_id == m_worker_id && m_worker_id > 0){
@@ -211,6 +453,12 @@ string Client::get_library_name() const {
     return response()->get_string(0);
 }
 
+string Client::server_statistics(bool reset) const {
+    const_cast<Client*>(this)->request(RequestType::STATS, reset);
+    assert(response()->type() == ResponseType::OK);
+    return response()->get_string(0);
+}
+
 uint64_t Client::num_edges() const {
     const_cast<Client*>(this)->request(RequestType::NUM_EDGES);
     assert(response()->type() == ResponseType::OK);
@@ -258,6 +506,11 @@ void Client::load(const std::string& path) {
 }
 
 bool Client::add_vertex(uint64_t vertex_id){
+    if(m_max_in_flight > 1){ // pipelined, the outcome is not known yet
+        request_update(RequestType::ADD_VERTEX, vertex_id);
+        return true;
+    }
+
     request(RequestType::ADD_VERTEX, vertex_id);
     if(response()->type() == ResponseType::NOT_SUPPORTED){
         ERROR("add_vertex(" << vertex_id << "): operation not supported by the remote interface");
@@ -267,6 +520,11 @@ bool Client::add_vertex(uint64_t vertex_id){
 }
 
 bool Client::remove_vertex(uint64_t vertex_id){
+    if(m_max_in_flight > 1){ // pipelined, the outcome is not known yet
+        request_update(RequestType::REMOVE_VERTEX, vertex_id);
+        return true;
+    }
+
     request(RequestType::REMOVE_VERTEX, vertex_id);
     if(response()->type() == ResponseType::NOT_SUPPORTED){
         ERROR("delete_vertex(" << vertex_id << "): operation not supported by the remote interface");
@@ -276,6 +534,11 @@ bool Client::remove_vertex(uint64_t vertex_id){
 }
 
 bool Client::add_edge(graph::WeightedEdge e){
+    if(m_max_in_flight > 1){ // pipelined, the outcome is not known yet
+        request_update(RequestType::ADD_EDGE, e.source(), e.destination(), e.weight());
+        return true;
+    }
+
     request(RequestType::ADD_EDGE, e.source(), e.destination(), e.weight());
     if(response()->type() == ResponseType::NOT_SUPPORTED){
         ERROR("add_edge(" << e.source() << ", " << e.destination() << ", " << e.weight() << "): operation not supported by the remote interface");
@@ -284,7 +547,26 @@ bool Client::add_edge(graph::WeightedEdge e){
     return response()->get<bool>(0);
 }
 
+bool Client::add_edge_v2(graph::WeightedEdge e){
+    if(m_max_in_flight > 1){ // pipelined, the outcome is not known yet
+        request_update(RequestType::ADD_EDGE_V2, e.source(), e.destination(), e.weight());
+        return true;
+    }
+
+    request(RequestType::ADD_EDGE_V2, e.source(), e.destination(), e.weight());
+    if(response()->type() == ResponseType::NOT_SUPPORTED){
+        ERROR("add_edge_v2(" << e.source() << ", " << e.destination() << ", " << e.weight() << "): operation not supported by the remote interface");
+    }
+    assert(response()->type() == ResponseType::OK);
+    return response()->get<bool>(0);
+}
+
 bool Client::remove_edge(graph::Edge e){
+    if(m_max_in_flight > 1){ // pipelined, the outcome is not known yet
+        request_update(RequestType::REMOVE_EDGE, e.source(), e.destination());
+        return true;
+    }
+
     request(RequestType::REMOVE_EDGE, e.source(), e.destination());
     if(response()->type() == ResponseType::NOT_SUPPORTED){
         ERROR("delete_edge(" << e.source() << ", " << e.destination() << "): operation not supported by the remote interface");
@@ -304,53 +586,125 @@ void Client::build() {
 bool Client::batch(const library::UpdateInterface::SingleUpdate* batch, uint64_t batch_sz, bool force){
     if(batch_sz == 0) return true;
     assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+
+    drain(0);
+    uint64_t num_failed_updates = connection.m_num_failed_updates; // the frames that failed are reported by the result of the batch
+
+    // stream the batch as a sequence of frames, the server applies each frame as it arrives
+    RequestType type = force ? RequestType::BATCH_FRAME_FORCE_YES : RequestType::BATCH_FRAME_FORCE_NO;
+    for(uint64_t i = 0; i < batch_sz; i += EDGE_FRAME_MAX_NUM_EDGES){
+        send_frame(type, batch + i, min(EDGE_FRAME_MAX_NUM_EDGES, batch_sz - i));
+    }
+    drain(0);
+
+    bool result = (connection.m_num_failed_updates == num_failed_updates);
+    connection.m_num_failed_updates = num_failed_updates;
+    return result;
+}
+
+void Client::stream_load(const std::string& path){
+    auto reader = reader::Reader::open(path);
+    if(reader->is_directed() != is_directed()){
+        ERROR("stream_load(\"" << path << "\"): the graph is " << (reader->is_directed() ? "directed" : "undirected") << ", while the remote library is not");
+    }
+
+    drain(0);
+    uint64_t num_failed_updates = m_connections[m_worker_id].m_num_failed_updates; // as #load, ignore the edges that could not be inserted
+
+    vector<library::UpdateInterface::SingleUpdate> frame;
+    frame.reserve(EDGE_FRAME_MAX_NUM_EDGES);
+    graph::WeightedEdge edge;
+    while(reader->read(edge)){
+        frame.push_back(library::UpdateInterface::SingleUpdate{ edge.source(), edge.destination(), edge.weight() });
+        if(frame.size() == EDGE_FRAME_MAX_NUM_EDGES){
+            send_frame(RequestType::LOAD_FRAME, frame.data(), frame.size());
+            frame.clear();
+        }
+    }
+    if(!frame.empty()){
+        send_frame(RequestType::LOAD_FRAME, frame.data(), frame.size());
+    }
+    drain(0);
+    m_connections[m_worker_id].m_num_failed_updates = num_failed_updates;
+
+    build();
+}
+
+void Client::send_frame(RequestType type, const library::UpdateInterface::SingleUpdate* edges, uint64_t num_edges){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+    drain(max_frames_in_flight -1); // the server applies a frame while the next ones are being transferred
+    reserve_request(sizeof(Request) + edge_frame_max_size(num_edges));
 
-    constexpr uint32_t header_sz = (uint32_t) sizeof(Request);
-    static_assert(header_sz == 8 && "Expected two int32_t fields: the message size and the message type");
-    uint32_t body_sz = (uint32_t) sizeof(library::UpdateInterface::SingleUpdate) * batch_sz;
-    uint32_t message_sz = header_sz + body_sz;
+    Request* message = new (connection.m_buffer_write) Request(type);
+    uint64_t sequence_id = connection.m_next_sequence_id++;
+    message->set_sequence_id(sequence_id);
+    message->extend(encode_edge_frame(edges, num_edges, m_frame_compression, message->buffer(), connection.m_frame_scratch));
+    send_data(connection.m_buffer_write, message->message_size());
 
-    if(message_sz > m_connections[m_worker_id].m_buffer_write_sz){
+    connection.m_pending.push_back(PendingRequest{ sequence_id, type, num_edges, 0, message->message_size() });
+    connection.m_bytes_in_flight += message->message_size();
+}
+
+void Client::reserve_request(uint64_t message_sz){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+    if(message_sz > connection.m_buffer_write_sz){
         uint32_t new_size = pow(2, ceil(log2(message_sz))); // next power of 2
         LOG("[worker: " << m_worker_id << "] Reallocate the write buffer to " << new_size << " bytes");
-        free(m_connections[m_worker_id].m_buffer_write);
-        m_connections[m_worker_id].m_buffer_write = (char*) malloc(new_size);
-        m_connections[m_worker_id].m_buffer_write_sz = new_size;
-    }
-
-    uint32_t* __restrict buffer_write = reinterpret_cast<uint32_t*>(m_connections[m_worker_id].m_buffer_write);
-    buffer_write[0] = message_sz;
-    buffer_write[1] = (uint32_t) (force ? RequestType::BATCH_PLAIN_FORCE_YES : RequestType::BATCH_PLAIN_FORCE_NO );
-    memcpy(buffer_write + 2, batch, batch_sz * sizeof(library::UpdateInterface::SingleUpdate));
-    ssize_t bytes_sent = send(m_connections[m_worker_id].m_fd, (void*) buffer_write, message_sz, /* flags */ 0);
-    if(bytes_sent == -1) ERROR_ERRNO("send_request, connection error");
-    assert(bytes_sent == message_sz && "Message not fully sent");
-
-    // this is actually more expensive than memcpy into the buffer and doing one send();
-//    // send the header
-//    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
-//    uint32_t* buffer_write = reinterpret_cast<uint32_t*>(m_connections[m_worker_id].m_buffer_write);
-//    buffer_write[0] = header_sz;
-//    buffer_write[1] = (uint32_t) RequestType::BATCH_PLAIN;
-//    ssize_t bytes_sent = send(m_connections[m_worker_id].m_fd, buffer_write, header_sz, /* flags */ 0);
-//    if(bytes_sent == -1) ERROR_ERRNO("send_request, header, connection error");
-//    assert(bytes_sent == header_sz && "Message not fully sent");
-//
-//    // send the body
-//    bytes_sent = send(m_connections[m_worker_id].m_fd, (void*) batch, body_sz, /* flags */ 0);
-//    if(bytes_sent == -1) ERROR_ERRNO("send_request, body, connection error");
-//    assert(bytes_sent == body_sz && "Message not fully sent");
-
-    // wait for the server to process the request
+        free(connection.m_buffer_write);
+        connection.m_buffer_write = (char*) malloc(new_size);
+        connection.m_buffer_write_sz = new_size;
+    }
+}
+
+void Client::scatter_send(RequestType type, const uint64_t* vertices, const uint64_t* values, uint64_t num_entries){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    assert((type == RequestType::SCATTER_DEGREE || type == RequestType::SCATTER_SUM || type == RequestType::SCATTER_MIN) && "Invalid request type");
+    ConnectionState& connection = m_connections[m_worker_id];
+    drain(0);
+    reserve_request(sizeof(Request) + result_frame_max_size(num_entries));
+
+    Request* message = new (connection.m_buffer_write) Request(type);
+    connection.m_scatter_sequence_id = connection.m_next_sequence_id++;
+    message->set_sequence_id(connection.m_scatter_sequence_id);
+    message->extend(encode_result_frame(vertices, values, num_entries, m_frame_compression, message->buffer(), connection.m_frame_scratch));
+    send_data(connection.m_buffer_write, message->message_size());
+}
+
+void Client::scatter_receive(vector<uint64_t>& vertices, vector<uint64_t>& values){
+    assert(m_worker_id >= 0 && m_worker_id < max_num_connections && "Invalid worker id");
+    ConnectionState& connection = m_connections[m_worker_id];
+
     wait_response();
+    check_response(connection.m_scatter_sequence_id);
+    while(response()->type() == ResponseType::RESULT_FRAME){
+        decode_result_frame(response()->buffer(), response()->message_size() - sizeof(Response), vertices, values, connection.m_frame_scratch);
+        wait_response();
+        check_response(connection.m_scatter_sequence_id);
+    }
 
-    if(response()->type() == ResponseType::TIMEOUT){
-        assert(force == true && "Only with the flag force == true, the interface is allowed to timeout");
-        RAISE_EXCEPTION(library::TimeoutError, "Batch timeout");
+    switch(response()->type()){
+    case ResponseType::OK:
+        break;
+    case ResponseType::NOT_SUPPORTED:
+        ERROR("scatter: operation not supported by the remote interface");
+        break;
+    case ResponseType::ERROR:
+        RPC_ERROR(response()->get_string(0));
+        break;
+    default:
+        ERROR("Invalid response type: " << response()->type())
     }
+}
 
-    assert(response()->type() == ResponseType::OK);
-    return response()->get<bool>(0);
+void Client::set_frame_compression(bool value){
+    m_frame_compression = value;
+}
+
+void Client::set_remote_results(bool value){
+    m_remote_results = value;
 }
 
 void Client::set_timeout(uint64_t seconds){
@@ -358,6 +712,13 @@ void Client::set_timeout(uint64_t seconds){
     assert(response()->type() == ResponseType::OK);
 }
 
+void Client::updates_stop(){
+    uint64_t num_failed_updates = flush() + m_num_failed_updates.exchange(0);
+    if(num_failed_updates > 0){
+        LOG("[client] WARNING: " << num_failed_updates << " pipelined updates returned false");
+    }
+}
+
 void Client::dump() const {
     const_cast<Client*>(this)->request(RequestType::DUMP_CLIENT);
     assert(response()->type() == ResponseType::OK);
@@ -377,7 +738,7 @@ void Client::bfs(uint64_t source_vertex_id, const char* dump2file){
     if(dump2file != nullptr && dump2file[0] == '\0') dump2file = nullptr;
 
 
-    request(RequestType::BFS, source_vertex_id, dump2file);
+    request_graphalytics<int64_t>(RequestType::BFS, dump2file, source_vertex_id, dump2file);
     if(response()->type() == ResponseType::NOT_SUPPORTED){
         ERROR("bfs(" << source_vertex_id << ", \"" << dump2file << "\"): operation not supported by the remote interface");
     } else if (response()->type() == ResponseType::ERROR){
@@ -389,7 +750,7 @@ void Client::bfs(uint64_t source_vertex_id, const char* dump2file){
 }
 
 void Client::pagerank(uint64_t num_iterations, double damping_factor, const char* dump2file) {
-    request(RequestType::PAGERANK, num_iterations, damping_factor, dump2file);
+    request_graphalytics<double>(RequestType::PAGERANK, dump2file, num_iterations, damping_factor, dump2file);
     if(response()->type() == ResponseType::NOT_SUPPORTED){
         ERROR("pagerank(" << num_iterations << ", " << damping_factor << ", \"" << dump2file << "\"): operation not supported by the remote interface");
     } else if (response()->type() == ResponseType::TIMEOUT){
@@ -399,7 +760,7 @@ void Client::pagerank(uint64_t num_iterations, double damping_factor, const char
 }
 
 void Client::wcc(const char* dump2file){
-    request(RequestType::WCC, dump2file);
+    request_graphalytics<uint64_t>(RequestType::WCC, dump2file, dump2file);
     if(response()->type() == ResponseType::NOT_SUPPORTED){
         ERROR("wcc(\"" << dump2file << "\"): operation not supported by the remote interface");
     } else if (response()->type() == ResponseType::TIMEOUT){
@@ -409,7 +770,7 @@ void Client::wcc(const char* dump2file){
 }
 
 void Client::cdlp(uint64_t max_iterations, const char* dump2file){
-    request(RequestType::CDLP, max_iterations, dump2file);
+    request_graphalytics<uint64_t>(RequestType::CDLP, dump2file, max_iterations, dump2file);
 
     switch(response()->type()){
     case ResponseType::NOT_SUPPORTED:
@@ -430,7 +791,7 @@ void Client::cdlp(uint64_t max_iterations, const char* dump2file){
 }
 
 void Client::lcc(const char* dump2file){
-    request(RequestType::LCC, dump2file);
+    request_graphalytics<double>(RequestType::LCC, dump2file, dump2file);
 
     switch(response()->type()){
     case ResponseType::NOT_SUPPORTED:
@@ -451,7 +812,7 @@ void Client::lcc(const char* dump2file){
 }
 
 void Client::sssp(uint64_t source_vertex_id, const char* dump2file){
-    request(RequestType::SSSP, source_vertex_id, dump2file);
+    request_graphalytics<double>(RequestType::SSSP, dump2file, source_vertex_id, dump2file);
 
     switch(response()->type()){
     case ResponseType::NOT_SUPPORTED:
@@ -17,21 +17,40 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <limits>
 #include <string>
 #include <vector>
 
 #include "library/interface.hpp"
 #include "message.hpp"
+#include "shared_memory.hpp"
 
 namespace gfe::network {
 
 /**
  * A Client acts as a proxy for a remote interface, reachable by a Server (gfe_server).
  * All requests performed to an instance of a Client are forwarded to the end and result propagated back
- * to the invoker. The communication between the client and a server is synchronous, but multiple
- * connections can be enabled, simply by invoking the public methods from different threads. The first
- * method invoked by any thread must be #on_thread_init(int worker_id), with a worker_id different
- * from any other active thread.
+ * to the invoker. Multiple connections can be enabled, simply by invoking the public methods from different
+ * threads. The first method invoked by any thread must be #on_thread_init(int worker_id), with a worker_id
+ * different from any other active thread.
+ *
+ * The updates (add/remove a vertex or an edge) can be pipelined: up to `max_in_flight' updates are sent to
+ * the server without waiting for their responses, so that the cost of a round-trip is amortised over many
+ * updates. In this case the updates always return true, as their outcome is not known yet. The responses
+ * already received are collected before sending the next update, the others when the window is full, before
+ * any other request, or explicitly with #flush(), which also reports how many updates returned false. The
+ * window is also bounded by the bytes of the updates in flight, so that their responses always fit in the
+ * buffers of the connection: otherwise the server would wait for the client to read the responses, while the
+ * client waits for the server to read the requests. The failed updates are also reported by #updates_stop().
+ * With max_in_flight = 1, all requests are synchronous, which is the default with the option --client_max_in_flight.
+ *
+ * When the server runs on the same host, the messages can be exchanged over a shared memory segment, one for each
+ * connection, rather than through the TCP stack. The TCP connection is only used to set up the segment.
+ *
+ * By default, the graphalytics kernels save their results in the server's file system. With #set_remote_results, the
+ * server streams the results back as frames of vertex IDs and values, and the client saves them in its own file system.
  *
  * The class is thread-safe only if different threads access it with a different worker_id,
  * previously set through #on_thread_init(int worker_id).
@@ -43,7 +62,23 @@ class Client : public virtual library::UpdateInterface, public virtual library::
     static thread_local int m_worker_id; // keep track which worker
     const std::string m_server_host;
     const int m_server_port;
+    const uint64_t m_max_in_flight; // max number of updates sent without waiting for their responses
+    const bool m_shared_memory; // whether to exchange the messages over shared memory, rather than TCP
+    bool m_frame_compression = false; // whether to compress the frames of edges streamed to the server
+    bool m_remote_results = false; // whether to receive the results of the graphalytics kernels in the client's file system
     static constexpr int max_num_connections = 1024;
+    static constexpr uint64_t max_frames_in_flight = 4; // max number of frames of edges sent without waiting for their responses
+    static constexpr uint64_t max_bytes_in_flight = 1ull << 16; // max amount of bytes of the updates sent without waiting for their responses, well below the capacity of the socket buffers and of the shared memory rings
+    std::atomic<uint64_t> m_num_failed_updates { 0 }; // number of pipelined updates that returned false, collected from the connections closed, since the last #updates_stop()
+
+    // An update sent to the server, whose response has not been received yet
+    struct PendingRequest {
+        uint64_t m_sequence_id; // the sequence id of the request
+        RequestType m_type; // the type of update
+        uint64_t m_arg0; // the vertex, the source of the edge or the number of edges in a frame
+        uint64_t m_arg1; // the destination of the edge
+        uint64_t m_size; // the size of the request, in bytes
+    };
 
     struct ConnectionState {
         int m_fd; // file descriptor for the connection
@@ -51,6 +86,16 @@ class Client : public virtual library::UpdateInterface, public virtual library::
         uint32_t m_buffer_write_sz; // current size of the write buffer
         char* m_buffer_read; // read buffer
         char* m_buffer_write; // write buffer
+        uint64_t m_next_sequence_id; // the sequence id to assign to the next request
+        std::deque<PendingRequest> m_pending; // updates in flight, in the same order they were sent
+        uint64_t m_bytes_in_flight; // the total size of the requests in m_pending, in bytes
+        uint64_t m_num_failed_updates; // number of pipelined updates that returned false, since the last #flush()
+        std::unique_ptr<SharedMemoryChannel> m_channel; // the shared memory segment for the messages, or nullptr to use TCP
+        std::vector<uint64_t> m_frame_scratch; // space to encode the frames of edges and decode the frames of results
+        int m_results_mode; // how the server replies to the kernels: 0 = results saved in the server, 1 = sent back, 2 = sent back compressed
+        std::vector<uint64_t> m_result_vertices; // the vertex IDs of the results received
+        std::vector<uint64_t> m_result_values; // the values of the results received, bitwise
+        uint64_t m_scatter_sequence_id; // the sequence id of the last superstep sent with #scatter_send
     };
 
     ConnectionState m_connections[max_num_connections]; // keep track of all connections
@@ -60,6 +105,11 @@ class Client : public virtual library::UpdateInterface, public virtual library::
      */
     void connect();
 
+    /**
+     * Move the connection of the current worker over a shared memory segment
+     */
+    void attach_shared_memory();
+
     /**
      * Close the connection to the server. It affects only the file descriptor referred by m_worker_id
      */
@@ -71,16 +121,77 @@ class Client : public virtual library::UpdateInterface, public virtual library::
     void disconnect(int worker_id);
 
     /**
-     * Send the given request to the server
+     * Send the given bytes to the server, over the connection of the current worker
+     */
+    void send_data(const char* buffer, uint32_t buffer_sz);
+
+    /**
+     * Receive exactly the given amount of bytes from the server, over the connection of the current worker
+     */
+    void recv_data(char* buffer, uint32_t buffer_sz);
+
+    /**
+     * Send the given request to the server, without waiting for its response
+     * @return the sequence id assigned to the request
+     */
+    template<typename... Args>
+    uint64_t send_request(RequestType type, Args... args);
+
+    /**
+     * Send the given request to the server and wait for its response
+     * @return the sequence id assigned to the request
      */
     template<typename... Args>
-    void request(RequestType type, Args... args);
+    uint64_t request(RequestType type, Args... args);
+
+    /**
+     * Send the given graphalytics request to the server and wait for its response. If the results are to be saved in
+     * the client's file system, receive them as a sequence of frames, with values of type T, and save them in dump2file.
+     */
+    template<typename T, typename... Args>
+    void request_graphalytics(RequestType type, const char* dump2file, Args... args);
+
+    /**
+     * Send the given update to the server, only wait for the responses of the previous updates when the window is full
+     */
+    void request_update(RequestType type, uint64_t arg0, uint64_t arg1 = 0, double weight = 0);
+
+    /**
+     * Ensure the write buffer of the current worker can hold a request of the given size
+     */
+    void reserve_request(uint64_t message_sz);
+
+    /**
+     * Send a frame of edges to the server, only wait for the responses of the previous frames when the window is full
+     */
+    void send_frame(RequestType type, const library::UpdateInterface::SingleUpdate* edges, uint64_t num_edges);
+
+    /**
+     * Receive the responses of the pending updates, until at most `num_pending' are left in flight, with a total
+     * size of at most `num_bytes'
+     */
+    void drain(uint64_t num_pending, uint64_t num_bytes = std::numeric_limits<uint64_t>::max());
+
+    /**
+     * Receive the responses of the pending updates that have already arrived, without waiting for the others
+     */
+    void drain_ready();
+
+    /**
+     * Check whether (part of) a response can be received without waiting
+     */
+    bool has_response() const;
 
     /**
      * Receive the response from the server
      */
     void wait_response();
 
+    /**
+     * Check the response received for the given request
+     */
+    void check_response(uint64_t sequence_id) const;
+
     /**
      * Retrieve the current response from the server
      */
@@ -89,8 +200,10 @@ class Client : public virtual library::UpdateInterface, public virtual library::
 public:
     /**
      * Connect the proxy to the server at the given host/port
+     * @param max_in_flight the max number of updates to pipeline on each connection, 0 = the value of the option --client_max_in_flight
+     * @param shared_memory whether to exchange the messages over shared memory. The server must be on the same host.
      */
-    Client(const std::string& host, int port);
+    Client(const std::string& host, int port, uint64_t max_in_flight = 0, bool shared_memory = false);
 
     /**
      * Destructor
@@ -117,11 +230,60 @@ public:
      */
     void terminate_server_on_exit();
 
+    /**
+     * Wait for the responses of all updates in flight for the current worker
+     * @return the number of pipelined updates that returned false since the last invocation
+     */
+    uint64_t flush();
+
+    /**
+     * Load the graph from the given path, in the client's file system, by streaming its edges to the server as a
+     * sequence of frames. The vertices are implicitly created. As #load, create a new snapshot at the end.
+     */
+    void stream_load(const std::string& path);
+
+    /**
+     * Whether to compress, with zlib, the frames of edges streamed by #stream_load and #batch
+     */
+    void set_frame_compression(bool value);
+
+    /**
+     * Whether the graphalytics kernels should save their results in the client's file system, rather than the server's.
+     * The server streams the results back as frames, compressed according to #set_frame_compression.
+     */
+    void set_remote_results(bool value);
+
+    /**
+     * Send a superstep of a BSP computation to the server, without waiting for its response. The server visits the
+     * neighbours of the given vertices in its library and aggregates, for each neighbour, the values of the vertices it
+     * is attached to. Used by the PartitionedClient, to run the superstep on all servers at the same time.
+     * @param type SCATTER_DEGREE (the local degree of each vertex), SCATTER_SUM (the sum of the values, as doubles)
+     *        or SCATTER_MIN (the min of the values, as unsigned integers)
+     * @param vertices the vertices to visit
+     * @param values the value of each vertex, bitwise
+     * @param num_entries the number of vertices, at most RESULT_FRAME_MAX_NUM_ENTRIES
+     */
+    void scatter_send(RequestType type, const uint64_t* vertices, const uint64_t* values, uint64_t num_entries);
+
+    /**
+     * Receive the result of the superstep sent with #scatter_send. The pairs <vertex, aggregate> are appended to the
+     * given vectors.
+     */
+    void scatter_receive(std::vector<uint64_t>& vertices, std::vector<uint64_t>& values);
+
     /**
      * Get the name of the library being evaluated in the server
      */
     std::string get_library_name() const;
 
+    /**
+     * Get the latencies of the requests processed by the server so far, for each type of request, as a human readable
+     * report. The latencies are split into the time queued in the server, the time spent in the library and the time to
+     * send the responses back.
+     * @param reset whether to reset the counters in the server, after retrieving them
+     */
+    std::string server_statistics(bool reset = false) const;
+
     // Proxy to the rest of the functions in the library
     virtual void on_main_init(int num_threads) override;
     virtual void on_thread_init(int thread_id) override;
@@ -137,10 +299,12 @@ public:
     virtual bool add_vertex(uint64_t vertex_id) override;
     virtual bool remove_vertex(uint64_t vertex_id) override;
     virtual bool add_edge(graph::WeightedEdge e) override;
+    virtual bool add_edge_v2(graph::WeightedEdge e) override;
     virtual bool remove_edge(graph::Edge e) override;
     virtual void build() override;
     virtual bool batch(const library::UpdateInterface::SingleUpdate* batch, uint64_t batch_sz, bool force) override;
     virtual void set_timeout(uint64_t seconds) override;
+    virtual void updates_stop() override; // report the pipelined updates that failed
     virtual void bfs(uint64_t source_vertex_id, const char* dump2file = nullptr) override; // graphalytics
     virtual void pagerank(uint64_t num_iterations, double damping_factor = 0.85, const char* dump2file = nullptr) override; // graphalytics
     virtual void wcc(const char* dump2file = nullptr) override; // graphalytics
@@ -0,0 +1,127 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "edge_frame.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <zlib.h>
+
+#include "internal.hpp"
+
+using namespace std;
+
+namespace gfe::network {
+
+namespace {
+
+struct FrameHeader {
+    uint32_t m_num_edges; // number of edges in the frame
+    uint32_t m_payload_sz; // size of the columns that follow, in bytes
+};
+static_assert(sizeof(FrameHeader) == 8);
+
+constexpr uint64_t EDGE_SZ = 3 * sizeof(uint64_t); // source, destination and weight
+static_assert(sizeof(library::UpdateInterface::SingleUpdate) == EDGE_SZ);
+
+// Round up to a multiple of 8 bytes
+uint64_t align8(uint64_t value){
+    return (value + 7) & ~(uint64_t) 7;
+}
+
+// Store the edges as three columns in the given output
+void edges2columns(const library::UpdateInterface::SingleUpdate* edges, uint64_t num_edges, uint64_t* __restrict output){
+    uint64_t* __restrict sources = output;
+    uint64_t* __restrict destinations = output + num_edges;
+    double* __restrict weights = reinterpret_cast<double*>(output + 2 * num_edges);
+    for(uint64_t i = 0; i < num_edges; i++){
+        sources[i] = edges[i].m_source;
+        destinations[i] = edges[i].m_destination;
+        weights[i] = edges[i].m_weight;
+    }
+}
+
+// Retrieve the edges from the three columns
+void columns2edges(const uint64_t* __restrict input, uint64_t num_edges, library::UpdateInterface::SingleUpdate* __restrict edges){
+    const uint64_t* __restrict sources = input;
+    const uint64_t* __restrict destinations = input + num_edges;
+    const double* __restrict weights = reinterpret_cast<const double*>(input + 2 * num_edges);
+    for(uint64_t i = 0; i < num_edges; i++){
+        edges[i].m_source = sources[i];
+        edges[i].m_destination = destinations[i];
+        edges[i].m_weight = weights[i];
+    }
+}
+
+} // anon namespace
+
+uint64_t edge_frame_max_size(uint64_t num_edges){
+    uint64_t raw_sz = num_edges * EDGE_SZ;
+    return align8(sizeof(FrameHeader) + max<uint64_t>(raw_sz, compressBound(raw_sz)));
+}
+
+uint64_t encode_edge_frame(const library::UpdateInterface::SingleUpdate* edges, uint64_t num_edges, bool compress, char* output, vector<uint64_t>& scratch){
+    assert(num_edges <= EDGE_FRAME_MAX_NUM_EDGES && "Too many edges for a single frame");
+    FrameHeader* header = reinterpret_cast<FrameHeader*>(output);
+    char* payload = output + sizeof(FrameHeader);
+    const uint64_t raw_sz = num_edges * EDGE_SZ;
+    header->m_num_edges = num_edges;
+    header->m_payload_sz = raw_sz;
+
+    if(!compress){
+        edges2columns(edges, num_edges, reinterpret_cast<uint64_t*>(payload));
+    } else {
+        scratch.resize(3 * num_edges);
+        edges2columns(edges, num_edges, scratch.data());
+        uLongf compressed_sz = compressBound(raw_sz);
+        int rc = compress2(reinterpret_cast<Bytef*>(payload), &compressed_sz, reinterpret_cast<const Bytef*>(scratch.data()), raw_sz, Z_BEST_SPEED);
+        if(rc != Z_OK) ERROR("Cannot compress the frame of edges, zlib error code: " << rc);
+        if(compressed_sz < raw_sz){
+            header->m_payload_sz = compressed_sz;
+        } else { // not worth it
+            memcpy(payload, scratch.data(), raw_sz);
+        }
+    }
+
+    uint64_t frame_sz = sizeof(FrameHeader) + header->m_payload_sz;
+    memset(output + frame_sz, 0, align8(frame_sz) - frame_sz); // padding
+    return align8(frame_sz);
+}
+
+void decode_edge_frame(const char* input, uint64_t input_sz, vector<library::UpdateInterface::SingleUpdate>& output, vector<uint64_t>& scratch){
+    if(input_sz < sizeof(FrameHeader)) ERROR("Invalid frame of edges, size: " << input_sz << " bytes");
+    const FrameHeader* header = reinterpret_cast<const FrameHeader*>(input);
+    const char* payload = input + sizeof(FrameHeader);
+    const uint64_t num_edges = header->m_num_edges;
+    const uint64_t raw_sz = num_edges * EDGE_SZ;
+    if(num_edges > EDGE_FRAME_MAX_NUM_EDGES || sizeof(FrameHeader) + header->m_payload_sz > input_sz){
+        ERROR("Invalid frame of edges, num edges: " << num_edges << ", payload size: " << header->m_payload_sz << ", frame size: " << input_sz);
+    }
+
+    output.resize(num_edges);
+    if(header->m_payload_sz == raw_sz){ // not compressed
+        columns2edges(reinterpret_cast<const uint64_t*>(payload), num_edges, output.data());
+    } else {
+        scratch.resize(3 * num_edges);
+        uLongf decompressed_sz = raw_sz;
+        int rc = uncompress(reinterpret_cast<Bytef*>(scratch.data()), &decompressed_sz, reinterpret_cast<const Bytef*>(payload), header->m_payload_sz);
+        if(rc != Z_OK || decompressed_sz != raw_sz) ERROR("Cannot decompress the frame of edges, zlib error code: " << rc);
+        columns2edges(scratch.data(), num_edges, output.data());
+    }
+}
+
+} // namespace
@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <vector>
+
+#include "library/interface.hpp"
+
+namespace gfe::network {
+
+/**
+ * A frame of edges, the body of the requests LOAD_FRAME and BATCH_FRAME_*. A client streams a large batch, or a
+ * whole graph, as a sequence of frames with at most EDGE_FRAME_MAX_NUM_EDGES edges each, so that the server can apply
+ * each frame as it arrives and its buffers do not grow beyond the size of a frame.
+ *
+ * The edges are encoded in three columns: first all sources, then all destinations, then all weights, each as an
+ * array of 8-byte values. The columns are optionally compressed, as a whole, with zlib. A frame starts with a header of
+ * two uint32_t: the number of edges and the size of the payload that follows, in bytes. The payload is compressed iff
+ * its size differs from num_edges * 24. The frame is padded to a multiple of 8 bytes.
+ */
+constexpr uint64_t EDGE_FRAME_MAX_NUM_EDGES = 1ull << 16; // 1.5 MB uncompressed
+
+/**
+ * Retrieve an upper bound to the size of a frame with the given number of edges, in bytes
+ */
+uint64_t edge_frame_max_size(uint64_t num_edges);
+
+/**
+ * Encode the given edges as a frame
+ * @param edges the edges to encode
+ * @param num_edges the number of edges, at most EDGE_FRAME_MAX_NUM_EDGES
+ * @param compress whether to compress the columns. If the compressed columns are not smaller, they are stored as they are.
+ * @param output where to store the frame, with a capacity of at least edge_frame_max_size(num_edges) bytes
+ * @param scratch space to stage the columns before compressing them
+ * @return the size of the frame, in bytes, including the padding
+ */
+uint64_t encode_edge_frame(const library::UpdateInterface::SingleUpdate* edges, uint64_t num_edges, bool compress, char* output, std::vector<uint64_t>& scratch);
+
+/**
+ * Decode a frame of edges
+ * @param input the frame
+ * @param input_sz the size of the frame, in bytes
+ * @param output where to store the edges. The content of the vector is replaced.
+ * @param scratch space to stage the decompressed columns
+ */
+void decode_edge_frame(const char* input, uint64_t input_sz, std::vector<library::UpdateInterface::SingleUpdate>& output, std::vector<uint64_t>& scratch);
+
+} // namespace
@@ -26,6 +26,8 @@ std::ostream& operator<<(std::ostream& out, RequestType type){
     case RequestType::TERMINATE_ON_LAST_CONNECTION: out << "TERMINATE_ON_LAST_CONNECTION"; break;
     case RequestType::LIBRARY_NAME: out << "LIBRARY_NAME"; break;
     case RequestType::SET_TIMEOUT: out << "SET_TIMEOUT"; break;
+    case RequestType::SHARED_MEMORY: out << "SHARED_MEMORY"; break;
+    case RequestType::REMOTE_RESULTS: out << "REMOTE_RESULTS"; break;
     case RequestType::ON_MAIN_INIT: out << "ON_MAIN_INIT"; break;
     case RequestType::ON_THREAD_INIT: out << "ON_THREAD_INIT"; break;
     case RequestType::ON_THREAD_DESTROY: out << "ON_THREAD_DESTROY"; break;
@@ -37,12 +39,16 @@ std::ostream& operator<<(std::ostream& out, RequestType type){
     case RequestType::HAS_EDGE: out << "HAS_EDGE"; break;
     case RequestType::GET_WEIGHT: out << "GET_WEIGHT"; break;
     case RequestType::LOAD: out << "LOAD"; break;
+    case RequestType::LOAD_FRAME: out << "LOAD_FRAME"; break;
     case RequestType::ADD_VERTEX: out << "ADD_VERTEX"; break;
     case RequestType::REMOVE_VERTEX: out << "REMOVE_VERTEX"; break;
     case RequestType::ADD_EDGE: out << "ADD_EDGE"; break;
     case RequestType::REMOVE_EDGE: out << "REMOVE_EDGE"; break;
+    case RequestType::ADD_EDGE_V2: out << "ADD_EDGE_V2"; break;
     case RequestType::BATCH_PLAIN_FORCE_NO: out << "BATCH_PLAIN (force = false)"; break;
     case RequestType::BATCH_PLAIN_FORCE_YES: out << "BATCH_PLAIN (force = true)"; break;
+    case RequestType::BATCH_FRAME_FORCE_NO: out << "BATCH_FRAME (force = false)"; break;
+    case RequestType::BATCH_FRAME_FORCE_YES: out << "BATCH_FRAME (force = true)"; break;
     case RequestType::BUILD: out << "BUILD"; break;
     case RequestType::DUMP_CLIENT: out << "DUMP_CLIENT"; break;
     case RequestType::DUMP_STDOUT: out << "DUMP_STDOUT"; break;
@@ -53,13 +59,17 @@ std::ostream& operator<<(std::ostream& out, RequestType type){
     case RequestType::CDLP: out << "CDLP (Graphalytics, Community Detection using Label Propagation)"; break;
     case RequestType::LCC: out << "LCC (Graphalytics, Local Clustering Coefficient)"; break;
     case RequestType::SSSP: out << "SSSP (Graphalytics, Single-Source Shortest Paths)"; break;
+    case RequestType::SCATTER_DEGREE: out << "SCATTER_DEGREE"; break;
+    case RequestType::SCATTER_SUM: out << "SCATTER_SUM"; break;
+    case RequestType::SCATTER_MIN: out << "SCATTER_MIN"; break;
+    case RequestType::STATS: out << "STATS"; break;
     default: out << "UNKNOWN (request code: " << (uint32_t) type << ")";
     }
     return out;
 }
 
 std::ostream& operator<<(std::ostream& out, const Request& request){
-    out << "[REQUEST " << request.type() << ", message size: " << request.message_size();
+    out << "[REQUEST " << request.type() << ", sequence id: " << request.sequence_id() << ", message size: " << request.message_size();
     switch(request.type()){
     case RequestType::ON_MAIN_INIT:
         out << ", num threads: " << request.get(0);
@@ -79,6 +89,7 @@ std::ostream& operator<<(std::ostream& out, const Request& request){
         out << ", vertex_id: " << request.get(0);
         break;
     case RequestType::ADD_EDGE:
+    case RequestType::ADD_EDGE_V2:
         out << ", source: " << request.get(0) << ", destination: " << request.get(1)<< ", weight: " << request.get(2);
         break;
     case RequestType::REMOVE_EDGE:
@@ -94,6 +105,9 @@ std::ostream& operator<<(std::ostream& out, const Request& request){
     case RequestType::CDLP:
         out << ", max_iterations: " << request.get(0);
         break;
+    case RequestType::REMOTE_RESULTS:
+        out << ", enabled: " << request.get<bool>(0) << ", compression: " << request.get<bool>(1);
+        break;
     default:
         ; /* nop */
     }
@@ -115,16 +129,21 @@ std::ostream& operator<<(std::ostream& out, ResponseType type){
     switch(type){
     case ResponseType::OK: out << "OK"; break;
     case ResponseType::NOT_SUPPORTED: out << "NOT_SUPPORTED"; break;
+    case ResponseType::ERROR: out << "ERROR"; break;
+    case ResponseType::TIMEOUT: out << "TIMEOUT"; break;
+    case ResponseType::RESULT_FRAME: out << "RESULT_FRAME"; break;
     default: out << "UNKNOWN (response code: " << (uint32_t) type << ")";
     }
     return out;
 }
 
 std::ostream& operator<<(std::ostream& out, const Response& response){
-    out << "[RESPONSE " << response.type() << ", message size: " << response.message_size();
+    out << "[RESPONSE " << response.type() << ", sequence id: " << response.sequence_id() << ", message size: " << response.message_size();
 
-    for(int i = 0, end = response.num_arguments(); i < end; i++){
-        out << ", arg[" << i << "]: " << response.get<int64_t>(i);
+    if(response.type() != ResponseType::RESULT_FRAME){ // the payload of a frame is not a list of arguments
+        for(int i = 0, end = response.num_arguments(); i < end; i++){
+            out << ", arg[" << i << "]: " << response.get<int64_t>(i);
+        }
     }
 
     out << "]";
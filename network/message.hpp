@@ -23,6 +23,7 @@
 #include <cstring>
 //#include <iostream> // debug only
 #include <ostream>
+#include <string>
 #include <type_traits>
 
 namespace gfe::network {
@@ -36,16 +37,24 @@ enum class RequestType : uint32_t {
     TERMINATE_ON_LAST_CONNECTION, // terminate the server when there no are more connections active
     LIBRARY_NAME, // the name of the library being evaluated
     SET_TIMEOUT, // avoid a computation running more than the given amount of  seconds
+    SHARED_MEMORY, // continue the communication over the shared memory segment with the given name
+    REMOTE_RESULTS, // whether to send back the results of the graphalytics kernels as frames, rather than saving them in the server
     ON_MAIN_INIT, ON_THREAD_INIT, ON_THREAD_DESTROY, ON_MAIN_DESTROY,
     NUM_EDGES, NUM_VERTICES, IS_DIRECTED,
     HAS_VERTEX, HAS_EDGE, GET_WEIGHT,
     LOAD, // load the graph from disk
+    LOAD_FRAME, // load a frame of edges streamed by the client, implicitly creating their vertices
     ADD_VERTEX, REMOVE_VERTEX, ADD_EDGE, REMOVE_EDGE,
+    ADD_EDGE_V2, // add an edge, implicitly creating its vertices
     BATCH_PLAIN_FORCE_NO, BATCH_PLAIN_FORCE_YES,
+    BATCH_FRAME_FORCE_NO, BATCH_FRAME_FORCE_YES, // a batch of updates, streamed by the client as a sequence of frames
     BUILD, // create a new snapshot
     DUMP_CLIENT, DUMP_STDOUT, DUMP_FILE, // #dump()
-    BFS, PAGERANK, WCC, CDLP, LCC, SSSP // graphalytics interface
+    BFS, PAGERANK, WCC, CDLP, LCC, SSSP, // graphalytics interface
+    SCATTER_DEGREE, SCATTER_SUM, SCATTER_MIN, // a superstep of a BSP computation coordinated by the client, see PartitionedClient
+    STATS, // the latencies of the requests processed by the server so far
 };
+constexpr uint32_t num_request_types = static_cast<uint32_t>(RequestType::STATS) + 1; // keep in sync with the last request type
 
 /**
  * The type of a response message, sent back from the server to the client
@@ -55,20 +64,29 @@ enum class ResponseType: uint32_t {
     NOT_SUPPORTED, // the remote server does not support the given operation
     ERROR, // an error occured, the message contains the error message
     TIMEOUT, // too many seconds elapsed to complete the operation
+    RESULT_FRAME, // a chunk of the results of a graphalytics kernel, more responses for the same request follow
 };
 
 /**
- * A generic message, type + arguments, sent between the clients and the server
+ * A generic message, type + arguments, sent between the clients and the server.
+ *
+ * Each request carries a sequence id, assigned by the client, and the server echoes it back in the related response.
+ * The client can have multiple requests in flight on the same connection, as the server processes them in order.
  */
 template<typename Type>
 class Message {
     uint32_t m_message_size; // size of the message, in bytes, including the header (that is sizeof(Message))
     const Type m_type;
+    uint64_t m_sequence_id; // id of the request, the response bears the same id of the request it replies to
 
 public:
     template<typename... Args>
     Message(Type type, Args... args);
 
+    // Compute the size of a message with the given arguments, without creating it
+    template<typename... Args>
+    static size_t compute_size(Args... args);
+
     // Retrieve the total number of arguments in the message
     int num_arguments() const;
 
@@ -78,6 +96,13 @@ public:
     // The type associated to this message
     Type type() const;
 
+    // The sequence id of the message
+    uint64_t sequence_id() const;
+    void set_sequence_id(uint64_t sequence_id);
+
+    // Extend the message with a payload of the given size, already written in the space of the arguments
+    void extend(uint32_t num_bytes);
+
     // Get the given argument
     template<typename T = uint64_t>
     T get(int index) const;
@@ -158,6 +183,29 @@ static uint64_t store_args(char* buffer, T first, Args... rest){
     return offset + store_args(buffer + offset, rest...);
 }
 
+// Compute the space required by the arguments, as in #store_args
+template<typename T>
+static typename std::enable_if_t< std::is_arithmetic_v<T>, uint64_t >
+size_single_arg(T arg){
+    return sizeof(uint64_t);
+}
+
+inline static uint64_t
+size_single_arg(const char* str){
+    uint64_t length = (str == nullptr) ? 0 : strlen(str);
+    return sizeof(uint64_t) + sizeof(uint64_t) * ((length + sizeof(uint64_t) -1) / sizeof(uint64_t));
+}
+
+inline static uint64_t
+size_single_arg(const std::string& str){
+    return size_single_arg(str.c_str());
+}
+
+template<typename... Args>
+static uint64_t size_args(Args... args){
+    return (0 + ... + size_single_arg(args));
+}
+
 template<typename TSigned>
 static typename std::enable_if_t< std::is_integral_v<TSigned> && std::is_signed_v<TSigned>, TSigned > retrieve_single_arg(const char* buffer){
     return static_cast<TSigned>(reinterpret_cast<const int64_t*>(buffer)[0]);
@@ -178,10 +226,16 @@ static typename std::enable_if_t< std::is_floating_point_v<TFloat>, TFloat > ret
 // Implementation details
 template<typename Type>
 template<typename... Args>
-Message<Type>::Message(Type type, Args... args) : m_message_size(sizeof(Message<Type>)), m_type(type){
+Message<Type>::Message(Type type, Args... args) : m_message_size(sizeof(Message<Type>)), m_type(type), m_sequence_id(0){
     m_message_size += details::store_args(buffer(), args...);
 }
 
+template<typename Type>
+template<typename... Args>
+size_t Message<Type>::compute_size(Args... args){
+    return sizeof(Message<Type>) + details::size_args(args...);
+}
+
 
 template<typename Type>
 int Message<Type>::num_arguments() const {
@@ -198,6 +252,21 @@ Type Message<Type>::type() const {
     return m_type;
 }
 
+template<typename Type>
+uint64_t Message<Type>::sequence_id() const {
+    return m_sequence_id;
+}
+
+template<typename Type>
+void Message<Type>::set_sequence_id(uint64_t sequence_id) {
+    m_sequence_id = sequence_id;
+}
+
+template<typename Type>
+void Message<Type>::extend(uint32_t num_bytes) {
+    m_message_size += num_bytes;
+}
+
 template<typename Type>
 const char* Message<Type>::buffer() const{
     return reinterpret_cast<const char*>(this) + sizeof(Message<Type>);
@@ -0,0 +1,375 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "partitioned_client.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+#include "utility/result_writer.hpp"
+#include "internal.hpp"
+#include "result_frame.hpp"
+
+using namespace std;
+
+namespace gfe::network {
+
+/*****************************************************************************
+ *                                                                           *
+ * Initialisation                                                            *
+ *                                                                           *
+ *****************************************************************************/
+
+PartitionedClient::PartitionedClient(const vector<pair<string, int>>& servers, uint64_t max_in_flight, bool shared_memory) : m_vertices(new VertexShard[num_vertex_shards]) {
+    if(servers.empty()) ERROR("No servers given");
+    for(const auto& server : servers){
+        m_partitions.emplace_back(new Client(server.first, server.second, max_in_flight, shared_memory));
+    }
+
+    m_is_directed = m_partitions[0]->is_directed();
+    for(uint64_t i = 1; i < m_partitions.size(); i++){
+        if(m_partitions[i]->is_directed() != m_is_directed){
+            ERROR("The server " << servers[i].first << ":" << servers[i].second << " hosts a " << (m_is_directed ? "undirected" : "directed") << " graph, while the server " << servers[0].first << ":" << servers[0].second << " does not");
+        }
+    }
+}
+
+PartitionedClient::~PartitionedClient(){
+    // the clients disconnect on their own
+}
+
+uint64_t PartitionedClient::num_partitions() const {
+    return m_partitions.size();
+}
+
+void PartitionedClient::terminate_servers_on_exit(){
+    for(auto& p : m_partitions){ p->terminate_server_on_exit(); }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Partitioning                                                              *
+ *                                                                           *
+ *****************************************************************************/
+
+uint64_t PartitionedClient::partition_id(uint64_t vertex_id) const {
+    // Fibonacci hashing, so that consecutive vertex IDs are spread over all partitions
+    return ((vertex_id * 0x9E3779B97F4A7C15ull) >> 32) % m_partitions.size();
+}
+
+Client* PartitionedClient::partition(uint64_t vertex_id) const {
+    return m_partitions[partition_id(vertex_id)].get();
+}
+
+Client* PartitionedClient::partition(uint64_t source, uint64_t destination) const {
+    return partition(m_is_directed ? source : min(source, destination));
+}
+
+bool PartitionedClient::register_vertex(uint64_t vertex_id){
+    VertexShard& shard = m_vertices[vertex_id % num_vertex_shards];
+    scoped_lock<mutex> lock(shard.m_mutex);
+    return shard.m_vertices.insert(vertex_id).second;
+}
+
+bool PartitionedClient::unregister_vertex(uint64_t vertex_id){
+    VertexShard& shard = m_vertices[vertex_id % num_vertex_shards];
+    scoped_lock<mutex> lock(shard.m_mutex);
+    return shard.m_vertices.erase(vertex_id) > 0;
+}
+
+bool PartitionedClient::is_registered(uint64_t vertex_id) const {
+    VertexShard& shard = m_vertices[vertex_id % num_vertex_shards];
+    scoped_lock<mutex> lock(shard.m_mutex);
+    return shard.m_vertices.count(vertex_id) > 0;
+}
+
+vector<uint64_t> PartitionedClient::registered_vertices() const {
+    vector<uint64_t> result;
+    for(uint64_t i = 0; i < num_vertex_shards; i++){
+        scoped_lock<mutex> lock(m_vertices[i].m_mutex);
+        result.insert(result.end(), m_vertices[i].m_vertices.begin(), m_vertices[i].m_vertices.end());
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Updates                                                                   *
+ *                                                                           *
+ *****************************************************************************/
+
+bool PartitionedClient::add_vertex(uint64_t vertex_id){
+    bool result = partition(vertex_id)->add_vertex(vertex_id);
+    if(result){ register_vertex(vertex_id); }
+    return result;
+}
+
+bool PartitionedClient::remove_vertex(uint64_t vertex_id){
+    // the other servers may store some edges of the vertex, with the vertex as a ghost. Ignore their outcome, as the ghost
+    // only exists if the server stores at least one of its edges
+    Client* owner = partition(vertex_id);
+    bool result = false;
+    for(auto& p : m_partitions){
+        bool removed = p->remove_vertex(vertex_id);
+        if(p.get() == owner){ result = removed; }
+    }
+    if(result){ unregister_vertex(vertex_id); }
+    return result;
+}
+
+bool PartitionedClient::add_edge(graph::WeightedEdge e){
+    if(!is_registered(e.source()) || !is_registered(e.destination())) return false;
+    // the endpoint owned by another server is created as a ghost in the server storing the edge
+    return partition(e.source(), e.destination())->add_edge_v2(e);
+}
+
+bool PartitionedClient::add_edge_v2(graph::WeightedEdge e){
+    if(register_vertex(e.source())){ partition(e.source())->add_vertex(e.source()); }
+    if(register_vertex(e.destination())){ partition(e.destination())->add_vertex(e.destination()); }
+    return partition(e.source(), e.destination())->add_edge_v2(e);
+}
+
+bool PartitionedClient::remove_edge(graph::Edge e){
+    return partition(e.source(), e.destination())->remove_edge(e);
+}
+
+uint64_t PartitionedClient::flush(){
+    uint64_t num_failed_updates = 0;
+    for(auto& p : m_partitions){ num_failed_updates += p->flush(); }
+    return num_failed_updates;
+}
+
+void PartitionedClient::build(){
+    for(auto& p : m_partitions){ p->build(); }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Properties                                                                *
+ *                                                                           *
+ *****************************************************************************/
+
+void PartitionedClient::on_main_init(int num_threads){
+    for(auto& p : m_partitions){ p->on_main_init(num_threads); }
+}
+
+void PartitionedClient::on_thread_init(int thread_id){
+    for(auto& p : m_partitions){ p->on_thread_init(thread_id); }
+}
+
+void PartitionedClient::on_thread_destroy(int thread_id){
+    for(auto& p : m_partitions){ p->on_thread_destroy(thread_id); }
+}
+
+void PartitionedClient::on_main_destroy(){
+    for(auto& p : m_partitions){ p->on_main_destroy(); }
+}
+
+uint64_t PartitionedClient::num_edges() const {
+    uint64_t result = 0;
+    for(auto& p : m_partitions){ result += p->num_edges(); } // each edge is stored by only one server
+    return result;
+}
+
+uint64_t PartitionedClient::num_vertices() const {
+    uint64_t result = 0;
+    for(uint64_t i = 0; i < num_vertex_shards; i++){
+        scoped_lock<mutex> lock(m_vertices[i].m_mutex);
+        result += m_vertices[i].m_vertices.size();
+    }
+    return result;
+}
+
+bool PartitionedClient::is_directed() const {
+    return m_is_directed;
+}
+
+bool PartitionedClient::has_vertex(uint64_t vertex_id) const {
+    return partition(vertex_id)->has_vertex(vertex_id);
+}
+
+bool PartitionedClient::has_edge(uint64_t source, uint64_t destination) const {
+    return partition(source, destination)->has_edge(source, destination);
+}
+
+double PartitionedClient::get_weight(uint64_t source, uint64_t destination) const {
+    return partition(source, destination)->get_weight(source, destination);
+}
+
+void PartitionedClient::set_timeout(uint64_t seconds){
+    for(auto& p : m_partitions){ p->set_timeout(seconds); }
+}
+
+void PartitionedClient::dump_ostream(std::ostream& out) const {
+    ERROR("OPERATION NOT SUPPORTED: the output stream is only local");
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * BSP                                                                       *
+ *                                                                           *
+ *****************************************************************************/
+
+template<typename Visitor>
+void PartitionedClient::superstep(RequestType type, const vector<uint64_t>& vertices, const vector<uint64_t>& values, Visitor&& visitor){
+    assert(vertices.size() == values.size());
+    const uint64_t num_partitions = m_partitions.size();
+
+    // the vertices to send to each server
+    vector<vector<uint64_t>> partition_vertices, partition_values;
+    if(m_is_directed){ // only the owner stores the outgoing edges of a vertex
+        partition_vertices.resize(num_partitions);
+        partition_values.resize(num_partitions);
+        for(uint64_t i = 0; i < vertices.size(); i++){
+            uint64_t p = partition_id(vertices[i]);
+            partition_vertices[p].push_back(vertices[i]);
+            partition_values[p].push_back(values[i]);
+        }
+    }
+    auto input_vertices = [&](uint64_t p) -> const vector<uint64_t>& { return m_is_directed ? partition_vertices[p] : vertices; };
+    auto input_values = [&](uint64_t p) -> const vector<uint64_t>& { return m_is_directed ? partition_values[p] : values; };
+
+    // in each round, send at most a frame to each server, so that all servers work at the same time
+    uint64_t num_rounds = 0;
+    for(uint64_t p = 0; p < num_partitions; p++){
+        num_rounds = max(num_rounds, (input_vertices(p).size() + RESULT_FRAME_MAX_NUM_ENTRIES -1) / RESULT_FRAME_MAX_NUM_ENTRIES);
+    }
+    vector<uint64_t> output_vertices, output_values;
+    for(uint64_t round = 0; round < num_rounds; round++){
+        const uint64_t start = round * RESULT_FRAME_MAX_NUM_ENTRIES;
+        for(uint64_t p = 0; p < num_partitions; p++){
+            if(start >= input_vertices(p).size()) continue;
+            uint64_t num_entries = min(RESULT_FRAME_MAX_NUM_ENTRIES, input_vertices(p).size() - start);
+            m_partitions[p]->scatter_send(type, input_vertices(p).data() + start, input_values(p).data() + start, num_entries);
+        }
+        for(uint64_t p = 0; p < num_partitions; p++){
+            if(start >= input_vertices(p).size()) continue;
+            output_vertices.clear();
+            output_values.clear();
+            m_partitions[p]->scatter_receive(output_vertices, output_values);
+            for(uint64_t i = 0; i < output_vertices.size(); i++){
+                visitor(output_vertices[i], output_values[i]);
+            }
+        }
+    }
+}
+
+void PartitionedClient::bfs(uint64_t source_vertex_id, const char* dump2file){
+    unordered_map<uint64_t, int64_t> distances;
+    distances[source_vertex_id] = 0;
+    vector<uint64_t> frontier { source_vertex_id };
+    vector<uint64_t> values;
+    vector<uint64_t> next;
+
+    for(int64_t distance = 1; !frontier.empty(); distance++){
+        values.assign(frontier.size(), distance);
+        next.clear();
+        superstep(RequestType::SCATTER_MIN, frontier, values, [&](uint64_t vertex, uint64_t /* distance */){
+            if(distances.try_emplace(vertex, distance).second){ next.push_back(vertex); }
+        });
+        frontier.swap(next);
+    }
+
+    if(dump2file != nullptr){
+        vector<uint64_t> vertices = registered_vertices();
+        vector<pair<uint64_t, int64_t>> results(vertices.size());
+        for(uint64_t i = 0; i < vertices.size(); i++){
+            auto it = distances.find(vertices[i]);
+            results[i] = make_pair(vertices[i], it != distances.end() ? it->second : -1);
+        }
+        utility::save_results(results, dump2file, /* negative scores ? */ false);
+    }
+}
+
+void PartitionedClient::pagerank(uint64_t num_iterations, double damping_factor, const char* dump2file){
+    const vector<uint64_t> vertices = registered_vertices();
+    const uint64_t num_vertices = vertices.size();
+    unordered_map<uint64_t, uint64_t> vertex2index;
+    for(uint64_t i = 0; i < num_vertices; i++){ vertex2index[vertices[i]] = i; }
+
+    // the out-degree of each vertex, summed over all servers
+    vector<uint64_t> degrees(num_vertices, 0);
+    superstep(RequestType::SCATTER_DEGREE, vertices, vector<uint64_t>(num_vertices, 0), [&](uint64_t vertex, uint64_t degree){
+        auto it = vertex2index.find(vertex);
+        if(it != vertex2index.end()){ degrees[it->second] += degree; }
+    });
+
+    const double base_score = (1.0 - damping_factor) / num_vertices;
+    vector<double> scores(num_vertices, 1.0 / num_vertices);
+    vector<double> incoming(num_vertices);
+    vector<uint64_t> sources, contributions;
+    for(uint64_t iteration = 0; iteration < num_iterations; iteration++){
+        // the contribution of each vertex to its outgoing neighbours, the sinks spread their score over all vertices
+        double dangling_sum = 0.0;
+        sources.clear();
+        contributions.clear();
+        for(uint64_t i = 0; i < num_vertices; i++){
+            if(degrees[i] == 0){
+                dangling_sum += scores[i];
+            } else {
+                double contribution = scores[i] / degrees[i];
+                uint64_t bits;
+                memcpy(&bits, &contribution, sizeof(bits));
+                sources.push_back(vertices[i]);
+                contributions.push_back(bits);
+            }
+        }
+        dangling_sum /= num_vertices;
+
+        fill(incoming.begin(), incoming.end(), 0.0);
+        superstep(RequestType::SCATTER_SUM, sources, contributions, [&](uint64_t vertex, uint64_t bits){
+            auto it = vertex2index.find(vertex);
+            if(it != vertex2index.end()){
+                double sum;
+                memcpy(&sum, &bits, sizeof(sum));
+                incoming[it->second] += sum;
+            }
+        });
+
+        for(uint64_t i = 0; i < num_vertices; i++){
+            scores[i] = base_score + damping_factor * (incoming[i] + dangling_sum);
+        }
+    }
+
+    if(dump2file != nullptr){
+        vector<pair<uint64_t, double>> results(num_vertices);
+        for(uint64_t i = 0; i < num_vertices; i++){ results[i] = make_pair(vertices[i], scores[i]); }
+        utility::save_results(results, dump2file);
+    }
+}
+
+void PartitionedClient::wcc(const char* dump2file){
+    ERROR("wcc: operation not supported by the partitioned client, only BFS and PageRank are executed as BSP");
+}
+
+void PartitionedClient::cdlp(uint64_t max_iterations, const char* dump2file){
+    ERROR("cdlp: operation not supported by the partitioned client, only BFS and PageRank are executed as BSP");
+}
+
+void PartitionedClient::lcc(const char* dump2file){
+    ERROR("lcc: operation not supported by the partitioned client, only BFS and PageRank are executed as BSP");
+}
+
+void PartitionedClient::sssp(uint64_t source_vertex_id, const char* dump2file){
+    ERROR("sssp: operation not supported by the partitioned client, only BFS and PageRank are executed as BSP");
+}
+
+} // namespace
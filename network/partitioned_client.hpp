@@ -0,0 +1,174 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "library/interface.hpp"
+#include "client.hpp"
+
+namespace gfe::network {
+
+/**
+ * A client for a graph partitioned across multiple servers (gfe_server), each hosting its own instance of the library,
+ * e.g. one server on each NUMA node of the same host (see the parameter numa_node of the Server).
+ *
+ * The vertices are hash-partitioned: each vertex is owned by exactly one server. Each edge is stored only by the server
+ * owning its source, with the destination implicitly created as a ghost vertex in that server. In undirected graphs, the
+ * source of an edge is the endpoint with the smallest ID, so that both directions are routed to the same server.
+ *
+ * BFS and PageRank are executed as a sequence of supersteps (BSP), coordinated by the client. In each superstep, the
+ * client sends the active vertices to the servers storing their edges: the owner of the vertex in directed graphs,
+ * all servers in undirected graphs. Each server visits the neighbours of those vertices and sends back the aggregated
+ * values for each neighbour. All servers process a superstep at the same time, while the client merges the results.
+ * The other Graphalytics kernels are not supported.
+ *
+ * The client keeps track of the vertices inserted, to count them and to report the results for all of them. With
+ * pipelined updates (max_in_flight > 1), a vertex is registered even if its insertion eventually fails. The removal of
+ * a vertex is sent to all servers, as any of them may store some of its edges, with the vertex as a ghost. Only the
+ * outcome from its owner is reported.
+ *
+ * As the Client, the class is thread-safe only if different threads access it with a different worker_id, previously
+ * set through #on_thread_init(int worker_id).
+ */
+class PartitionedClient : public virtual library::UpdateInterface, public virtual library::GraphalyticsInterface {
+    PartitionedClient(const PartitionedClient&) = delete;
+    PartitionedClient& operator=(const PartitionedClient&) = delete;
+
+    std::vector<std::unique_ptr<Client>> m_partitions; // one client for each server
+    bool m_is_directed; // whether the graph is directed
+
+    // The vertices inserted so far, split in shards to reduce the contention among the workers
+    struct alignas(64) VertexShard {
+        std::mutex m_mutex; // sync the workers
+        std::unordered_set<uint64_t> m_vertices; // the vertices in the shard
+    };
+    static constexpr uint64_t num_vertex_shards = 64;
+    std::unique_ptr<VertexShard[]> m_vertices;
+
+    /**
+     * Retrieve the index of the server owning the given vertex
+     */
+    uint64_t partition_id(uint64_t vertex_id) const;
+
+    /**
+     * Retrieve the server owning the given vertex
+     */
+    Client* partition(uint64_t vertex_id) const;
+
+    /**
+     * Retrieve the server storing the given edge
+     */
+    Client* partition(uint64_t source, uint64_t destination) const;
+
+    /**
+     * Record the given vertex as inserted
+     * @return true if the vertex was not already recorded, false otherwise
+     */
+    bool register_vertex(uint64_t vertex_id);
+
+    /**
+     * Forget the given vertex
+     * @return true if the vertex was recorded, false otherwise
+     */
+    bool unregister_vertex(uint64_t vertex_id);
+
+    /**
+     * Check whether the given vertex has been recorded
+     */
+    bool is_registered(uint64_t vertex_id) const;
+
+    /**
+     * Retrieve all vertices recorded, sorted by their ID
+     */
+    std::vector<uint64_t> registered_vertices() const;
+
+    /**
+     * Execute a superstep on all servers: send the pairs <vertex, value> to the servers storing the edges of the vertex
+     * and invoke visitor(vertex, aggregate) for each aggregate received. The same vertex can be reported by more servers.
+     */
+    template<typename Visitor>
+    void superstep(RequestType type, const std::vector<uint64_t>& vertices, const std::vector<uint64_t>& values, Visitor&& visitor);
+
+public:
+    /**
+     * Connect to the given servers. All servers must host an empty instance of the same library.
+     * @param servers the host and port of each server, one for each partition
+     * @param max_in_flight the max number of updates to pipeline on each connection, 0 = the value of the option --client_max_in_flight
+     * @param shared_memory whether to exchange the messages over shared memory. The servers must be on the same host.
+     */
+    PartitionedClient(const std::vector<std::pair<std::string, int>>& servers, uint64_t max_in_flight = 0, bool shared_memory = false);
+
+    /**
+     * Destructor
+     */
+    ~PartitionedClient();
+
+    /**
+     * The number of partitions, i.e. servers
+     */
+    uint64_t num_partitions() const;
+
+    /**
+     * Terminate all servers when the client ends
+     */
+    void terminate_servers_on_exit();
+
+    /**
+     * Wait for the responses of all updates in flight for the current worker, on all servers
+     * @return the number of pipelined updates that returned false since the last invocation
+     */
+    uint64_t flush();
+
+    /**
+     * Operation not supported: the output stream is only local
+     */
+    virtual void dump_ostream(std::ostream& out) const override;
+
+    // Proxy to the rest of the functions in the library
+    virtual void on_main_init(int num_threads) override;
+    virtual void on_thread_init(int thread_id) override;
+    virtual void on_thread_destroy(int thread_id) override;
+    virtual void on_main_destroy() override;
+    virtual uint64_t num_edges() const override;
+    virtual uint64_t num_vertices() const override;
+    virtual bool is_directed() const override;
+    virtual bool has_vertex(uint64_t vertex_id) const override;
+    virtual bool has_edge(uint64_t source, uint64_t destination) const override;
+    virtual double get_weight(uint64_t source, uint64_t destination) const override;
+    virtual bool add_vertex(uint64_t vertex_id) override;
+    virtual bool remove_vertex(uint64_t vertex_id) override;
+    virtual bool add_edge(graph::WeightedEdge e) override;
+    virtual bool add_edge_v2(graph::WeightedEdge e) override;
+    virtual bool remove_edge(graph::Edge e) override;
+    virtual void build() override;
+    virtual void set_timeout(uint64_t seconds) override;
+    virtual void bfs(uint64_t source_vertex_id, const char* dump2file = nullptr) override; // BSP
+    virtual void pagerank(uint64_t num_iterations, double damping_factor = 0.85, const char* dump2file = nullptr) override; // BSP
+    virtual void wcc(const char* dump2file = nullptr) override; // not supported
+    virtual void cdlp(uint64_t max_iterations, const char* dump2file = nullptr) override; // not supported
+    virtual void lcc(const char* dump2file = nullptr) override; // not supported
+    virtual void sssp(uint64_t source_vertex_id, const char* dump2file = nullptr) override; // not supported
+};
+
+} // namespace
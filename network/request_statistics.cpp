@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "request_statistics.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+
+namespace gfe::network {
+
+RequestStatistics::RequestStatistics(){ }
+
+// Add the given amount to a counter with a single writer, without a read-modify-write
+static void increment(atomic<uint64_t>& counter, uint64_t amount){
+    counter.store(counter.load(memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+void RequestStatistics::record(RequestType type, Phase phase, chrono::nanoseconds latency){
+    assert(static_cast<uint32_t>(type) < num_request_types && "Invalid request type");
+    Histogram& histogram = m_histograms[static_cast<uint32_t>(type)][static_cast<int>(phase)];
+    const uint64_t value = max<int64_t>(0, latency.count());
+    const int bucket = value == 0 ? 0 : 63 - __builtin_clzll(value);
+
+    increment(histogram.m_count, 1);
+    increment(histogram.m_sum, value);
+    increment(histogram.m_buckets[bucket], 1);
+    if(value > histogram.m_max.load(memory_order_relaxed)){ histogram.m_max.store(value, memory_order_relaxed); }
+}
+
+void RequestStatistics::merge(const RequestStatistics& other){
+    for(uint32_t type = 0; type < num_request_types; type++){
+        for(int phase = 0; phase < num_phases; phase++){
+            Histogram& histogram = m_histograms[type][phase];
+            const Histogram& source = other.m_histograms[type][phase];
+            increment(histogram.m_count, source.m_count.load(memory_order_relaxed));
+            increment(histogram.m_sum, source.m_sum.load(memory_order_relaxed));
+            for(int i = 0; i < num_buckets; i++){ increment(histogram.m_buckets[i], source.m_buckets[i].load(memory_order_relaxed)); }
+            histogram.m_max.store(max(histogram.m_max.load(memory_order_relaxed), source.m_max.load(memory_order_relaxed)), memory_order_relaxed);
+        }
+    }
+}
+
+void RequestStatistics::reset(){
+    for(auto& histograms : m_histograms){
+        for(auto& histogram : histograms){
+            histogram.m_count = 0;
+            histogram.m_sum = 0;
+            histogram.m_max = 0;
+            for(auto& bucket : histogram.m_buckets){ bucket = 0; }
+        }
+    }
+}
+
+bool RequestStatistics::empty() const {
+    for(auto& histograms : m_histograms){
+        if(histograms[static_cast<int>(Phase::LIBRARY)].m_count.load(memory_order_relaxed) > 0) return false;
+    }
+    return true;
+}
+
+uint64_t RequestStatistics::Histogram::percentile(double p) const {
+    const uint64_t count = m_count.load(memory_order_relaxed);
+    if(count == 0) return 0;
+    const uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(p * count + 0.5));
+    uint64_t cumulative = 0;
+    for(int i = 0; i < num_buckets; i++){
+        cumulative += m_buckets[i].load(memory_order_relaxed);
+        if(cumulative >= rank){
+            return min(m_max.load(memory_order_relaxed), (uint64_t) (i < 63 ? (2ull << i) - 1 : numeric_limits<uint64_t>::max()));
+        }
+    }
+    return m_max.load(memory_order_relaxed); // counters updated concurrently
+}
+
+void RequestStatistics::dump(ostream& out) const {
+    static const char* phase_names[num_phases] = { "queue", "library", "send" };
+    for(uint32_t type = 0; type < num_request_types; type++){
+        const auto& histograms = m_histograms[type];
+        if(histograms[static_cast<int>(Phase::LIBRARY)].m_count.load(memory_order_relaxed) == 0) continue;
+
+        out << "[server] " << static_cast<RequestType>(type) << ", requests: " << histograms[static_cast<int>(Phase::LIBRARY)].m_count.load(memory_order_relaxed);
+        for(int phase = 0; phase < num_phases; phase++){
+            const Histogram& h = histograms[phase];
+            const uint64_t count = h.m_count.load(memory_order_relaxed);
+            out << ", " << phase_names[phase] << " [";
+            if(phase == static_cast<int>(Phase::SEND)){ out << "count: " << count << ", "; }
+            out << "mean: " << (count > 0 ? h.m_sum.load(memory_order_relaxed) / count : 0) << " ns, "
+                   "p50: " << h.percentile(0.5) << " ns, p99: " << h.percentile(0.99) << " ns, max: " << h.m_max.load(memory_order_relaxed) << " ns]";
+        }
+        out << "\n";
+    }
+}
+
+string RequestStatistics::to_string() const {
+    stringstream ss;
+    dump(ss);
+    return ss.str();
+}
+
+ostream& operator<<(ostream& out, const RequestStatistics& statistics){
+    statistics.dump(out);
+    return out;
+}
+
+} // namespace
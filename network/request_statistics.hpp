@@ -0,0 +1,93 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <ostream>
+#include <string>
+
+#include "message.hpp"
+
+namespace gfe::network {
+
+/**
+ * The latencies of the requests processed by a server, for each type of request. Each request is split in three phases:
+ * - queue: from when the request was received in full, to when a worker started processing it. It includes the time
+ *   spent behind the requests of the same connection received earlier;
+ * - library: the time spent to process the request, i.e. to decode it and invoke the library;
+ * - send: the time spent to send the responses to the client. The responses are coalesced, the time of each send is
+ *   attributed to the last request processed before it.
+ *
+ * The latencies are recorded in histograms with power of 2 buckets: the percentiles reported are the upper bound of
+ * their bucket, i.e. they are accurate up to a factor of 2.
+ *
+ * An instance is updated by a single thread, e.g. each worker of the server keeps its own, so that recording a latency
+ * does not need any atomic read-modify-write. The counters are atomics only to be read at the same time by the other
+ * threads, to merge the instances of all workers into a report (#merge).
+ */
+class RequestStatistics {
+    RequestStatistics(const RequestStatistics&) = delete;
+    RequestStatistics& operator=(const RequestStatistics&) = delete;
+
+public:
+    enum class Phase { QUEUE, LIBRARY, SEND };
+    constexpr static int num_phases = 3;
+
+private:
+    constexpr static int num_buckets = 64; // the bucket i counts the latencies in [2^i, 2^(i+1)) nanosecs
+
+    struct Histogram {
+        std::atomic<uint64_t> m_count { 0 }; // number of latencies recorded
+        std::atomic<uint64_t> m_sum { 0 }; // sum of the latencies, in nanosecs
+        std::atomic<uint64_t> m_max { 0 }; // max latency recorded, in nanosecs
+        std::atomic<uint64_t> m_buckets[num_buckets] {}; // distribution of the latencies
+
+        // Retrieve the given percentile, in [0, 1], in nanosecs
+        uint64_t percentile(double p) const;
+    };
+
+    Histogram m_histograms[num_request_types][num_phases];
+
+public:
+    // Initialise an empty instance
+    RequestStatistics();
+
+    // Record the latency of the given phase of a request. Only invoked by the thread owning the instance.
+    void record(RequestType type, Phase phase, std::chrono::nanoseconds latency);
+
+    // Add the latencies recorded by another instance, possibly still being updated by its owner
+    void merge(const RequestStatistics& other);
+
+    // Reset all counters. Only invoked by the thread owning the instance.
+    void reset();
+
+    // Check whether no request has been recorded
+    bool empty() const;
+
+    // Print the statistics of all requests recorded, one line for each type of request
+    void dump(std::ostream& out) const;
+
+    // Retrieve the output of #dump as a string
+    std::string to_string() const;
+};
+
+std::ostream& operator<<(std::ostream& out, const RequestStatistics& statistics);
+
+} // namespace
@@ -0,0 +1,107 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "result_frame.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <zlib.h>
+
+#include "internal.hpp"
+
+using namespace std;
+
+namespace gfe::network {
+
+namespace {
+
+struct FrameHeader {
+    uint32_t m_num_entries; // number of entries in the frame
+    uint32_t m_payload_sz; // size of the columns that follow, in bytes
+};
+static_assert(sizeof(FrameHeader) == 8);
+
+constexpr uint64_t ENTRY_SZ = 2 * sizeof(uint64_t); // vertex ID and value
+
+// Round up to a multiple of 8 bytes
+uint64_t align8(uint64_t value){
+    return (value + 7) & ~(uint64_t) 7;
+}
+
+} // anon namespace
+
+uint64_t result_frame_max_size(uint64_t num_entries){
+    uint64_t raw_sz = num_entries * ENTRY_SZ;
+    return align8(sizeof(FrameHeader) + max<uint64_t>(raw_sz, compressBound(raw_sz)));
+}
+
+uint64_t encode_result_frame(const uint64_t* vertices, const uint64_t* values, uint64_t num_entries, bool compress, char* output, vector<uint64_t>& scratch){
+    assert(num_entries <= RESULT_FRAME_MAX_NUM_ENTRIES && "Too many entries for a single frame");
+    FrameHeader* header = reinterpret_cast<FrameHeader*>(output);
+    char* payload = output + sizeof(FrameHeader);
+    const uint64_t column_sz = num_entries * sizeof(uint64_t);
+    const uint64_t raw_sz = num_entries * ENTRY_SZ;
+    header->m_num_entries = num_entries;
+    header->m_payload_sz = raw_sz;
+
+    if(!compress){
+        memcpy(payload, vertices, column_sz);
+        memcpy(payload + column_sz, values, column_sz);
+    } else {
+        scratch.resize(2 * num_entries);
+        memcpy(scratch.data(), vertices, column_sz);
+        memcpy(scratch.data() + num_entries, values, column_sz);
+        uLongf compressed_sz = compressBound(raw_sz);
+        int rc = compress2(reinterpret_cast<Bytef*>(payload), &compressed_sz, reinterpret_cast<const Bytef*>(scratch.data()), raw_sz, Z_BEST_SPEED);
+        if(rc != Z_OK) ERROR("Cannot compress the frame of results, zlib error code: " << rc);
+        if(compressed_sz < raw_sz){
+            header->m_payload_sz = compressed_sz;
+        } else { // not worth it
+            memcpy(payload, scratch.data(), raw_sz);
+        }
+    }
+
+    uint64_t frame_sz = sizeof(FrameHeader) + header->m_payload_sz;
+    memset(output + frame_sz, 0, align8(frame_sz) - frame_sz); // padding
+    return align8(frame_sz);
+}
+
+void decode_result_frame(const char* input, uint64_t input_sz, vector<uint64_t>& vertices, vector<uint64_t>& values, vector<uint64_t>& scratch){
+    if(input_sz < sizeof(FrameHeader)) ERROR("Invalid frame of results, size: " << input_sz << " bytes");
+    const FrameHeader* header = reinterpret_cast<const FrameHeader*>(input);
+    const char* payload = input + sizeof(FrameHeader);
+    const uint64_t num_entries = header->m_num_entries;
+    const uint64_t raw_sz = num_entries * ENTRY_SZ;
+    if(num_entries > RESULT_FRAME_MAX_NUM_ENTRIES || sizeof(FrameHeader) + header->m_payload_sz > input_sz){
+        ERROR("Invalid frame of results, num entries: " << num_entries << ", payload size: " << header->m_payload_sz << ", frame size: " << input_sz);
+    }
+
+    const uint64_t* columns = reinterpret_cast<const uint64_t*>(payload);
+    if(header->m_payload_sz != raw_sz){ // compressed
+        scratch.resize(2 * num_entries);
+        uLongf decompressed_sz = raw_sz;
+        int rc = uncompress(reinterpret_cast<Bytef*>(scratch.data()), &decompressed_sz, reinterpret_cast<const Bytef*>(payload), header->m_payload_sz);
+        if(rc != Z_OK || decompressed_sz != raw_sz) ERROR("Cannot decompress the frame of results, zlib error code: " << rc);
+        columns = scratch.data();
+    }
+
+    vertices.insert(vertices.end(), columns, columns + num_entries);
+    values.insert(values.end(), columns + num_entries, columns + 2 * num_entries);
+}
+
+} // namespace
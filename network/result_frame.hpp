@@ -0,0 +1,65 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <vector>
+
+namespace gfe::network {
+
+/**
+ * A frame of results of a graphalytics kernel, the payload of the responses RESULT_FRAME. When the client asks for
+ * the results in its own file system, the server streams them back as a sequence of frames with at most
+ * RESULT_FRAME_MAX_NUM_ENTRIES entries each, so that the client can decode a frame while the next one is transferred.
+ *
+ * The entries are encoded in two columns: first all vertex IDs, then all values, each as an array of 8-byte words.
+ * The values are stored bitwise, the receiver knows their type (int64_t, uint64_t or double) from the kernel requested.
+ * As the frames of edges, the columns are optionally compressed with zlib. A frame starts with a header of two
+ * uint32_t: the number of entries and the size of the payload that follows, in bytes. The payload is compressed iff
+ * its size differs from num_entries * 16. The frame is padded to a multiple of 8 bytes.
+ */
+constexpr uint64_t RESULT_FRAME_MAX_NUM_ENTRIES = 1ull << 16; // 1 MB uncompressed
+
+/**
+ * Retrieve an upper bound to the size of a frame with the given number of entries, in bytes
+ */
+uint64_t result_frame_max_size(uint64_t num_entries);
+
+/**
+ * Encode the given results as a frame
+ * @param vertices the column of the vertex IDs
+ * @param values the column of the values, bitwise
+ * @param num_entries the number of entries, at most RESULT_FRAME_MAX_NUM_ENTRIES
+ * @param compress whether to compress the columns. If the compressed columns are not smaller, they are stored as they are.
+ * @param output where to store the frame, with a capacity of at least result_frame_max_size(num_entries) bytes
+ * @param scratch space to stage the columns before compressing them
+ * @return the size of the frame, in bytes, including the padding
+ */
+uint64_t encode_result_frame(const uint64_t* vertices, const uint64_t* values, uint64_t num_entries, bool compress, char* output, std::vector<uint64_t>& scratch);
+
+/**
+ * Decode a frame of results
+ * @param input the frame
+ * @param input_sz the size of the frame, in bytes
+ * @param vertices the entries decoded are appended to this vector
+ * @param values the values decoded are appended to this vector, bitwise
+ * @param scratch space to stage the decompressed columns
+ */
+void decode_result_frame(const char* input, uint64_t input_sz, std::vector<uint64_t>& vertices, std::vector<uint64_t>& values, std::vector<uint64_t>& scratch);
+
+} // namespace
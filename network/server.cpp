@@ -17,23 +17,39 @@
 
 #include "server.hpp"
 
+#include <algorithm>
 #include <arpa/inet.h> // inet_ntoa
 #include <cassert>
 #include <cstring>
 #include <netinet/ip.h> // TCP/IP protocol
+#include <netinet/tcp.h> // TCP_NODELAY
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <linux/errqueue.h> // MSG_ZEROCOPY notifications
+#if defined(HAVE_LIBNUMA)
+#include <numa.h>
+#endif
+#include <poll.h>
 #include <signal.h>
+#include <streambuf>
+#include <sys/epoll.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <unistd.h>
 
 #include "common/filesystem.hpp"
 #include "common/system.hpp"
+#include "common/timer.hpp"
 #include "graph/edge.hpp"
 #include "library/interface.hpp"
 #include "configuration.hpp"
 #include "internal.hpp"
 #include "message.hpp"
+#include "result_frame.hpp"
 
 using namespace std;
 
@@ -100,7 +116,16 @@ static void signal_handler_uninstall(){
  *                                                                           *
  *****************************************************************************/
 
-Server::Server(shared_ptr<library::Interface> interface, int port) : m_interface(interface), m_port(port){
+Server::Server(shared_ptr<library::Interface> interface, int port, int num_io_threads, int num_workers, int numa_node) :
+        m_interface(interface), m_port(port), m_num_io_threads(num_io_threads),
+        m_num_workers(num_workers > 0 ? num_workers : max<int>(1, thread::hardware_concurrency())), m_numa_node(numa_node){
+    if(m_num_io_threads <= 0) ERROR("Invalid number of I/O threads: " << m_num_io_threads);
+#if !defined(HAVE_LIBNUMA)
+    if(m_numa_node >= 0) ERROR("Cannot bind the server to the NUMA node " << m_numa_node << ", dependency on libnuma missing");
+#else
+    if(m_numa_node >= 0 && numa_available() < 0) ERROR("Cannot bind the server to the NUMA node " << m_numa_node << ", a call to numa_available() returns a negative value (=> NUMA not available)");
+#endif
+
     int fd = socket(AF_INET, SOCK_STREAM, 0);
     if(fd < 0) ERROR_ERRNO("Cannot initialise the socket");
     m_server_fd = fd;
@@ -123,6 +148,8 @@ Server::Server(shared_ptr<library::Interface> interface, int port) : m_interface
 }
 
 Server::~Server(){
+    stop_threads(); // in case main_loop() was interrupted by an exception
+
     // close the file descriptor
     if(m_server_fd >= 0){
         close(m_server_fd);
@@ -148,9 +175,14 @@ void Server::handle_signals(){
 }
 
 void Server::main_loop(){
-    cout << "[server] Server listening to port: " << m_port << endl;
+    cout << "[server] Server listening to port: " << m_port << ", I/O threads: " << m_num_io_threads << ", workers: " << m_num_workers;
+    if(m_numa_node >= 0){ cout << ", NUMA node: " << m_numa_node; }
+    cout << endl;
+    start_threads();
 
     while(!m_server_stop){
+        reap_connections();
+
         // Set the timeout to 1 second (it may be changed after each call to select)
         struct timeval timeout;
         timeout.tv_sec = 1;
@@ -172,6 +204,8 @@ void Server::main_loop(){
                 LOG("[server] Call to select() failed, server requested to terminate...");
                 m_server_stop = true;
                 continue;
+            } else if(errno == EINTR){
+                continue;
             } else {
                 ERROR_ERRNO("server, select");
             }
@@ -182,18 +216,255 @@ void Server::main_loop(){
 
         // there is only one fd that can be set, no need to check the bitmask from select
         struct sockaddr_in address;
-        socklen_t address_len {0};
+        socklen_t address_len { sizeof(address) };
         int connection_fd = accept(m_server_fd, (struct sockaddr *) &address, &address_len);
         if(connection_fd < 0)
             ERROR_ERRNO("Cannot establish a connection with a remote client");
 
 //        LOG("[server] Connection received from: " << inet_ntoa(address.sin_addr) << ":" << address.sin_port);
 
-        auto t = thread(&ConnectionHandler::execute, new ConnectionHandler(this, connection_fd));
-        t.detach(); // do not explicitly wait for the thread to terminate
+        open_connection(connection_fd);
     }
 
+    stop_threads();
     cout << "[server] Connection loop terminated" << endl;
+    RequestStatistics statistics;
+    collect_statistics(statistics);
+    if(!statistics.empty()){
+        cout << "[server] Latencies of the requests processed:\n" << statistics << flush;
+    }
+}
+
+void Server::start_threads(){
+    if(!m_io_threads.empty()) return; // already started
+
+#if defined(HAVE_LIBNUMA)
+    if(m_numa_node >= 0){ // the threads spawned from now on inherit the binding of the current thread
+        if(numa_run_on_node(m_numa_node) != 0) ERROR_ERRNO("Cannot bind the server to the NUMA node " << m_numa_node);
+        numa_set_preferred(m_numa_node);
+    }
+#endif
+
+    for(int i = 0; i < m_num_workers; i++){
+        m_workers.emplace_back(new Worker(this));
+        m_workers.back()->start();
+    }
+
+    for(int i = 0; i < m_num_io_threads; i++){
+        int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if(epoll_fd < 0) ERROR_ERRNO("epoll_create1");
+        m_epoll_fds.push_back(epoll_fd);
+        m_io_threads.emplace_back(&Server::io_thread, this, epoll_fd);
+    }
+}
+
+void Server::stop_threads(){
+    bool server_stop = m_server_stop;
+    m_server_stop = true; // also terminate the I/O threads
+    for(auto& t : m_io_threads){ t.join(); }
+    m_io_threads.clear();
+    for(auto& w : m_workers){ w->stop(); retire_statistics(w.get()); }
+    m_workers.clear();
+    for(auto connection : m_connections){ connection->join(); } // the dedicated threads of the connections over shared memory
+    m_server_stop = server_stop;
+
+    // the threads are gone, close the connections still open
+    for(auto connection : m_connections){
+        if(connection->dedicated_worker() != nullptr){ retire_statistics(connection->dedicated_worker()); }
+        delete connection;
+    }
+    m_num_active_connections -= m_connections.size();
+    m_connections.clear();
+    m_connections_terminated.clear();
+    m_num_shared_memory_connections = 0;
+
+    for(int epoll_fd : m_epoll_fds){ close(epoll_fd); }
+    m_epoll_fds.clear();
+}
+
+void Server::open_connection(int fd){
+    // the sockets are non blocking, the I/O threads only read what is already available
+    int flags = fcntl(fd, F_GETFL, 0);
+    if(flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1){
+        ERROR_ERRNO("fcntl, cannot set the connection as non blocking");
+    }
+
+    // the responses are already coalesced by the connection handler, do not delay them further
+    int nodelay_value = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void*) &nodelay_value, sizeof(nodelay_value));
+
+    // assign the connection to an I/O thread and a worker, round robin
+    int epoll_fd = m_epoll_fds[m_num_connections_opened % m_epoll_fds.size()];
+    Worker* worker = m_workers[m_num_connections_opened % m_workers.size()].get();
+    m_num_connections_opened++;
+
+    auto connection = new ConnectionHandler(this, fd, epoll_fd, worker);
+    {
+        scoped_lock<mutex> lock(m_connections_mutex);
+        m_connections.insert(connection);
+    }
+    int num_active_connections [[maybe_unused]] = ++m_num_active_connections;
+    COUT_DEBUG("[server] New connection, fd: " << fd << ", num active connections: " << num_active_connections);
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = connection;
+    if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) ERROR_ERRNO("epoll_ctl, cannot monitor the new connection");
+}
+
+void Server::close_connection(ConnectionHandler* connection){
+    {
+        scoped_lock<mutex> lock(m_connections_mutex);
+        m_connections.erase(connection);
+    }
+    if(connection->dedicated_worker() != nullptr){ retire_statistics(connection->dedicated_worker()); }
+    delete connection; // closing the file descriptor also removes it from the epoll instance
+    int num_active_connections [[maybe_unused]] = --m_num_active_connections;
+    COUT_DEBUG("[server] Connection closed, remaining active connections: " << num_active_connections);
+}
+
+void Server::reap_connections(){
+    vector<ConnectionHandler*> connections;
+    {
+        scoped_lock<mutex> lock(m_connections_mutex);
+        connections.swap(m_connections_terminated);
+        m_num_shared_memory_connections -= connections.size();
+    }
+
+    for(auto connection : connections){
+        connection->join();
+        close_connection(connection);
+    }
+}
+
+void Server::collect_statistics(RequestStatistics& output){
+    const uint64_t epoch = m_statistics_epoch.load(memory_order_acquire);
+    scoped_lock<mutex, mutex> lock(m_connections_mutex, m_statistics_mutex);
+    for(auto& worker : m_workers){ worker->collect_statistics(output, epoch); }
+    for(auto connection : m_connections){
+        if(connection->dedicated_worker() != nullptr){ connection->dedicated_worker()->collect_statistics(output, epoch); }
+    }
+    output.merge(m_statistics_retired);
+}
+
+void Server::retire_statistics(Worker* worker){
+    scoped_lock<mutex> lock(m_statistics_mutex);
+    worker->collect_statistics(m_statistics_retired, m_statistics_epoch.load(memory_order_acquire));
+}
+
+void Server::reset_statistics(){
+    scoped_lock<mutex> lock(m_statistics_mutex);
+    m_statistics_retired.reset();
+    m_statistics_epoch++;
+}
+
+void Server::io_thread(int epoll_fd){
+    constexpr int max_events = 64;
+    struct epoll_event events[max_events];
+
+    while(!m_server_stop){
+        int num_events = epoll_wait(epoll_fd, events, max_events, /* timeout, in millisecs */ 100);
+        if(num_events < 0){
+            if(errno == EINTR) continue;
+            ERROR_ERRNO("epoll_wait");
+        }
+
+        for(int i = 0; i < num_events; i++){
+            // with EPOLLONESHOT, the connection is not reported again until it's rearmed
+            ConnectionHandler* connection = reinterpret_cast<ConnectionHandler*>(events[i].data.ptr);
+            if(connection->is_waiting_output()){ // the socket can take more responses, or the connection has been closed
+                connection->worker()->submit(connection);
+            } else if(!connection->receive()){
+                LOG("[server] Connection closed by the remote end without sending a TERMINATE_WORKER message");
+                close_connection(connection);
+            } else if(connection->has_request()){
+                connection->worker()->submit(connection);
+            } else {
+                connection->rearm();
+            }
+        }
+    }
+}
+
+
+/*****************************************************************************
+ *                                                                           *
+ * Worker                                                                    *
+ *                                                                           *
+ *****************************************************************************/
+
+Server::Worker::Worker(Server* instance) : m_instance(instance) {
+
+}
+
+void Server::Worker::start(){
+    m_thread = thread(&Worker::main_thread, this);
+}
+
+void Server::Worker::stop(){
+    {
+        scoped_lock<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condvar.notify_all();
+    if(m_thread.joinable()) m_thread.join();
+}
+
+void Server::Worker::submit(ConnectionHandler* connection){
+    {
+        scoped_lock<mutex> lock(m_mutex);
+        m_queue.push_back(connection);
+    }
+    m_condvar.notify_one();
+}
+
+void Server::Worker::activate(int thread_id){
+    if(thread_id < 0 || thread_id == m_thread_id) return;
+    if(m_thread_id >= 0){ m_instance->m_interface->on_thread_destroy(m_thread_id); }
+    m_instance->m_interface->on_thread_init(thread_id);
+    m_thread_id = thread_id;
+}
+
+void Server::Worker::deactivate(int thread_id){
+    if(thread_id < 0 || thread_id != m_thread_id) return;
+    m_instance->m_interface->on_thread_destroy(m_thread_id);
+    m_thread_id = -1;
+}
+
+RequestStatistics& Server::Worker::statistics(){
+    const uint64_t epoch = m_instance->m_statistics_epoch.load(memory_order_acquire);
+    if(m_statistics_epoch.load(memory_order_relaxed) != epoch){ // the statistics have been reset in the meanwhile
+        m_statistics.reset();
+        m_statistics_epoch.store(epoch, memory_order_release);
+    }
+    return m_statistics;
+}
+
+void Server::Worker::collect_statistics(RequestStatistics& output, uint64_t epoch) const {
+    if(m_statistics_epoch.load(memory_order_acquire) == epoch){ // otherwise the counters are stale, the worker did not reset them yet
+        output.merge(m_statistics);
+    }
+}
+
+void Server::Worker::main_thread(){
+    while(true){
+        ConnectionHandler* connection { nullptr };
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_condvar.wait(lock, [this](){ return m_stop || !m_queue.empty(); });
+            if(m_stop) break;
+            connection = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        activate(connection->thread_id()); // the library may expect the calls from a thread with the id of the client
+        if(!connection->execute()){
+            m_instance->close_connection(connection);
+        }
+    }
+
+    deactivate(m_thread_id);
 }
 
 
@@ -202,67 +473,196 @@ void Server::main_loop(){
  * Connection Handler                                                        *
  *                                                                           *
  *****************************************************************************/
-Server::ConnectionHandler::ConnectionHandler(Server* instance, int fd) : m_instance(instance), m_fd(fd) {
+Server::ConnectionHandler::ConnectionHandler(Server* instance, int fd, int epoll_fd, Worker* worker) : m_instance(instance), m_fd(fd), m_epoll_fd(epoll_fd), m_worker(worker) {
     m_buffer_read = (char*) malloc(m_buffer_read_sz);
     m_buffer_write = (char*) malloc(m_buffer_write_sz);
     assert(m_buffer_read != nullptr && m_buffer_write != nullptr && "malloc error (no memory space left?)");
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+    int enable = 1;
+    m_zerocopy = setsockopt(m_fd, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) == 0; // otherwise not supported by the kernel
+#endif
 }
 
 Server::ConnectionHandler::~ConnectionHandler() {
+    // the write buffers cannot be released while the kernel is still transmitting from them
+    try {
+        zerocopy_wait(m_zerocopy_num_sends);
+    } catch(NetworkError& e){
+        LOG("[server] Cannot wait for the zero copy sends to complete: " << e.what());
+    }
+
     close(m_fd);
     m_fd = -1;
 
     free(m_buffer_read); m_buffer_read = nullptr;
     free(m_buffer_write); m_buffer_write = nullptr;
+    for(auto& buffer : m_buffers_retired){ free(buffer.m_buffer); }
+    m_buffers_retired.clear();
+
+    if(!m_results_path.empty()){ // left behind by a kernel that timed out
+        std::error_code ec;
+        filesystem::remove(m_results_path, ec);
+    }
 }
 
-void Server::ConnectionHandler::execute(){
-    [[maybe_unused]] int num_active_connections = ++(m_instance->m_num_active_connections);
-    int64_t thread_id = common::concurrency::get_thread_id();
-    struct sockaddr_in address; socklen_t address_len { sizeof(address) };
-    /* ignore rc */ getpeername(m_fd, (struct sockaddr *) &address, &address_len);
-    string remote_host { inet_ntoa(address.sin_addr) }; // thread-unsafe?
-    int remote_port [[maybe_unused]] = address.sin_port;
-    COUT_DEBUG("[server] [thread " << thread_id << "] Connected with " << remote_host << ":" << remote_port << ", num active connections: " << num_active_connections);
+bool Server::ConnectionHandler::execute(){
+    m_waiting_output = false;
 
-    while(!m_terminate){
-        int64_t num_bytes_read { 0 }, recv_bytes { 0 };
+    while(true){
+        while(has_request() && !m_terminate && !m_channel){
+            process_request();
+            // stream the responses back while processing the rest of the pipeline. If the client is not consuming them,
+            // stop processing its requests until the socket can take more responses
+            if(m_write_end - m_write_start >= flush_threshold && !m_channel && !flush()) break;
+        }
 
-        // read the size of the message
-        recv_bytes = recv(m_fd, m_buffer_read + num_bytes_read, sizeof(uint32_t), /* flags */ 0);
-        if(recv_bytes == -1) {
-            ERROR_ERRNO("recv, connection interrupted?");
-        } else if(recv_bytes == 0){
-            LOG("[server] [thread " << thread_id << "] Connection closed by the remote end without sending a TERMINATE_WORKER message");
-            m_terminate = true;
-            break;
+        if(m_channel){ // hand the connection over to a dedicated thread, which also sends the last responses over TCP
+            m_worker->deactivate(m_thread_id); // the library context moves to the new thread
+            { // visited by Server::collect_statistics
+                scoped_lock<mutex> lock(m_instance->m_connections_mutex);
+                m_dedicated_worker.reset(new Worker(m_instance));
+            }
+            m_worker = m_dedicated_worker.get();
+            m_dedicated_thread = thread(&ConnectionHandler::execute_shared_memory, this);
+            return true;
+        } else if(!flush()){ // all requests received so far have been processed, send their responses back
+            rearm(/* output */ true); // do not wait for the client, resume once the socket can take more responses
+            return true;
+        } else if(m_terminate){
+            return false;
+        } else if(!receive()){ // check whether more requests arrived in the meanwhile
+            LOG("[server] Connection closed by the remote end without sending a TERMINATE_WORKER message");
+            return false;
+        } else if(!has_request()){
+            rearm(); // wait for the I/O thread to signal the next request
+            return true;
         }
+    }
+}
 
-        assert(recv_bytes == sizeof(uint32_t) && "Expected to read 4 bytes, while we probably read something less");
-        num_bytes_read += recv_bytes;
-        int64_t message_sz = static_cast<int64_t>(*(reinterpret_cast<uint32_t*>(m_buffer_read)));
+void Server::ConnectionHandler::execute_shared_memory(){
+    assert(m_channel.get() != nullptr);
 
-        if(message_sz > (int64_t) m_buffer_read_sz){ // realloc the buffer if it is too small
-            m_buffer_read_sz = pow(2, ceil(log2(message_sz))); // next power of 2
-            LOG("[server] [thread " << thread_id << "] Reallocate the internal read buffer to " << m_buffer_read_sz << " bytes");
-            m_buffer_read = (char*) realloc(m_buffer_read, m_buffer_read_sz);
-            assert(m_buffer_read != nullptr && "realloc error (no memory space left?)");
+    // the responses not sent yet over TCP, including the one to the request SHARED_MEMORY. This thread only serves this connection, it can wait
+    while(m_write_start < m_write_end && !flush_socket()){
+        struct pollfd pfd { m_fd, POLLOUT, 0 };
+        poll(&pfd, 1, /* millisecs */ 100);
+        if(m_instance->m_server_stop){ break; }
+    }
+    m_write_start = m_write_end = 0;
+
+    m_worker->activate(m_thread_id);
+
+    while(!m_terminate && !m_instance->m_server_stop){
+        if(!has_request()){
+            flush(); // all requests received so far have been processed, send their responses back
+            if(!receive()){
+                LOG("[server] Connection closed by the remote end without sending a TERMINATE_WORKER message");
+                m_terminate = true;
+            }
+            continue;
         }
-        // read the rest of the message
-        while(num_bytes_read < message_sz){
-            recv_bytes = read(m_fd, m_buffer_read + num_bytes_read, message_sz - num_bytes_read);
-            if(recv_bytes == -1) ERROR_ERRNO("recv, only able to read " << num_bytes_read << " out of " << num_bytes_read <<" bytes, then the connection was interrupted?");
-            num_bytes_read += recv_bytes;
+
+        process_request();
+        if(m_write_end >= flush_threshold){ flush(); } // stream the responses back while processing the rest of the pipeline
+    }
+    flush();
+
+    m_worker->deactivate(m_thread_id);
+    if(m_terminate){ // otherwise the server is stopping, the connection is closed by #stop_threads
+        scoped_lock<mutex> lock(m_instance->m_connections_mutex);
+        m_instance->m_connections_terminated.push_back(this); // joined and closed by the main loop
+    }
+}
+
+void Server::ConnectionHandler::join(){
+    if(m_dedicated_thread.joinable()){ m_dedicated_thread.join(); }
+}
+
+bool Server::ConnectionHandler::is_alive() const {
+    char c;
+    ssize_t rc = recv(m_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return rc > 0 || (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+}
+
+int Server::ConnectionHandler::thread_id() const {
+    return m_thread_id;
+}
+
+Server::Worker* Server::ConnectionHandler::worker() const {
+    return m_worker;
+}
+
+Server::Worker* Server::ConnectionHandler::dedicated_worker() const {
+    return m_dedicated_worker.get();
+}
+
+class Server::ConnectionHandler::ResponseStream : public std::streambuf {
+    ConnectionHandler* m_handler;
+    const size_t m_message_offset; // position of the response in the write buffer
+
+    // Grow the write buffer, without flushing the responses already there, so that it can hold num_bytes more chars
+    void reserve(size_t num_bytes){
+        const size_t length = pptr() - pbase();
+        const size_t required_sz = (pptr() - m_handler->m_buffer_write) + num_bytes + /* padding */ sizeof(uint64_t);
+        if(required_sz > m_handler->m_buffer_write_sz){
+            m_handler->grow_write_buffer(pptr() - m_handler->m_buffer_write, required_sz);
+            setp(message()->buffer() + sizeof(uint64_t), m_handler->m_buffer_write + m_handler->m_buffer_write_sz - sizeof(uint64_t));
+            pbump(length);
+        }
+    }
+
+    Response* message(){ return reinterpret_cast<Response*>(m_handler->m_buffer_write + m_message_offset); }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if(!traits_type::eq_int_type(ch, traits_type::eof())){
+            reserve(1);
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
         }
-        assert(num_bytes_read == message_sz && "Message read");
+        return traits_type::not_eof(ch);
+    }
+
+    streamsize xsputn(const char* s, streamsize count) override {
+        if(count > epptr() - pptr()){ reserve(count); }
+        memcpy(pptr(), s, count);
+        pbump(count);
+        return count;
+    }
 
-        handle_request();
+public:
+    ResponseStream(ConnectionHandler* handler, ResponseType type) : m_handler(handler), m_message_offset((handler->reserve_response(4096), handler->m_write_end)) {
+        new (message()) Response(type);
+        message()->set_sequence_id(m_handler->request()->sequence_id());
+        setp(message()->buffer() + sizeof(uint64_t), m_handler->m_buffer_write + m_handler->m_buffer_write_sz - sizeof(uint64_t));
     }
 
-    num_active_connections = --(m_instance->m_num_active_connections);
-    COUT_DEBUG("[server] [thread " << thread_id << "] Disconnected with " << remote_host << ":" << remote_port << ", remaining active connections: " << num_active_connections);
+    // Complete the response and append it to the pending responses
+    void finish(){
+        const uint64_t length = pptr() - pbase();
+        const uint64_t padding = (sizeof(uint64_t) - length % sizeof(uint64_t)) % sizeof(uint64_t);
+        memset(pptr(), 0, padding); // the space is always reserved
+        *reinterpret_cast<uint64_t*>(message()->buffer()) = length;
+        message()->extend(sizeof(uint64_t) + length + padding);
+        m_handler->m_write_end += message()->message_size();
+    }
+};
+
+void Server::ConnectionHandler::process_request(){
+    const RequestType type = request()->type();
+    const auto start = chrono::steady_clock::now();
+    RequestStatistics& statistics = m_worker->statistics();
+    assert(!m_request_times.empty() && "The request has not been timestamped");
+    statistics.record(type, RequestStatistics::Phase::QUEUE, start - m_request_times.front());
+    m_request_times.pop_front();
+    m_last_request_type = type;
 
-    delete this; // done!
+    handle_request();
+
+    statistics.record(type, RequestStatistics::Phase::LIBRARY, chrono::steady_clock::now() - start);
+    m_read_start += request()->message_size();
 }
 
 void Server::ConnectionHandler::handle_request(){
@@ -289,18 +689,50 @@ void Server::ConnectionHandler::handle_request(){
         interface()->set_timeout(request()->get(0));
         response(ResponseType::OK);
         break;
+    case RequestType::REMOTE_RESULTS:
+        m_remote_results = request()->get<bool>(0);
+        m_remote_results_compression = request()->get<bool>(1);
+        if(m_remote_results && m_results_path.empty()){
+            m_results_path = filesystem::temp_directory_path() / ("gfe_server_results." + to_string(getpid()) + "." + to_string(m_fd));
+        }
+        response(ResponseType::OK);
+        break;
+    case RequestType::STATS: {
+        RequestStatistics statistics;
+        m_instance->collect_statistics(statistics);
+        ResponseStream stream { this, ResponseType::OK };
+        ostream out { &stream };
+        statistics.dump(out);
+        stream.finish();
+        if(request()->get<bool>(0)){ m_instance->reset_statistics(); }
+    } break;
+    case RequestType::SHARED_MEMORY: {
+        if(m_channel){ ERROR("The connection is already over shared memory"); }
+        unique_ptr<SharedMemoryChannel> channel { new SharedMemoryChannel(request()->get_string(0)) };
+        { // each connection over shared memory is served by its own thread
+            scoped_lock<mutex> lock(m_instance->m_connections_mutex);
+            if(m_instance->m_num_shared_memory_connections >= m_instance->m_num_workers){
+                ERROR("Too many connections over shared memory, max: " << m_instance->m_num_workers);
+            }
+            m_instance->m_num_shared_memory_connections++;
+        }
+        response(ResponseType::OK); // the last response over TCP, sent by the dedicated thread
+        m_channel = move(channel);
+    } break;
     case RequestType::ON_MAIN_INIT:
         interface()->on_main_init((int) request()->get<int>(0));
         response(ResponseType::OK);
         break;
     case RequestType::ON_THREAD_INIT:
         COUT_DEBUG("ON_THREAD_INIT: " << request()->get<int>(0));
-        interface()->on_thread_init((int) request()->get<int>(0));
+        m_thread_id = (int) request()->get<int>(0);
+        m_worker->activate(m_thread_id);
         response(ResponseType::OK);
         break;
     case RequestType::ON_THREAD_DESTROY:
         COUT_DEBUG("ON_THREAD_DESTROY: " << request()->get<int>(0));
-        interface()->on_thread_destroy((int) request()->get<int>(0));
+        m_worker->deactivate((int) request()->get<int>(0));
+        m_thread_id = -1;
         response(ResponseType::OK);
         break;
     case RequestType::ON_MAIN_DESTROY:
@@ -343,6 +775,22 @@ void Server::ConnectionHandler::handle_request(){
             response(ResponseType::OK);
         }
     } break;
+    case RequestType::LOAD_FRAME: {
+        library::UpdateInterface* update_interface = dynamic_cast<library::UpdateInterface*>(interface());
+        if(update_interface == nullptr){
+            LOG("Operation not supported by the current interface: " << request()->type());
+            response(ResponseType::NOT_SUPPORTED);
+        } else {
+            decode_edge_frame(request()->buffer(), request()->message_size() - sizeof(Request), m_frame, m_frame_scratch);
+            bool result = true;
+            for(const auto& e : m_frame){ // as UpdateInterface#load
+                update_interface->add_vertex(e.m_source);
+                update_interface->add_vertex(e.m_destination);
+                result &= update_interface->add_edge(graph::WeightedEdge{ e.m_source, e.m_destination, e.m_weight });
+            }
+            response(ResponseType::OK, result);
+        }
+    } break;
     case RequestType::ADD_VERTEX: {
         COUT_DEBUG("ADD_VERTEX: " << request()->get<int>(0));
         library::UpdateInterface* update_interface = dynamic_cast<library::UpdateInterface*>(interface());
@@ -377,6 +825,18 @@ void Server::ConnectionHandler::handle_request(){
             response(ResponseType::OK, result);
         }
     } break;
+    case RequestType::ADD_EDGE_V2: {
+        library::UpdateInterface* update_interface = dynamic_cast<library::UpdateInterface*>(interface());
+        if(update_interface == nullptr){
+            LOG("Operation not supported by the current interface: " << request()->type());
+            response(ResponseType::NOT_SUPPORTED);
+        } else {
+            graph::WeightedEdge edge { request()->get(0),  request()->get(1), request()->get<double>(2)};
+            COUT_DEBUG("ADD_EDGE_V2: " << edge);
+            bool result = update_interface->add_edge_v2(edge);
+            response(ResponseType::OK, result);
+        }
+    } break;
     case RequestType::REMOVE_EDGE: {
         library::UpdateInterface* update_interface = dynamic_cast<library::UpdateInterface*>(interface());
         if(update_interface == nullptr){
@@ -410,6 +870,25 @@ void Server::ConnectionHandler::handle_request(){
             }
         }
     } break;
+    case RequestType::BATCH_FRAME_FORCE_NO:
+    case RequestType::BATCH_FRAME_FORCE_YES: {
+        library::UpdateInterface* update_interface = dynamic_cast<library::UpdateInterface*>(interface());
+        if(update_interface == nullptr){
+            LOG("Operation not supported by the current interface: " << request()->type());
+            response(ResponseType::NOT_SUPPORTED);
+        } else {
+            try {
+                decode_edge_frame(request()->buffer(), request()->message_size() - sizeof(Request), m_frame, m_frame_scratch);
+                bool force = request()->type() == RequestType::BATCH_FRAME_FORCE_YES;
+                bool result = update_interface->batch(m_frame.data(), m_frame.size(), force);
+                response(ResponseType::OK, result);
+            } catch (library::TimeoutError& e){
+                assert(request()->type() == RequestType::BATCH_FRAME_FORCE_YES);
+                LOG("Batch timeout: " << e);
+                response(ResponseType::TIMEOUT);
+            }
+        }
+    } break;
     case RequestType::BUILD: {
         library::UpdateInterface* update_interface = dynamic_cast<library::UpdateInterface*>(interface());
         if(update_interface == nullptr){
@@ -431,22 +910,10 @@ void Server::ConnectionHandler::handle_request(){
 //        response(ResponseType::OK, true);
 //        break;
     case RequestType::DUMP_CLIENT: {
-        ostringstream ss;
-        interface()->dump_ostream(ss);
-        string result = ss.str();
-
-        uint64_t header_sz = sizeof(Response) + /* string length */ sizeof(uint64_t);
-        uint64_t body_sz = strlen(result.c_str()) +1;
-        uint64_t message_sz = header_sz + body_sz;
-
-        // send the header
-        reinterpret_cast<uint32_t*>(m_buffer_write)[0] = (uint32_t) message_sz;
-        reinterpret_cast<uint32_t*>(m_buffer_write)[1] = (uint32_t) ResponseType::OK;
-        reinterpret_cast<uint64_t*>(m_buffer_write)[1] = body_sz -1;
-        send_data(m_buffer_write, header_sz);
-
-        // send the body
-        send_data(result.c_str(), body_sz);
+        ResponseStream stream { this, ResponseType::OK };
+        ostream out { &stream };
+        interface()->dump_ostream(out);
+        stream.finish();
     } break;
     case RequestType::BFS: {
         auto graphalytics = dynamic_cast<library::GraphalyticsInterface*>(interface());
@@ -455,9 +922,9 @@ void Server::ConnectionHandler::handle_request(){
             response(ResponseType::NOT_SUPPORTED);
         } else {
             string path = request()->get_string(1);
-            const char* c_path = path.empty() ? nullptr : path.c_str();
+            const char* c_path = results_path(path);
             graphalytics->bfs(request()->get(0), c_path);
-            response(ResponseType::OK);
+            send_results<int64_t>(c_path);
         }
     } break;
     case RequestType::PAGERANK: {
@@ -467,9 +934,9 @@ void Server::ConnectionHandler::handle_request(){
             response(ResponseType::NOT_SUPPORTED);
         } else {
             string path = request()->get_string(2);
-            const char* c_path = path.empty() ? nullptr : path.c_str();
+            const char* c_path = results_path(path);
             graphalytics->pagerank(request()->get(0), request()->get<double>(1), c_path);
-            response(ResponseType::OK);
+            send_results<double>(c_path);
         }
     } break;
     case RequestType::WCC: {
@@ -479,9 +946,9 @@ void Server::ConnectionHandler::handle_request(){
             response(ResponseType::NOT_SUPPORTED);
         } else {
             string path = request()->get_string(0);
-            const char* c_path = path.empty() ? nullptr : path.c_str();
+            const char* c_path = results_path(path);
             graphalytics->wcc(c_path);
-            response(ResponseType::OK);
+            send_results<uint64_t>(c_path);
         }
     } break;
     case RequestType::CDLP: {
@@ -491,9 +958,9 @@ void Server::ConnectionHandler::handle_request(){
             response(ResponseType::NOT_SUPPORTED);
         } else {
             string path = request()->get_string(1);
-            const char* c_path = path.empty() ? nullptr : path.c_str();
+            const char* c_path = results_path(path);
             graphalytics->cdlp(request()->get(0), c_path);
-            response(ResponseType::OK);
+            send_results<uint64_t>(c_path);
         }
     } break;
     case RequestType::LCC: {
@@ -503,9 +970,9 @@ void Server::ConnectionHandler::handle_request(){
             response(ResponseType::NOT_SUPPORTED);
         } else {
             string path = request()->get_string(0);
-            const char* c_path = path.empty() ? nullptr : path.c_str();
+            const char* c_path = results_path(path);
             graphalytics->lcc(c_path);
-            response(ResponseType::OK);
+            send_results<double>(c_path);
         }
     } break;
     case RequestType::SSSP: {
@@ -515,9 +982,20 @@ void Server::ConnectionHandler::handle_request(){
             response(ResponseType::NOT_SUPPORTED);
         } else {
             string path = request()->get_string(1);
-            const char* c_path = path.empty() ? nullptr : path.c_str();
+            const char* c_path = results_path(path);
             graphalytics->sssp(request()->get(0), c_path);
-            response(ResponseType::OK);
+            send_results<double>(c_path);
+        }
+    } break;
+    case RequestType::SCATTER_DEGREE:
+    case RequestType::SCATTER_SUM:
+    case RequestType::SCATTER_MIN: {
+        auto graphalytics = dynamic_cast<library::GraphalyticsInterface*>(interface());
+        if(graphalytics == nullptr){
+            LOG("Operation not supported by the current interface: " << request()->type());
+            response(ResponseType::NOT_SUPPORTED);
+        } else {
+            scatter(graphalytics);
         }
     } break;
     default:
@@ -539,29 +1017,364 @@ void Server::ConnectionHandler::handle_request(){
  * Retrieve the request being current processed
  */
 const Request* Server::ConnectionHandler::request() const {
-    return reinterpret_cast<const Request*>(m_buffer_read);
+    return reinterpret_cast<const Request*>(m_buffer_read + m_read_start);
+}
+
+bool Server::ConnectionHandler::has_request() const {
+    size_t num_bytes = m_read_end - m_read_start;
+    return num_bytes >= sizeof(uint32_t) && num_bytes >= *(reinterpret_cast<const uint32_t*>(m_buffer_read + m_read_start));
+}
+
+bool Server::ConnectionHandler::receive(){
+    while(true){
+        // move the partial request at the start of the buffer
+        if(m_read_start > 0){
+            memmove(m_buffer_read, m_buffer_read + m_read_start, m_read_end - m_read_start);
+            m_read_end -= m_read_start;
+            m_read_scan -= m_read_start;
+            m_read_start = 0;
+        }
+
+        // realloc the buffer if it is too small for the request
+        if(m_read_end == m_buffer_read_sz || (m_read_end >= sizeof(uint32_t) && *(reinterpret_cast<uint32_t*>(m_buffer_read)) > m_buffer_read_sz)){
+            size_t message_sz = max<size_t>(m_buffer_read_sz +1, *(reinterpret_cast<uint32_t*>(m_buffer_read)));
+            m_buffer_read_sz = pow(2, ceil(log2(message_sz))); // next power of 2
+            LOG("[server] [thread " << common::concurrency::get_thread_id() << "] Reallocate the internal read buffer to " << m_buffer_read_sz << " bytes");
+            m_buffer_read = (char*) realloc(m_buffer_read, m_buffer_read_sz);
+            assert(m_buffer_read != nullptr && "realloc error (no memory space left?)");
+        }
+
+        if(m_channel){ // shared memory, wait a bit for the next request, then check whether the client is still there
+            uint64_t num_bytes_read = m_channel->requests().read_some(m_buffer_read + m_read_end, m_buffer_read_sz - m_read_end);
+            m_read_end += num_bytes_read;
+            if(num_bytes_read > 0){ timestamp_requests(); }
+            if(has_request()) return true;
+            if(num_bytes_read == 0 && !m_channel->requests().wait_data(chrono::milliseconds(100))){
+                return is_alive();
+            }
+            continue;
+        }
+
+        ssize_t recv_bytes = recv(m_fd, m_buffer_read + m_read_end, m_buffer_read_sz - m_read_end, /* flags */ 0);
+        if(recv_bytes > 0){
+            m_read_end += recv_bytes;
+            timestamp_requests();
+            if(has_request()) return true; // process what we have so far
+        } else if(recv_bytes == 0){
+            return false; // connection closed
+        } else if(errno == EAGAIN || errno == EWOULDBLOCK){
+            return true; // nothing else to read
+        } else if(errno != EINTR){
+            LOG("[server] recv, connection interrupted? " << strerror(errno) << " (errno: " << errno << ")");
+            return false;
+        }
+    }
+}
+
+void Server::ConnectionHandler::timestamp_requests(){
+    const auto now = chrono::steady_clock::now();
+    while(m_read_end - m_read_scan >= sizeof(uint32_t)){
+        const uint32_t message_sz = *(reinterpret_cast<const uint32_t*>(m_buffer_read + m_read_scan));
+        if(m_read_end - m_read_scan < message_sz) break; // partial request
+        m_request_times.push_back(now);
+        m_read_scan += message_sz;
+    }
 }
 
 template<typename... Args>
 void Server::ConnectionHandler::response(ResponseType type, Args... args){
-    new (m_buffer_write) Response(type, std::forward<Args>(args)...);
+    reserve_response(Response::compute_size(args...) + /* null terminator of the strings */ sizeof(uint64_t));
+
+    Response* message = new (m_buffer_write + m_write_end) Response(type, std::forward<Args>(args)...);
+    message->set_sequence_id(request()->sequence_id());
+    m_write_end += message->message_size();
+}
+
+void Server::ConnectionHandler::reserve_response(size_t message_sz){
+    if(m_write_end + message_sz <= m_buffer_write_sz) return;
+
+    flush();
+    if(m_write_start > 0 && !m_buffer_write_zerocopy){ // move the responses not sent yet at the start of the buffer
+        memmove(m_buffer_write, m_buffer_write + m_write_start, m_write_end - m_write_start);
+        m_write_end -= m_write_start;
+        m_write_start = 0;
+    }
+    if(m_write_end + message_sz > m_buffer_write_sz){ // the buffer is too small, or the client is not consuming the responses
+        grow_write_buffer(m_write_end, m_write_end + message_sz);
+    }
+}
+
+void Server::ConnectionHandler::grow_write_buffer(size_t used_sz, size_t required_sz){
+    assert(m_write_start <= used_sz && used_sz <= m_buffer_write_sz);
+    size_t buffer_sz = pow(2, ceil(log2(required_sz))); // next power of 2
+    char* buffer = (char*) malloc(buffer_sz);
+    assert(buffer != nullptr && "malloc error (no memory space left?)");
+    memcpy(buffer + m_write_start, m_buffer_write + m_write_start, used_sz - m_write_start); // keep the offsets of the responses
+    retire_write_buffer();
+    m_buffer_write = buffer;
+    m_buffer_write_sz = buffer_sz;
+}
+
+void Server::ConnectionHandler::retire_write_buffer(){
+    if(m_buffer_write_zerocopy){ // the kernel may still be transmitting from the buffer
+        if(!m_buffers_retired.empty()){ zerocopy_drain(); } // release the buffers already transmitted
+        m_buffers_retired.push_back(RetiredBuffer{ m_buffer_write, m_zerocopy_num_sends });
+        m_buffer_write_zerocopy = false;
+    } else {
+        free(m_buffer_write);
+    }
+    m_buffer_write = nullptr;
+}
+
+const char* Server::ConnectionHandler::results_path(const string& path) const {
+    if(path.empty()){
+        return nullptr;
+    } else if(m_remote_results){
+        return m_results_path.c_str(); // the path requested refers to the client's file system
+    } else {
+        return path.c_str();
+    }
+}
+
+template<typename T>
+void Server::ConnectionHandler::send_results(const char* path){
+    if(!m_remote_results || path == nullptr){
+        response(ResponseType::OK);
+        return;
+    }
+
+    common::Timer timer; // the time spent to parse and encode the results, excluding the transfer
+    timer.start();
+
+    // parse the results saved by the kernel
+    m_result_vertices.clear();
+    m_result_values.clear();
+    FILE* file = fopen(path, "r");
+    if(file == nullptr) ERROR("Cannot open the results saved in `" << path << "': " << strerror(errno));
+    char* line = nullptr;
+    size_t line_sz = 0;
+    while(getline(&line, &line_sz, file) != -1){
+        char* next = nullptr;
+        uint64_t vertex_id = strtoull(line, &next, 10);
+        if(next == line) continue; // empty line
+        uint64_t value = 0;
+        if constexpr (is_floating_point_v<T>){
+            double v = strtod(next, nullptr);
+            memcpy(&value, &v, sizeof(value));
+        } else if constexpr (is_signed_v<T>){
+            value = static_cast<uint64_t>(strtoll(next, nullptr, 10));
+        } else {
+            value = strtoull(next, nullptr, 10);
+        }
+        m_result_vertices.push_back(vertex_id);
+        m_result_values.push_back(value);
+    }
+    free(line);
+    fclose(file);
+    filesystem::remove(path);
+    timer.stop();
 
-    assert(/* message_sz */ (*(reinterpret_cast<uint32_t*>(m_buffer_write))) < m_buffer_write_sz && "The message is too long");
-    send_data(m_buffer_write);
+    send_frames(timer);
+    response(ResponseType::OK, timer.microseconds());
 }
 
-void Server::ConnectionHandler::send_data(const char* buffer){
-    ssize_t message_sz = *(reinterpret_cast<const uint32_t*>(buffer));
-    send_data(buffer, message_sz);
+void Server::ConnectionHandler::send_frames(common::Timer& timer){
+    // the client decodes a frame while the next one is encoded
+    const uint64_t num_entries = m_result_vertices.size();
+    for(uint64_t i = 0; i < num_entries; i += RESULT_FRAME_MAX_NUM_ENTRIES){
+        timer.resume();
+        const uint64_t frame_num_entries = min(RESULT_FRAME_MAX_NUM_ENTRIES, num_entries - i);
+        reserve_response(sizeof(Response) + result_frame_max_size(frame_num_entries));
+        Response* message = new (m_buffer_write + m_write_end) Response(ResponseType::RESULT_FRAME);
+        message->set_sequence_id(request()->sequence_id());
+        message->extend(encode_result_frame(m_result_vertices.data() + i, m_result_values.data() + i, frame_num_entries, m_remote_results_compression, message->buffer(), m_frame_scratch));
+        m_write_end += message->message_size();
+        timer.stop();
+        flush();
+    }
 }
 
-void Server::ConnectionHandler::send_data(const char* buffer, uint32_t buffer_sz){
-    ssize_t message_sz = (ssize_t) buffer_sz; // cast
-    ssize_t bytes_sent = send(m_fd, buffer, message_sz, /* flags */ 0);
-    if(bytes_sent == -1) ERROR_ERRNO("send_response, connection error");
-    assert(bytes_sent == message_sz && "Message not fully sent");
+void Server::ConnectionHandler::scatter(library::GraphalyticsInterface* graphalytics){
+    const RequestType type = request()->type();
+    m_result_vertices.clear();
+    m_result_values.clear();
+    decode_result_frame(request()->buffer(), request()->message_size() - sizeof(Request), m_result_vertices, m_result_values, m_frame_scratch);
+
+    // aggregate the values sent to each neighbour. With SCATTER_SUM, the values are doubles stored bitwise.
+    unordered_map<uint64_t, uint64_t> aggregates;
+    for(uint64_t i = 0, end = m_result_vertices.size(); i < end; i++){
+        const uint64_t vertex = m_result_vertices[i];
+        const uint64_t value = m_result_values[i];
+        switch(type){
+        case RequestType::SCATTER_DEGREE: {
+            uint64_t degree = 0;
+            if(graphalytics->scan_neighbors(vertex, [&degree](uint64_t, double){ degree++; return true; })){
+                aggregates[vertex] = degree;
+            }
+        } break;
+        case RequestType::SCATTER_SUM: {
+            double contribution;
+            memcpy(&contribution, &value, sizeof(contribution));
+            graphalytics->scan_neighbors(vertex, [&aggregates, contribution](uint64_t destination, double){
+                uint64_t& slot = aggregates[destination]; // zero initialised, the same bits of 0.0
+                double sum;
+                memcpy(&sum, &slot, sizeof(sum));
+                sum += contribution;
+                memcpy(&slot, &sum, sizeof(sum));
+                return true;
+            });
+        } break;
+        case RequestType::SCATTER_MIN: {
+            graphalytics->scan_neighbors(vertex, [&aggregates, value](uint64_t destination, double){
+                auto result = aggregates.try_emplace(destination, value);
+                if(!result.second && value < result.first->second){ result.first->second = value; }
+                return true;
+            });
+        } break;
+        default:
+            assert(false && "Invalid request type");
+        }
+    }
+
+    // send back the aggregates, as a sequence of frames
+    m_result_vertices.clear();
+    m_result_values.clear();
+    for(const auto& p : aggregates){
+        m_result_vertices.push_back(p.first);
+        m_result_values.push_back(p.second);
+    }
+    common::Timer timer;
+    send_frames(timer);
+    response(ResponseType::OK);
 }
 
+bool Server::ConnectionHandler::flush(){
+    if(!m_channel){ return flush_socket(); }
+    if(m_write_end == 0) return true; // nothing to send
+    const auto start = chrono::steady_clock::now();
+
+    if(!m_channel->responses().write(m_buffer_write, m_write_end, [this](){ return is_alive(); })){
+        LOG("[server] Connection closed by the remote end while sending the responses");
+        m_terminate = true; // abort the connection
+    }
+    m_write_end = 0;
+    m_worker->statistics().record(m_last_request_type, RequestStatistics::Phase::SEND, chrono::steady_clock::now() - start);
+    return true;
+}
+
+bool Server::ConnectionHandler::flush_socket(){
+    if(m_write_start == m_write_end) return true; // nothing to send
+    const auto start = chrono::steady_clock::now();
+
+    // with zero copy, the kernel transmits straight from the write buffer, which cannot be altered until the kernel releases it
+    bool zerocopy = m_zerocopy && m_write_end - m_write_start >= zerocopy_threshold;
+    while(m_write_start < m_write_end){
+        int flags = MSG_NOSIGNAL;
+#if defined(MSG_ZEROCOPY)
+        if(zerocopy){ flags |= MSG_ZEROCOPY; }
+#endif
+        ssize_t bytes_sent = send(m_fd, m_buffer_write + m_write_start, m_write_end - m_write_start, flags);
+        if(bytes_sent == -1){
+            if(errno == EINTR) continue;
+            if(errno == ENOBUFS && zerocopy){ // cannot pin more pages, fall back to a regular send
+                zerocopy = false;
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK){ break; } // the client is not consuming the responses, do not wait for it
+            LOG("[server] send, connection interrupted? " << strerror(errno) << " (errno: " << errno << ")");
+            m_terminate = true; // abort the connection
+            m_write_start = m_write_end;
+            break;
+        }
+        m_write_start += bytes_sent;
+        if(zerocopy){
+            m_zerocopy_num_sends++;
+            m_buffer_write_zerocopy = true;
+        }
+    }
+
+    const bool done = m_write_start == m_write_end;
+    if(done){
+        m_write_start = m_write_end = 0;
+        if(m_buffer_write_zerocopy){ // carry on with a new buffer, while the kernel transmits the current one
+            retire_write_buffer();
+            m_buffer_write = (char*) malloc(m_buffer_write_sz);
+            assert(m_buffer_write != nullptr && "malloc error (no memory space left?)");
+        }
+    }
+
+    m_worker->statistics().record(m_last_request_type, RequestStatistics::Phase::SEND, chrono::steady_clock::now() - start);
+    return done;
+}
+
+void Server::ConnectionHandler::zerocopy_wait(uint32_t num_sends){
+#if defined(SO_EE_ORIGIN_ZEROCOPY)
+    while(static_cast<int32_t>(m_zerocopy_num_completed - num_sends) < 0){ // the counters wrap around
+        if(!zerocopy_drain()){
+            struct pollfd pfd { m_fd, 0, 0 }; // the notifications are signalled with POLLERR
+            poll(&pfd, 1, /* no timeout */ -1);
+            if((pfd.revents & POLLERR) == 0) return; // the connection has been closed, the pending sends will never be completed
+        }
+    }
+#endif
+}
+
+bool Server::ConnectionHandler::zerocopy_drain(){
+    bool drained = false;
+#if defined(SO_EE_ORIGIN_ZEROCOPY)
+    if(m_zerocopy_num_sends == 0) return false; // zero copy never used, nothing to drain
+
+    while(true){
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if(recvmsg(m_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1){
+            if(errno == EINTR) continue;
+            if(errno != EAGAIN && errno != EWOULDBLOCK) ERROR_ERRNO("recvmsg, cannot retrieve the zero copy notifications");
+            break; // the error queue is empty
+        }
+        drained = true;
+
+        for(struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+            if(!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) && !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) continue;
+            auto error = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cmsg));
+            if(error->ee_errno != 0 || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+            m_zerocopy_num_completed = error->ee_data + 1; // the range [ee_info, ee_data] of sends completed, in order
+            if(error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED){ // the kernel copied the data anyway (e.g. loopback), zero copy is only an overhead
+                m_zerocopy = false;
+            }
+        }
+    }
+
+    // release the write buffers no longer transmitted by the kernel
+    auto is_completed = [this](uint32_t num_sends){ return static_cast<int32_t>(m_zerocopy_num_completed - num_sends) >= 0; }; // the counters wrap around
+    auto it = remove_if(m_buffers_retired.begin(), m_buffers_retired.end(), [&](const RetiredBuffer& buffer){
+        if(!is_completed(buffer.m_num_sends)) return false;
+        free(buffer.m_buffer);
+        return true;
+    });
+    m_buffers_retired.erase(it, m_buffers_retired.end());
+    if(m_buffer_write_zerocopy && is_completed(m_zerocopy_num_sends)){ m_buffer_write_zerocopy = false; }
+#endif
+    return drained;
+}
+
+void Server::ConnectionHandler::rearm(bool output){
+    zerocopy_drain(); // otherwise the pending notifications wake up the I/O thread again straight away, with EPOLLERR
+
+    m_waiting_output = output;
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = (output ? EPOLLOUT : EPOLLIN) | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = this;
+    if(epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, m_fd, &event) != 0) ERROR_ERRNO("epoll_ctl, cannot monitor the connection");
+}
+
+bool Server::ConnectionHandler::is_waiting_output() const {
+    return m_waiting_output;
+}
 
 library::Interface* Server::ConnectionHandler::interface(){
     return m_instance->m_interface.get();
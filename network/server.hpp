@@ -18,51 +18,164 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
+#include "common/timer.hpp"
+#include "edge_frame.hpp"
 #include "message.hpp"
+#include "request_statistics.hpp"
+#include "shared_memory.hpp"
 
-namespace gfe::library { class Interface; } // forward decl.
+namespace gfe::library { class GraphalyticsInterface; class Interface; } // forward decl.
 
 namespace gfe::network {
 
 /**
  * This class bridges the remote requests (made by a client) and forwards them to a given library instance (library::Interface).
- * The communication client - server is synchronous:
- * 1- The client makes a request, e.g. an action to perform on the graph.
- * 2- The server receives the request and invokes the related method in the library instance.
- * 3- The server sends the result back to the client.
- * 4- The client receives the response and resumes its execution.
+ * The communication client - server is pipelined:
+ * 1- The client sends one or more requests, e.g. actions to perform on the graph, without waiting for their responses.
+ * 2- The server receives the requests and invokes the related methods in the library instance, one request at the time,
+ *    in the same order they were sent.
+ * 3- The server sends the results back to the client, in the same order of the requests. The responses are buffered and
+ *    sent together once there are no more requests already received to process.
+ * 4- The client receives the responses, matching them to the requests by their sequence id.
+ *
+ * The connections are served by a fixed number of threads, rather than one thread per connection. The sockets are
+ * non blocking and monitored by a few I/O threads with epoll. When a connection receives a whole request, it is handed
+ * to a worker of a bounded pool, which invokes the library. Each connection is always served by the same worker, so that
+ * its requests are processed in order. A worker serving multiple connections registers itself in the library with the
+ * thread id of the connection being served, as set by the client with ON_THREAD_INIT, re-registering itself when it
+ * switches to a connection with a different thread id. A worker never waits for a slow client: when the socket cannot
+ * take more responses, the connection keeps them buffered, stops processing its requests and is monitored again by
+ * its I/O thread for EPOLLOUT, while the worker moves on to the other connections.
+ *
+ * A client on the same host can move its connection over a shared memory segment (SHARED_MEMORY request). The
+ * connection is then served by a dedicated thread, waiting for the requests on the futex of the segment rather than
+ * through epoll. The TCP connection is kept open only to detect when the client goes away. There are at most as many
+ * dedicated threads as workers, further clients carry on over TCP. A dedicated thread is joined once its connection
+ * is closed.
  *
  * The class is not thread safe.
  */
 class Server {
     std::shared_ptr<library::Interface> m_interface; // the interface we are serving
     const int m_port; // server port
+    const int m_num_io_threads; // number of threads monitoring the connections
+    const int m_num_workers; // number of threads invoking the library
+    const int m_numa_node; // the NUMA node where the threads run and allocate their memory, or -1 for no binding
     int m_server_fd {-1}; // file descriptor used by the server to listen for connections
-    bool m_server_stop { false }; // flag to stop the server accepting connections
+    std::atomic<bool> m_server_stop { false }; // flag to stop the server accepting connections
     std::atomic<bool> m_terminate_on_last_connection { false }; // requested by the client, if true the server should terminate when there are no more connections active (e.g. the client terminated)
     std::atomic<int> m_num_active_connections = 0;
 
+    class Worker; // forward decl.
+
     class ConnectionHandler {
         Server* m_instance;
         int m_fd;
+        const int m_epoll_fd; // the epoll instance monitoring this connection
+        Worker* m_worker; // the worker processing the requests of this connection
+        std::unique_ptr<SharedMemoryChannel> m_channel; // the shared memory segment for the messages, or nullptr to use TCP
+        std::unique_ptr<Worker> m_dedicated_worker; // with shared memory, the library context of the dedicated thread
+        std::thread m_dedicated_thread; // with shared memory, the thread serving the connection
+        int m_thread_id { -1 }; // the thread id set by the client with ON_THREAD_INIT, or -1 if not set
         size_t m_buffer_read_sz = 4096, m_buffer_write_sz = 4096; // capacity of the internal buffers, in bytes
         char* m_buffer_read; // read buffer (for requests)
         char* m_buffer_write; // write buffer (for responses)
+        bool m_buffer_write_zerocopy { false }; // whether the kernel may still be transmitting from the current write buffer, with zero copy
+        struct RetiredBuffer { char* m_buffer; uint32_t m_num_sends; }; // a write buffer released once the first m_num_sends zero copy sends completed
+        std::vector<RetiredBuffer> m_buffers_retired; // previous write buffers, possibly still being transmitted by the kernel
+        bool m_zerocopy { false }; // whether the large flushes over TCP are sent with MSG_ZEROCOPY
+        uint32_t m_zerocopy_num_sends = 0; // number of sends issued with MSG_ZEROCOPY
+        uint32_t m_zerocopy_num_completed = 0; // number of sends with MSG_ZEROCOPY whose pages have been released by the kernel
+        size_t m_read_start = 0; // offset of the current request in the read buffer
+        size_t m_read_end = 0; // amount of bytes received in the read buffer
+        size_t m_write_start = 0; // offset of the first byte of the responses not sent yet
+        size_t m_write_end = 0; // end of the responses in the write buffer
+        bool m_waiting_output { false }; // whether the connection waits for the socket to take the pending responses (EPOLLOUT)
         bool m_terminate { false }; // flag to signal to terminate the handler
+        std::vector<library::UpdateInterface::SingleUpdate> m_frame; // the edges decoded from the last frame received
+        std::vector<uint64_t> m_frame_scratch; // space to decompress the frames of edges
+        bool m_remote_results { false }; // whether to send back the results of the graphalytics kernels, rather than saving them in the server
+        bool m_remote_results_compression { false }; // whether to compress the frames of results
+        std::string m_results_path; // the temporary file where the kernels save the results to send back
+        std::vector<uint64_t> m_result_vertices; // the vertex IDs of the results to send back
+        std::vector<uint64_t> m_result_values; // the values of the results to send back, bitwise
+        size_t m_read_scan = 0; // offset of the first request in the read buffer not timestamped yet
+        std::deque<std::chrono::steady_clock::time_point> m_request_times; // when each request not processed yet was received in full
+        RequestType m_last_request_type { RequestType::TERMINATE_WORKER }; // the last request processed, the pending responses are attributed to it
+        static constexpr size_t flush_threshold = 1024; // send the pending responses once they exceed this amount of bytes, even if there are more requests to process
+        static constexpr size_t zerocopy_threshold = 1ull << 16; // min amount of bytes to flush with MSG_ZEROCOPY, below that copying is cheaper than pinning the pages
+
+        // Write a response with a single string argument, formatted with a std::ostream, directly into the write buffer
+        class ResponseStream;
+        friend class ResponseStream;
 
         /**
-         * Send the given response to the client
+         * Append the given response to the write buffer
          */
         template<typename... Args>
         void response(ResponseType type, Args... args);
 
         /**
-         * Send the given message to the client
+         * Ensure the write buffer can hold a further response of the given size, flushing the pending responses if needed.
+         * If the client is not consuming the responses, the write buffer grows, rather than waiting for the client.
+         */
+        void reserve_response(size_t message_sz);
+
+        /**
+         * Replace the write buffer with a larger one, of at least `required_sz' bytes, copying the first `used_sz' bytes
+         */
+        void grow_write_buffer(size_t used_sz, size_t required_sz);
+
+        /**
+         * Release the write buffer, or retire it if the kernel may still be transmitting from it with zero copy
+         */
+        void retire_write_buffer();
+
+        /**
+         * Wait for the kernel to release the pages of the first `num_sends' sends issued with MSG_ZEROCOPY
+         */
+        void zerocopy_wait(uint32_t num_sends);
+
+        /**
+         * Consume the zero copy notifications in the error queue of the socket, without waiting, and release the retired
+         * write buffers no longer transmitted. Pending notifications raise EPOLLERR, which epoll always reports, even for a
+         * connection waiting for the next request.
+         * @return false if the error queue was already empty, true otherwise
+         */
+        bool zerocopy_drain();
+
+        /**
+         * Retrieve where a graphalytics kernel should save its results, given the path requested by the client
+         */
+        const char* results_path(const std::string& path) const;
+
+        /**
+         * Reply to a graphalytics request. If the client asked for the results, send back those saved by the kernel in
+         * the given path, parsed as values of type T, as a sequence of frames, followed by the final response.
+         */
+        template<typename T>
+        void send_results(const char* path);
+
+        /**
+         * Send the pairs in m_result_vertices and m_result_values as a sequence of RESULT_FRAME responses
+         * @param timer resumed while encoding the frames
+         */
+        void send_frames(common::Timer& timer);
+
+        /**
+         * Process a superstep of a BSP computation (SCATTER_* request): visit the neighbours of the vertices received
+         * and send back, for each neighbour, the aggregate of the values of the vertices it is attached to
          */
-        void send_data(const char* raw_message); // assume that ((uint32_t*)(raw_message))[0] is the message_sz
-        void send_data(const char* data, uint32_t data_sz);
+        void scatter(library::GraphalyticsInterface* graphalytics);
 
         /**
          * Retrieve the request being current processed
@@ -74,13 +187,23 @@ class Server {
          */
         void handle_request();
 
+        /**
+         * Process the current request, record its latencies and move to the next request in the read buffer
+         */
+        void process_request();
+
         /**
          * The library we are evaluating
          */
         library::Interface* interface();
 
+        /**
+         * Check whether the client is still connected, when the messages are exchanged over shared memory
+         */
+        bool is_alive() const;
+
     public:
-        ConnectionHandler(Server* instance, int fd);
+        ConnectionHandler(Server* instance, int fd, int epoll_fd, Worker* worker);
 
         /**
          * Destructor
@@ -88,19 +211,172 @@ class Server {
         ~ConnectionHandler();
 
         /**
-         * Handle all remote requests from the associated file descriptor
+         * Check whether the read buffer contains a whole request, not processed yet
+         */
+        bool has_request() const;
+
+        /**
+         * Receive all data available from the client into the read buffer, without blocking
+         * @return false if the connection has been closed by the client, true otherwise
+         */
+        bool receive();
+
+        /**
+         * Record the arrival time of the requests received in full since the last invocation
+         */
+        void timestamp_requests();
+
+        /**
+         * Send the pending responses to the client, as long as the socket can take them without waiting
+         * @return true if all responses have been sent (or the connection aborted), false if some are still pending
+         */
+        bool flush();
+
+        /**
+         * Send the pending responses over the TCP socket, as long as it can take them without waiting
+         * @return true if all responses have been sent (or the connection aborted), false if some are still pending
          */
-        void execute();
+        bool flush_socket();
+
+        /**
+         * Monitor the connection again in its epoll instance, either for the next request or, with `output', for the
+         * socket to take the pending responses
+         */
+        void rearm(bool output = false);
+
+        /**
+         * Whether the connection waits for the socket to take the pending responses, rather than for the next request
+         */
+        bool is_waiting_output() const;
+
+        /**
+         * Process all requests received so far, and those arriving in the meanwhile, until the socket cannot take more
+         * responses
+         * @return false if the connection should be closed, true otherwise
+         */
+        bool execute();
+
+        /**
+         * Process all requests over the shared memory segment, until the connection is closed or the server stopped.
+         * This is the main loop of the dedicated thread of the connection.
+         */
+        void execute_shared_memory();
+
+        /**
+         * Wait for the dedicated thread of the connection over shared memory, if any, to terminate
+         */
+        void join();
+
+        /**
+         * The thread id set by the client, or -1 if not set
+         */
+        int thread_id() const;
+
+        /**
+         * The worker assigned to this connection
+         */
+        Worker* worker() const;
+
+        /**
+         * The worker of the dedicated thread, with shared memory, or nullptr
+         */
+        Worker* dedicated_worker() const;
     };
     friend class ConnectionHandler;
 
+    /**
+     * Invoke the library for the requests received by the connections assigned to it
+     */
+    class Worker {
+        Server* m_instance;
+        std::thread m_thread; // the thread running the worker
+        std::mutex m_mutex; // protect the queue
+        std::condition_variable m_condvar; // wait for new connections to serve
+        std::deque<ConnectionHandler*> m_queue; // connections with requests ready to be processed
+        bool m_stop { false }; // flag to terminate the worker
+        int m_thread_id { -1 }; // the thread id currently registered in the library by this worker, or -1 if none
+        RequestStatistics m_statistics; // the latencies of the requests processed by this worker, only updated by the worker itself
+        std::atomic<uint64_t> m_statistics_epoch { 0 }; // the reset of the statistics (Server::m_statistics_epoch) the counters refer to
+
+        // Main loop of the worker thread
+        void main_thread();
+
+    public:
+        Worker(Server* instance);
+
+        // Start the worker thread
+        void start();
+
+        // Stop the worker thread and wait for it to terminate
+        void stop();
+
+        // Process the requests of the given connection
+        void submit(ConnectionHandler* connection);
+
+        // Register the thread of the worker in the library with the given id, unregistering the previous id if needed
+        void activate(int thread_id);
+
+        // Unregister the given thread id from the library, if it's the one registered by the worker
+        void deactivate(int thread_id);
+
+        // Retrieve the statistics where to record the latencies of the requests, reset if requested in the meanwhile
+        RequestStatistics& statistics();
+
+        // Add the latencies recorded by the worker to `output', unless they precede the reset `epoch'
+        void collect_statistics(RequestStatistics& output, uint64_t epoch) const;
+    };
+    friend class Worker;
+
+    std::vector<int> m_epoll_fds; // one epoll instance for each I/O thread
+    std::vector<std::thread> m_io_threads; // the threads monitoring the connections
+    std::vector<std::unique_ptr<Worker>> m_workers; // the pool of workers
+    std::mutex m_connections_mutex; // protect m_connections
+    std::unordered_set<ConnectionHandler*> m_connections; // all connections currently open
+    std::vector<ConnectionHandler*> m_connections_terminated; // connections over shared memory whose dedicated thread terminated, to be joined and closed, protected by m_connections_mutex
+    int m_num_shared_memory_connections = 0; // number of connections served by a dedicated thread, protected by m_connections_mutex
+    uint64_t m_num_connections_opened = 0; // total number of connections accepted, to assign them round robin to the I/O threads and the workers
+    std::mutex m_statistics_mutex; // protect m_statistics_retired
+    RequestStatistics m_statistics_retired; // the latencies recorded by the workers no longer active
+    std::atomic<uint64_t> m_statistics_epoch { 0 }; // incremented at each reset of the statistics, the workers reset their own counters lazily
+
+    // Main loop of an I/O thread
+    void io_thread(int epoll_fd);
+
+    // Register a new connection from a client
+    void open_connection(int fd);
+
+    // Close the connection with a client
+    void close_connection(ConnectionHandler* connection);
+
+    // Join the dedicated threads terminated and close their connections
+    void reap_connections();
+
+    // Merge the latencies recorded by all workers, including those no longer active, into `output'
+    void collect_statistics(RequestStatistics& output);
+
+    // Keep the latencies recorded by a worker about to be destroyed
+    void retire_statistics(Worker* worker);
+
+    // Reset the latencies recorded by all workers
+    void reset_statistics();
+
+    // Start the I/O threads and the workers
+    void start_threads();
+
+    // Stop the I/O threads and the workers, close the connections still open
+    void stop_threads();
+
 public:
     /**
      * Initialise the server and listen for connections from the given port
      * @param interface pass all requests to the given interface
      * @param port the port to listen for TCP connections
+     * @param num_io_threads the number of threads monitoring the connections
+     * @param num_workers the number of threads invoking the library, 0 to use the number of hardware threads
+     * @param numa_node if non negative, bind the threads of the server to the given NUMA node, e.g. to host one partition
+     *        of a graph on each socket. It requires libnuma.
      */
-    Server(std::shared_ptr<library::Interface> interface, int port);
+    Server(std::shared_ptr<library::Interface> interface, int port, int num_io_threads = 1, int num_workers = 0, int numa_node = -1);
 
     /**
      * Destructor
@@ -0,0 +1,246 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "shared_memory.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "internal.hpp"
+
+using namespace std;
+
+namespace gfe::network {
+
+/*****************************************************************************
+ *                                                                           *
+ * Ring                                                                      *
+ *                                                                           *
+ *****************************************************************************/
+
+// Number of times to check the condition before sleeping on the futex. The requests and the responses usually follow
+// each other within a few microsecs, spinning avoids the cost of a syscall to go to sleep and another to be woken up.
+constexpr static int NUM_SPINS = 1000;
+
+SharedMemoryRing::SharedMemoryRing(Header* header, char* buffer, uint64_t capacity) : m_header(header), m_buffer(buffer), m_capacity(capacity) {
+    assert((capacity & (capacity -1)) == 0 && "The capacity must be a power of 2");
+}
+
+void SharedMemoryRing::futex_wait(atomic<uint32_t>* futex, uint32_t value, chrono::microseconds timeout){
+    struct timespec ts;
+    ts.tv_sec = timeout.count() / 1000000;
+    ts.tv_nsec = (timeout.count() % 1000000) * 1000;
+    // not FUTEX_WAIT_PRIVATE, the futex is shared with another process
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(futex), FUTEX_WAIT, value, &ts, nullptr, 0); // ignore rc: EAGAIN, EINTR and ETIMEDOUT are all fine
+}
+
+void SharedMemoryRing::futex_wake(atomic<uint32_t>* futex){
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(futex), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+template<typename Predicate>
+bool SharedMemoryRing::wait(atomic<uint32_t>* futex, atomic<uint32_t>* waiting, Predicate predicate, chrono::microseconds timeout){
+    for(int i = 0; i < NUM_SPINS; i++){
+        if(predicate()) return true;
+    }
+
+    auto deadline = chrono::steady_clock::now() + timeout;
+    while(true){
+        // the other end increments the futex after changing the ring, re-check the predicate after reading its value
+        uint32_t value = futex->load(memory_order_acquire);
+        waiting->store(1, memory_order_seq_cst);
+        if(predicate()){ waiting->store(0, memory_order_relaxed); return true; }
+
+        auto now = chrono::steady_clock::now();
+        if(now >= deadline){ waiting->store(0, memory_order_relaxed); return false; }
+        futex_wait(futex, value, chrono::duration_cast<chrono::microseconds>(deadline - now));
+        waiting->store(0, memory_order_relaxed);
+    }
+}
+
+bool SharedMemoryRing::write(const char* buffer, uint64_t size, const function<bool()>& is_alive){
+    while(size > 0){
+        const uint64_t head = m_header->m_head.load(memory_order_relaxed); // only updated by the producer
+        auto has_space = [this, head](){ return head - m_header->m_tail.load(memory_order_acquire) < m_capacity; };
+        while(!wait(&(m_header->m_space_futex), &(m_header->m_producer_waiting), has_space, chrono::seconds(1))) {
+            if(!is_alive()) return false;
+        };
+
+        // copy as much as possible, up to the end of the buffer
+        const uint64_t space = m_capacity - (head - m_header->m_tail.load(memory_order_acquire));
+        const uint64_t offset = head & (m_capacity -1);
+        const uint64_t length = min(size, min(space, m_capacity - offset));
+        memcpy(m_buffer + offset, buffer, length);
+        m_header->m_head.store(head + length, memory_order_release);
+        buffer += length;
+        size -= length;
+
+        // wake up the consumer
+        m_header->m_data_futex.fetch_add(1, memory_order_seq_cst);
+        if(m_header->m_consumer_waiting.load(memory_order_seq_cst)){ futex_wake(&(m_header->m_data_futex)); }
+    }
+
+    return true;
+}
+
+uint64_t SharedMemoryRing::read_some(char* buffer, uint64_t size){
+    uint64_t num_bytes_read = 0;
+    while(size > 0){
+        const uint64_t tail = m_header->m_tail.load(memory_order_relaxed); // only updated by the consumer
+        const uint64_t available = m_header->m_head.load(memory_order_acquire) - tail;
+        if(available == 0) break;
+
+        // copy as much as possible, up to the end of the buffer
+        const uint64_t offset = tail & (m_capacity -1);
+        const uint64_t length = min(size, min(available, m_capacity - offset));
+        memcpy(buffer, m_buffer + offset, length);
+        m_header->m_tail.store(tail + length, memory_order_release);
+        buffer += length;
+        size -= length;
+        num_bytes_read += length;
+    }
+
+    if(num_bytes_read > 0){ // wake up the producer
+        m_header->m_space_futex.fetch_add(1, memory_order_seq_cst);
+        if(m_header->m_producer_waiting.load(memory_order_seq_cst)){ futex_wake(&(m_header->m_space_futex)); }
+    }
+
+    return num_bytes_read;
+}
+
+bool SharedMemoryRing::read(char* buffer, uint64_t size, const function<bool()>& is_alive){
+    while(size > 0){
+        while(!wait_data(chrono::seconds(1))) {
+            if(!is_alive()) return false;
+        };
+        uint64_t num_bytes_read = read_some(buffer, size);
+        buffer += num_bytes_read;
+        size -= num_bytes_read;
+    }
+
+    return true;
+}
+
+bool SharedMemoryRing::wait_data(chrono::microseconds timeout){
+    return wait(&(m_header->m_data_futex), &(m_header->m_consumer_waiting), [this](){ return size() > 0; }, timeout);
+}
+
+uint64_t SharedMemoryRing::size() const {
+    return m_header->m_head.load(memory_order_acquire) - m_header->m_tail.load(memory_order_relaxed);
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Channel                                                                   *
+ *                                                                           *
+ *****************************************************************************/
+namespace {
+
+// The layout of the segment: this header, the state of the two rings, then the content of the rings
+struct SegmentHeader {
+    uint64_t m_capacity; // the size of each ring, in bytes
+    alignas(64) SharedMemoryRing::Header m_requests;
+    alignas(64) SharedMemoryRing::Header m_responses;
+};
+
+constexpr uint64_t SEGMENT_HEADER_SZ = 4096; // the content of the rings starts at this offset
+static_assert(sizeof(SegmentHeader) <= SEGMENT_HEADER_SZ);
+
+} // anon namespace
+
+SharedMemoryChannel::SharedMemoryChannel(const string& name, uint64_t capacity) : m_name(name), m_is_owner(true) {
+    if(capacity == 0 || (capacity & (capacity -1)) != 0) ERROR("The capacity of the rings must be a power of 2: " << capacity);
+
+    int fd = shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if(fd < 0) ERROR_ERRNO("Cannot create the shared memory segment `" << m_name << "'");
+    if(ftruncate(fd, SEGMENT_HEADER_SZ + 2 * capacity) != 0){
+        close(fd);
+        shm_unlink(m_name.c_str());
+        ERROR_ERRNO("Cannot resize the shared memory segment `" << m_name << "'");
+    }
+
+    map(fd, capacity, /* initialise ? */ true);
+}
+
+SharedMemoryChannel::SharedMemoryChannel(const string& name) : m_name(name), m_is_owner(false) {
+    int fd = shm_open(m_name.c_str(), O_RDWR, 0);
+    if(fd < 0) ERROR_ERRNO("Cannot open the shared memory segment `" << m_name << "'");
+
+    uint64_t capacity = 0;
+    if(pread(fd, &capacity, sizeof(capacity), 0) != sizeof(capacity) || capacity == 0 || (capacity & (capacity -1)) != 0){
+        close(fd);
+        ERROR("Invalid shared memory segment `" << m_name << "'");
+    }
+
+    map(fd, capacity, /* initialise ? */ false);
+}
+
+void SharedMemoryChannel::map(int fd, uint64_t capacity, bool initialise){
+    m_segment_sz = SEGMENT_HEADER_SZ + 2 * capacity;
+    m_segment = mmap(nullptr, m_segment_sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the segment alive
+    if(m_segment == MAP_FAILED){
+        m_segment = nullptr;
+        if(m_is_owner){ shm_unlink(m_name.c_str()); }
+        ERROR_ERRNO("Cannot map the shared memory segment `" << m_name << "'");
+    }
+
+    SegmentHeader* header = reinterpret_cast<SegmentHeader*>(m_segment);
+    if(initialise){ // the segment is zero-filled by ftruncate, the atomics are already zero
+        header->m_capacity = capacity;
+    }
+
+    char* content = reinterpret_cast<char*>(m_segment) + SEGMENT_HEADER_SZ;
+    m_requests.reset(new SharedMemoryRing(&(header->m_requests), content, capacity));
+    m_responses.reset(new SharedMemoryRing(&(header->m_responses), content + capacity, capacity));
+}
+
+SharedMemoryChannel::~SharedMemoryChannel(){
+    unlink();
+    if(m_segment != nullptr){
+        munmap(m_segment, m_segment_sz);
+        m_segment = nullptr;
+    }
+}
+
+void SharedMemoryChannel::unlink(){
+    if(m_is_owner){
+        shm_unlink(m_name.c_str()); // ignore rc
+        m_is_owner = false;
+    }
+}
+
+const string& SharedMemoryChannel::name() const {
+    return m_name;
+}
+
+SharedMemoryRing& SharedMemoryChannel::requests(){
+    return *m_requests;
+}
+
+SharedMemoryRing& SharedMemoryChannel::responses(){
+    return *m_responses;
+}
+
+} // namespace
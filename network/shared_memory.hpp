@@ -0,0 +1,162 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace gfe::network {
+
+/**
+ * A single producer single consumer ring of bytes, placed in a shared memory segment. The producer and the consumer can
+ * live in different processes. They wait on each other, for new data or for free space, with a futex on the segment.
+ * The ring is a stream of bytes, as a TCP connection, the messages are framed by their size (e.g. Request and Response).
+ * A blocking operation periodically checks whether the other end is still alive, as a process can terminate without
+ * ever releasing the segment.
+ */
+class SharedMemoryRing {
+public:
+    // The state of the ring, in the shared memory segment
+    struct Header {
+        alignas(64) std::atomic<uint64_t> m_head; // total number of bytes written by the producer
+        alignas(64) std::atomic<uint64_t> m_tail; // total number of bytes read by the consumer
+        alignas(64) std::atomic<uint32_t> m_data_futex; // incremented by the producer every time it writes
+        std::atomic<uint32_t> m_consumer_waiting; // whether the consumer is sleeping on m_data_futex
+        alignas(64) std::atomic<uint32_t> m_space_futex; // incremented by the consumer every time it reads
+        std::atomic<uint32_t> m_producer_waiting; // whether the producer is sleeping on m_space_futex
+    };
+
+private:
+    Header* m_header; // the state of the ring
+    char* m_buffer; // the content of the ring
+    uint64_t m_capacity; // the size of m_buffer, in bytes, a power of 2
+
+    // Wait until the futex changes from the given value, or the timeout expires
+    static void futex_wait(std::atomic<uint32_t>* futex, uint32_t value, std::chrono::microseconds timeout);
+
+    // Wake up the process sleeping on the given futex
+    static void futex_wake(std::atomic<uint32_t>* futex);
+
+    // Wait until the predicate holds, sleeping on the given futex
+    template<typename Predicate>
+    bool wait(std::atomic<uint32_t>* futex, std::atomic<uint32_t>* waiting, Predicate predicate, std::chrono::microseconds timeout);
+
+public:
+    /**
+     * Create a view of a ring
+     * @param header the state of the ring, in the shared memory segment
+     * @param buffer the content of the ring
+     * @param capacity the size of the buffer, in bytes, a power of 2
+     */
+    SharedMemoryRing(Header* header, char* buffer, uint64_t capacity);
+
+    /**
+     * Producer side. Write the whole buffer in the ring, waiting for the consumer to make room if needed.
+     * @param is_alive invoked about every second while waiting, to check whether the consumer is still there
+     * @return true if the whole buffer has been written, false if the consumer is gone
+     */
+    bool write(const char* buffer, uint64_t size, const std::function<bool()>& is_alive);
+
+    /**
+     * Consumer side. Read up to `size' bytes from the ring, without waiting.
+     * @return the number of bytes read
+     */
+    uint64_t read_some(char* buffer, uint64_t size);
+
+    /**
+     * Consumer side. Read exactly `size' bytes from the ring, waiting for the producer if needed.
+     * @param is_alive invoked about every second while waiting, to check whether the producer is still there
+     * @return true if all bytes have been read, false if the producer is gone
+     */
+    bool read(char* buffer, uint64_t size, const std::function<bool()>& is_alive);
+
+    /**
+     * Consumer side. Wait until there is some data to read, or the timeout expires.
+     * @return true if there is data to read, false in case of timeout
+     */
+    bool wait_data(std::chrono::microseconds timeout);
+
+    /**
+     * Retrieve the number of bytes that can be read
+     */
+    uint64_t size() const;
+};
+
+/**
+ * A connection between a client and a server on the same host, over a POSIX shared memory segment. The segment contains
+ * two rings: one for the requests, from the client to the server, and one for the responses, from the server to the
+ * client. The client creates the segment and sends its name to the server, which attaches to it.
+ */
+class SharedMemoryChannel {
+    SharedMemoryChannel(const SharedMemoryChannel&) = delete;
+    SharedMemoryChannel& operator=(const SharedMemoryChannel&) = delete;
+
+    const std::string m_name; // the name of the segment, as for shm_open
+    bool m_is_owner; // whether this instance created the segment
+    void* m_segment { nullptr }; // the mapped segment
+    uint64_t m_segment_sz { 0 }; // the size of the mapped segment, in bytes
+    std::unique_ptr<SharedMemoryRing> m_requests; // client -> server
+    std::unique_ptr<SharedMemoryRing> m_responses; // server -> client
+
+    // Map the segment in the address space of the process and initialise the rings
+    void map(int fd, uint64_t capacity, bool initialise);
+
+public:
+    /**
+     * Create a new segment, with the given name, as the client side of the channel
+     * @param name the name of the segment, it must start with a slash
+     * @param capacity the size of each ring, in bytes, a power of 2
+     */
+    SharedMemoryChannel(const std::string& name, uint64_t capacity);
+
+    /**
+     * Attach to an existing segment, as the server side of the channel
+     */
+    SharedMemoryChannel(const std::string& name);
+
+    /**
+     * Unmap the segment. If the segment was created by this instance and not unlinked yet, remove it.
+     */
+    ~SharedMemoryChannel();
+
+    /**
+     * Remove the name of the segment, once the other end has attached to it. The segment is released when both ends unmap it.
+     */
+    void unlink();
+
+    /**
+     * The name of the segment
+     */
+    const std::string& name() const;
+
+    /**
+     * The ring from the client to the server
+     */
+    SharedMemoryRing& requests();
+
+    /**
+     * The ring from the server to the client
+     */
+    SharedMemoryRing& responses();
+};
+
+} // namespace
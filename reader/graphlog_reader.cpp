@@ -113,6 +113,22 @@ void set_marker(const Properties& properties, std::fstream& handle, Section sect
     handle.seekg(stoull(property->second));
 }
 
+vector<uint64_t> load_vertices_final(const std::string& path_graphlog){
+    if(!common::filesystem::file_exists(path_graphlog)) ERROR("The given file does not exist: " << path_graphlog);
+    fstream handle{path_graphlog, ios_base::in | ios_base::binary};
+    if(!handle.good()) ERROR("Cannot open the file: " << path_graphlog);
+    Properties properties = parse_properties(handle);
+
+    vector<uint64_t> vertices ( stoull(properties["internal.vertices.final.cardinality"]) );
+    set_marker(properties, handle, Section::VTX_FINAL);
+    VertexLoader loader { handle };
+    uint64_t num_vertices = loader.load(vertices.data(), vertices.size());
+    vertices.resize(num_vertices);
+    handle.close();
+
+    return vertices;
+}
+
 } // namespace graphlog
 
 /*****************************************************************************
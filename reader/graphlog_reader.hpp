@@ -25,6 +25,7 @@
 #include <memory>
 #include <random>
 #include <unordered_map>
+#include <vector>
 
 namespace gfe::graph { class WeightedEdge; } // forward decl.
 
@@ -65,6 +66,9 @@ Properties parse_properties(std::fstream& handle);
 enum class Section { VTX_FINAL, VTX_TEMP, EDGES };
 void set_marker(const Properties& properties, std::fstream& handle, Section section);
 
+// Load all the vertices of the final graph from the given file
+std::vector<uint64_t> load_vertices_final(const std::string& path_graphlog);
+
 // Load the vertices from the given graph. The handle should already be position at the start of the respective compressed section.
 class VertexLoader {
     VertexLoader(const VertexLoader&) = delete;
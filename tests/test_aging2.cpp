@@ -32,7 +32,7 @@ using namespace gfe::library;
 using namespace std;
 
 static
-void validate_aging2(bool is_directed, const string& path_graph, const string& path_log, uint64_t exp_granularity = 1024){
+void validate_aging2(bool is_directed, const string& path_graph, const string& path_log, uint64_t exp_granularity = 1024, Aging2Partition partition = Aging2Partition::HASH, bool work_stealing = false, const string& trace_record = "", const string& trace_replay = ""){
     auto stream = make_shared<WeightedEdgeStream>(path_graph);
     auto adjlist = make_shared<AdjacencyList>(is_directed);
 
@@ -41,6 +41,10 @@ void validate_aging2(bool is_directed, const string& path_graph, const string& p
     exp_aging.set_log(path_log);
     exp_aging.set_parallelism_degree(8);
     exp_aging.set_worker_granularity(exp_granularity);
+    exp_aging.set_partition(partition);
+    exp_aging.set_work_stealing(work_stealing);
+    exp_aging.set_trace_record(trace_record);
+    exp_aging.set_trace_replay(trace_replay);
     exp_aging.execute();
 
     adjlist->dump();
@@ -70,3 +74,29 @@ TEST(Aging2, Undirected){
     const string path_log = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.graphlog";
     validate_aging2(/* is directed ? */ false, path_graph, path_log, 4);
 }
+
+TEST(Aging2, PartitionSource){
+    const string path_graph = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+    const string path_log = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.graphlog";
+    validate_aging2(/* is directed ? */ false, path_graph, path_log, 4, Aging2Partition::SOURCE);
+}
+
+TEST(Aging2, PartitionRange){
+    const string path_graph = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+    const string path_log = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.graphlog";
+    validate_aging2(/* is directed ? */ false, path_graph, path_log, 4, Aging2Partition::RANGE);
+}
+
+TEST(Aging2, WorkStealing){
+    const string path_graph = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+    const string path_log = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.graphlog";
+    validate_aging2(/* is directed ? */ false, path_graph, path_log, 4, Aging2Partition::SOURCE, /* work stealing */ true);
+}
+
+TEST(Aging2, RecordReplay){
+    const string path_graph = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+    const string path_log = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.graphlog";
+    const string path_trace = common::filesystem::directory_executable() + "/test_aging2_trace";
+    validate_aging2(/* is directed ? */ false, path_graph, path_log, 4, Aging2Partition::HASH, false, /* record */ path_trace, "");
+    validate_aging2(/* is directed ? */ false, path_graph, path_log, 4, Aging2Partition::HASH, false, "", /* replay */ path_trace);
+}
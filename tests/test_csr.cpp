@@ -18,9 +18,12 @@
 #include "gtest/gtest.h"
 
 #include <string>
+#include <unordered_map>
 
 #include "common/filesystem.hpp"
 #include "graph/edge_stream.hpp"
+#include "graph/vertex_list.hpp"
+#include "library/analytics_session.hpp"
 #include "library/baseline/adjacency_list.hpp"
 #include "library/baseline/csr.hpp"
 
@@ -67,3 +70,128 @@ TEST(CSR, LoadUndirected){
     }
 }
 
+
+// Check that #scan_neighbors visits the same edges in the CSR and in the adjacency list, and that it can stop the scan early
+TEST(CSR, ScanNeighbours){
+    string graph_path = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+
+    CSR csr { /* directed */ false };
+    csr.load(graph_path);
+    AdjacencyList adjlist { /* directed */ false };
+    adjlist.load(graph_path);
+
+    gfe::graph::WeightedEdgeStream stream { graph_path };
+    for(uint64_t i = 0; i < stream.num_edges(); i++){
+        uint64_t vertex = stream.get(i).source();
+
+        uint64_t num_edges_csr = 0;
+        ASSERT_TRUE( csr.scan_neighbors(vertex, [&](uint64_t destination, double weight){
+            EXPECT_EQ( csr.get_weight(vertex, destination), weight );
+            num_edges_csr++;
+            return true;
+        }) );
+        uint64_t num_edges_adjlist = 0;
+        ASSERT_TRUE( adjlist.scan_neighbors(vertex, [&](uint64_t destination, double weight){
+            EXPECT_EQ( csr.get_weight(vertex, destination), weight );
+            num_edges_adjlist++;
+            return true;
+        }) );
+        ASSERT_EQ( num_edges_csr, num_edges_adjlist );
+
+        // stop after the first edge
+        uint64_t num_edges_visited = 0;
+        ASSERT_TRUE( csr.scan_neighbors(vertex, [&](uint64_t, double){ num_edges_visited++; return false; }) );
+        ASSERT_EQ( num_edges_visited, 1 );
+    }
+
+    ASSERT_FALSE( csr.scan_neighbors(1ull<<50, [](uint64_t, double){ return true; }) );
+    ASSERT_FALSE( adjlist.scan_neighbors(1ull<<50, [](uint64_t, double){ return true; }) );
+}
+
+// Copy the graph loaded in `source' into `target' through #materialize_begin, #materialize_edge and #materialize_end, as a
+// dynamic library would do with its snapshot. The internal vertex IDs are sparse, and the edges are visited in reverse order.
+static void materialize(const string& graph_path, CSR& source, CSR& target){
+    gfe::graph::WeightedEdgeStream stream { graph_path };
+    auto vertices = stream.vertex_list();
+
+    unordered_map<uint64_t, uint64_t> ext2int;
+    AnalyticsSnapshot snapshot { vertices->num_vertices() * 2 +1 };
+    for(uint64_t i = 0; i < vertices->num_vertices(); i++){
+        uint64_t external_id = vertices->get(i);
+        uint64_t internal_id = 2 * i +1; // leave a hole between two vertices
+        ext2int[external_id] = internal_id;
+        uint64_t degree = 0;
+        source.scan_neighbors(external_id, [&](uint64_t, double){ degree++; return true; });
+        snapshot.set_vertex(internal_id, external_id, degree);
+    }
+    snapshot.seal(source.is_directed());
+    ASSERT_EQ( snapshot.num_vertices(), source.num_vertices() );
+    ASSERT_EQ( snapshot.num_edges(), source.num_edges() );
+
+    target.materialize_begin(snapshot);
+    for(uint64_t i = 0; i < vertices->num_vertices(); i++){
+        uint64_t external_id = vertices->get(i);
+        uint64_t position = snapshot.degrees()[ext2int[external_id]];
+        source.scan_neighbors(external_id, [&](uint64_t destination, double weight){
+            target.materialize_edge(ext2int[external_id], --position, ext2int[destination], weight);
+            return true;
+        });
+    }
+    target.materialize_end();
+}
+
+// Check that the edges of the snapshot are sorted by destination, in the logical vertex IDs
+static void check_sorted(uint64_t num_vertices, const uint64_t* vertex_array, const uint64_t* edge_array){
+    for(uint64_t v = 0; v < num_vertices; v++){
+        uint64_t start = (v == 0) ? 0 : vertex_array[v -1];
+        for(uint64_t i = start +1; i < vertex_array[v]; i++){
+            ASSERT_LT( edge_array[i -1], edge_array[i] );
+        }
+    }
+}
+
+// Check that a snapshot of graphs/ldbc_graphalytics/example-directed.properties is properly materialised into a CSR
+TEST(CSR, MaterializeDirected){
+    string graph_path = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-directed.properties";
+
+    CSR source { /* directed */ true };
+    source.load(graph_path);
+    CSR csr { /* directed */ true };
+    materialize(graph_path, source, csr);
+
+    gfe::graph::WeightedEdgeStream stream { graph_path };
+    ASSERT_EQ( csr.num_vertices(), source.num_vertices() );
+    ASSERT_EQ( csr.num_edges(), stream.num_edges() );
+    for(uint64_t i = 0; i < stream.num_edges(); i++){
+        auto edge = stream.get(i);
+        ASSERT_TRUE( csr.has_vertex(edge.source()) );
+        ASSERT_TRUE( csr.has_vertex(edge.destination()) );
+        ASSERT_TRUE( csr.has_edge(edge.source(), edge.destination()) );
+        ASSERT_EQ( csr.get_weight(edge.source(), edge.destination()), edge.weight() );
+    }
+    check_sorted(csr.num_vertices(), csr.out_v(), csr.out_e());
+    ASSERT_EQ( csr.in_v()[csr.num_vertices() -1], csr.num_edges() );
+    check_sorted(csr.num_vertices(), csr.in_v(), csr.in_e());
+}
+
+// Check that a snapshot of graphs/ldbc_graphalytics/example-undirected.properties is properly materialised into a CSR
+TEST(CSR, MaterializeUndirected){
+    string graph_path = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+
+    CSR source { /* directed */ false };
+    source.load(graph_path);
+    CSR csr { /* directed */ false };
+    materialize(graph_path, source, csr);
+
+    gfe::graph::WeightedEdgeStream stream { graph_path };
+    ASSERT_EQ( csr.num_vertices(), source.num_vertices() );
+    ASSERT_EQ( csr.num_edges(), stream.num_edges() );
+    for(uint64_t i = 0; i < stream.num_edges(); i++){
+        auto edge = stream.get(i);
+        ASSERT_TRUE( csr.has_edge(edge.source(), edge.destination()) );
+        ASSERT_EQ( csr.get_weight(edge.source(), edge.destination()), edge.weight() );
+        ASSERT_TRUE( csr.has_edge(edge.destination(), edge.source()) );
+        ASSERT_EQ( csr.get_weight(edge.destination(), edge.source()), edge.weight() );
+    }
+    check_sorted(csr.num_vertices(), csr.out_v(), csr.out_e());
+}
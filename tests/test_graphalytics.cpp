@@ -16,11 +16,18 @@
  */
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib> // mkstemp
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unistd.h>
 #include <unordered_set>
 
 #include "common/error.hpp"
@@ -49,9 +56,13 @@
 #if defined(HAVE_SORTLEDTON)
 #include "library/sortledton/sortledton_driver.hpp"
 #endif
+#include "library/analytics_session.hpp"
 #include "library/interface.hpp"
+#include "network/partitioned_client.hpp"
+#include "network/server.hpp"
 #include "reader/graphalytics_reader.hpp"
 #include "utility/graphalytics_validate.hpp"
+#include "utility/result_writer.hpp"
 
 using namespace gfe::library;
 using namespace gfe::utility;
@@ -179,6 +190,140 @@ static void validate(gfe::library::GraphalyticsInterface* interface, const std::
     interface->on_main_destroy();
 }
 
+// Run BFS, PageRank, WCC and SSSP in the same analytics session, optionally over the snapshot materialised into a CSR
+static void validate_session(gfe::library::GraphalyticsInterface* interface, const std::string& path_graphalytics_graph, bool materialize_csr = false, int algorithms = GA_BFS | GA_PAGERANK | GA_WCC | GA_SSSP){
+    interface->on_main_init(1);
+    interface->on_thread_init(0);
+
+    gfe::reader::GraphalyticsReader reader { path_graphalytics_graph + ".properties" }; // to parse the properties in the file
+    auto session = interface->begin_analytics_session();
+    if(materialize_csr){
+        ASSERT_TRUE( session->materialize_csr() );
+        ASSERT_NE( session->csr(), nullptr );
+    }
+
+    string path_result;
+    if(algorithms & GA_BFS){
+        path_result = temp_file_path();
+        LOG("Session BFS, result: " << path_result);
+        session->bfs(stoull(reader.get_property("bfs.source-vertex")), path_result.c_str());
+        GraphalyticsValidate::bfs(path_result, path_graphalytics_graph + "-BFS");
+    }
+
+    if(algorithms & GA_PAGERANK){
+        path_result = temp_file_path();
+        LOG("Session PAGERANK, result: " << path_result);
+        session->pagerank(stoull(reader.get_property("pr.num-iterations")), stod(reader.get_property("pr.damping-factor")), path_result.c_str());
+        GraphalyticsValidate::pagerank(path_result, path_graphalytics_graph + "-PR");
+    }
+
+    if(algorithms & GA_WCC){
+        path_result = temp_file_path();
+        LOG("Session WCC, result: " << path_result);
+        session->wcc(path_result.c_str());
+        GraphalyticsValidate::wcc(path_result, path_graphalytics_graph + "-WCC");
+    }
+
+    if(algorithms & GA_SSSP){
+        path_result = temp_file_path();
+        LOG("Session SSSP, result: " << path_result);
+        session->sssp(stoull(reader.get_property("sssp.source-vertex")), path_result.c_str());
+        GraphalyticsValidate::sssp(path_result, path_graphalytics_graph + "-SSSP");
+    }
+    LOG("Session, validation succeeded");
+
+    session.reset(); // release the snapshot
+    interface->on_thread_destroy(0);
+    interface->on_main_destroy();
+}
+
+// The output of the parallel writer must be identical to the one of std::ostream
+template<typename T>
+static void validate_result_writer(const vector<pair<uint64_t, T>>& result, bool negative_scores, bool skip_invalid = true){
+    stringstream expected;
+    for(const auto& p : result){
+        if(skip_invalid && p.first == numeric_limits<uint64_t>::max()) continue; // invalid node
+        expected << p.first << " ";
+        if(!negative_scores && p.second < 0){
+            expected << numeric_limits<T>::max();
+        } else {
+            expected << p.second;
+        }
+        expected << "\n";
+    }
+
+    string path_result = temp_file_path();
+    save_results(result, path_result.c_str(), negative_scores, skip_invalid);
+    fstream handle(path_result, ios_base::in);
+    stringstream actual;
+    actual << handle.rdbuf();
+    ASSERT_EQ(actual.str(), expected.str());
+}
+
+TEST(ResultWriter, Format){
+    mt19937_64 random_generator { 42 };
+    uniform_real_distribution<double> random_score { -1, 1 };
+    vector<pair<uint64_t, int64_t>> distances;
+    vector<pair<uint64_t, uint64_t>> components;
+    vector<pair<uint64_t, double>> scores;
+    for(uint64_t i = 0; i < 300000; i++){ // span multiple chunks
+        uint64_t vertex_id = (i % 1000 == 7) ? numeric_limits<uint64_t>::max() : random_generator();
+        distances.emplace_back(vertex_id, static_cast<int64_t>(random_generator() % 1000) - 500);
+        components.emplace_back(vertex_id, random_generator());
+        double score = random_score(random_generator) * pow(10, static_cast<int>(random_generator() % 40) - 20);
+        if(i % 11 == 0) score = numeric_limits<double>::infinity();
+        scores.emplace_back(vertex_id, score);
+    }
+
+    for(bool negative_scores : { true, false }){
+        validate_result_writer(distances, negative_scores);
+        validate_result_writer(components, negative_scores);
+        validate_result_writer(scores, negative_scores);
+    }
+    validate_result_writer(distances, true, /* skip invalid */ false); // LLAMA & Sortledton
+    validate_result_writer(scores, false, /* skip invalid */ false);
+    validate_result_writer(vector<pair<uint64_t, double>>{}, true); // empty result
+}
+
+// The validator must detect the mismatches regardless of the order of the vertices in the two files
+TEST(GraphalyticsValidate, Mismatch){
+    auto write_file = [](const vector<pair<uint64_t, int64_t>>& content){
+        string path = temp_file_path();
+        fstream handle(path, ios_base::out);
+        for(const auto& p : content){ handle << p.first << " " << p.second << "\n"; }
+        return path;
+    };
+
+    vector<pair<uint64_t, int64_t>> expected;
+    for(uint64_t i = 0; i < 100000; i++){ expected.emplace_back(i * 7 + 1, i % 13); }
+    vector<pair<uint64_t, int64_t>> result = expected;
+    shuffle(result.begin(), result.end(), mt19937_64{ 42 });
+    string path_expected = write_file(expected);
+    GraphalyticsValidate::bfs(write_file(result), path_expected);
+
+    // components relabelled in the result
+    vector<pair<uint64_t, int64_t>> components = result;
+    for(auto& p : components){ p.second = p.second * 1000 + 5; }
+    GraphalyticsValidate::wcc(write_file(components), path_expected);
+
+    // value mismatch
+    result[result.size() / 2].second++;
+    ASSERT_THROW(GraphalyticsValidate::bfs(write_file(result), path_expected), GraphalyticsValidateError);
+    result[result.size() / 2].second--;
+
+    // two components merged in the result
+    components[0].second = find_if(components.begin(), components.end(), [&](const auto& p){ return p.second != components[0].second; })->second;
+    ASSERT_THROW(GraphalyticsValidate::wcc(write_file(components), path_expected), GraphalyticsValidateError);
+
+    // missing vertex
+    result.pop_back();
+    ASSERT_THROW(GraphalyticsValidate::bfs(write_file(result), path_expected), GraphalyticsValidateError);
+
+    // duplicate vertex
+    result.push_back(result.front());
+    ASSERT_THROW(GraphalyticsValidate::bfs(write_file(result), path_expected), GraphalyticsValidateError);
+}
+
 TEST(AdjacencyList, GraphalyticsDirected){
     auto adjlist = make_unique<AdjacencyList>(/* directed */ true);
     load_graph(adjlist.get(), path_example_directed);
@@ -191,6 +336,95 @@ TEST(AdjacencyList, GraphalyticsUndirected){
     validate(adjlist.get(), path_example_undirected);
 }
 
+TEST(AdjacencyList, AnalyticsSession){
+    auto adjlist = make_unique<AdjacencyList>(/* directed */ false);
+    load_graph(adjlist.get(), path_example_undirected);
+    validate_session(adjlist.get(), path_example_undirected);
+}
+
+// A server on the loopback interface, hosting its own adjacency list
+namespace {
+struct LoopbackServer {
+    shared_ptr<AdjacencyList> m_library;
+    unique_ptr<gfe::network::Server> m_server;
+    thread m_thread;
+    const int m_port;
+
+    static int next_port(){
+        static int port = 20000 + getpid() % 20000;
+        return port++;
+    }
+
+    LoopbackServer(bool is_directed) : m_library(make_shared<AdjacencyList>(is_directed)), m_port(next_port()) {
+        m_server.reset(new gfe::network::Server(m_library, m_port, /* I/O threads */ 1, /* workers */ 2));
+        m_thread = thread([this](){ m_server->main_loop(); });
+    }
+
+    ~LoopbackServer(){
+        m_server->stop();
+        m_thread.join();
+    }
+};
+} // anonymous namespace
+
+// Partition the graph over multiple servers. The results of the BSP kernels must be the same of a single instance.
+static void validate_partitioned(bool is_directed, const std::string& path_graphalytics_graph, int num_servers){
+    vector<unique_ptr<LoopbackServer>> servers;
+    vector<pair<string, int>> addresses;
+    for(int i = 0; i < num_servers; i++){
+        servers.emplace_back(new LoopbackServer(is_directed));
+        addresses.emplace_back("localhost", servers.back()->m_port);
+    }
+
+    auto single = make_unique<AdjacencyList>(is_directed);
+    load_graph(single.get(), path_graphalytics_graph);
+    auto partitioned = make_unique<gfe::network::PartitionedClient>(addresses, /* max in flight */ 1);
+    load_graph(partitioned.get(), path_graphalytics_graph);
+    ASSERT_EQ(partitioned->num_vertices(), single->num_vertices());
+    ASSERT_EQ(partitioned->num_edges(), single->num_edges());
+    validate(partitioned.get(), path_graphalytics_graph, GA_BFS | GA_PAGERANK);
+
+    // same results of the single instance
+    gfe::reader::GraphalyticsReader reader { path_graphalytics_graph + ".properties" };
+    uint64_t source_vertex_id = stoull(reader.get_property("bfs.source-vertex"));
+    uint64_t num_iterations = stoull(reader.get_property("pr.num-iterations"));
+    double damping_factor = stod(reader.get_property("pr.damping-factor"));
+    string path_single = temp_file_path();
+    string path_partitioned = temp_file_path();
+    single->bfs(source_vertex_id, path_single.c_str());
+    partitioned->bfs(source_vertex_id, path_partitioned.c_str());
+    GraphalyticsValidate::bfs(path_partitioned, path_single);
+    single->pagerank(num_iterations, damping_factor, path_single.c_str());
+    partitioned->pagerank(num_iterations, damping_factor, path_partitioned.c_str());
+    GraphalyticsValidate::pagerank(path_partitioned, path_single);
+
+    // the removal of a vertex must also reach the servers storing the vertex as a ghost
+    uint64_t vertex_id = 0;
+    uint64_t removed_vertex_id = 0;
+    int64_t max_num_copies = 0;
+    while(reader.read_vertex(vertex_id)){
+        int64_t num_copies = count_if(servers.begin(), servers.end(), [vertex_id](auto& server){ return server->m_library->has_vertex(vertex_id); });
+        if(num_copies > max_num_copies){
+            max_num_copies = num_copies;
+            removed_vertex_id = vertex_id;
+        }
+    }
+    ASSERT_GE(max_num_copies, 2); // the owner and at least one ghost
+    const uint64_t num_vertices = partitioned->num_vertices();
+    ASSERT_TRUE(partitioned->remove_vertex(removed_vertex_id));
+    for(auto& server : servers){ ASSERT_FALSE(server->m_library->has_vertex(removed_vertex_id)); }
+    ASSERT_EQ(partitioned->num_vertices(), num_vertices -1);
+    ASSERT_FALSE(partitioned->remove_vertex(removed_vertex_id));
+}
+
+TEST(PartitionedClient, GraphalyticsDirected){
+    validate_partitioned(/* directed */ true, path_example_directed, /* servers */ 2);
+}
+
+TEST(PartitionedClient, GraphalyticsUndirected){
+    validate_partitioned(/* directed */ false, path_example_undirected, /* servers */ 3);
+}
+
 TEST(CSR, GraphalyticsDirected){
     auto csr = make_unique<CSR>(/* directed */ true);
     csr->load(path_example_directed + ".properties");
@@ -400,6 +634,17 @@ TEST(LiveGraph, GraphalyticsDirected){
      */
     validate(graph.get(), path_example_directed, GA_WCC | GA_SSSP);
 }
+TEST(LiveGraph, AnalyticsSession){
+    auto graph = make_unique<LiveGraphDriver>(/* directed */ false);
+    load_graph(graph.get(), path_example_undirected);
+    validate_session(graph.get(), path_example_undirected, /* materialize csr */ false, GA_BFS | GA_PAGERANK | GA_SSSP); // WCC is a weight scan, as in LiveGraphDriver::wcc
+}
+
+TEST(LiveGraph, AnalyticsSessionCSR){
+    auto graph = make_unique<LiveGraphDriver>(/* directed */ true);
+    load_graph(graph.get(), path_example_directed);
+    validate_session(graph.get(), path_example_directed, /* materialize csr */ true);
+}
 #endif
 
 #if defined(HAVE_TESEO)
@@ -414,6 +659,18 @@ TEST(TeseoLCC, GraphalyticsUndirected){
     load_graph(graph.get(), path_example_undirected);
     validate(graph.get(), path_example_undirected, GA_LCC);
 }
+
+TEST(Teseo, AnalyticsSession){
+    auto graph = make_unique<TeseoDriver>(/* directed */ false);
+    load_graph(graph.get(), path_example_undirected);
+    validate_session(graph.get(), path_example_undirected);
+}
+
+TEST(Teseo, AnalyticsSessionCSR){
+    auto graph = make_unique<TeseoDriver>(/* directed */ false);
+    load_graph(graph.get(), path_example_undirected);
+    validate_session(graph.get(), path_example_undirected, /* materialize csr */ true);
+}
 #endif
 
 #if defined(HAVE_SORTLEDTON)
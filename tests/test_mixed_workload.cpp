@@ -0,0 +1,376 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <thread>
+#include <unordered_set>
+
+#include "common/filesystem.hpp"
+#include "experiment/aging2_experiment.hpp"
+#include "experiment/details/incremental_analytics.hpp"
+#include "experiment/graphalytics.hpp"
+#include "experiment/mixed_workload.hpp"
+#include "experiment/mixed_workload_result.hpp"
+#include "experiment/update_short_reads_experiment.hpp"
+#include "graph/edge_stream.hpp"
+#include "graph/vertex_list.hpp"
+#include "library/baseline/adjacency_list.hpp"
+#include "reader/graphlog_reader.hpp"
+#include "utility/vertex_sampler.hpp"
+#include "utility/zipf_distribution.hpp"
+
+using namespace gfe::experiment;
+using namespace gfe::experiment::details;
+using namespace gfe::library;
+using namespace std;
+
+TEST(MixedWorkload, ParseStreams){
+    auto streams = analytics_streams_from_string("4:bfs+pagerank,2:one_hop+2hop+sssp");
+    ASSERT_EQ(streams.size(), 2);
+    ASSERT_EQ(streams[0].m_num_threads, 4);
+    ASSERT_EQ(streams[0].m_kernels.size(), 2);
+    ASSERT_EQ(streams[0].m_kernels[0], AnalyticsKernel::BFS);
+    ASSERT_EQ(streams[0].m_kernels[1], AnalyticsKernel::PAGERANK);
+    ASSERT_EQ(streams[1].m_num_threads, 2);
+    ASSERT_EQ(streams[1].m_kernels.size(), 3);
+    ASSERT_EQ(streams[1].m_kernels[0], AnalyticsKernel::ONE_HOP);
+    ASSERT_EQ(streams[1].m_kernels[1], AnalyticsKernel::TWO_HOPS);
+    ASSERT_EQ(streams[1].m_kernels[2], AnalyticsKernel::SSSP);
+
+    ASSERT_ANY_THROW(analytics_streams_from_string("4"));
+    ASSERT_ANY_THROW(analytics_streams_from_string("4:"));
+    ASSERT_ANY_THROW(analytics_streams_from_string("4:lcc"));
+    ASSERT_ANY_THROW(analytics_streams_from_string("x:bfs"));
+}
+
+TEST(MixedWorkload, ParseWindows){
+    auto windows = mixed_workload_windows_from_string("0:0.25,0.5:1");
+    ASSERT_EQ(windows.size(), 2);
+    ASSERT_DOUBLE_EQ(windows[0].m_progress_start, 0.0);
+    ASSERT_DOUBLE_EQ(windows[0].m_progress_end, 0.25);
+    ASSERT_DOUBLE_EQ(windows[1].m_progress_start, 0.5);
+    ASSERT_DOUBLE_EQ(windows[1].m_progress_end, 1.0);
+
+    ASSERT_ANY_THROW(mixed_workload_windows_from_string("0.5"));
+    ASSERT_ANY_THROW(mixed_workload_windows_from_string("0.5:0.2")); // end < start
+    ASSERT_ANY_THROW(mixed_workload_windows_from_string("0:1.5")); // end > 1
+    ASSERT_ANY_THROW(mixed_workload_windows_from_string("0:0.5,0.4:0.9")); // overlapping
+}
+
+// Run two analytics streams concurrently with the updates, it should neither deadlock nor alter the final graph
+TEST(MixedWorkload, ConcurrentStreams){
+    const string path_graph = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+    const string path_log = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.graphlog";
+    auto adjlist = make_shared<AdjacencyList>(/* directed ? */ false);
+
+    Aging2Experiment exp_aging;
+    exp_aging.set_library(adjlist);
+    exp_aging.set_log(path_log);
+    exp_aging.set_parallelism_degree(4);
+    exp_aging.set_worker_granularity(4);
+
+    GraphalyticsAlgorithms properties { path_graph };
+    MixedWorkload exp_mixed { exp_aging, adjlist, properties, /* read threads */ 1 };
+    exp_mixed.set_windows(mixed_workload_windows_from_string("0:1"));
+    vector<AnalyticsStreamSpec> streams = analytics_streams_from_string("1:wcc+one_hop,1:two_hops");
+    exp_mixed.set_streams(streams);
+    auto result = exp_mixed.execute();
+    result.report();
+
+    auto stream = make_shared<gfe::graph::WeightedEdgeStream>(path_graph);
+    ASSERT_EQ(stream->num_edges(), adjlist->num_edges());
+}
+
+// Refresh PageRank and WCC concurrently with the updates, it should neither deadlock nor alter the final graph
+TEST(MixedWorkload, IncrementalAnalytics){
+    const string path_graph = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+    const string path_log = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.graphlog";
+    auto adjlist = make_shared<AdjacencyList>(/* directed ? */ false);
+
+    Aging2Experiment exp_aging;
+    exp_aging.set_library(adjlist);
+    exp_aging.set_log(path_log);
+    exp_aging.set_parallelism_degree(4);
+    exp_aging.set_worker_granularity(4);
+
+    GraphalyticsAlgorithms properties { path_graph };
+    MixedWorkload exp_mixed { exp_aging, adjlist, properties, /* read threads */ 1 };
+    exp_mixed.set_windows(mixed_workload_windows_from_string("0:1"));
+    exp_mixed.set_streams(analytics_streams_from_string("1:pagerank+wcc"));
+    exp_mixed.set_incremental_analytics(gfe::reader::graphlog::load_vertices_final(path_log));
+    auto result = exp_mixed.execute();
+    result.report();
+
+    auto stream = make_shared<gfe::graph::WeightedEdgeStream>(path_graph);
+    ASSERT_EQ(stream->num_edges(), adjlist->num_edges());
+}
+
+// Retrieve the vertices of the given graph
+static vector<uint64_t> load_vertices(const string& path_graph){
+    gfe::graph::WeightedEdgeStream stream { path_graph };
+    auto vertex_list = stream.vertex_list();
+    vector<uint64_t> vertices;
+    for(uint64_t i = 0; i < vertex_list->num_vertices(); i++){ vertices.push_back(vertex_list->get(i)); }
+    return vertices;
+}
+
+// The entries are drained in the order the updates started, up to the oldest update still in progress
+TEST(IncrementalAnalytics, DeltaLogOrder){
+    DeltaLog delta_log;
+    delta_log.append(0, 10, 20, true); // not enabled yet
+    delta_log.enable();
+    uint64_t seq0 = delta_log.reserve(/* worker */ 1);
+    uint64_t seq1 = delta_log.reserve(/* worker */ 2);
+    ASSERT_LT(seq0, seq1);
+    delta_log.append(2, seq1, 10, 20, /* insertion */ false);
+    delta_log.append(0, 30, 40, /* insertion */ true);
+
+    vector<DeltaLog::Entry> output;
+    delta_log.drain(output);
+    ASSERT_TRUE(output.empty()); // the update of the worker 1 is still in progress
+
+    delta_log.append(1, seq0, 10, 20, /* insertion */ true);
+    delta_log.drain(output);
+    ASSERT_EQ(output.size(), 3);
+    ASSERT_EQ(output[0].m_source, 10); ASSERT_TRUE(output[0].m_insertion);
+    ASSERT_EQ(output[1].m_source, 10); ASSERT_FALSE(output[1].m_insertion);
+    ASSERT_EQ(output[2].m_source, 30); ASSERT_TRUE(output[2].m_insertion);
+
+    delta_log.drain(output);
+    ASSERT_EQ(output.size(), 3);
+}
+
+// The ranks refreshed with the edges inserted must match the ranks computed from scratch
+TEST(IncrementalAnalytics, PageRank){
+    const string path_graph = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+    auto adjlist = make_shared<AdjacencyList>(/* directed ? */ false);
+    adjlist->load(path_graph);
+    vector<uint64_t> vertices = load_vertices(path_graph);
+    auto delta_log = make_shared<DeltaLog>();
+    IncrementalAnalytics incremental { adjlist.get(), delta_log, vertices };
+    ASSERT_FALSE( incremental.pagerank(100) ); // the first execution computes the ranks from scratch
+    ASSERT_TRUE( delta_log->is_enabled() );
+
+    // connect a few vertices not adjacent yet. Both endpoints already have some edges, so that the sinks do not change
+    auto has_edges = [&](uint64_t vertex){
+        bool found = false;
+        adjlist->scan_neighbors(vertex, [&](uint64_t, double){ found = true; return false; });
+        return found;
+    };
+    uint64_t num_insertions = 0;
+    for(uint64_t i = 0; i < vertices.size() && num_insertions < 3; i++){
+        for(uint64_t j = i +1; j < vertices.size() && num_insertions < 3; j++){
+            if(!has_edges(vertices[i]) || !has_edges(vertices[j]) || adjlist->has_edge(vertices[i], vertices[j])) continue;
+            ASSERT_TRUE( adjlist->add_edge(gfe::graph::WeightedEdge{ vertices[i], vertices[j], 1.0 }) );
+            delta_log->append(/* worker */ 0, vertices[i], vertices[j], /* insertion */ true);
+            num_insertions++;
+            break; // move to the next source
+        }
+    }
+    ASSERT_GT( num_insertions, 0 );
+    ASSERT_TRUE( incremental.pagerank(100) );
+
+    IncrementalAnalytics expected { adjlist.get(), make_shared<DeltaLog>(), vertices };
+    expected.pagerank(100);
+    for(uint64_t vertex : vertices){
+        ASSERT_NEAR( incremental.get_rank(vertex), expected.get_rank(vertex), 1e-4 ) << "vertex: " << vertex;
+    }
+}
+
+// The components are merged with the edges inserted and recomputed when an edge is removed
+TEST(IncrementalAnalytics, WCC){
+    const string path_graph = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+    auto adjlist = make_shared<AdjacencyList>(/* directed ? */ false);
+    adjlist->load(path_graph);
+    vector<uint64_t> vertices = load_vertices(path_graph);
+    auto delta_log = make_shared<DeltaLog>();
+    IncrementalAnalytics incremental { adjlist.get(), delta_log, vertices };
+    ASSERT_FALSE( incremental.wcc() );
+
+    // a new component, not reachable from the initial population
+    const uint64_t v1 = 1000001, v2 = 1000002;
+    ASSERT_TRUE( adjlist->add_edge_v2(gfe::graph::WeightedEdge{ v1, v2, 1.0 }) );
+    delta_log->append(0, v1, v2, true);
+    ASSERT_TRUE( incremental.wcc() );
+    ASSERT_EQ( incremental.get_component(v1), incremental.get_component(v2) );
+    ASSERT_NE( incremental.get_component(v1), incremental.get_component(vertices[0]) );
+
+    // merge it with the component of the first vertex
+    ASSERT_TRUE( adjlist->add_edge(gfe::graph::WeightedEdge{ vertices[0], v1, 1.0 }) );
+    delta_log->append(0, vertices[0], v1, true);
+    ASSERT_TRUE( incremental.wcc() );
+    ASSERT_EQ( incremental.get_component(v2), incremental.get_component(vertices[0]) );
+
+    // split it again
+    ASSERT_TRUE( adjlist->remove_edge(gfe::graph::Edge{ vertices[0], v1 }) );
+    delta_log->append(0, vertices[0], v1, false);
+    ASSERT_FALSE( incremental.wcc() ); // recomputed from scratch
+    ASSERT_EQ( incremental.get_component(v1), incremental.get_component(v2) );
+    ASSERT_NE( incremental.get_component(v1), incremental.get_component(vertices[0]) );
+
+    // the same partition of the computation from scratch
+    vertices.push_back(v1);
+    vertices.push_back(v2);
+    IncrementalAnalytics expected { adjlist.get(), make_shared<DeltaLog>(), vertices };
+    expected.wcc();
+    for(uint64_t u : vertices){
+        for(uint64_t v : vertices){
+            ASSERT_EQ( incremental.get_component(u) == incremental.get_component(v), expected.get_component(u) == expected.get_component(v) );
+        }
+    }
+}
+
+TEST(ShortReads, ParseMix){
+    auto mix = short_reads_mix_from_string("has_edge=1, two_hops=3");
+    ASSERT_EQ(mix.size(), num_short_read_operations);
+    ASSERT_DOUBLE_EQ(mix[(int) ShortReadOperation::HAS_EDGE], 1.0);
+    ASSERT_DOUBLE_EQ(mix[(int) ShortReadOperation::GET_WEIGHT], 0.0);
+    ASSERT_DOUBLE_EQ(mix[(int) ShortReadOperation::ONE_HOP], 0.0);
+    ASSERT_DOUBLE_EQ(mix[(int) ShortReadOperation::TWO_HOPS], 3.0);
+
+    ASSERT_ANY_THROW(short_reads_mix_from_string("has_edge"));
+    ASSERT_ANY_THROW(short_reads_mix_from_string("lookup=1"));
+    ASSERT_ANY_THROW(short_reads_mix_from_string("has_edge=-1"));
+    ASSERT_ANY_THROW(short_reads_mix_from_string("has_edge=0"));
+}
+
+TEST(ShortReads, Zipf){
+    constexpr uint64_t n = 100;
+    constexpr uint64_t num_samples = 1000000;
+    gfe::utility::ZipfDistribution zipf { n, 1.0 };
+    mt19937_64 random { 42 };
+    vector<uint64_t> frequencies(n +1, 0);
+    for(uint64_t i = 0; i < num_samples; i++){
+        uint64_t value = zipf(random);
+        ASSERT_GE(value, 1);
+        ASSERT_LE(value, n);
+        frequencies[value]++;
+    }
+
+    // with exponent 1, the value 1 is twice as frequent as 2 and ten times as frequent as 10
+    ASSERT_NEAR((double) frequencies[1] / frequencies[2], 2.0, 0.1);
+    ASSERT_NEAR((double) frequencies[1] / frequencies[10], 10.0, 0.5);
+}
+
+// The vertices drawn by the sampler must be distinct and belong to the population
+TEST(VertexSampler, Distinct){
+    using namespace gfe::utility;
+    vector<uint64_t> population;
+    for(uint64_t i = 0; i < 1000; i++){ population.push_back(i * 10); }
+
+    for(auto distribution : { VertexSamplerDistribution::UNIFORM, VertexSamplerDistribution::ZIPF }){
+        VertexSampler sampler { distribution, 2.0, /* seed */ 42 };
+        sampler.set_population(population);
+
+        // with a large exponent, most draws are duplicates and the sample must be completed with the rest of the population
+        for(uint64_t count : { 10, 500, 999, 1000, 2000 }){
+            vector<uint64_t> sample;
+            sampler.sample(count, sample);
+            ASSERT_EQ(sample.size(), min<uint64_t>(count, population.size()));
+            unordered_set<uint64_t> unique ( begin(sample), end(sample) );
+            ASSERT_EQ(unique.size(), sample.size());
+            for(uint64_t vertex : sample){ ASSERT_EQ(vertex % 10, 0); ASSERT_LT(vertex, 10000); }
+        }
+
+        // each thread has its own generator, seeded with the id set by the caller
+        vector<uint64_t> sample1, sample2;
+        thread([&](){ VertexSampler::set_thread_id(1); VertexSampler s { distribution, 2.0, 7 }; s.set_population(population); s.sample(100, sample1); }).join();
+        thread([&](){ VertexSampler::set_thread_id(2); VertexSampler s { distribution, 2.0, 7 }; s.set_population(population); s.sample(100, sample2); }).join();
+        ASSERT_EQ(sample1.size(), 100);
+        ASSERT_NE(sample1, sample2); // different threads, different sequences
+    }
+}
+
+// Two runs with the same seed must draw the same samples, regardless of the order in which the threads start sampling
+TEST(VertexSampler, Reproducible){
+    using namespace gfe::utility;
+    constexpr uint64_t num_threads = 4;
+    vector<uint64_t> population;
+    for(uint64_t i = 0; i < 1000; i++){ population.push_back(i); }
+
+    auto run = [&](bool reverse){
+        vector<vector<uint64_t>> samples(num_threads);
+        VertexSampler sampler { VertexSamplerDistribution::ZIPF, 1.0, /* seed */ 42 };
+        sampler.set_population(population);
+        for(uint64_t i = 0; i < num_threads; i++){
+            uint64_t thread_id = reverse ? num_threads - i -1 : i;
+            thread([&, thread_id](){
+                VertexSampler::set_thread_id(thread_id);
+                for(int j = 0; j < 3; j++){
+                    vector<uint64_t> sample;
+                    sampler.sample(20, sample);
+                    samples[thread_id].insert(end(samples[thread_id]), begin(sample), end(sample));
+                }
+            }).join();
+        }
+        return samples;
+    };
+
+    auto samples1 = run(/* reverse ? */ false);
+    auto samples2 = run(/* reverse ? */ true);
+    for(uint64_t i = 0; i < num_threads; i++){
+        ASSERT_EQ(samples1[i].size(), 60);
+        ASSERT_EQ(samples1[i], samples2[i]);
+    }
+    ASSERT_NE(samples1[0], samples1[1]);
+}
+
+// With the degree distribution, vertices without edges are never drawn
+TEST(VertexSampler, Degree){
+    using namespace gfe::utility;
+    vector<uint64_t> vertices, degrees;
+    for(uint64_t i = 0; i < 100; i++){
+        vertices.push_back(i);
+        degrees.push_back(i % 2 == 0 ? 0 : i);
+    }
+
+    VertexSampler sampler { VertexSamplerDistribution::DEGREE, 1.0, 42 };
+    ASSERT_ANY_THROW(sampler.set_population(vertices)); // the degrees are only known to the library
+    vector<uint64_t> sample;
+    sampler.sample(vertices.data(), degrees.data(), vertices.size(), 60, sample);
+    ASSERT_EQ(sample.size(), 50); // only 50 vertices with at least one edge
+    for(uint64_t vertex : sample){ ASSERT_EQ(vertex % 2, 1); }
+}
+
+// Run the readers concurrently with the updates, it should neither deadlock nor alter the final graph
+TEST(ShortReads, ConcurrentReaders){
+    const string path_graph = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.properties";
+    const string path_log = common::filesystem::directory_executable() + "/graphs/ldbc_graphalytics/example-undirected.graphlog";
+    auto adjlist = make_shared<AdjacencyList>(/* directed ? */ false);
+
+    Aging2Experiment exp_aging;
+    exp_aging.set_library(adjlist);
+    exp_aging.set_log(path_log);
+    exp_aging.set_parallelism_degree(4);
+    exp_aging.set_worker_granularity(4);
+
+    for(auto distribution : { ShortReadsDistribution::UNIFORM, ShortReadsDistribution::ZIPF }){
+        adjlist = make_shared<AdjacencyList>(/* directed ? */ false);
+        exp_aging.set_library(adjlist);
+
+        UpdatesShortReadsExperiment exp_reads { exp_aging, adjlist };
+        exp_reads.set_num_readers(4);
+        exp_reads.set_distribution(distribution);
+        auto result = exp_reads.execute();
+        result.report();
+
+        auto stream = make_shared<gfe::graph::WeightedEdgeStream>(path_graph);
+        ASSERT_EQ(stream->num_edges(), adjlist->num_edges());
+    }
+}
@@ -0,0 +1,420 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstring>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "common/error.hpp"
+#include "graph/edge.hpp"
+#include "library/interface.hpp"
+#include "network/client.hpp"
+#include "network/edge_frame.hpp"
+#include "network/error.hpp"
+#include "network/request_statistics.hpp"
+#include "network/result_frame.hpp"
+#include "network/server.hpp"
+#include "network/shared_memory.hpp"
+#include "utility/result_writer.hpp"
+
+using namespace gfe::network;
+using namespace std;
+using SingleUpdate = gfe::library::UpdateInterface::SingleUpdate;
+
+static void check_edge_frame(const vector<SingleUpdate>& edges, bool compress){
+    unique_ptr<uint64_t[]> buffer { new uint64_t[edge_frame_max_size(edges.size()) / sizeof(uint64_t)] };
+    char* frame = reinterpret_cast<char*>(buffer.get());
+    vector<uint64_t> scratch;
+    uint64_t frame_sz = encode_edge_frame(edges.data(), edges.size(), compress, frame, scratch);
+    ASSERT_EQ(frame_sz % 8, 0);
+    ASSERT_LE(frame_sz, edge_frame_max_size(edges.size()));
+    if(compress && edges.size() > 0){ ASSERT_LT(frame_sz, edges.size() * sizeof(SingleUpdate)); } // the edges are very regular
+
+    vector<SingleUpdate> output { SingleUpdate{ 1, 2, 3 } }; // replaced by the decoder
+    decode_edge_frame(frame, frame_sz, output, scratch);
+    ASSERT_EQ(output.size(), edges.size());
+    for(uint64_t i = 0; i < edges.size(); i++){
+        ASSERT_EQ(output[i].m_source, edges[i].m_source);
+        ASSERT_EQ(output[i].m_destination, edges[i].m_destination);
+        ASSERT_EQ(output[i].m_weight, edges[i].m_weight);
+    }
+}
+
+TEST(Network, EdgeFrame){
+    vector<SingleUpdate> edges;
+    check_edge_frame(edges, false);
+    check_edge_frame(edges, true);
+
+    for(uint64_t i = 0; i < EDGE_FRAME_MAX_NUM_EDGES; i++){
+        edges.push_back(SingleUpdate{ i / 4, i * 7 + 1, (i % 5 == 0) ? -1.0 : 0.5 * (i % 3) });
+    }
+    check_edge_frame(edges, false);
+    check_edge_frame(edges, true);
+
+    // truncated frame
+    unique_ptr<uint64_t[]> buffer { new uint64_t[edge_frame_max_size(edges.size()) / sizeof(uint64_t)] };
+    char* frame = reinterpret_cast<char*>(buffer.get());
+    vector<uint64_t> scratch;
+    uint64_t frame_sz = encode_edge_frame(edges.data(), edges.size(), true, frame, scratch);
+    vector<SingleUpdate> output;
+    ASSERT_THROW(decode_edge_frame(frame, frame_sz / 2, output, scratch), gfe::network::NetworkError);
+}
+
+TEST(Network, ResultFrame){
+    vector<uint64_t> vertices, values;
+    for(uint64_t i = 0; i < RESULT_FRAME_MAX_NUM_ENTRIES + 10; i++){
+        vertices.push_back(i * 3);
+        double value = 1.0 / (i + 1);
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        values.push_back(bits);
+    }
+
+    for(bool compress : { false, true }){
+        unique_ptr<uint64_t[]> buffer { new uint64_t[result_frame_max_size(RESULT_FRAME_MAX_NUM_ENTRIES) / sizeof(uint64_t)] };
+        char* frame = reinterpret_cast<char*>(buffer.get());
+        vector<uint64_t> scratch;
+        vector<uint64_t> output_vertices, output_values;
+
+        // the results are split in two frames, decoded one after the other
+        for(uint64_t start = 0; start < vertices.size(); start += RESULT_FRAME_MAX_NUM_ENTRIES){
+            uint64_t num_entries = min<uint64_t>(RESULT_FRAME_MAX_NUM_ENTRIES, vertices.size() - start);
+            uint64_t frame_sz = encode_result_frame(vertices.data() + start, values.data() + start, num_entries, compress, frame, scratch);
+            ASSERT_EQ(frame_sz % 8, 0);
+            ASSERT_LE(frame_sz, result_frame_max_size(num_entries));
+            decode_result_frame(frame, frame_sz, output_vertices, output_values, scratch);
+        }
+
+        ASSERT_EQ(output_vertices, vertices);
+        ASSERT_EQ(output_values, values);
+    }
+
+    // truncated frame
+    unique_ptr<uint64_t[]> buffer { new uint64_t[result_frame_max_size(RESULT_FRAME_MAX_NUM_ENTRIES) / sizeof(uint64_t)] };
+    char* frame = reinterpret_cast<char*>(buffer.get());
+    vector<uint64_t> scratch, output_vertices, output_values;
+    uint64_t frame_sz = encode_result_frame(vertices.data(), values.data(), RESULT_FRAME_MAX_NUM_ENTRIES, true, frame, scratch);
+    ASSERT_THROW(decode_result_frame(frame, frame_sz / 2, output_vertices, output_values, scratch), gfe::network::NetworkError);
+}
+
+TEST(Network, RequestStatistics){
+    RequestStatistics statistics;
+    ASSERT_TRUE(statistics.empty());
+    ASSERT_EQ(statistics.to_string(), "");
+
+    for(int i = 1; i <= 100; i++){
+        statistics.record(RequestType::ADD_EDGE, RequestStatistics::Phase::QUEUE, chrono::nanoseconds(10));
+        statistics.record(RequestType::ADD_EDGE, RequestStatistics::Phase::LIBRARY, chrono::nanoseconds(i < 100 ? 100 : 5000));
+    }
+    statistics.record(RequestType::ADD_EDGE, RequestStatistics::Phase::SEND, chrono::nanoseconds(2000));
+    ASSERT_FALSE(statistics.empty());
+
+    string report = statistics.to_string();
+    ASSERT_NE(report.find("ADD_EDGE, requests: 100,"), string::npos);
+    ASSERT_NE(report.find("queue [mean: 10 ns, p50: 10 ns, p99: 10 ns, max: 10 ns]"), string::npos);
+    ASSERT_NE(report.find("library [mean: 149 ns, p50: 127 ns, p99: 127 ns, max: 5000 ns]"), string::npos); // the percentiles are the upper bound of their bucket
+    ASSERT_NE(report.find("send [count: 1, mean: 2000 ns"), string::npos);
+    ASSERT_EQ(report.find("REMOVE_EDGE"), string::npos); // only the requests recorded
+
+    statistics.reset();
+    ASSERT_TRUE(statistics.empty());
+}
+
+// Each worker of the server records its own latencies, merged into a single report
+TEST(Network, RequestStatisticsMerge){
+    RequestStatistics worker1, worker2, merged;
+    for(int i = 0; i < 10; i++){
+        worker1.record(RequestType::ADD_EDGE, RequestStatistics::Phase::LIBRARY, chrono::nanoseconds(100));
+        worker2.record(RequestType::ADD_EDGE, RequestStatistics::Phase::LIBRARY, chrono::nanoseconds(300));
+    }
+    worker2.record(RequestType::REMOVE_EDGE, RequestStatistics::Phase::LIBRARY, chrono::nanoseconds(1000));
+
+    merged.merge(worker1);
+    merged.merge(worker2);
+    string report = merged.to_string();
+    ASSERT_NE(report.find("ADD_EDGE, requests: 20,"), string::npos);
+    ASSERT_NE(report.find("library [mean: 200 ns, p50: 127 ns, p99: 300 ns, max: 300 ns]"), string::npos);
+    ASSERT_NE(report.find("REMOVE_EDGE, requests: 1,"), string::npos);
+    ASSERT_EQ(worker1.to_string().find("REMOVE_EDGE"), string::npos); // the sources are not altered
+}
+
+// A ring in the memory of the process, rather than in a shared memory segment
+struct LocalRing {
+    unique_ptr<SharedMemoryRing::Header> m_header { new SharedMemoryRing::Header() }; // zero-initialised
+    unique_ptr<char[]> m_buffer;
+    SharedMemoryRing m_ring;
+
+    LocalRing(uint64_t capacity) : m_buffer(new char[capacity]), m_ring(m_header.get(), m_buffer.get(), capacity) { }
+};
+
+static bool always_alive(){ return true; }
+
+TEST(Network, SharedMemoryRingWrapAround){
+    LocalRing local { 16 };
+    SharedMemoryRing& ring = local.m_ring;
+    char input[16], output[16];
+    for(int i = 0; i < 16; i++){ input[i] = 'a' + i; }
+
+    ASSERT_TRUE(ring.write(input, 10, always_alive));
+    ASSERT_EQ(ring.size(), 10);
+    ASSERT_EQ(ring.read_some(output, 16), 10);
+    ASSERT_EQ(memcmp(input, output, 10), 0);
+
+    // the next write starts at offset 10 and continues from the start of the buffer
+    ASSERT_TRUE(ring.write(input, 16, always_alive));
+    ASSERT_EQ(ring.size(), 16);
+    memset(output, 0, sizeof(output));
+    ASSERT_TRUE(ring.read(output, 16, always_alive));
+    ASSERT_EQ(memcmp(input, output, 16), 0);
+    ASSERT_EQ(ring.size(), 0);
+}
+
+TEST(Network, SharedMemoryRingReadSome){
+    LocalRing local { 16 };
+    SharedMemoryRing& ring = local.m_ring;
+    char input[8] = { 1, 2, 3, 4, 5, 6, 7, 8 }, output[16];
+
+    ASSERT_EQ(ring.read_some(output, sizeof(output)), 0); // empty
+    ASSERT_FALSE(ring.wait_data(chrono::milliseconds(1)));
+    ASSERT_TRUE(ring.write(input, sizeof(input), always_alive));
+    ASSERT_TRUE(ring.wait_data(chrono::milliseconds(1)));
+    ASSERT_EQ(ring.read_some(output, 3), 3);
+    ASSERT_EQ(memcmp(input, output, 3), 0);
+    ASSERT_EQ(ring.size(), 5);
+    ASSERT_EQ(ring.read_some(output, sizeof(output)), 5); // only what is available
+    ASSERT_EQ(memcmp(input + 3, output, 5), 0);
+    ASSERT_EQ(ring.read_some(output, sizeof(output)), 0);
+}
+
+// The messages are larger than the ring, the producer and the consumer must wait on each other
+TEST(Network, SharedMemoryRingProducerConsumer){
+    LocalRing local { 64 };
+    SharedMemoryRing& ring = local.m_ring;
+    constexpr uint64_t num_messages = 1000;
+    auto message_size = [](uint64_t i){ return 1 + (i * 37) % 200; };
+
+    thread producer { [&](){
+        vector<char> message;
+        for(uint64_t i = 0; i < num_messages; i++){
+            message.resize(message_size(i));
+            for(uint64_t j = 0; j < message.size(); j++){ message[j] = static_cast<char>(i + j); }
+            ring.write(message.data(), message.size(), always_alive);
+        }
+    } };
+
+    vector<char> message;
+    for(uint64_t i = 0; i < num_messages; i++){
+        message.resize(message_size(i));
+        ASSERT_TRUE(ring.read(message.data(), message.size(), always_alive));
+        for(uint64_t j = 0; j < message.size(); j++){ ASSERT_EQ(message[j], static_cast<char>(i + j)) << "message: " << i << ", byte: " << j; }
+    }
+    producer.join();
+    ASSERT_EQ(ring.size(), 0);
+}
+
+// Both ends stop waiting once the other end is gone
+TEST(Network, SharedMemoryRingDeadPeer){
+    LocalRing local { 16 };
+    SharedMemoryRing& ring = local.m_ring;
+    char buffer[16] = { 0 };
+    auto dead = [](){ return false; };
+
+    ASSERT_FALSE(ring.read(buffer, 1, dead)); // nothing to read
+    ASSERT_TRUE(ring.write(buffer, 16, dead)); // there is enough space, it does not wait
+    ASSERT_FALSE(ring.write(buffer, 1, dead)); // the ring is full
+}
+
+/*****************************************************************************
+ *                                                                           *
+ * Loopback Server & Client                                                  *
+ *                                                                           *
+ *****************************************************************************/
+
+namespace {
+
+// A library that only counts the updates. The insertions of the edges whose source is a multiple of 10 fail.
+class MockInterface : public virtual gfe::library::UpdateInterface, public virtual gfe::library::GraphalyticsInterface {
+public:
+    atomic<uint64_t> m_num_edges = 0; // number of insertions requested
+    atomic<uint64_t> m_num_vertices_removed = 0;
+    string m_reference_path; // where the kernels also save their results, to validate the client's copy
+
+    static bool expected_result(uint64_t source){ return source % 10 != 0; }
+
+    void dump_ostream(std::ostream& out) const override { out << "MockInterface"; }
+    uint64_t num_edges() const override { return m_num_edges; }
+    uint64_t num_vertices() const override { return 0; }
+    bool has_vertex(uint64_t vertex_id) const override { return true; }
+    double get_weight(uint64_t source, uint64_t destination) const override { return 0; }
+    bool is_directed() const override { return false; }
+    void set_timeout(uint64_t seconds) override { }
+    void load(const std::string& path) override { }
+    bool add_vertex(uint64_t vertex_id) override { return true; }
+    bool remove_vertex(uint64_t vertex_id) override { m_num_vertices_removed++; return true; }
+    bool add_edge(gfe::graph::WeightedEdge e) override { m_num_edges++; return expected_result(e.source()); }
+    bool add_edge_v2(gfe::graph::WeightedEdge e) override { return add_edge(e); }
+    bool remove_edge(gfe::graph::Edge e) override { return true; }
+
+    void bfs(uint64_t source_vertex_id, const char* dump2file) override {
+        vector<pair<uint64_t, int64_t>> result;
+        for(uint64_t i = 0; i < 200000; i++){ // more than a single frame
+            result.emplace_back(i * 3 + source_vertex_id, i % 7 == 0 ? numeric_limits<int64_t>::max() : static_cast<int64_t>(i));
+        }
+        save(result, dump2file);
+    }
+
+    void pagerank(uint64_t num_iterations, double damping_factor, const char* dump2file) override {
+        vector<pair<uint64_t, double>> result;
+        for(uint64_t i = 0; i < 1000; i++){ result.emplace_back(i, damping_factor / (i + num_iterations)); }
+        save(result, dump2file);
+    }
+
+    void wcc(const char* dump2file) override { }
+    void cdlp(uint64_t max_iterations, const char* dump2file) override { }
+    void lcc(const char* dump2file) override { }
+    void sssp(uint64_t source_vertex_id, const char* dump2file) override { }
+
+private:
+    template<typename T>
+    void save(const vector<pair<uint64_t, T>>& result, const char* dump2file){
+        if(dump2file == nullptr) return;
+        gfe::utility::save_results(result, dump2file);
+        gfe::utility::save_results(result, m_reference_path.c_str());
+    }
+};
+
+// Run a server on the loopback interface, in a separate thread
+class LoopbackServer {
+    shared_ptr<MockInterface> m_interface;
+    unique_ptr<Server> m_server;
+    thread m_thread;
+    const int m_port;
+
+    static int next_port(){
+        static int port = 20000 + getpid() % 20000;
+        return port++;
+    }
+
+public:
+    LoopbackServer(int num_workers) : m_interface(make_shared<MockInterface>()), m_port(next_port()) {
+        m_server.reset(new Server(m_interface, m_port, /* I/O threads */ 2, num_workers));
+        m_thread = thread([this](){ m_server->main_loop(); });
+    }
+
+    ~LoopbackServer(){
+        m_server->stop();
+        m_thread.join();
+    }
+
+    int port() const { return m_port; }
+    MockInterface* interface() { return m_interface.get(); }
+};
+
+// Insert the edges from multiple threads, each over its own connection, pipelining the updates
+void run_pipelined_updates(uint64_t max_in_flight, bool shared_memory){
+    constexpr int num_threads = 4;
+    constexpr uint64_t num_edges_per_thread = 20000;
+    LoopbackServer server { /* workers */ 2 }; // with shared memory, only two connections are served by a dedicated thread, the others carry on over TCP
+    Client client { "localhost", server.port(), max_in_flight, shared_memory };
+    client.on_main_init(num_threads);
+
+    atomic<uint64_t> num_failed = 0;
+    atomic<uint64_t> num_errors = 0;
+    vector<thread> threads;
+    for(int thread_id = 1; thread_id <= num_threads; thread_id++){
+        threads.emplace_back([&, thread_id](){
+            client.on_thread_init(thread_id);
+            uint64_t num_expected_failures = 0;
+            for(uint64_t i = 0; i < num_edges_per_thread; i++){
+                uint64_t source = i * num_threads + thread_id;
+                bool result = client.add_edge(gfe::graph::WeightedEdge(source, source + 1, 0.5));
+                if(max_in_flight == 1 && result != MockInterface::expected_result(source)){ num_errors++; }
+                if(!MockInterface::expected_result(source)){ num_expected_failures++; }
+            }
+            uint64_t num_failed_thread = client.flush();
+            if(max_in_flight > 1 && num_failed_thread != num_expected_failures){ num_errors++; }
+            num_failed += num_expected_failures;
+            client.on_thread_destroy(thread_id);
+        });
+    }
+    for(auto& t : threads){ t.join(); }
+
+    ASSERT_EQ(num_errors, 0);
+    ASSERT_EQ(num_failed, num_threads * num_edges_per_thread / 10);
+    ASSERT_EQ(server.interface()->m_num_edges, num_threads * num_edges_per_thread);
+    ASSERT_EQ(client.num_edges(), num_threads * num_edges_per_thread);
+}
+
+string read_file(const string& path){
+    ifstream file { path };
+    return string { istreambuf_iterator<char>(file), istreambuf_iterator<char>() };
+}
+
+} // anonymous namespace
+
+TEST(Network, LoopbackUpdates){
+    run_pipelined_updates(/* max in flight */ 1, /* shared memory */ false);
+}
+
+TEST(Network, LoopbackPipelinedUpdates){
+    run_pipelined_updates(/* max in flight */ 64, /* shared memory */ false);
+}
+
+// The window is larger than the socket buffers, the client and the server must not wait on each other
+TEST(Network, LoopbackPipelinedUpdatesLargeWindow){
+    run_pipelined_updates(/* max in flight */ 1000000, /* shared memory */ false);
+}
+
+TEST(Network, LoopbackPipelinedUpdatesSharedMemory){
+    run_pipelined_updates(/* max in flight */ 1000000, /* shared memory */ true);
+}
+
+// The server streams back the results of the kernels to the client's file system
+TEST(Network, LoopbackRemoteResults){
+    LoopbackServer server { /* workers */ 2 };
+    auto directory = filesystem::temp_directory_path();
+    const string suffix = "." + to_string(getpid());
+    server.interface()->m_reference_path = directory / ("gfe_test_network_reference" + suffix);
+    const string path_client = directory / ("gfe_test_network_client" + suffix);
+
+    Client client { "localhost", server.port(), /* max in flight */ 1 };
+    client.set_remote_results(true);
+    for(bool compression : { false, true }){
+        client.set_frame_compression(compression);
+
+        client.bfs(1, path_client.c_str());
+        ASSERT_EQ(read_file(path_client), read_file(server.interface()->m_reference_path)) << "compression: " << compression;
+
+        client.pagerank(10, 0.85, path_client.c_str());
+        ASSERT_EQ(read_file(path_client), read_file(server.interface()->m_reference_path)) << "compression: " << compression;
+    }
+
+    filesystem::remove(path_client);
+    filesystem::remove(server.interface()->m_reference_path);
+}
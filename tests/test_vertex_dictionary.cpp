@@ -0,0 +1,244 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "library/vertex_dictionary.hpp"
+
+using namespace gfe::library;
+using namespace std;
+
+// Insert, look up and remove the vertices from a single thread
+TEST(VertexDictionary, Sequential){
+    VertexDictionary dictionary { /* capacity */ 4 };
+    ASSERT_EQ(dictionary.find(10), VertexDictionary::NOT_FOUND);
+
+    for(uint64_t i = 0; i < 1000; i++){
+        auto result = dictionary.find_or_insert(i * 10);
+        ASSERT_TRUE(result.second);
+        ASSERT_EQ(dictionary.find(i * 10), VertexDictionary::NOT_FOUND); // not published yet
+        dictionary.publish(i * 10, i);
+    }
+
+    for(uint64_t i = 0; i < 1000; i++){
+        ASSERT_EQ(dictionary.find(i * 10), i);
+        ASSERT_EQ(dictionary.find(i * 10 +1), VertexDictionary::NOT_FOUND);
+        auto result = dictionary.find_or_insert(i * 10);
+        ASSERT_FALSE(result.second);
+        ASSERT_EQ(result.first, i);
+    }
+
+    // remove the even vertices and insert them again
+    for(uint64_t i = 0; i < 1000; i += 2){
+        ASSERT_EQ(dictionary.remove(i * 10), i);
+        ASSERT_EQ(dictionary.remove(i * 10), VertexDictionary::NOT_FOUND);
+        ASSERT_EQ(dictionary.find(i * 10), VertexDictionary::NOT_FOUND);
+    }
+    for(uint64_t i = 0; i < 1000; i++){
+        auto result = dictionary.find_or_insert(i * 10);
+        ASSERT_EQ(result.second, i % 2 == 0);
+        if(result.second){ dictionary.publish(i * 10, i + 1000); }
+    }
+    for(uint64_t i = 0; i < 1000; i++){
+        ASSERT_EQ(dictionary.find(i * 10), i % 2 == 0 ? i + 1000 : i);
+    }
+}
+
+// Multiple threads register the same vertices, while the table grows. Each vertex must be registered exactly once.
+TEST(VertexDictionary, Concurrent){
+    constexpr uint64_t num_threads = 8;
+    constexpr uint64_t num_vertices = 200000;
+    VertexDictionary dictionary { /* capacity */ 2 };
+    atomic<uint64_t> num_inserted = 0;
+    atomic<uint64_t> num_errors = 0;
+
+    vector<thread> threads;
+    for(uint64_t thread_id = 0; thread_id < num_threads; thread_id++){
+        threads.emplace_back([&, thread_id](){
+            for(uint64_t i = 0; i < num_vertices; i++){
+                uint64_t vertex_id = ((i + thread_id * 7919) % num_vertices) * 3;
+                auto result = dictionary.find_or_insert(vertex_id);
+                if(result.second){
+                    num_inserted++;
+                    dictionary.publish(vertex_id, vertex_id / 3);
+                } else if(result.first != vertex_id / 3){
+                    num_errors++;
+                }
+                uint64_t internal_id = dictionary.find(vertex_id);
+                if(internal_id != vertex_id / 3){ num_errors++; }
+            }
+        });
+    }
+    for(auto& t : threads) t.join();
+
+    ASSERT_EQ(num_inserted, num_vertices);
+    ASSERT_EQ(num_errors, 0);
+    for(uint64_t i = 0; i < num_vertices; i++){
+        ASSERT_EQ(dictionary.find(i * 3), i);
+    }
+}
+
+// Multiple threads register distinct vertices at the same time, racing to claim the last free slots before the table grows.
+// The table must never fill up, otherwise the lookups would probe forever.
+TEST(VertexDictionary, ConcurrentDistinct){
+    constexpr uint64_t num_threads = 16;
+    constexpr uint64_t num_vertices_per_thread = 20000;
+    VertexDictionary dictionary { /* capacity */ 2 };
+    atomic<uint64_t> num_errors = 0;
+
+    vector<thread> threads;
+    for(uint64_t thread_id = 0; thread_id < num_threads; thread_id++){
+        threads.emplace_back([&, thread_id](){
+            for(uint64_t i = 0; i < num_vertices_per_thread; i++){
+                uint64_t internal_id = i * num_threads + thread_id;
+                uint64_t vertex_id = internal_id * 5 + 1;
+                auto result = dictionary.find_or_insert(vertex_id);
+                if(!result.second){ num_errors++; continue; }
+                dictionary.publish(vertex_id, internal_id);
+                if(dictionary.find(vertex_id) != internal_id){ num_errors++; }
+            }
+        });
+    }
+    for(auto& t : threads) t.join();
+
+    ASSERT_EQ(num_errors, 0);
+    for(uint64_t internal_id = 0; internal_id < num_threads * num_vertices_per_thread; internal_id++){
+        ASSERT_EQ(dictionary.find(internal_id * 5 + 1), internal_id);
+    }
+}
+
+// Register the vertices in bulk
+TEST(VertexDictionary, Preload){
+    constexpr uint64_t num_vertices = 100000;
+    vector<uint64_t> external_ids, internal_ids;
+    for(uint64_t i = 0; i < num_vertices; i++){
+        external_ids.push_back(i * 2 + 1);
+        internal_ids.push_back(i);
+    }
+
+    VertexDictionary dictionary;
+    ASSERT_TRUE(dictionary.find_or_insert(1).second);
+    dictionary.publish(1, 1000);
+    dictionary.reset_statistics();
+    dictionary.preload(external_ids.data(), internal_ids.data(), num_vertices);
+    stringstream statistics;
+    dictionary.dump_statistics(statistics);
+    ASSERT_EQ(statistics.str().rfind("time: 0 us", 0), 0) << statistics.str(); // timed by the caller, not sampled
+    ASSERT_EQ(dictionary.find(1), 1000); // already present
+    for(uint64_t i = 1; i < num_vertices; i++){
+        ASSERT_EQ(dictionary.find(i * 2 + 1), i);
+        ASSERT_EQ(dictionary.find(i * 2), VertexDictionary::NOT_FOUND);
+    }
+}
+
+// Translate the internal vertex IDs back into the external vertex IDs
+TEST(VertexDictionary, Int2Ext){
+    VertexDictionary dictionary;
+    ASSERT_EQ(dictionary.int2ext(0), VertexDictionary::NOT_FOUND);
+
+    const uint64_t internal_ids[] = { 0, 1, 2, (1ull << 20) -1, 1ull << 20, (1ull << 22) + 3 }; // across multiple segments
+    for(uint64_t i = 0; i < size(internal_ids); i++){
+        ASSERT_TRUE(dictionary.find_or_insert(i * 10).second);
+        ASSERT_EQ(dictionary.int2ext(internal_ids[i]), VertexDictionary::NOT_FOUND);
+        dictionary.publish(i * 10, internal_ids[i]);
+    }
+    for(uint64_t i = 0; i < size(internal_ids); i++){
+        ASSERT_EQ(dictionary.int2ext(internal_ids[i]), i * 10);
+    }
+    ASSERT_EQ(dictionary.int2ext(3), VertexDictionary::NOT_FOUND);
+    ASSERT_EQ(dictionary.int2ext(1ull << 21), VertexDictionary::NOT_FOUND); // segment not allocated
+    ASSERT_EQ(dictionary.int2ext(numeric_limits<uint64_t>::max() -1), VertexDictionary::NOT_FOUND);
+
+    // removed vertices leave a tombstone
+    ASSERT_EQ(dictionary.remove(10), 1);
+    ASSERT_EQ(dictionary.int2ext(1), VertexDictionary::NOT_FOUND);
+    ASSERT_EQ(dictionary.int2ext(0), 0);
+    ASSERT_EQ(dictionary.int2ext(2), 20);
+
+    // preloaded vertices
+    vector<uint64_t> external_ids { 1000, 1001 }, preload_ids { 5, 6 };
+    dictionary.preload(external_ids.data(), preload_ids.data(), external_ids.size());
+    ASSERT_EQ(dictionary.int2ext(5), 1000);
+    ASSERT_EQ(dictionary.int2ext(6), 1001);
+}
+
+// Translate the snapshot of a library while another thread removes and creates vertices. The library is emulated by an
+// array with the external vertex ID of each internal vertex ID, copied as a whole to open a snapshot. As in the drivers,
+// the writer publishes a vertex after committing it and removes it from the dictionary before deleting it. The vertices
+// the dictionary cannot vouch for are looked up in the snapshot: the translation must always match the snapshot exactly.
+TEST(VertexDictionary, Int2ExtSnapshot){
+    constexpr uint64_t num_vertices = 4096;
+    constexpr uint64_t num_snapshots = 200;
+    VertexDictionary dictionary;
+    mutex mutex_library;
+    vector<uint64_t> library(num_vertices * 2, VertexDictionary::NOT_FOUND); // internal -> external vertex IDs
+
+    for(uint64_t i = 0; i < num_vertices; i++){ // initial vertices
+        library[i] = i * 10;
+        ASSERT_TRUE(dictionary.find_or_insert(i * 10).second);
+        dictionary.publish(i * 10, i);
+    }
+
+    atomic<bool> done = false;
+    thread writer([&](){
+        uint64_t next_internal_id = num_vertices;
+        for(uint64_t i = 0; i < num_vertices && !done; i++){
+            // remove the vertex i
+            uint64_t internal_id = dictionary.remove(i * 10);
+            if(internal_id != i){ ADD_FAILURE() << "remove " << i * 10 << ": " << internal_id; return; }
+            this_thread::yield(); // leave the tombstone visible before the deletion is committed
+            { scoped_lock<mutex> lock(mutex_library); library[internal_id] = VertexDictionary::NOT_FOUND; }
+
+            // create a new vertex
+            uint64_t external_id = i * 10 + 1;
+            if(!dictionary.find_or_insert(external_id).second){ ADD_FAILURE() << "insert " << external_id; return; }
+            { scoped_lock<mutex> lock(mutex_library); library[next_internal_id] = external_id; }
+            this_thread::yield(); // leave the vertex committed but not published yet
+            dictionary.publish(external_id, next_internal_id);
+            next_internal_id++;
+        }
+    });
+
+    uint64_t num_lookups = 0; // number of vertices resolved through the snapshot
+    for(uint64_t k = 0; k < num_snapshots; k++){
+        uint64_t version = dictionary.version(); // before opening the snapshot
+        vector<uint64_t> snapshot;
+        { scoped_lock<mutex> lock(mutex_library); snapshot = library; }
+        this_thread::yield(); // let the writer alter the dictionary while the snapshot is open
+
+        for(uint64_t internal_id = 0; internal_id < snapshot.size(); internal_id++){
+            uint64_t external_id = dictionary.int2ext(internal_id, version);
+            if(external_id == VertexDictionary::NOT_FOUND){
+                external_id = snapshot[internal_id];
+                num_lookups++;
+            }
+            ASSERT_EQ(external_id, snapshot[internal_id]) << "snapshot: " << k << ", internal vertex ID: " << internal_id;
+        }
+    }
+    done = true;
+    writer.join();
+
+    ASSERT_GT(num_lookups, 0);
+}
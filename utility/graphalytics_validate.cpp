@@ -14,19 +14,30 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
-
 #include "graphalytics_validate.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <cerrno>
 #include <cmath>
 #include <cstdlib>
-#include <fstream>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
 #include <iostream>
-#include <unordered_map>
-#include <unordered_set>
+#include <limits>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
 #include <utility>
+#include <vector>
+
+#if defined(HAVE_OPENMP)
+#include "omp.h"
+#endif
 
 #include "common/error.hpp"
 
@@ -65,6 +76,9 @@ namespace gfe::utility {
 }
 #define ERROR_EXIT if(error_count > 0){ FATAL("Validation found " << error_count << " mismatches"); }
 
+// Record a mismatch found by a worker thread, it is reported later, in the order of the lines of the reference file
+#define MISMATCH(lineno, msg) { std::stringstream ss; ss << msg; mismatches.add(lineno, ss.str()); }
+
 /*****************************************************************************
  *                                                                           *
  *  Helpers                                                                  *
@@ -97,12 +111,13 @@ static pair<int64_t, T> parse_value(uint64_t lineno, char* buffer, const char* b
 };
 
 /**
- * Relabel the vertex ID according to the given map
+ * Relabel the vertex ID according to the given map. The value is relabelled only for integral types.
  */
-static pair<int64_t, int64_t> relabel(const pair<int64_t, int64_t>& tuple, uint64_t lineno, const std::unordered_map<uint64_t, uint64_t>* vtx_map, bool relabel_value) {
+template<typename T>
+static pair<int64_t, T> relabel(const pair<int64_t, T>& tuple, uint64_t lineno, const GraphalyticsValidate::vertex_map_t* vtx_map, bool relabel_value) {
     if(vtx_map == nullptr) return tuple; // nothing to relabel
 
-    pair<int64_t, int64_t> result = tuple;
+    pair<int64_t, T> result = tuple;
 
     { // restrict the scope
         auto remap = vtx_map->find(tuple.first); // vertex ID
@@ -112,46 +127,256 @@ static pair<int64_t, int64_t> relabel(const pair<int64_t, int64_t>& tuple, uint6
         result.first = remap->second;
     }
 
-    if(relabel_value){
-        auto remap = vtx_map->find(tuple.second); // value
-        if(remap == vtx_map->end()){
-            FATAL("[lineno=" << lineno << "] VALIDATION ERROR, cannot remap the value for the vertex `" << tuple.second << "'");
+    if constexpr (is_integral_v<T>){
+        if(relabel_value){
+            auto remap = vtx_map->find(tuple.second); // value
+            if(remap == vtx_map->end()){
+                FATAL("[lineno=" << lineno << "] VALIDATION ERROR, cannot remap the value for the vertex `" << tuple.second << "'");
+            }
+            result.second = remap->second;
         }
-        result.second = remap->second;
     }
 
     return result;
 }
 
-namespace { template<typename T> struct Tuple { int64_t vertex_id; T value; uint64_t lineno; }; }
+// The number of threads to use for parsing, sorting and comparing the files
+static uint64_t num_threads(){
+#if defined(HAVE_OPENMP)
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+namespace {
+
+template<typename T> struct Tuple { int64_t vertex_id; T value; uint64_t lineno; };
+
+// Order the tuples by vertex ID, and by line number for the same vertex ID
+template<typename T> bool operator<(const Tuple<T>& t1, const Tuple<T>& t2){
+    return t1.vertex_id < t2.vertex_id || (t1.vertex_id == t2.vertex_id && t1.lineno < t2.lineno);
+}
 
 /**
- * Read the content of the given reference/expected file, return an hash map vertex id -> <value, line in the file>
+ * A read-only memory mapping of a whole file
+ */
+class MappedFile {
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* m_content = nullptr; // the content of the file
+    uint64_t m_size = 0; // the size of the file, in bytes
+
+public:
+    // Map the given file. The description (`result', `reference') is only used in the error messages
+    MappedFile(const string& path, const char* description){
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) FATAL("The " << description << " file does not exist or is not accessible. Path: `" << path << "'");
+        struct stat file_stats;
+        if(fstat(fd, &file_stats) != 0){
+            ::close(fd);
+            FATAL("Cannot retrieve the size of the " << description << " file: " << strerror(errno) << ". Path: `" << path << "'");
+        }
+        m_size = file_stats.st_size;
+        if(m_size > 0){ // mmap fails with an empty region
+            void* region = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(region == MAP_FAILED){
+                ::close(fd);
+                FATAL("Cannot map the " << description << " file in memory: " << strerror(errno) << ". Path: `" << path << "'");
+            }
+            madvise(region, m_size, MADV_SEQUENTIAL);
+            m_content = reinterpret_cast<const char*>(region);
+        }
+        ::close(fd); // the mapping is still valid
+    }
+
+    ~MappedFile(){
+        if(m_content != nullptr){ munmap(const_cast<char*>(m_content), m_size); }
+    }
+
+    const char* begin() const { return m_content; }
+    const char* end() const { return m_content + m_size; }
+};
+
+/**
+ * The mismatches found by the worker threads. Only the first `max_num_errors' mismatches, in the order of the
+ * reference file, can ever be reported, the others are discarded to bound the memory usage.
+ */
+class Mismatches {
+    struct Mismatch { uint64_t m_lineno; string m_message; };
+    const uint64_t m_max_num_errors; // 0 => unlimited
+    vector<Mismatch> m_mismatches;
+
+    void shrink(){
+        assert(m_max_num_errors > 0);
+        nth_element(m_mismatches.begin(), m_mismatches.begin() + m_max_num_errors -1, m_mismatches.end(), [](const Mismatch& m1, const Mismatch& m2){ return m1.m_lineno < m2.m_lineno; });
+        m_mismatches.resize(m_max_num_errors);
+    }
+
+public:
+    Mismatches(uint64_t max_num_errors) : m_max_num_errors(max_num_errors) { }
+
+    void add(uint64_t lineno, string message){
+        m_mismatches.push_back(Mismatch{ lineno, move(message) });
+        if(m_max_num_errors > 0 && m_mismatches.size() >= 2 * m_max_num_errors){ shrink(); }
+    }
+
+    // Merge the mismatches found by another thread
+    void merge(Mismatches& other){
+        for(auto& m : other.m_mismatches){ add(m.m_lineno, move(m.m_message)); }
+        other.m_mismatches.clear();
+    }
+
+    // Sort the mismatches in the order of the reference file
+    vector<Mismatch>& sorted(){
+        if(m_max_num_errors > 0 && m_mismatches.size() > m_max_num_errors){ shrink(); }
+        sort(m_mismatches.begin(), m_mismatches.end(), [](const Mismatch& m1, const Mismatch& m2){ return m1.m_lineno < m2.m_lineno; });
+        return m_mismatches;
+    }
+};
+
+} // anon namespace
+
+/**
+ * Sort the elements in parallel: each thread sorts a run, then the runs are merged in pairs
+ */
+template<typename T, typename Compare = less<T>>
+static void parallel_sort(vector<T>& elements, Compare compare = Compare()){
+    const uint64_t num_runs = max<uint64_t>(1, min<uint64_t>(num_threads(), elements.size() / 1024));
+    vector<uint64_t> boundaries(num_runs +1);
+    for(uint64_t i = 0; i <= num_runs; i++){ boundaries[i] = elements.size() * i / num_runs; }
+
+    #pragma omp parallel for schedule(static, 1)
+    for(uint64_t i = 0; i < num_runs; i++){
+        sort(elements.begin() + boundaries[i], elements.begin() + boundaries[i +1], compare);
+    }
+
+    for(uint64_t width = 1; width < num_runs; width *= 2){
+        #pragma omp parallel for schedule(static, 1)
+        for(uint64_t i = 0; i < num_runs; i += 2 * width){
+            if(i + width < num_runs){
+                inplace_merge(elements.begin() + boundaries[i], elements.begin() + boundaries[i + width], elements.begin() + boundaries[min(i + 2 * width, num_runs)], compare);
+            }
+        }
+    }
+}
+
+/**
+ * Parse the content of the given file, in parallel. The file is split in ranges of lines, one for each thread. The
+ * vertices, and optionally the values, are relabelled with the given map. Return the tuples in the order of the file.
  */
 template<typename T>
-static unordered_map</* vertex id */ int64_t, /* value */ Tuple<T>> read_results(const std::string& path_to_file){
-    fstream handle(path_to_file, ios_base::in);
-    if(!handle.good()) FATAL("The result file does not exist or is not accessible. Path: `"  << path_to_file << "'");
-
-    uint64_t lineno = 0; // current line number
-    char buffer[BUFFER_SZ]; // read the current line from the file
-    unordered_map<int64_t, Tuple<T>> result;
-
-    lineno = 0;
-    while(true){
-        handle.getline(buffer, BUFFER_SZ);
-        if(handle.eof()) break;
-        auto v = parse_value<T>(lineno, buffer, "result");
-        auto rc = result.insert({ v.first, Tuple<T>{v.first, v.second, lineno} });
-        if(!rc.second){ FATAL("[lineno=" << lineno << ", file=" << path_to_file << "] The vertex " << v.first << " is a duplicate, already defined at line #" << rc.first->second.lineno); }
-        lineno++;
+static vector<Tuple<T>> parse_file(const MappedFile& file, const char* buffer_name, const GraphalyticsValidate::vertex_map_t* vtx_map = nullptr, bool relabel_value = false){
+    const uint64_t file_size = file.end() - file.begin();
+    const uint64_t num_ranges = max<uint64_t>(1, min<uint64_t>(num_threads(), file_size / BUFFER_SZ));
+
+    // split the file at the line boundaries
+    vector<const char*> boundaries(num_ranges +1);
+    boundaries[0] = file.begin();
+    boundaries[num_ranges] = file.end();
+    for(uint64_t i = 1; i < num_ranges; i++){
+        const char* start = max(boundaries[i -1], file.begin() + file_size * i / num_ranges);
+        const char* newline = reinterpret_cast<const char*>(memchr(start, '\n', file.end() - start));
+        boundaries[i] = (newline == nullptr) ? file.end() : newline +1;
     }
 
-    handle.close();
+    // count the lines in each range, to determine the line number where each range starts
+    vector<uint64_t> line_offsets(num_ranges +1, 0);
+    #pragma omp parallel for schedule(static, 1)
+    for(uint64_t i = 0; i < num_ranges; i++){
+        const char* end = boundaries[i +1];
+        line_offsets[i +1] = count(boundaries[i], end, '\n');
+        if(end > boundaries[i] && end[-1] != '\n'){ line_offsets[i +1]++; } // the last line of the file does not end with a newline
+    }
+    for(uint64_t i = 1; i <= num_ranges; i++){ line_offsets[i] += line_offsets[i -1]; }
+
+    // parse the lines
+    vector<Tuple<T>> tuples(line_offsets[num_ranges]);
+    vector<exception_ptr> errors(num_ranges);
+    #pragma omp parallel for schedule(static, 1)
+    for(uint64_t i = 0; i < num_ranges; i++){
+        try {
+            char buffer[BUFFER_SZ]; // the current line, null terminated
+            uint64_t lineno = line_offsets[i];
+            const char* line = boundaries[i];
+            const char* end = boundaries[i +1];
+            while(line < end){
+                const char* newline = reinterpret_cast<const char*>(memchr(line, '\n', end - line));
+                if(newline == nullptr) newline = end;
+                uint64_t length = min<uint64_t>(newline - line, BUFFER_SZ -1);
+                memcpy(buffer, line, length);
+                buffer[length] = '\0';
+
+                auto v = relabel( parse_value<T>(lineno, buffer, buffer_name), lineno, vtx_map, relabel_value );
+                tuples[lineno] = Tuple<T>{ v.first, v.second, lineno };
+
+                lineno++;
+                line = newline +1;
+            }
+        } catch( ... ){
+            errors[i] = current_exception();
+        }
+    }
+
+    // report the first error in the file
+    for(auto& e : errors){ if(e) rethrow_exception(e); }
+
+    return tuples;
+}
+
+/**
+ * Read the content of the given result file, return the tuples sorted by vertex id
+ */
+template<typename T>
+static vector<Tuple<T>> read_results(const std::string& path_to_file){
+    MappedFile file(path_to_file, "result");
+    auto result = parse_file<T>(file, "result");
+    parallel_sort(result);
+
+    // check there are no duplicates. Report the first duplicate in the order of the file
+    uint64_t duplicate = result.size(); // position of the first duplicate
+    #pragma omp parallel for
+    for(uint64_t i = 1; i < result.size(); i++){
+        if(result[i -1].vertex_id == result[i].vertex_id && (i == 1 || result[i -2].vertex_id != result[i].vertex_id)){ // only the second occurrence of the vertex
+            #pragma omp critical
+            if(duplicate == result.size() || result[i].lineno < result[duplicate].lineno){ duplicate = i; }
+        }
+    }
+    if(duplicate < result.size()){
+        FATAL("[lineno=" << result[duplicate].lineno << ", file=" << path_to_file << "] The vertex " << result[duplicate].vertex_id << " is a duplicate, already defined at line #" << result[duplicate -1].lineno);
+    }
 
     return result;
 }
 
+/**
+ * Split the sorted reference in ranges, one for each thread, and invoke the callback for each tuple of the reference,
+ * with its position in the reference and the matching tuple in the sorted result, or nullptr if the vertex does not
+ * appear in the result file.
+ * The callbacks are executed concurrently, each thread with its own set of mismatches.
+ */
+template<typename T, typename Callback>
+static void join(const vector<Tuple<T>>& expected, const vector<Tuple<T>>& result, Mismatches& mismatches, Callback callback){
+    const uint64_t num_ranges = max<uint64_t>(1, min<uint64_t>(num_threads(), expected.size() / 1024));
+    vector<Mismatches> partial_mismatches(num_ranges, mismatches);
+
+    #pragma omp parallel for schedule(static, 1)
+    for(uint64_t i = 0; i < num_ranges; i++){
+        uint64_t start = expected.size() * i / num_ranges;
+        uint64_t end = expected.size() * (i +1) / num_ranges;
+        if(start == end) continue;
+        auto it = lower_bound(result.begin(), result.end(), expected[start].vertex_id, [](const Tuple<T>& t, int64_t vertex_id){ return t.vertex_id < vertex_id; });
+        for(uint64_t j = start; j < end; j++){
+            while(it != result.end() && it->vertex_id < expected[j].vertex_id) it++;
+            const Tuple<T>* match = (it != result.end() && it->vertex_id == expected[j].vertex_id) ? &(*it) : nullptr;
+            callback(j, expected[j], match, partial_mismatches[i]);
+        }
+    }
+
+    for(auto& m : partial_mismatches){ mismatches.merge(m); }
+}
+
 /*****************************************************************************
  *                                                                           *
  *  Exact match                                                              *
@@ -160,40 +385,33 @@ static unordered_map</* vertex id */ int64_t, /* value */ Tuple<T>> read_results
 void GraphalyticsValidate::exact_match(const std::string& path_result, const std::string& path_expected, uint64_t max_num_errors, const vertex_map_t* vtx_map, bool vtx_relabel_values){
     ERROR_INIT
 
-    fstream handle_expected(path_expected, ios_base::in);
-    if(!handle_expected.good()) FATAL("The reference file does not exist or is not accessible. Path: `" << path_expected << "'");
-    auto hash_results = read_results<int64_t>(path_result); // hash map: vertex id -> <value, line>
-
-    // now parse `reference'
-    char buffer[BUFFER_SZ];
-    uint64_t lineno = 0;
-    while(true){
-        handle_expected.getline(buffer, BUFFER_SZ);
-        if(handle_expected.eof()) break;
-        auto t_expected = relabel( parse_value<int64_t>(lineno, buffer, "expected"), lineno, vtx_map, vtx_relabel_values );
-
-        if(lineno >= hash_results.size()){
-            ERROR_COUNT("[lineno=" << lineno << "] VALIDATION ERROR, the reference contains more vertices than the actual result file");
-        } else {
-            const auto& t_result_it = hash_results.find(t_expected.first);
-            if (t_result_it == end(hash_results)){
-                ERROR_COUNT("[line number reference: " << lineno << "] VALIDATION ERROR, the vertex " << t_expected.first << " is present in the reference (" << path_expected << ") but not in the results (" << path_result << ") ");
-            } else if (t_result_it->second.vertex_id != t_expected.first){ // this should never occur, as the index of the hash map is the vertex id itself
-                ERROR_COUNT("[line number result: " << t_result_it->second.lineno << ", reference: " << lineno << "] VALIDATION ERROR, vertex retrieved: " << t_result_it->second.vertex_id << ", vertex expected: " << t_expected.first << " ");
-            } else if (t_expected.second != t_result_it->second.value){
-                ERROR_COUNT("[line number result: " << t_result_it->second.lineno << ", reference: " << lineno << "] VALIDATION ERROR, vertex: " << t_result_it->second.vertex_id << " matches, but value retrieved: " << t_result_it->second.value << " != value expected: " << t_expected.second);
-            }
+    MappedFile file_expected(path_expected, "reference");
+    auto results = read_results<int64_t>(path_result); // sorted by vertex id
+    auto expected = parse_file<int64_t>(file_expected, "expected", vtx_map, vtx_relabel_values);
+    const uint64_t num_results = results.size();
+    const uint64_t num_expected = expected.size();
+    parallel_sort(expected);
+
+    Mismatches mismatches(max_num_errors);
+    join(expected, results, mismatches, [&](uint64_t, const Tuple<int64_t>& t_expected, const Tuple<int64_t>* t_result, Mismatches& mismatches){
+        const uint64_t lineno = t_expected.lineno;
+        if(lineno >= num_results){
+            MISMATCH(lineno, "[lineno=" << lineno << "] VALIDATION ERROR, the reference contains more vertices than the actual result file");
+        } else if (t_result == nullptr){
+            MISMATCH(lineno, "[line number reference: " << lineno << "] VALIDATION ERROR, the vertex " << t_expected.vertex_id << " is present in the reference (" << path_expected << ") but not in the results (" << path_result << ") ");
+        } else if (t_expected.value != t_result->value){
+            MISMATCH(lineno, "[line number result: " << t_result->lineno << ", reference: " << lineno << "] VALIDATION ERROR, vertex: " << t_result->vertex_id << " matches, but value retrieved: " << t_result->value << " != value expected: " << t_expected.value);
         }
+    });
 
-        lineno++;
+    for(auto& m : mismatches.sorted()){
+        ERROR_COUNT(m.m_message);
     }
 
-    if(lineno < hash_results.size()){
-    	ERROR_COUNT("The result file contains more lines [vertices] than the expected/reference output. Vertices in the result file: " << hash_results.size() << ", vertices expected: " << lineno);
+    if(num_expected < num_results){
+    	ERROR_COUNT("The result file contains more lines [vertices] than the expected/reference output. Vertices in the result file: " << num_results << ", vertices expected: " << num_expected);
     }
 
-    handle_expected.close();
-
     ERROR_EXIT
 }
 
@@ -213,52 +431,41 @@ void GraphalyticsValidate::cdlp(const std::string& result, const std::string& ex
 void GraphalyticsValidate::epsilon_match(const std::string& path_result, const std::string& path_expected, double epsilon, uint64_t max_num_errors, const vertex_map_t* vertex_map){
     ERROR_INIT
 
-    fstream handle_expected(path_expected, ios_base::in);
-    if(!handle_expected.good()) FATAL("The reference file does not exist or is not accessible. Path: `" << path_expected << "'");
-    auto hash_results = read_results<double>(path_result); // hash map: vertex id -> <value, line>
-
-    uint64_t lineno = 0; // current line number
-    char buffer[BUFFER_SZ]; // current line read from the file
-
-    while(true){ // read until the eof
-        handle_expected.getline(buffer, BUFFER_SZ);
-        if(handle_expected.eof()) break;
-
-        auto t_expected = parse_value<double>(lineno, buffer, "expected");
-        if(vertex_map != nullptr) { t_expected.first = vertex_map->find(t_expected.first)->second; } // remap the vertex
-
-        if(lineno >= hash_results.size()){
-            ERROR_COUNT("[lineno=" << lineno << "] VALIDATION ERROR, the reference contains more vertices than the actual result file");
+    MappedFile file_expected(path_expected, "reference");
+    auto results = read_results<double>(path_result); // sorted by vertex id
+    auto expected = parse_file<double>(file_expected, "expected", vertex_map);
+    const uint64_t num_results = results.size();
+    const uint64_t num_expected = expected.size();
+    parallel_sort(expected);
+
+    Mismatches mismatches(max_num_errors);
+    join(expected, results, mismatches, [&](uint64_t, const Tuple<double>& t_expected, const Tuple<double>* t_result, Mismatches& mismatches){
+        const uint64_t lineno = t_expected.lineno;
+        if(lineno >= num_results){
+            MISMATCH(lineno, "[lineno=" << lineno << "] VALIDATION ERROR, the reference contains more vertices than the actual result file");
+        } else if (t_result == nullptr){
+            MISMATCH(lineno, "[line number reference: " << lineno << "] VALIDATION ERROR, the vertex " << t_expected.vertex_id << " is present in the reference (" << path_expected << ") but not in the results (" << path_result << ") ");
         } else {
-
-            const auto& t_result_it = hash_results.find(t_expected.first);
-            if (t_result_it == end(hash_results)){
-                ERROR_COUNT("[line number reference: " << lineno << "] VALIDATION ERROR, the vertex " << t_expected.first << " is present in the reference (" << path_expected << ") but not in the results (" << path_result << ") ");
-            } else if (t_result_it->second.vertex_id != t_expected.first){ // this should never occur, as the index of the hash map is the vertex id itself
-                ERROR_COUNT("[line number result: " << t_result_it->second.lineno << ", reference: " << lineno << "] VALIDATION ERROR, vertex retrieved: " << t_result_it->second.vertex_id << ", vertex expected: " << t_expected.first << " ");
-            } else {
-                double value_result = t_result_it->second.value;
-                double value_expected = t_expected.second;
-
-
-                double error = abs(value_result - value_expected) / value_expected;
-                COUT_DEBUG("vertex: " << t_result_it->second.vertex_id << ", value: " << value_result << ", expected: " << value_expected << ", error: " << error);
-                if (error > epsilon){
-                    ERROR_COUNT("[lineno result: " << t_result_it->second.lineno << ", reference:" << lineno << "] VALIDATION ERROR, vertex: " << t_result_it->second.vertex_id << " matches, but "
-                            "value retrieved: " << value_result << ", value expected: " << value_expected << ", error: " << error << ", tolerance (epsilon): " << epsilon);
-                }
+            double value_result = t_result->value;
+            double value_expected = t_expected.value;
+
+            double error = abs(value_result - value_expected) / value_expected;
+            COUT_DEBUG("vertex: " << t_result->vertex_id << ", value: " << value_result << ", expected: " << value_expected << ", error: " << error);
+            if (error > epsilon){
+                MISMATCH(lineno, "[lineno result: " << t_result->lineno << ", reference:" << lineno << "] VALIDATION ERROR, vertex: " << t_result->vertex_id << " matches, but "
+                        "value retrieved: " << value_result << ", value expected: " << value_expected << ", error: " << error << ", tolerance (epsilon): " << epsilon);
             }
         }
+    });
 
-        lineno++;
+    for(auto& m : mismatches.sorted()){
+        ERROR_COUNT(m.m_message);
     }
 
-    if(lineno < hash_results.size()){
-        ERROR_COUNT("The result file contains more lines [vertices] than the expected/reference output. Vertices in the result file: " << hash_results.size() << ", vertices expected: " << lineno);
+    if(num_expected < num_results){
+        ERROR_COUNT("The result file contains more lines [vertices] than the expected/reference output. Vertices in the result file: " << num_results << ", vertices expected: " << num_expected);
     }
 
-    handle_expected.close();
-
     ERROR_EXIT
 }
 
@@ -281,70 +488,81 @@ void GraphalyticsValidate::sssp(const std::string& result, const std::string& ex
  *  Equivalence match                                                        *
  *                                                                           *
  *****************************************************************************/
+namespace {
+struct Component { int64_t m_reference; int64_t m_result; uint64_t m_lineno; int64_t m_vertex_id; }; // the components of a vertex in the two files
+}
 
 void GraphalyticsValidate::equivalence_match(const std::string& result, const std::string& expected, uint64_t max_num_errors, const vertex_map_t* vertex_map){
     ERROR_INIT
 
-    fstream handle_result(result, ios_base::in);
-    if(!handle_result.good()) FATAL("The result file does not exist or is not accessible. Path: `"  << result << "'");
-    fstream handle_expected(expected, ios_base::in);
-    if(!handle_expected.good()) FATAL("The reference file does not exist or is not accessible. Path: `" << expected << "'");
-
-    char buffer[BUFFER_SZ]; // current line being processed
-    uint64_t lineno = 0; // current line number
-    unordered_map<int64_t, int64_t> components_result; // read the results
-    unordered_map<int64_t, int64_t> ref_mapping; // component[ref] -> component[exp]
-    unordered_set<int64_t> unique_components; // check that component[exp] does not belong to different components in ref
-
-    // process the file with the results
-    while(true){
-        handle_result.getline(buffer, BUFFER_SZ);
-        if(handle_result.eof()) break;
-        auto t = parse_value<int64_t>(lineno, buffer, "result");
-        components_result[t.first] = t.second;
-        lineno++;
-    }
+    MappedFile file_result(result, "result");
+    MappedFile file_expected(expected, "reference");
 
-    handle_result.close();
+    // process the file with the results. If a vertex is repeated, its last occurrence wins
+    auto components_result = parse_file<int64_t>(file_result, "result");
+    parallel_sort(components_result);
+    uint64_t num_results = 0;
+    for(uint64_t i = 0; i < components_result.size(); i++){
+        if(i +1 == components_result.size() || components_result[i +1].vertex_id != components_result[i].vertex_id){
+            components_result[num_results++] = components_result[i];
+        }
+    }
+    components_result.resize(num_results);
 
     // process the reference file
-    lineno = 0;
-    while(true){
-        handle_expected.getline(buffer, BUFFER_SZ);
-        if(handle_expected.eof()) break;
-        auto t_ref = parse_value<int64_t>(lineno, buffer, "reference");
-        if(vertex_map != nullptr) { t_ref.first = vertex_map->find(t_ref.first)->second; } // relabel the vertex
-
-        // first of all, does this vertex exist in the result file?
-        auto ptr_t_res = components_result.find(t_ref.first);
-        if(ptr_t_res == end(components_result)){
-            ERROR_COUNT("[lineno reference:" << lineno << "] VALIDATION ERROR, the vertex " << t_ref.first << " is expected but not present in the result file");
+    auto components_expected = parse_file<int64_t>(file_expected, "reference", vertex_map);
+    const uint64_t num_expected = components_expected.size();
+    parallel_sort(components_expected);
+
+    // first of all, does this vertex exist in the result file?
+    Mismatches mismatches(max_num_errors);
+    vector<Component> components(num_expected);
+    join(components_expected, components_result, mismatches, [&](uint64_t position, const Tuple<int64_t>& t_ref, const Tuple<int64_t>* t_res, Mismatches& mismatches){
+        const uint64_t lineno = t_ref.lineno;
+        if(t_res == nullptr){
+            MISMATCH(lineno, "[lineno reference:" << lineno << "] VALIDATION ERROR, the vertex " << t_ref.vertex_id << " is expected but not present in the result file");
+            components[position] = Component{ 0, 0, numeric_limits<uint64_t>::max(), t_ref.vertex_id }; // skip
         } else {
-            auto t_res = *ptr_t_res;
-
-            // is the first time we see this vertex in the ref file?
-            auto mapping = ref_mapping.insert({t_ref.second, t_res.second});
-            if(mapping.second){ // as we have seen for the first time this component in ref, check we haven't seen previously also in exp
-                auto insert_rc = unique_components.insert(t_res.second);
-                if(!insert_rc.second){ // we were not able to insert `result' in the list of unique_values => a mapping for `result' already exists
-                    ERROR_COUNT("[lineno reference:" << lineno << "] VALIDATION ERROR, vertex: " << t_ref.first << ", the component " << t_res.second << " is associated to a single component in the result file but "
-                            "belongs to two different components in the reference file");
-                }
-            } else if(!mapping.second && mapping.first->second != t_res.second) { // this mapping already exists, but the two components don't match
-                ERROR_COUNT("[lineno reference:" << lineno << "] VALIDATION ERROR, vertex: " << t_ref.first << ", invalid mapping, component in the result file: " << t_res.second <<
-                        ", expected value: " << mapping.first->second << " (in ref. file, mapped to value: " << t_ref.second << ")");
-            }
-
+            components[position] = Component{ t_ref.value, t_res->value, lineno, t_ref.vertex_id };
+        }
+    });
+    components.erase(remove_if(components.begin(), components.end(), [](const Component& c){ return c.m_lineno == numeric_limits<uint64_t>::max(); }), components.end());
+
+    // the first vertex of a component in the reference file, in the order of the file, determines the mapping
+    // component[ref] -> component[exp]. All other vertices of the same component must be mapped to the same value.
+    parallel_sort(components, [](const Component& c1, const Component& c2){
+        return c1.m_reference < c2.m_reference || (c1.m_reference == c2.m_reference && c1.m_lineno < c2.m_lineno);
+    });
+    vector<Component> ref_mapping; // the first vertex of each component in the reference file
+    for(uint64_t i = 0; i < components.size(); i++){
+        if(i == 0 || components[i -1].m_reference != components[i].m_reference){
+            ref_mapping.push_back(components[i]);
+        } else if(components[i].m_result != ref_mapping.back().m_result) { // this mapping already exists, but the two components don't match
+            const auto& c = components[i];
+            MISMATCH(c.m_lineno, "[lineno reference:" << c.m_lineno << "] VALIDATION ERROR, vertex: " << c.m_vertex_id << ", invalid mapping, component in the result file: " << c.m_result <<
+                    ", expected value: " << ref_mapping.back().m_result << " (in ref. file, mapped to value: " << c.m_reference << ")");
         }
+    }
 
-        lineno++;
+    // check that component[exp] does not belong to different components in ref
+    parallel_sort(ref_mapping, [](const Component& c1, const Component& c2){
+        return c1.m_result < c2.m_result || (c1.m_result == c2.m_result && c1.m_lineno < c2.m_lineno);
+    });
+    for(uint64_t i = 1; i < ref_mapping.size(); i++){
+        if(ref_mapping[i -1].m_result == ref_mapping[i].m_result){
+            const auto& c = ref_mapping[i];
+            MISMATCH(c.m_lineno, "[lineno reference:" << c.m_lineno << "] VALIDATION ERROR, vertex: " << c.m_vertex_id << ", the component " << c.m_result << " is associated to a single component in the result file but "
+                    "belongs to two different components in the reference file");
+        }
     }
 
-    if(lineno < components_result.size()){
-        ERROR_COUNT("The result file contains more lines [vertices] than the expected/reference output. Vertices result:  " << components_result.size() << ", vertices expected: " << lineno);
+    for(auto& m : mismatches.sorted()){
+        ERROR_COUNT(m.m_message);
     }
 
-    handle_expected.close();
+    if(num_expected < num_results){
+        ERROR_COUNT("The result file contains more lines [vertices] than the expected/reference output. Vertices result:  " << num_results << ", vertices expected: " << num_expected);
+    }
 
     ERROR_EXIT
 }
@@ -0,0 +1,165 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "result_writer.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <unistd.h>
+
+#if defined(HAVE_OPENMP)
+#include "omp.h"
+#endif
+
+#include "common/error.hpp"
+
+using namespace std;
+
+namespace gfe::utility {
+
+/*****************************************************************************
+ *                                                                           *
+ *  Formatting                                                               *
+ *                                                                           *
+ *****************************************************************************/
+namespace {
+
+constexpr uint64_t CHUNK_SIZE = 1ull << 16; // number of entries formatted by each thread at the time
+constexpr uint64_t MAX_LINE_LENGTH = 48; // 20 digits for the vertex ID, a space, at most 20 chars for the value (integers) or 13 chars (%g format), the newline
+
+// Format the value as std::ostream would, with the default precision of 6 digits for the floating point numbers
+template<typename T>
+char* format_value(char* first, char* last, T value){
+    to_chars_result result;
+    if constexpr (is_floating_point_v<T>){
+        result = to_chars(first, last, value, chars_format::general, 6);
+    } else {
+        result = to_chars(first, last, value);
+    }
+    assert(result.ec == errc{});
+    return result.ptr;
+}
+
+// Format the entries in [start, end) of the result into the buffer, return the number of chars written
+template<typename T>
+uint64_t format_chunk(const vector<pair<uint64_t, T>>& result, uint64_t start, uint64_t end, bool negative_scores, bool skip_invalid, char* buffer){
+    char* const buffer_end = buffer + (end - start) * MAX_LINE_LENGTH;
+    char* position = buffer;
+
+    for(uint64_t i = start; i < end; i++){
+        const auto& p = result[i];
+        if(skip_invalid && p.first == numeric_limits<uint64_t>::max()) continue; // invalid node
+
+        position = format_value(position, buffer_end, p.first);
+        *(position++) = ' ';
+        if(!negative_scores && p.second < 0){
+            position = format_value(position, buffer_end, numeric_limits<T>::max());
+        } else {
+            position = format_value(position, buffer_end, p.second);
+        }
+        *(position++) = '\n';
+    }
+
+    return position - buffer;
+}
+
+// Write the whole buffer at the given offset of the file
+bool write_fully(int fd, const char* buffer, uint64_t length, uint64_t offset){
+    while(length > 0){
+        ssize_t num_bytes = ::pwrite(fd, buffer, length, offset);
+        if(num_bytes < 0){
+            if(errno == EINTR) continue;
+            return false;
+        }
+        buffer += num_bytes;
+        length -= num_bytes;
+        offset += num_bytes;
+    }
+    return true;
+}
+
+} // anon namespace
+
+/*****************************************************************************
+ *                                                                           *
+ *  Save                                                                     *
+ *                                                                           *
+ *****************************************************************************/
+template<typename T>
+void save_results(const vector<pair<uint64_t, T>>& result, const char* dump2file, bool negative_scores, bool skip_invalid){
+    assert(dump2file != nullptr);
+
+    int fd = ::open(dump2file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) ERROR("Cannot save the result to `" << dump2file << "': " << strerror(errno));
+
+#if defined(HAVE_OPENMP)
+    const uint64_t num_slots = omp_get_max_threads();
+#else
+    const uint64_t num_slots = 1;
+#endif
+    const uint64_t num_chunks = (result.size() + CHUNK_SIZE -1) / CHUNK_SIZE;
+    unique_ptr<unique_ptr<char[]>[]> buffers { new unique_ptr<char[]>[num_slots] };
+    unique_ptr<uint64_t[]> lengths { new uint64_t[num_slots] };
+    unique_ptr<uint64_t[]> offsets { new uint64_t[num_slots] };
+    uint64_t file_offset = 0;
+    atomic<int> error_code = 0; // errno of the first write that failed
+
+    // process a block of num_slots chunks at the time
+    for(uint64_t block_start = 0; block_start < num_chunks && error_code == 0; block_start += num_slots){
+        const uint64_t block_end = min(num_chunks, block_start + num_slots);
+
+        #pragma omp parallel for schedule(static, 1)
+        for(uint64_t chunk = block_start; chunk < block_end; chunk++){
+            const uint64_t slot = chunk - block_start;
+            if(!buffers[slot]){ buffers[slot].reset(new char[CHUNK_SIZE * MAX_LINE_LENGTH]); }
+            const uint64_t start = chunk * CHUNK_SIZE;
+            const uint64_t end = min<uint64_t>(result.size(), start + CHUNK_SIZE);
+            lengths[slot] = format_chunk(result, start, end, negative_scores, skip_invalid, buffers[slot].get());
+        }
+
+        // the position of each chunk in the file
+        for(uint64_t slot = 0; slot < block_end - block_start; slot++){
+            offsets[slot] = file_offset;
+            file_offset += lengths[slot];
+        }
+
+        #pragma omp parallel for schedule(static, 1)
+        for(uint64_t slot = 0; slot < block_end - block_start; slot++){
+            if(!write_fully(fd, buffers[slot].get(), lengths[slot], offsets[slot])){
+                int expected = 0;
+                error_code.compare_exchange_strong(expected, errno);
+            }
+        }
+    }
+
+    ::close(fd);
+    if(error_code != 0) ERROR("Cannot save the result to `" << dump2file << "': " << strerror(error_code));
+}
+
+// Explicitly instantiate the templates
+template void save_results<int64_t>(const vector<pair<uint64_t, int64_t>>& result, const char* dump2file, bool negative_scores, bool skip_invalid);
+template void save_results<uint64_t>(const vector<pair<uint64_t, uint64_t>>& result, const char* dump2file, bool negative_scores, bool skip_invalid);
+template void save_results<double>(const vector<pair<uint64_t, double>>& result, const char* dump2file, bool negative_scores, bool skip_invalid);
+
+} // namespace
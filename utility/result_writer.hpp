@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <utility>
+#include <vector>
+
+namespace gfe::utility {
+
+/**
+ * Save the result of a Graphalytics kernel in the format expected by the benchmark specification, one line `<vertex> <value>'
+ * for each vertex, with the same formatting of std::ostream.
+ *
+ * The result is split in chunks, each chunk is formatted with std::to_chars by a separate thread and written at its own
+ * offset of the file with pwrite. The chunks are processed a block at the time, to bound the memory used by the buffers.
+ *
+ * Supported types: int64_t, uint64_t and double.
+ *
+ * @param result pairs <external vertex ID, value>
+ * @param dump2file the path of the file to create
+ * @param negative_scores if false, negative values are saved as numeric_limits<T>::max()
+ * @param skip_invalid if true, the entries with the vertex ID numeric_limits<uint64_t>::max() are skipped
+ */
+template<typename T>
+void save_results(const std::vector<std::pair<uint64_t, T>>& result, const char* dump2file, bool negative_scores = true, bool skip_invalid = true);
+
+} // namespace
@@ -18,6 +18,11 @@
 #include "timeout_service.hpp"
 
 #include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
 
 #include "common/system.hpp"
 
@@ -25,40 +30,110 @@ using namespace std;
 
 namespace gfe::utility {
 
+/*****************************************************************************
+ *                                                                           *
+ *  TimeoutTimer                                                             *
+ *                                                                           *
+ *****************************************************************************/
+/**
+ * The background thread shared by all instances of the TimeoutService. It sleeps until the earliest deadline
+ * registered, and then raises the flag of the related services.
+ */
+class TimeoutTimer {
+    using clock_t = TimeoutService::clock_t;
+    using entry_t = pair<clock_t::time_point, TimeoutService*>;
+
+    set<entry_t> m_deadlines; // the services registered, sorted by deadline
+    bool m_terminate = false; // signal termination to the background thread
+    mutex m_mutex; // sync the services with the background thread
+    condition_variable m_condvar; // wake up the background thread
+    thread m_background_thread; // handle to the background thread
+
+    // The underlying thread responsible to raise the flag of the services
+    void main_thread(){
+        unique_lock<mutex> lock(m_mutex);
+        while(!m_terminate){
+            if(m_deadlines.empty()){
+                m_condvar.wait(lock);
+            } else {
+                m_condvar.wait_until(lock, m_deadlines.begin()->first);
+            }
+
+            auto now = clock_t::now();
+            while(!m_deadlines.empty() && m_deadlines.begin()->first <= now){
+                m_deadlines.begin()->second->expire();
+                m_deadlines.erase(m_deadlines.begin());
+            }
+        }
+    }
+
+public:
+    TimeoutTimer() {
+        m_background_thread = thread(&TimeoutTimer::main_thread, this);
+    }
+
+    ~TimeoutTimer(){
+        {
+            scoped_lock<mutex> lock(m_mutex);
+            m_terminate = true;
+        }
+        m_condvar.notify_all();
+        m_background_thread.join(); // wait for termination
+    }
+
+    // Raise the flag of the service at the given deadline
+    void add(TimeoutService* service, clock_t::time_point deadline){
+        bool is_first = false;
+        {
+            scoped_lock<mutex> lock(m_mutex);
+            auto it = m_deadlines.emplace(deadline, service).first;
+            is_first = (it == m_deadlines.begin());
+        }
+        if(is_first){ m_condvar.notify_all(); } // the background thread needs to wake up earlier
+    }
+
+    // Remove the service, if its deadline did not expire yet
+    void remove(TimeoutService* service, clock_t::time_point deadline){
+        scoped_lock<mutex> lock(m_mutex);
+        m_deadlines.erase(entry_t{ deadline, service });
+    }
+
+    // The instance shared by all services
+    static TimeoutTimer& instance(){
+        static TimeoutTimer timer;
+        return timer;
+    }
+};
+
 /*****************************************************************************
  *                                                                           *
  *  TimeoutService                                                           *
  *                                                                           *
  *****************************************************************************/
+static thread_local chrono::microseconds g_last_overrun { 0 }; // the overrun of the last service expired destroyed by this thread
+
 void TimeoutService::start() {
     if(m_budget == 0s) return; // nop, the timer will never expire
 
-    assert(!m_background_thread.joinable() && "A background thread is already present");
-    m_background_thread = thread(&TimeoutService::main_thread, this);
+    TimeoutTimer::instance().add(this, deadline());
 }
 
 void TimeoutService::stop(){
     if(m_budget == 0s) return; // nop, never started
 
-    {
-        scoped_lock<mutex> lock(m_mutex);
-        m_terminate = true;
-    }
-    m_condvar.notify_all();
+    TimeoutTimer::instance().remove(this, deadline());
 
-    m_background_thread.join(); // wait for termination
+    if(is_timeout()){
+        g_last_overrun = chrono::duration_cast<chrono::microseconds>(clock_t::now() - deadline());
+    }
 }
 
-void TimeoutService::main_thread(){
-    bool terminate = false;
-    while(!terminate){
-        unique_lock<mutex> lock(m_mutex);
-        m_condvar.wait_for(lock, 1s, [this](){ return m_terminate; });
-        terminate = m_terminate;
-        lock.unlock();
+void TimeoutService::expire(){
+    m_is_timeout.store(true, memory_order_relaxed);
+}
 
-        m_is_timeout = ( clock_t::now() - m_start ) > m_budget;
-    }
+chrono::microseconds TimeoutService::last_overrun(){
+    return g_last_overrun;
 }
 
 } // namespace
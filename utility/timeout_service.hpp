@@ -17,10 +17,8 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
-#include <mutex>
-#include <thread>
 
 namespace gfe::utility {
     
@@ -28,27 +26,36 @@ namespace gfe::utility {
  * This service keeps track sets the flag is_timeout() after a certain given of time has passed
  * since the service itself was created.
  * The service is meant to be used by multiple threads to poll continuously whether they can
- * continue their computation or they depleted their budget and abort the computation.
+ * continue their computation or they depleted their budget and abort the computation. Polling
+ * the flag costs a single relaxed load, so that it can be checked in the inner loops of the kernels.
+ *
+ * The flag is raised asynchronously, at the deadline, by a background thread shared by all
+ * instances of the service. When a service whose deadline expired is destroyed, the time
+ * elapsed past the deadline is recorded as the overrun of the computation, see #last_overrun().
  * This class is thread safe.
  */
 class TimeoutService {
+    TimeoutService(const TimeoutService&) = delete;
+    TimeoutService& operator=(const TimeoutService&) = delete;
+
+public:
     using clock_t = std::chrono::steady_clock;
+
+private:
     const clock_t::time_point m_start; // the time when the service was started
     const std::chrono::seconds m_budget; // the amount of time that must pass before updating the flag `m_is_timeout'
-    bool m_is_timeout = false; // the flag to update asynchronously
-    bool m_terminate = false; // signal termination to the async thread
-    std::mutex m_mutex; // sync the termination with the background thread
-    std::condition_variable m_condvar; // sync the termination with the background thread
-    std::thread m_background_thread; // handle to the background thread
-
-    // The underlying thread responsible to update asynchronously the flag `m_is_timeout'
-    void main_thread();
+    std::atomic<bool> m_is_timeout = false; // the flag to update asynchronously
 
     // Starts the service
     void start();
 
     // Stops the service
     void stop();
+
+    // Invoked by the background thread when the deadline expires
+    friend class TimeoutTimer;
+    void expire();
+
 public:
     /**
      * Create the service.
@@ -75,7 +82,18 @@ public:
     /**
      * Checks whether the specified amount of time has passed.
      */
-    bool is_timeout() const { return m_is_timeout; }
+    bool is_timeout() const { return m_is_timeout.load(std::memory_order_relaxed); }
+
+    /**
+     * Retrieve the time when the flag is_timeout() is raised
+     */
+    clock_t::time_point deadline() const { return m_start + m_budget; }
+
+    /**
+     * Retrieve the overrun of the last service, whose deadline expired, destroyed by the calling thread. That is,
+     * the time elapsed between the deadline and the end of the computation that was meant to be interrupted.
+     */
+    static std::chrono::microseconds last_overrun();
 };
     
 } // namespace
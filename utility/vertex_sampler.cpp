@@ -0,0 +1,201 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vertex_sampler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#include "common/error.hpp"
+#include "zipf_distribution.hpp"
+
+using namespace std;
+
+namespace gfe::utility {
+
+/*****************************************************************************
+ *                                                                           *
+ *  Distribution                                                             *
+ *                                                                           *
+ *****************************************************************************/
+string vertex_sampler_distribution_to_string(VertexSamplerDistribution distribution){
+    switch(distribution){
+    case VertexSamplerDistribution::UNIFORM: return "uniform";
+    case VertexSamplerDistribution::DEGREE: return "degree";
+    case VertexSamplerDistribution::ZIPF: return "zipf";
+    default: return "unknown";
+    }
+}
+
+VertexSamplerDistribution vertex_sampler_distribution_from_string(const string& name){
+    string value = name;
+    transform(begin(value), end(value), begin(value), ::tolower);
+    if(value == "uniform"){
+        return VertexSamplerDistribution::UNIFORM;
+    } else if(value == "degree"){
+        return VertexSamplerDistribution::DEGREE;
+    } else if(value == "zipf"){
+        return VertexSamplerDistribution::ZIPF;
+    } else {
+        INVALID_ARGUMENT("Invalid distribution: `" << name << "'. Expected one of uniform, degree or zipf");
+    }
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Init                                                                     *
+ *                                                                           *
+ *****************************************************************************/
+VertexSampler::VertexSampler(VertexSamplerDistribution distribution, double zipf_exponent, uint64_t seed) :
+        m_distribution(distribution), m_zipf_exponent(zipf_exponent), m_seed(seed) {
+    if(m_distribution == VertexSamplerDistribution::ZIPF && m_zipf_exponent <= 0){
+        INVALID_ARGUMENT("The exponent of the zipf distribution must be positive: " << m_zipf_exponent);
+    }
+}
+
+void VertexSampler::set_population(vector<uint64_t> vertices){
+    if(m_distribution == VertexSamplerDistribution::DEGREE){
+        INVALID_ARGUMENT("A fixed population cannot be used with the degree distribution, the degrees are only known to the library");
+    }
+    m_population = move(vertices);
+}
+
+// the finaliser of SplitMix64, to derive the parameters of the permutations from the seed
+static uint64_t mix(uint64_t x){
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static thread_local uint64_t t_thread_id = 0; // set by the caller with #set_thread_id
+static thread_local bool t_initialised = false; // whether t_random has been seeded for t_seed and t_thread_id
+static thread_local uint64_t t_seed = 0;
+static thread_local mt19937_64 t_random;
+
+void VertexSampler::set_thread_id(uint64_t thread_id){
+    if(thread_id != t_thread_id){
+        t_thread_id = thread_id;
+        t_initialised = false; // reseed the generator
+    }
+}
+
+mt19937_64& VertexSampler::random() const {
+    // samplers with the same seed share the sequence of the thread, so that different instances do not repeat the same samples
+    if(!t_initialised || t_seed != m_seed){
+        t_random.seed(mix(m_seed + t_thread_id));
+        t_seed = m_seed;
+        t_initialised = true;
+    }
+
+    return t_random;
+}
+
+/*****************************************************************************
+ *                                                                           *
+ *  Sample                                                                   *
+ *                                                                           *
+ *****************************************************************************/
+void VertexSampler::sample(uint64_t count, vector<uint64_t>& output) const {
+    if(!has_population()){ ERROR("The population of the sampler has not been set"); }
+    sample(m_population.data(), nullptr, m_population.size(), count, output);
+}
+
+void VertexSampler::sample(const uint64_t* vertices, const uint64_t* degrees, uint64_t num_vertices, uint64_t count, vector<uint64_t>& output) const {
+    if(m_distribution == VertexSamplerDistribution::DEGREE && degrees == nullptr){
+        INVALID_ARGUMENT("The degree distribution requires the degrees of the vertices");
+    }
+
+    output.clear();
+    if(num_vertices == 0 || count == 0) return;
+    if(count >= num_vertices){ // take the whole population
+        output.assign(vertices, vertices + num_vertices);
+        return;
+    }
+
+    auto& random = this->random();
+
+    // the positions of the vertices already drawn, both as a bitmap and as a list. Reused by the thread across the invocations.
+    thread_local vector<uint64_t> t_bitmap;
+    thread_local vector<uint64_t> t_drawn;
+    if(t_bitmap.size() < (num_vertices + 63) / 64){ t_bitmap.resize((num_vertices + 63) / 64, 0); }
+    t_drawn.clear();
+    auto draw = [&](uint64_t position){
+        uint64_t mask = 1ull << (position % 64);
+        if((t_bitmap[position / 64] & mask) == 0){
+            t_bitmap[position / 64] |= mask;
+            t_drawn.push_back(position);
+        }
+    };
+
+    // with a skewed distribution, most attempts are rejected as duplicates when `count' gets close to the size of the population
+    const uint64_t max_attempts = count * 16 + 1024;
+    uint64_t num_attempts = 0;
+
+    switch(m_distribution){
+    case VertexSamplerDistribution::UNIFORM: {
+        uniform_int_distribution<uint64_t> distribution { 0, num_vertices -1 };
+        while(t_drawn.size() < count && num_attempts++ < max_attempts){ draw(distribution(random)); }
+    } break;
+    case VertexSamplerDistribution::DEGREE: {
+        thread_local vector<uint64_t> t_prefix_sum;
+        t_prefix_sum.resize(num_vertices);
+        uint64_t sum = 0;
+        for(uint64_t i = 0; i < num_vertices; i++){
+            sum += degrees[i];
+            t_prefix_sum[i] = sum;
+        }
+        if(sum == 0) break; // there are no edges
+
+        uniform_int_distribution<uint64_t> distribution { 0, sum -1 };
+        while(t_drawn.size() < count && num_attempts++ < max_attempts){
+            draw( upper_bound(begin(t_prefix_sum), begin(t_prefix_sum) + num_vertices, distribution(random)) - begin(t_prefix_sum) );
+        }
+    } break;
+    case VertexSamplerDistribution::ZIPF: {
+        // map the ranks to the positions with the permutation k -> (k * a + b) % num_vertices, with gcd(a, num_vertices) = 1,
+        // so that the most popular vertices are not simply those at the start of the population
+        uint64_t a = mix(m_seed) % num_vertices;
+        while(gcd(a, num_vertices) != 1){ a++; }
+        uint64_t b = mix(m_seed +1) % num_vertices;
+
+        ZipfDistribution distribution { num_vertices, m_zipf_exponent };
+        while(t_drawn.size() < count && num_attempts++ < max_attempts){
+            unsigned __int128 rank = distribution(random) -1;
+            draw( static_cast<uint64_t>((rank * a + b) % num_vertices) );
+        }
+    } break;
+    }
+
+    // too many duplicates, complete the sample with the next vertices, starting from a random position
+    if(t_drawn.size() < count){
+        uint64_t start = uniform_int_distribution<uint64_t>{ 0, num_vertices -1 }(random);
+        for(uint64_t i = 0; i < num_vertices && t_drawn.size() < count; i++){
+            uint64_t position = (start + i) % num_vertices;
+            if(degrees != nullptr && m_distribution == VertexSamplerDistribution::DEGREE && degrees[position] == 0) continue;
+            draw(position);
+        }
+    }
+
+    output.reserve(t_drawn.size());
+    for(uint64_t position : t_drawn){
+        output.push_back(vertices[position]);
+        t_bitmap[position / 64] = 0; // reset the bitmap for the next invocation
+    }
+}
+
+} // namespace
@@ -0,0 +1,113 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cinttypes>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace gfe::utility {
+
+/**
+ * How the vertices are picked by the VertexSampler
+ */
+enum class VertexSamplerDistribution {
+    UNIFORM, // all vertices have the same probability
+    DEGREE, // the probability of a vertex is proportional to its degree
+    ZIPF, // the probability of the k-th vertex, in a pseudo-random order fixed by the seed, is proportional to 1 / k^exponent
+};
+
+// Retrieve the name of the distribution: uniform, degree or zipf
+std::string vertex_sampler_distribution_to_string(VertexSamplerDistribution distribution);
+
+// Parse the name of a distribution. It throws an exception if the name is not recognised.
+VertexSamplerDistribution vertex_sampler_distribution_from_string(const std::string& name);
+
+/**
+ * Draw sets of distinct vertices, e.g. the candidates of the 1-hop and 2-hop expansions.
+ *
+ * The vertices are drawn either from a fixed population, set with #set_population, for instance the final
+ * vertices of an aging log, or from a population provided by the caller at each invocation, such as the
+ * live vertices retrieved from the vertex dictionary of a library.
+ *
+ * Each thread draws from its own generator, seeded with the seed of the sampler and the id of the thread, set
+ * by the caller with #set_thread_id, so that the sequence of samples is reproducible for a given seed, regardless
+ * of how the threads are scheduled, and does not contend on any shared state. Duplicates are filtered with a per-thread bitmap over the population.
+ * This class is thread safe, once the population has been set.
+ */
+class VertexSampler {
+    const VertexSamplerDistribution m_distribution; // how to pick the vertices
+    const double m_zipf_exponent; // the skew of the zipf distribution
+    const uint64_t m_seed; // the seed for the per-thread generators
+    std::vector<uint64_t> m_population; // the fixed population to draw the vertices from, if any
+
+    // Retrieve the generator of the current thread, seeded for this sampler
+    std::mt19937_64& random() const;
+
+public:
+    /**
+     * Set the id of the current thread, to derive the seed of its generator. Threads that draw concurrently should
+     * use different ids, e.g. the id of their worker. The default is 0, e.g. for the main thread.
+     */
+    static void set_thread_id(uint64_t thread_id);
+
+    /**
+     * Create a new sampler, without a fixed population
+     * @param distribution how to pick the vertices
+     * @param zipf_exponent the skew of the distribution, only used with VertexSamplerDistribution::ZIPF
+     * @param seed the seed for the per-thread generators
+     */
+    VertexSampler(VertexSamplerDistribution distribution = VertexSamplerDistribution::UNIFORM, double zipf_exponent = 1.0, uint64_t seed = 5051789ull);
+
+    /**
+     * Set the fixed population to draw the vertices from. This is not allowed with the degree distribution, as
+     * the degrees are only known to the library.
+     */
+    void set_population(std::vector<uint64_t> vertices);
+
+    // Whether a fixed population has been set
+    bool has_population() const { return !m_population.empty(); }
+
+    /**
+     * Draw up to `count' distinct vertices from the fixed population. If the population is smaller than `count',
+     * all vertices are returned.
+     */
+    void sample(uint64_t count, std::vector<uint64_t>& output) const;
+
+    /**
+     * Draw up to `count' distinct vertices from the given population.
+     * @param vertices the population
+     * @param degrees the degree of each vertex in the population, required only with the degree distribution
+     * @param num_vertices the size of the arrays `vertices' and `degrees'
+     * @param count the number of vertices to draw
+     * @param output where to store the vertices drawn, the vector is overwritten
+     */
+    void sample(const uint64_t* vertices, const uint64_t* degrees, uint64_t num_vertices, uint64_t count, std::vector<uint64_t>& output) const;
+
+    // Retrieve how the vertices are picked
+    VertexSamplerDistribution distribution() const { return m_distribution; }
+
+    // Retrieve the skew of the zipf distribution
+    double zipf_exponent() const { return m_zipf_exponent; }
+
+    // Retrieve the seed of the per-thread generators
+    uint64_t seed() const { return m_seed; }
+};
+
+} // namespace
@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2019 Dean De Leo, email: dleo[at]cwi.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace gfe::utility {
+
+/**
+ * Generate integers in [1, n] following a Zipf distribution with the given exponent, that is, the probability
+ * of the value k is proportional to 1 / k^exponent. The interface follows the random number distributions of the
+ * standard library, e.g. `zipf(generator)'.
+ *
+ * The values are generated in O(1) by rejection-inversion, without materialising the probabilities of the n values.
+ * Reference: W. Hörmann and G. Derflinger, Rejection-inversion to generate variates from monotone discrete
+ * distributions, ACM TOMACS 1996.
+ */
+class ZipfDistribution {
+    uint64_t m_n; // number of distinct values
+    double m_exponent; // the skew of the distribution, > 0
+    double m_h_integral_x1; // H(1.5) - 1
+    double m_h_integral_n; // H(n + 0.5)
+    double m_s; // threshold to accept a sample without evaluating H
+    std::uniform_real_distribution<double> m_uniform { 0., 1. };
+
+    // log(1 + x) / x, accurate also for x close to 0
+    static double helper1(double x){
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1. - x * (0.5 - x * (1./3. - 0.25 * x));
+    }
+
+    // (exp(x) - 1) / x, accurate also for x close to 0
+    static double helper2(double x){
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1. + x * 0.5 * (1. + x * 1./3. * (1. + 0.25 * x));
+    }
+
+    // the function h(x) = 1 / x^exponent
+    double h(double x) const {
+        return std::exp(-m_exponent * std::log(x));
+    }
+
+    // H(x), integral of h(x)
+    double h_integral(double x) const {
+        double log_x = std::log(x);
+        return helper2((1. - m_exponent) * log_x) * log_x;
+    }
+
+    // the inverse of H(x)
+    double h_integral_inverse(double x) const {
+        double t = x * (1. - m_exponent);
+        if(t < -1.) t = -1.; // numerical safety
+        return std::exp(helper1(t) * x);
+    }
+
+public:
+    /**
+     * @param n the number of distinct values, the generated values are in [1, n]
+     * @param exponent the skew of the distribution, e.g. 0.99 as in YCSB
+     */
+    ZipfDistribution(uint64_t n, double exponent) : m_n(n), m_exponent(exponent) {
+        assert(n >= 1 && "Empty domain");
+        assert(exponent > 0 && "The exponent must be positive");
+        m_h_integral_x1 = h_integral(1.5) - 1.;
+        m_h_integral_n = h_integral(static_cast<double>(m_n) + 0.5);
+        m_s = 2. - h_integral_inverse(h_integral(2.5) - h(2.));
+    }
+
+    // Generate the next value in [1, n]
+    template<typename Generator>
+    uint64_t operator()(Generator& generator) {
+        while(true){
+            double u = m_h_integral_n + m_uniform(generator) * (m_h_integral_x1 - m_h_integral_n);
+            double x = h_integral_inverse(u);
+            double k = std::floor(x + 0.5);
+            if(k < 1.){
+                k = 1.;
+            } else if (k > static_cast<double>(m_n)){
+                k = static_cast<double>(m_n);
+            }
+
+            if(k - x <= m_s || u >= h_integral(k + 0.5) - h(k)){
+                return static_cast<uint64_t>(k);
+            }
+        }
+    }
+
+    // The number of distinct values
+    uint64_t n() const { return m_n; }
+
+    // The skew of the distribution
+    double exponent() const { return m_exponent; }
+};
+
+} // namespace